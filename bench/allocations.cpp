@@ -0,0 +1,47 @@
+#include "bench.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/* Replacements for the global operator new and delete that count
+ * allocations. They live in a file of their own so that the compiler can't
+ * inline them into code that also sees the standard declarations, which
+ * makes GCC warn about mismatched new/free. */
+
+namespace {
+
+std::atomic<uint64_t> heap_allocations(0);
+std::atomic<uint64_t> heap_bytes(0);
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	heap_bytes.fetch_add(size, std::memory_order_relaxed);
+	void* ptr = std::malloc(size == 0 ? 1 : size);
+	if (ptr == nullptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+namespace Bench {
+
+uint64_t allocation_count()
+{
+	return heap_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t allocated_bytes()
+{
+	return heap_bytes.load(std::memory_order_relaxed);
+}
+
+} // namespace Bench
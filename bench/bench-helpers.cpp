@@ -0,0 +1,454 @@
+#include "bench-helpers.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+#include "rssfeed.h"
+#include "rssitem.h"
+#include "strprintf.h"
+
+using namespace newsboat;
+
+namespace {
+
+const char* const words[] = {
+	"the", "of", "and", "a", "to", "in", "is", "you", "that", "it",
+	"kernel", "release", "feed", "update", "security", "patch", "news",
+	"linux", "open", "source", "project", "community", "developer",
+	"performance", "memory", "network", "version", "support", "server",
+	"terminal", "reader", "article", "announced", "yesterday", "finally",
+	"improved", "significantly", "compatibility", "configuration",
+	"documentation", "über", "naïve", "café", "résumé", "Zürich",
+	"東京", "новости", "ελληνικά"
+};
+const size_t words_count = sizeof(words) / sizeof(words[0]);
+
+// 2020-01-01 00:00:00 UTC; items get older by an hour each
+const time_t newest_item = 1577836800;
+
+std::string word(std::mt19937& rng)
+{
+	return words[rng() % words_count];
+}
+
+std::string xml_escape(const std::string& text)
+{
+	std::string result;
+	result.reserve(text.size() + text.size() / 8);
+	for (const char c : text) {
+		switch (c) {
+		case '<':
+			result += "&lt;";
+			break;
+		case '>':
+			result += "&gt;";
+			break;
+		case '&':
+			result += "&amp;";
+			break;
+		case '"':
+			result += "&quot;";
+			break;
+		default:
+			result.push_back(c);
+		}
+	}
+	return result;
+}
+
+std::string format_time(time_t t, const char* format)
+{
+	char buf[64];
+	struct tm tm;
+	gmtime_r(&t, &tm);
+	strftime(buf, sizeof(buf), format, &tm);
+	return buf;
+}
+
+std::string rfc822_date(time_t t)
+{
+	return format_time(t, "%a, %d %b %Y %H:%M:%S +0000");
+}
+
+std::string iso8601_date(time_t t)
+{
+	return format_time(t, "%Y-%m-%dT%H:%M:%SZ");
+}
+
+std::string item_link(unsigned int i)
+{
+	return strprintf::fmt("https://example.com/articles/%u.html", i);
+}
+
+/// Converts UTF-8 \a text to ISO-8859-1, replacing characters outside of
+/// it with question marks
+std::string to_latin1(const std::string& text)
+{
+	std::string result;
+	result.reserve(text.size());
+	for (size_t i = 0; i < text.size(); ++i) {
+		const unsigned char c = text[i];
+		if (c < 0x80) {
+			result.push_back(c);
+		} else if ((c & 0xE0) == 0xC0 && i + 1 < text.size()) {
+			const unsigned int codepoint =
+				((c & 0x1F) << 6) | (text[i + 1] & 0x3F);
+			result.push_back(codepoint < 0x100 ? codepoint : '?');
+			i += 1;
+		} else {
+			result.push_back('?');
+			// Skip continuation bytes of a longer sequence
+			while (i + 1 < text.size() && (text[i + 1] & 0xC0) == 0x80) {
+				i++;
+			}
+		}
+	}
+	return result;
+}
+
+} // namespace
+
+namespace BenchHelpers {
+
+std::mt19937 make_rng(uint32_t seed)
+{
+	return std::mt19937(seed);
+}
+
+std::string prose(std::mt19937& rng, unsigned int count)
+{
+	std::string result;
+	for (unsigned int i = 0; i < count; ++i) {
+		if (i > 0) {
+			result += (rng() % 12 == 0) ? ". " : " ";
+		}
+		result += word(rng);
+	}
+	return result;
+}
+
+std::string html_article(std::mt19937& rng, unsigned int paragraphs)
+{
+	std::string html;
+	for (unsigned int i = 0; i < paragraphs; ++i) {
+		switch (rng() % 8) {
+		case 0:
+			html += "<ul>";
+			for (unsigned int j = 0; j < 3 + rng() % 4; ++j) {
+				html += "<li>" + prose(rng, 5 + rng() % 10) + "</li>";
+			}
+			html += "</ul>";
+			break;
+		case 1:
+			html += "<blockquote><p>" + prose(rng, 20 + rng() % 30) +
+				"</p></blockquote>";
+			break;
+		case 2:
+			html += "<pre><code>for (int i = 0; i &lt; n; ++i) {\n"
+				"\tsum += values[i];\n}</code></pre>";
+			break;
+		case 3:
+			html += strprintf::fmt(
+					"<p><img src=\"https://example.com/img/%u.png\" "
+					"alt=\"%s\" /></p>",
+					static_cast<unsigned int>(rng() % 10000),
+					prose(rng, 3));
+			break;
+		default:
+			html += "<p>" + prose(rng, 10 + rng() % 20);
+			html += strprintf::fmt(" <a href=\"%s\">%s</a> ",
+					item_link(rng() % 100000),
+					prose(rng, 2));
+			html += "<b>" + prose(rng, 2) + "</b> ";
+			html += "<em>" + prose(rng, 3) + "</em> ";
+			html += prose(rng, 20 + rng() % 40) + ".</p>";
+			break;
+		}
+		html += "\n";
+	}
+	return html;
+}
+
+std::string feed_document(FeedFormat format, unsigned int items,
+	uint32_t seed, Encoding encoding, unsigned int max_paragraphs)
+{
+	auto rng = make_rng(seed);
+	const auto paragraphs = [&]() {
+		return 2 + rng() % std::max(1u, max_paragraphs - 1);
+	};
+
+	std::ostringstream out;
+	out << "<?xml version=\"1.0\" encoding=\""
+		<< (encoding == Encoding::UTF_8 ? "UTF-8" : "ISO-8859-1")
+		<< "\"?>\n";
+
+	switch (format) {
+	case FeedFormat::RSS_0_91:
+		out << "<rss version=\"0.91\"><channel>"
+			"<title>Synthetic RSS 0.91 feed</title>"
+			"<link>https://example.com/</link>"
+			"<description>Generated for benchmarks</description>"
+			"<language>en</language>\n";
+		for (unsigned int i = 0; i < items; ++i) {
+			out << "<item><title>" << xml_escape(prose(rng, 8))
+				<< "</title><link>" << item_link(i) << "</link>"
+				<< "<description>"
+				<< xml_escape(html_article(rng, paragraphs()))
+				<< "</description></item>\n";
+		}
+		out << "</channel></rss>\n";
+		break;
+	case FeedFormat::RSS_0_92:
+		out << "<rss version=\"0.92\"><channel>"
+			"<title>Synthetic RSS 0.92 feed</title>"
+			"<link>https://example.com/</link>"
+			"<description>Generated for benchmarks</description>\n";
+		for (unsigned int i = 0; i < items; ++i) {
+			out << "<item><title>" << xml_escape(prose(rng, 8))
+				<< "</title><link>" << item_link(i) << "</link>"
+				<< "<category>" << xml_escape(prose(rng, 1))
+				<< "</category>";
+			if (rng() % 4 == 0) {
+				out << "<enclosure url=\"https://example.com/"
+					"episodes/" << i << ".ogg\" length=\"4567890\" "
+					"type=\"audio/ogg\" />";
+			}
+			out << "<description>"
+				<< xml_escape(html_article(rng, paragraphs()))
+				<< "</description></item>\n";
+		}
+		out << "</channel></rss>\n";
+		break;
+	case FeedFormat::RSS_1_0:
+		out << "<rdf:RDF "
+			"xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\" "
+			"xmlns=\"http://purl.org/rss/1.0/\" "
+			"xmlns:dc=\"http://purl.org/dc/elements/1.1/\" "
+			"xmlns:content=\"http://purl.org/rss/1.0/modules/content/\">"
+			"<channel rdf:about=\"https://example.com/\">"
+			"<title>Synthetic RSS 1.0 feed</title>"
+			"<link>https://example.com/</link>"
+			"<description>Generated for benchmarks</description>"
+			"</channel>\n";
+		for (unsigned int i = 0; i < items; ++i) {
+			out << "<item rdf:about=\"" << item_link(i) << "\">"
+				<< "<title>" << xml_escape(prose(rng, 8)) << "</title>"
+				<< "<link>" << item_link(i) << "</link>"
+				<< "<dc:creator>" << xml_escape(prose(rng, 2))
+				<< "</dc:creator>"
+				<< "<dc:date>" << iso8601_date(newest_item - i * 3600)
+				<< "</dc:date>"
+				<< "<content:encoded><![CDATA["
+				<< html_article(rng, paragraphs())
+				<< "]]></content:encoded></item>\n";
+		}
+		out << "</rdf:RDF>\n";
+		break;
+	case FeedFormat::RSS_2_0:
+		out << "<rss version=\"2.0\" "
+			"xmlns:content=\"http://purl.org/rss/1.0/modules/content/\">"
+			"<channel><title>Synthetic RSS 2.0 feed</title>"
+			"<link>https://example.com/</link>"
+			"<description>Generated for benchmarks</description>\n";
+		for (unsigned int i = 0; i < items; ++i) {
+			out << "<item><title>" << xml_escape(prose(rng, 8))
+				<< "</title><link>" << item_link(i) << "</link>"
+				<< "<guid isPermaLink=\"true\">" << item_link(i)
+				<< "</guid>"
+				<< "<author>author@example.com ("
+				<< xml_escape(prose(rng, 2)) << ")</author>"
+				<< "<pubDate>" << rfc822_date(newest_item - i * 3600)
+				<< "</pubDate>";
+			if (rng() % 4 == 0) {
+				out << "<enclosure url=\"https://example.com/"
+					"episodes/" << i << ".mp3\" length=\"12345678\" "
+					"type=\"audio/mpeg\" />";
+			}
+			out << "<description>" << xml_escape(prose(rng, 30))
+				<< "</description>"
+				<< "<content:encoded><![CDATA["
+				<< html_article(rng, paragraphs())
+				<< "]]></content:encoded></item>\n";
+		}
+		out << "</channel></rss>\n";
+		break;
+	case FeedFormat::ATOM_1_0:
+		out << "<feed xmlns=\"http://www.w3.org/2005/Atom\">"
+			"<title>Synthetic Atom 1.0 feed</title>"
+			"<link href=\"https://example.com/\" />"
+			"<id>urn:example:feed</id>"
+			"<updated>" << iso8601_date(newest_item) << "</updated>\n";
+		for (unsigned int i = 0; i < items; ++i) {
+			out << "<entry><title>" << xml_escape(prose(rng, 8))
+				<< "</title><link href=\"" << item_link(i) << "\" />"
+				<< "<id>urn:example:entry:" << i << "</id>"
+				<< "<author><name>" << xml_escape(prose(rng, 2))
+				<< "</name></author>"
+				<< "<updated>" << iso8601_date(newest_item - i * 3600)
+				<< "</updated>"
+				<< "<content type=\"html\">"
+				<< xml_escape(html_article(rng, paragraphs()))
+				<< "</content></entry>\n";
+		}
+		out << "</feed>\n";
+		break;
+	}
+
+	if (encoding == Encoding::ISO_8859_1) {
+		return to_latin1(out.str());
+	}
+	return out.str();
+}
+
+std::vector<CorpusFeed> generate_corpus(unsigned int feeds,
+	unsigned int items,
+	uint32_t seed)
+{
+	// Roughly what a large subscription list looks like: mostly RSS 2.0
+	// and Atom, with a long tail of older formats
+	const FeedFormat formats[] = {
+		FeedFormat::RSS_2_0, FeedFormat::RSS_2_0, FeedFormat::RSS_2_0,
+		FeedFormat::RSS_2_0, FeedFormat::ATOM_1_0, FeedFormat::ATOM_1_0,
+		FeedFormat::ATOM_1_0, FeedFormat::RSS_1_0, FeedFormat::RSS_0_92,
+		FeedFormat::RSS_0_91
+	};
+	const size_t formats_count = sizeof(formats) / sizeof(formats[0]);
+
+	auto rng = make_rng(seed);
+	std::vector<CorpusFeed> corpus;
+	corpus.reserve(feeds);
+	for (unsigned int i = 0; i < feeds; ++i) {
+		const FeedFormat format = formats[rng() % formats_count];
+		const Encoding encoding =
+			(rng() % 10 == 0) ? Encoding::ISO_8859_1 : Encoding::UTF_8;
+		// Between a quarter and twice the requested number of items
+		const unsigned int item_count =
+			std::max<unsigned int>(1, items / 4 + rng() % (items * 7 / 4 + 1));
+		// Most feeds carry summaries, some carry full long articles
+		const unsigned int max_paragraphs = (rng() % 5 == 0) ? 20 : 4;
+
+		CorpusFeed feed;
+		feed.path = strprintf::fmt("/feeds/%u.xml", i);
+		feed.content_type = strprintf::fmt("%s; charset=%s",
+				format == FeedFormat::ATOM_1_0
+				? "application/atom+xml"
+				: "application/rss+xml",
+				encoding == Encoding::UTF_8 ? "utf-8" : "iso-8859-1");
+		feed.body = feed_document(format, item_count, rng(), encoding,
+				max_paragraphs);
+		feed.last_modified = newest_item - (rng() % 86400);
+		corpus.push_back(std::move(feed));
+	}
+	return corpus;
+}
+
+std::shared_ptr<RssFeed> rssfeed(Cache* cache,
+	const std::string& rssurl,
+	unsigned int items,
+	uint32_t seed)
+{
+	auto rng = make_rng(seed);
+	auto feed = std::make_shared<RssFeed>(cache);
+	feed->set_rssurl(rssurl);
+	feed->set_title("Synthetic feed");
+	feed->set_link("https://example.com/");
+
+	for (unsigned int i = 0; i < items; ++i) {
+		auto item = std::make_shared<RssItem>(cache);
+		item->set_guid(strprintf::fmt("%s#%u", rssurl, i));
+		item->set_title(prose(rng, 8));
+		item->set_link(item_link(i));
+		item->set_author(prose(rng, 2));
+		item->set_pubDate(newest_item - i * 3600);
+		item->set_description(html_article(rng, 2 + rng() % 4));
+		item->set_unread_nowrite(rng() % 3 != 0);
+		item->set_feedurl(rssurl);
+		feed->add_item(item);
+	}
+
+	return feed;
+}
+
+TempFile::TempFile()
+{
+	const char* tmpdir = ::getenv("TMPDIR");
+	path = (tmpdir != nullptr) ? tmpdir : "/tmp";
+	path += "/newsboat-bench.XXXXXX";
+
+	const int fd = ::mkstemp(&path[0]);
+	if (fd == -1) {
+		std::cerr << "Couldn't create a temporary file in "
+			<< path << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+	::close(fd);
+	// Callers want a path to create a file at, not an empty file
+	::unlink(path.c_str());
+}
+
+TempFile::~TempFile()
+{
+	::unlink(path.c_str());
+	::unlink((path + "-journal").c_str());
+}
+
+TempDir::TempDir()
+{
+	const char* tmpdir = ::getenv("TMPDIR");
+	path = (tmpdir != nullptr) ? tmpdir : "/tmp";
+	path += "/newsboat-bench.XXXXXX";
+
+	if (::mkdtemp(&path[0]) == nullptr) {
+		std::cerr << "Couldn't create a temporary directory "
+			<< path << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+	path.push_back('/');
+}
+
+TempDir::~TempDir()
+{
+	DIR* dir = ::opendir(path.c_str());
+	if (dir != nullptr) {
+		while (const dirent* entry = ::readdir(dir)) {
+			const std::string name(entry->d_name);
+			if (name != "." && name != "..") {
+				::unlink((path + name).c_str());
+			}
+		}
+		::closedir(dir);
+	}
+	::rmdir(path.c_str());
+}
+
+void write_file(const std::string& path, const std::string& contents)
+{
+	std::ofstream out(path, std::ios::binary);
+	out << contents;
+	if (!out.good()) {
+		std::cerr << "Couldn't write " << path << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+std::string read_file(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in.is_open()) {
+		std::cerr << "Couldn't open " << path
+			<< "; benchmarks have to be run from the repository root"
+			<< std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+	std::ostringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+} // namespace BenchHelpers
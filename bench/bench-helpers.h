@@ -0,0 +1,118 @@
+#ifndef NEWSBOAT_BENCH_HELPERS_H_
+#define NEWSBOAT_BENCH_HELPERS_H_
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace newsboat {
+class Cache;
+class RssFeed;
+} // namespace newsboat
+
+/* Deterministic inputs for benchmarks. Everything here is generated from
+ * a fixed seed, so two runs of `make bench` (on any machine) work on
+ * byte-for-byte identical data. */
+
+namespace BenchHelpers {
+
+enum class FeedFormat { RSS_0_91, RSS_0_92, RSS_1_0, RSS_2_0, ATOM_1_0 };
+
+enum class Encoding { UTF_8, ISO_8859_1 };
+
+/// \brief Random number generator with a fixed seed.
+std::mt19937 make_rng(uint32_t seed = 42);
+
+/// \brief Returns \a words words of English-looking text.
+std::string prose(std::mt19937& rng, unsigned int words);
+
+/// \brief Returns an HTML article body with \a paragraphs paragraphs,
+/// sprinkled with links, emphasis, lists, quotes, code and images, like
+/// the ones found in real-world feeds.
+std::string html_article(std::mt19937& rng, unsigned int paragraphs);
+
+/// \brief Returns a feed with \a items items, each with an HTML body of
+/// two to \a max_paragraphs paragraphs.
+///
+/// Characters that can't be represented in \a encoding are replaced with
+/// question marks.
+std::string feed_document(FeedFormat format,
+	unsigned int items,
+	uint32_t seed = 42,
+	Encoding encoding = Encoding::UTF_8,
+	unsigned int max_paragraphs = 5);
+
+/// \brief A feed as served over HTTP.
+struct CorpusFeed {
+	/// Absolute path on the server, e.g. "/feeds/42.xml"
+	std::string path;
+	std::string content_type;
+	std::string body;
+	time_t last_modified;
+};
+
+/// \brief Returns \a feeds feeds that look like a real subscription list:
+/// a mix of RSS 0.91, 0.92, 1.0, 2.0 and Atom, a few of them in
+/// ISO-8859-1, with item counts around \a items and article sizes varying
+/// from a couple of sentences to long reads.
+std::vector<CorpusFeed> generate_corpus(unsigned int feeds,
+	unsigned int items,
+	uint32_t seed = 42);
+
+/// \brief Returns a feed with \a items items, ready to be written to
+/// \a cache. Item GUIDs are unique and stable across calls.
+std::shared_ptr<newsboat::RssFeed> rssfeed(newsboat::Cache* cache,
+	const std::string& rssurl,
+	unsigned int items,
+	uint32_t seed = 42);
+
+/// \brief Path to a file in $TMPDIR (or /tmp) that doesn't exist yet, and
+/// is removed when the object is destroyed.
+class TempFile {
+public:
+	TempFile();
+	~TempFile();
+	TempFile(const TempFile&) = delete;
+	TempFile& operator=(const TempFile&) = delete;
+
+	const std::string& get_path() const
+	{
+		return path;
+	}
+
+private:
+	std::string path;
+};
+
+/// \brief A directory in $TMPDIR (or /tmp) that is removed, along with
+/// the files in it, when the object is destroyed.
+class TempDir {
+public:
+	TempDir();
+	~TempDir();
+	TempDir(const TempDir&) = delete;
+	TempDir& operator=(const TempDir&) = delete;
+
+	/// \brief Path to the directory, with a trailing slash.
+	const std::string& get_path() const
+	{
+		return path;
+	}
+
+private:
+	std::string path;
+};
+
+/// \brief Writes \a contents to \a path. Exits the program on failure.
+void write_file(const std::string& path, const std::string& contents);
+
+/// \brief Returns the contents of \a path, e.g. one of the feeds recorded
+/// in test/data/. Exits the program if the file can't be read.
+std::string read_file(const std::string& path);
+
+} // namespace BenchHelpers
+
+#endif /* NEWSBOAT_BENCH_HELPERS_H_ */
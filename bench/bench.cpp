@@ -0,0 +1,255 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <clocale>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "strprintf.h"
+
+using namespace newsboat;
+
+namespace {
+
+struct Benchmark {
+	std::string name;
+	std::function<void(Bench::State&)> function;
+	bool large;
+};
+
+std::vector<Benchmark>& registry()
+{
+	static std::vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+std::string format_duration(double seconds)
+{
+	if (seconds < 1e-6) {
+		return strprintf::fmt("%.1f ns", seconds * 1e9);
+	} else if (seconds < 1e-3) {
+		return strprintf::fmt("%.1f us", seconds * 1e6);
+	} else if (seconds < 1) {
+		return strprintf::fmt("%.1f ms", seconds * 1e3);
+	}
+	return strprintf::fmt("%.2f s", seconds);
+}
+
+std::string format_rate(double per_second, const std::string& unit)
+{
+	if (per_second >= 1e9) {
+		return strprintf::fmt("%.1f G%s/s", per_second / 1e9, unit);
+	} else if (per_second >= 1e6) {
+		return strprintf::fmt("%.1f M%s/s", per_second / 1e6, unit);
+	} else if (per_second >= 1e3) {
+		return strprintf::fmt("%.1f k%s/s", per_second / 1e3, unit);
+	}
+	return strprintf::fmt("%.1f %s/s", per_second, unit);
+}
+
+std::string format_throughput(const Bench::State& state)
+{
+	const double seconds = state.seconds();
+	if (seconds <= 0) {
+		return "-";
+	}
+	if (state.bytes() > 0) {
+		return format_rate(state.bytes() / seconds, "B");
+	} else if (state.items() > 0) {
+		return format_rate(state.items() / seconds, "items");
+	}
+	return "-";
+}
+
+bool matches_filters(const std::string& name,
+	const std::vector<std::string>& filters)
+{
+	if (filters.empty()) {
+		return true;
+	}
+	return std::any_of(filters.begin(), filters.end(),
+	[&](const std::string& filter) {
+		return name.find(filter) != std::string::npos;
+	});
+}
+
+void print_usage(const char* argv0)
+{
+	std::cout << "Usage: " << argv0
+		<< " [--large] [--list] [--min-time=SECONDS]"
+		" [--max-iterations=N] [FILTER...]\n"
+		"\n"
+		"Runs benchmarks whose names contain any of FILTERs (all of them"
+		" if none are\n"
+		"given). Benchmarks marked as large only run with --large.\n";
+}
+
+} // namespace
+
+namespace Bench {
+
+Registration::Registration(const std::string& name,
+	std::function<void(State&)> function,
+	bool large)
+{
+	registry().push_back({name, function, large});
+}
+
+State::State(double min_seconds, uint64_t max_iterations)
+	: min_duration(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			  std::chrono::duration<double>(min_seconds)))
+	, max_iterations(max_iterations)
+	, running(false)
+	, elapsed(0)
+	, allocations_at_start(0)
+	, allocated_bytes_at_start(0)
+	, iteration_count(0)
+	, allocation_count(0)
+	, allocated_byte_count(0)
+	, items_per_iteration(0)
+	, bytes_per_iteration(0)
+{
+}
+
+bool State::keep_running()
+{
+	if (iteration_count == 0) {
+		start();
+		iteration_count = 1;
+		return true;
+	}
+
+	auto so_far = elapsed;
+	if (running) {
+		so_far += std::chrono::steady_clock::now() - started_at;
+	}
+	if (so_far >= min_duration || iteration_count >= max_iterations) {
+		if (running) {
+			stop();
+		}
+		return false;
+	}
+
+	iteration_count++;
+	return true;
+}
+
+void State::pause_timing()
+{
+	if (running) {
+		stop();
+	}
+}
+
+void State::resume_timing()
+{
+	if (!running) {
+		start();
+	}
+}
+
+double State::seconds() const
+{
+	return std::chrono::duration<double>(elapsed).count();
+}
+
+void State::start()
+{
+	running = true;
+	allocations_at_start = Bench::allocation_count();
+	allocated_bytes_at_start = Bench::allocated_bytes();
+	started_at = std::chrono::steady_clock::now();
+}
+
+void State::stop()
+{
+	elapsed += std::chrono::steady_clock::now() - started_at;
+	allocation_count += Bench::allocation_count() - allocations_at_start;
+	allocated_byte_count += Bench::allocated_bytes() -
+		allocated_bytes_at_start;
+	running = false;
+}
+
+} // namespace Bench
+
+int main(int argc, char* argv[])
+{
+	setlocale(LC_CTYPE, "");
+
+	bool run_large = false;
+	bool list_only = false;
+	double min_seconds = 1.0;
+	uint64_t max_iterations = 1000000000;
+	std::vector<std::string> filters;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg(argv[i]);
+		if (arg == "--large") {
+			run_large = true;
+		} else if (arg == "--list") {
+			list_only = true;
+		} else if (arg.compare(0, 11, "--min-time=") == 0) {
+			min_seconds = std::atof(arg.c_str() + 11);
+		} else if (arg.compare(0, 17, "--max-iterations=") == 0) {
+			max_iterations = std::max(1ull,
+					std::strtoull(arg.c_str() + 17, nullptr, 10));
+		} else if (arg == "-h" || arg == "--help") {
+			print_usage(argv[0]);
+			return EXIT_SUCCESS;
+		} else if (arg.compare(0, 1, "-") == 0) {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		} else {
+			filters.push_back(arg);
+		}
+	}
+
+	// Registration order depends on the linker; sort to make runs
+	// comparable
+	auto& benchmarks = registry();
+	std::stable_sort(benchmarks.begin(), benchmarks.end(),
+	[](const Benchmark& a, const Benchmark& b) {
+		return a.name < b.name;
+	});
+
+	if (!list_only) {
+		std::cout << strprintf::fmt("%-44s %10s %10s %14s %12s %12s",
+				"benchmark",
+				"iterations",
+				"time/iter",
+				"throughput",
+				"allocs/iter",
+				"bytes/iter")
+			<< std::endl;
+	}
+
+	for (const auto& benchmark : benchmarks) {
+		if (!matches_filters(benchmark.name, filters)) {
+			continue;
+		}
+		if (list_only) {
+			std::cout << benchmark.name
+				<< (benchmark.large ? " (large)" : "") << std::endl;
+			continue;
+		}
+		if (benchmark.large && !run_large) {
+			continue;
+		}
+
+		Bench::State state(min_seconds, max_iterations);
+		benchmark.function(state);
+
+		const uint64_t iterations = std::max<uint64_t>(1, state.iterations());
+		std::cout << strprintf::fmt("%-44s %10s %10s %14s %12s %12s",
+				benchmark.name,
+				std::to_string(state.iterations()),
+				format_duration(state.seconds() / iterations),
+				format_throughput(state),
+				std::to_string(state.allocations() / iterations),
+				std::to_string(state.allocated_bytes() / iterations))
+			<< std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+#ifndef NEWSBOAT_BENCH_H_
+#define NEWSBOAT_BENCH_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/* A tiny benchmarking harness for `make bench`.
+ *
+ * Benchmarks are registered at static initialization time, much like Catch
+ * test cases, and run by bench/bench.cpp. Each benchmark gets a State and
+ * loops while State::keep_running() returns true:
+ *
+ *     static Bench::Registration reg("wrap_line/prose", [](Bench::State& s) {
+ *             const auto text = ...;
+ *             s.set_bytes_per_iteration(text.size());
+ *             while (s.keep_running()) {
+ *                     wrap_line(text, 80);
+ *             }
+ *     });
+ *
+ * Besides the time per iteration, the harness reports throughput (if the
+ * benchmark told it how many items or bytes it processes per iteration) and
+ * the number of C++ heap allocations per iteration. Allocations made through
+ * malloc() by C libraries (libxml2, SQLite, curl) aren't counted. */
+
+namespace Bench {
+
+class State {
+public:
+	State(double min_seconds, uint64_t max_iterations);
+
+	/// \brief Returns true if the benchmark should run another iteration.
+	///
+	/// The first call starts the clock; the call that returns false stops
+	/// it.
+	bool keep_running();
+
+	/// \brief Excludes the code that follows from measurements, until
+	/// resume_timing() is called. Use it for per-iteration setup.
+	void pause_timing();
+	void resume_timing();
+
+	void set_items_per_iteration(uint64_t items)
+	{
+		items_per_iteration = items;
+	}
+	void set_bytes_per_iteration(uint64_t bytes)
+	{
+		bytes_per_iteration = bytes;
+	}
+
+	uint64_t iterations() const
+	{
+		return iteration_count;
+	}
+	double seconds() const;
+	uint64_t allocations() const
+	{
+		return allocation_count;
+	}
+	uint64_t allocated_bytes() const
+	{
+		return allocated_byte_count;
+	}
+	uint64_t items() const
+	{
+		return items_per_iteration * iteration_count;
+	}
+	uint64_t bytes() const
+	{
+		return bytes_per_iteration * iteration_count;
+	}
+
+private:
+	void start();
+	void stop();
+
+	const std::chrono::nanoseconds min_duration;
+	const uint64_t max_iterations;
+
+	bool running;
+	std::chrono::steady_clock::time_point started_at;
+	std::chrono::nanoseconds elapsed;
+	uint64_t allocations_at_start;
+	uint64_t allocated_bytes_at_start;
+
+	uint64_t iteration_count;
+	uint64_t allocation_count;
+	uint64_t allocated_byte_count;
+	uint64_t items_per_iteration;
+	uint64_t bytes_per_iteration;
+};
+
+/// \brief Registers a benchmark. \a large benchmarks take minutes and
+/// gigabytes of memory, and only run if `--large` is passed.
+struct Registration {
+	Registration(const std::string& name,
+		std::function<void(State&)> function,
+		bool large = false);
+};
+
+/// \brief Number of C++ heap allocations made by the process so far.
+uint64_t allocation_count();
+
+/// \brief Number of bytes requested from the C++ heap so far.
+uint64_t allocated_bytes();
+
+/// \brief Prevents the compiler from optimizing away \a value.
+template<typename T>
+void do_not_optimize(const T& value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace Bench
+
+#endif /* NEWSBOAT_BENCH_H_ */
@@ -0,0 +1,127 @@
+#include "cache.h"
+
+#include <memory>
+
+#include "bench.h"
+#include "bench-helpers.h"
+#include "configcontainer.h"
+#include "rssfeed.h"
+
+using namespace newsboat;
+
+namespace {
+
+const std::string feedurl = "https://example.com/feed.xml";
+
+/// Writes \a items new items into an empty cache
+void externalize(Bench::State& state, unsigned int items)
+{
+	ConfigContainer cfg;
+	const auto feed = BenchHelpers::rssfeed(nullptr, feedurl, items);
+
+	state.set_items_per_iteration(items);
+	while (state.keep_running()) {
+		state.pause_timing();
+		std::unique_ptr<BenchHelpers::TempFile> dbfile(
+			new BenchHelpers::TempFile());
+		std::unique_ptr<Cache> rsscache(
+			new Cache(dbfile->get_path(), &cfg));
+		state.resume_timing();
+
+		rsscache->externalize_rssfeed(feed, false);
+
+		state.pause_timing();
+		rsscache.reset();
+		dbfile.reset();
+		state.resume_timing();
+	}
+}
+
+/// Writes the same \a items items again, which is what most reloads do
+void externalize_unchanged(Bench::State& state, unsigned int items)
+{
+	ConfigContainer cfg;
+	BenchHelpers::TempFile dbfile;
+	Cache rsscache(dbfile.get_path(), &cfg);
+	const auto feed = BenchHelpers::rssfeed(nullptr, feedurl, items);
+	rsscache.externalize_rssfeed(feed, false);
+
+	state.set_items_per_iteration(items);
+	while (state.keep_running()) {
+		rsscache.externalize_rssfeed(feed, false);
+	}
+}
+
+void internalize(Bench::State& state, unsigned int items)
+{
+	ConfigContainer cfg;
+	BenchHelpers::TempFile dbfile;
+	Cache rsscache(dbfile.get_path(), &cfg);
+	rsscache.externalize_rssfeed(
+		BenchHelpers::rssfeed(nullptr, feedurl, items), false);
+
+	state.set_items_per_iteration(items);
+	while (state.keep_running()) {
+		const auto feed = rsscache.internalize_rssfeed(feedurl, nullptr);
+		Bench::do_not_optimize(feed);
+	}
+}
+
+Bench::Registration externalize_10k("cache/externalize_rssfeed/10k",
+[](Bench::State& state)
+{
+	externalize(state, 10000);
+});
+
+Bench::Registration externalize_100k("cache/externalize_rssfeed/100k",
+[](Bench::State& state)
+{
+	externalize(state, 100000);
+});
+
+Bench::Registration externalize_1m("cache/externalize_rssfeed/1M",
+[](Bench::State& state)
+{
+	externalize(state, 1000000);
+}, true);
+
+Bench::Registration unchanged_10k(
+	"cache/externalize_rssfeed/10k-unchanged",
+[](Bench::State& state)
+{
+	externalize_unchanged(state, 10000);
+});
+
+Bench::Registration unchanged_100k(
+	"cache/externalize_rssfeed/100k-unchanged",
+[](Bench::State& state)
+{
+	externalize_unchanged(state, 100000);
+});
+
+Bench::Registration unchanged_1m(
+	"cache/externalize_rssfeed/1M-unchanged",
+[](Bench::State& state)
+{
+	externalize_unchanged(state, 1000000);
+}, true);
+
+Bench::Registration internalize_10k("cache/internalize_rssfeed/10k",
+[](Bench::State& state)
+{
+	internalize(state, 10000);
+});
+
+Bench::Registration internalize_100k("cache/internalize_rssfeed/100k",
+[](Bench::State& state)
+{
+	internalize(state, 100000);
+});
+
+Bench::Registration internalize_1m("cache/internalize_rssfeed/1M",
+[](Bench::State& state)
+{
+	internalize(state, 1000000);
+}, true);
+
+} // namespace
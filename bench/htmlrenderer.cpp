@@ -0,0 +1,37 @@
+#include "htmlrenderer.h"
+
+#include "bench.h"
+#include "bench-helpers.h"
+
+using namespace newsboat;
+
+namespace {
+
+void render(Bench::State& state, unsigned int paragraphs)
+{
+	auto rng = BenchHelpers::make_rng();
+	const auto html = BenchHelpers::html_article(rng, paragraphs);
+
+	HtmlRenderer renderer;
+	state.set_bytes_per_iteration(html.size());
+	while (state.keep_running()) {
+		std::vector<std::pair<LineType, std::string>> lines;
+		std::vector<LinkPair> links;
+		renderer.render(html, lines, links, "https://example.com/");
+		Bench::do_not_optimize(lines);
+	}
+}
+
+Bench::Registration short_article("htmlrenderer/render/5-paragraphs",
+[](Bench::State& state)
+{
+	render(state, 5);
+});
+
+Bench::Registration long_article("htmlrenderer/render/100-paragraphs",
+[](Bench::State& state)
+{
+	render(state, 100);
+});
+
+} // namespace
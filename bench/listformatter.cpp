@@ -0,0 +1,75 @@
+#include "listformatter.h"
+
+#include "bench.h"
+#include "bench-helpers.h"
+#include "regexmanager.h"
+
+using namespace newsboat;
+
+namespace {
+
+std::vector<std::string> feedlist_lines(unsigned int count)
+{
+	auto rng = BenchHelpers::make_rng();
+	std::vector<std::string> lines;
+	for (unsigned int i = 0; i < count; ++i) {
+		lines.push_back(std::to_string(i + 1) + "   (12/345) " +
+			BenchHelpers::prose(rng, 6 + rng() % 10));
+	}
+	return lines;
+}
+
+void add_lines(Bench::State& state, unsigned int count)
+{
+	const auto lines = feedlist_lines(count);
+	state.set_items_per_iteration(lines.size());
+	while (state.keep_running()) {
+		ListFormatter formatter;
+		formatter.add_lines(lines, 80);
+		Bench::do_not_optimize(formatter);
+	}
+}
+
+void format_list(Bench::State& state, unsigned int count, bool highlight)
+{
+	RegexManager rxman;
+	rxman.handle_action("highlight", {"feedlist", "linux", "red", "default"});
+	rxman.handle_action("highlight",
+		{"feedlist", "(security|patch)", "yellow", "default", "bold"});
+
+	ListFormatter formatter;
+	formatter.add_lines(feedlist_lines(count), 80);
+
+	state.set_items_per_iteration(count);
+	while (state.keep_running()) {
+		const auto list = formatter.format_list(
+				highlight ? &rxman : nullptr, "feedlist");
+		Bench::do_not_optimize(list);
+	}
+}
+
+Bench::Registration add_lines_1k("listformatter/add_lines/1k",
+[](Bench::State& state)
+{
+	add_lines(state, 1000);
+});
+
+Bench::Registration format_1k("listformatter/format_list/1k",
+[](Bench::State& state)
+{
+	format_list(state, 1000, false);
+});
+
+Bench::Registration format_10k("listformatter/format_list/10k",
+[](Bench::State& state)
+{
+	format_list(state, 10000, false);
+});
+
+Bench::Registration highlight_1k("listformatter/format_list/1k-highlighted",
+[](Bench::State& state)
+{
+	format_list(state, 1000, true);
+});
+
+} // namespace
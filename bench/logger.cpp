@@ -0,0 +1,68 @@
+#include "logger.h"
+
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "bench-helpers.h"
+
+using namespace newsboat;
+
+namespace {
+
+// Roughly what a reload thread logs for each item when debug logging is on
+void log_from_threads(Bench::State& state, unsigned int threads)
+{
+	const unsigned int messages = 1000;
+
+	BenchHelpers::TempFile logfile;
+	Logger::set_logfile(logfile.get_path());
+	Logger::set_loglevel(Level::DEBUG);
+
+	state.set_items_per_iteration(threads * messages);
+	while (state.keep_running()) {
+		std::vector<std::thread> workers;
+		for (unsigned int t = 0; t < threads; ++t) {
+			workers.emplace_back([]() {
+				for (unsigned int i = 0; i < messages; ++i) {
+					LOG(Level::DEBUG,
+						"RssIgnores::matches: ignore rule %u "
+						"doesn't match item %s",
+						i,
+						"https://example.com/articles/42");
+				}
+			});
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+	Logger::flush();
+
+	Logger::set_loglevel(Level::NONE);
+}
+
+Bench::Registration disabled("logger/disabled", [](Bench::State& state)
+{
+	Logger::set_loglevel(Level::NONE);
+	state.set_items_per_iteration(1000);
+	while (state.keep_running()) {
+		for (unsigned int i = 0; i < 1000; ++i) {
+			LOG(Level::DEBUG, "item %u of %s", i, "feed");
+		}
+	}
+});
+
+Bench::Registration one_thread("logger/debug-1-thread",
+	[](Bench::State& state)
+{
+	log_from_threads(state, 1);
+});
+
+Bench::Registration eight_threads("logger/debug-8-threads",
+	[](Bench::State& state)
+{
+	log_from_threads(state, 8);
+});
+
+} // namespace
@@ -0,0 +1,61 @@
+#include "matcher.h"
+
+#include "bench.h"
+#include "bench-helpers.h"
+#include "rssfeed.h"
+#include "rssitem.h"
+
+using namespace newsboat;
+
+namespace {
+
+// Expressions typical for query feeds and ignore rules
+void match(Bench::State& state, const std::string& expression)
+{
+	const auto feed = BenchHelpers::rssfeed(
+			nullptr, "https://example.com/feed.xml", 1000);
+	feed->set_tags({"news", "linux"});
+	feed->set_feedptrs(feed);
+	const auto items = feed->items();
+
+	Matcher matcher(expression);
+	state.set_items_per_iteration(items.size());
+	while (state.keep_running()) {
+		unsigned int matched = 0;
+		for (const auto& item : items) {
+			if (matcher.matches(item.get())) {
+				matched++;
+			}
+		}
+		Bench::do_not_optimize(matched);
+	}
+}
+
+Bench::Registration unread("matcher/unread", [](Bench::State& state)
+{
+	match(state, "unread = \"yes\"");
+});
+
+Bench::Registration age("matcher/age-between", [](Bench::State& state)
+{
+	match(state, "age between 0:7");
+});
+
+Bench::Registration regex("matcher/title-regex", [](Bench::State& state)
+{
+	match(state, "title =~ \"(linux|kernel) (release|patch)\"");
+});
+
+Bench::Registration tags("matcher/tags", [](Bench::State& state)
+{
+	match(state, "tags # \"news\"");
+});
+
+Bench::Registration combined("matcher/combined", [](Bench::State& state)
+{
+	match(state,
+		"unread = \"yes\" and (title =~ \"security\" or "
+		"content =~ \"patch\") and age between 0:30");
+});
+
+} // namespace
@@ -0,0 +1,138 @@
+#include "reloader.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+
+#include "bench.h"
+#include "bench-helpers.h"
+#include "cliargsparser.h"
+#include "configpaths.h"
+#include "controller.h"
+#include "replayserver.h"
+#include "rss/parser.h"
+#include "view.h"
+
+using namespace newsboat;
+
+namespace {
+
+struct Scenario {
+	unsigned int feeds;
+	unsigned int items;
+	unsigned int latency_ms;
+	unsigned int jitter_ms;
+	double error_rate;
+	/// If true, the cache already holds the feeds, so most requests are
+	/// answered with "304 Not Modified"
+	bool warm;
+};
+
+/// Runs `newsboat` with \a arguments in this process, the same way
+/// newsboat.cpp does it
+void run_newsboat(const std::vector<std::string>& arguments)
+{
+	ConfigPaths configpaths;
+	if (!configpaths.initialized()) {
+		std::cerr << configpaths.error_message() << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+
+	Controller controller(configpaths);
+	newsboat::View view(&controller);
+	controller.set_view(&view);
+
+	std::vector<char*> argv;
+	for (const auto& argument : arguments) {
+		argv.push_back(const_cast<char*>(argument.c_str()));
+	}
+	argv.push_back(nullptr);
+	CliArgsParser args(arguments.size(), argv.data());
+	configpaths.process_args(args);
+
+	if (controller.run(args) != EXIT_SUCCESS) {
+		std::cerr << "newsboat exited with an error" << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+/// Measures `newsboat -x reload`, i.e. Reloader::reload_all() plus
+/// loading the cache, against a local ReplayServer
+void reload_all(Bench::State& state, const Scenario& scenario)
+{
+	rsspp::Parser::global_init();
+
+	BenchHelpers::ReplayServerOptions options;
+	options.latency_ms = scenario.latency_ms;
+	options.jitter_ms = scenario.jitter_ms;
+	options.error_rate = scenario.error_rate;
+	const auto corpus =
+		BenchHelpers::generate_corpus(scenario.feeds, scenario.items);
+	BenchHelpers::ReplayServer server(corpus, options);
+	server.start();
+
+	BenchHelpers::TempDir dir;
+	const auto urls_file = dir.get_path() + "urls";
+	const auto config_file = dir.get_path() + "config";
+	const auto cache_file = dir.get_path() + "cache.db";
+
+	std::string urls;
+	for (const auto& feed : corpus) {
+		urls += server.url(feed) + "\n";
+	}
+	BenchHelpers::write_file(urls_file, urls);
+	BenchHelpers::write_file(config_file, "reload-threads 8\n");
+
+	const std::vector<std::string> arguments = {
+		"newsboat", "-q",
+		"-u", urls_file,
+		"-c", cache_file,
+		"-C", config_file,
+		"-x", "reload"
+	};
+
+	if (scenario.warm) {
+		run_newsboat(arguments);
+	}
+
+	state.set_items_per_iteration(scenario.feeds);
+	while (state.keep_running()) {
+		if (!scenario.warm) {
+			state.pause_timing();
+			::unlink(cache_file.c_str());
+			state.resume_timing();
+		}
+		run_newsboat(arguments);
+	}
+
+	server.stop();
+	rsspp::Parser::global_cleanup();
+}
+
+Bench::Registration cold_100("reload/reload_all/100-feeds-cold",
+[](Bench::State& state)
+{
+	reload_all(state, {100, 20, 5, 20, 0.01, false});
+});
+
+Bench::Registration warm_100("reload/reload_all/100-feeds-warm",
+[](Bench::State& state)
+{
+	reload_all(state, {100, 20, 5, 20, 0.01, true});
+});
+
+// Our production setup: 1,500 feeds on servers of all kinds of speeds
+Bench::Registration cold_1500("reload/reload_all/1500-feeds-cold",
+[](Bench::State& state)
+{
+	reload_all(state, {1500, 50, 50, 200, 0.01, false});
+}, true);
+
+Bench::Registration warm_1500("reload/reload_all/1500-feeds-warm",
+[](Bench::State& state)
+{
+	reload_all(state, {1500, 50, 50, 200, 0.01, true});
+}, true);
+
+} // namespace
@@ -0,0 +1,126 @@
+/* Serves a synthetic corpus of feeds over HTTP, for load-testing reloads on
+ * a developer's machine:
+ *
+ *     $ ./bench/replay-server --feeds 1500 --latency 80 --jitter 200 \
+ *             --error-rate 0.01 --urls /tmp/urls
+ *     $ ./newsboat -u /tmp/urls -c /tmp/cache.db -x reload stats
+ *
+ * See print_usage() for all the options. */
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "bench-helpers.h"
+#include "replayserver.h"
+
+using namespace BenchHelpers;
+
+namespace {
+
+void print_usage(const char* argv0)
+{
+	std::cout << "Usage: " << argv0 << " [OPTION...]\n"
+		"\n"
+		"Generates a corpus of feeds and serves it on 127.0.0.1 until"
+		" interrupted.\n"
+		"\n"
+		"  --feeds N         number of feeds (default: 100)\n"
+		"  --items N         average number of items per feed"
+		" (default: 50)\n"
+		"  --port N          port to listen on (default: any free one)\n"
+		"  --latency MS      delay before each response (default: 0)\n"
+		"  --jitter MS       random extra delay, up to MS (default: 0)\n"
+		"  --error-rate R    fraction of requests answered with 503"
+		" (default: 0)\n"
+		"  --no-conditional  no ETag/Last-Modified, never answer 304\n"
+		"  --no-gzip         never compress responses\n"
+		"  --seed N          seed for the corpus, latency and errors"
+		" (default: 42)\n"
+		"  --urls FILE       write the feeds' URLs to FILE, in the format"
+		" of\n"
+		"                    newsboat's urls file\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	unsigned int feeds = 100;
+	unsigned int items = 50;
+	unsigned int port = 0;
+	std::string urls_file;
+	ReplayServerOptions options;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg(argv[i]);
+		const bool has_value = (i + 1 < argc);
+		if (arg == "--no-conditional") {
+			options.conditional = false;
+		} else if (arg == "--no-gzip") {
+			options.gzip = false;
+		} else if (arg == "--feeds" && has_value) {
+			feeds = std::strtoul(argv[++i], nullptr, 10);
+		} else if (arg == "--items" && has_value) {
+			items = std::strtoul(argv[++i], nullptr, 10);
+		} else if (arg == "--port" && has_value) {
+			port = std::strtoul(argv[++i], nullptr, 10);
+		} else if (arg == "--latency" && has_value) {
+			options.latency_ms = std::strtoul(argv[++i], nullptr, 10);
+		} else if (arg == "--jitter" && has_value) {
+			options.jitter_ms = std::strtoul(argv[++i], nullptr, 10);
+		} else if (arg == "--error-rate" && has_value) {
+			options.error_rate = std::atof(argv[++i]);
+		} else if (arg == "--seed" && has_value) {
+			options.seed = std::strtoul(argv[++i], nullptr, 10);
+		} else if (arg == "--urls" && has_value) {
+			urls_file = argv[++i];
+		} else if (arg == "-h" || arg == "--help") {
+			print_usage(argv[0]);
+			return EXIT_SUCCESS;
+		} else {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Block the signals before any threads are started, so that only
+	// sigwait() below receives them
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+	std::cout << "Generating " << feeds << " feeds..." << std::flush;
+	const auto corpus = generate_corpus(feeds, items, options.seed);
+	std::cout << " done." << std::endl;
+
+	ReplayServer server(corpus, options);
+	server.start(port);
+
+	if (!urls_file.empty()) {
+		std::string urls;
+		for (const auto& feed : corpus) {
+			urls += server.url(feed) + "\n";
+		}
+		write_file(urls_file, urls);
+	}
+
+	std::cout << "Serving on http://127.0.0.1:" << server.get_port()
+		<< "/feeds/0.xml to /feeds/" << (feeds > 0 ? feeds - 1 : 0)
+		<< ".xml; press Ctrl-C to stop." << std::endl;
+
+	int signal;
+	sigwait(&signals, &signal);
+	server.stop();
+
+	const auto stats = server.get_stats();
+	std::cout << stats.requests << " requests, "
+		<< stats.not_modified << " not modified, "
+		<< stats.errors << " errors, "
+		<< stats.bytes_sent << " bytes sent." << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,420 @@
+#include "replayserver.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "strprintf.h"
+
+using namespace newsboat;
+
+namespace {
+
+// How often blocked threads check if the server is stopping
+const int poll_interval_ms = 100;
+
+// Requests with longer headers are rejected
+const size_t max_header_size = 64 * 1024;
+
+std::string gzip(const std::string& data)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	// 16 + MAX_WBITS asks zlib for a gzip header rather than a zlib one
+	if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+			16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		std::cerr << "ReplayServer: deflateInit2 failed" << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+
+	std::string result(deflateBound(&stream, data.size()), '\0');
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+	stream.avail_in = data.size();
+	stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+	stream.avail_out = result.size();
+	deflate(&stream, Z_FINISH);
+	result.resize(stream.total_out);
+	deflateEnd(&stream);
+
+	return result;
+}
+
+std::string http_date(time_t t)
+{
+	char buf[64];
+	struct tm tm;
+	gmtime_r(&t, &tm);
+	strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+	return buf;
+}
+
+/// Returns -1 if \a value isn't a date in RFC 7231 format
+time_t parse_http_date(const std::string& value)
+{
+	struct tm tm;
+	memset(&tm, 0, sizeof(tm));
+	if (strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm) == nullptr) {
+		return -1;
+	}
+	return timegm(&tm);
+}
+
+std::string lowercase(std::string text)
+{
+	for (auto& c : text) {
+		c = tolower(static_cast<unsigned char>(c));
+	}
+	return text;
+}
+
+std::string trim(const std::string& text)
+{
+	const auto first = text.find_first_not_of(" \t");
+	if (first == std::string::npos) {
+		return "";
+	}
+	const auto last = text.find_last_not_of(" \t\r");
+	return text.substr(first, last - first + 1);
+}
+
+bool send_all(int fd, const std::string& data)
+{
+	size_t sent = 0;
+	while (sent < data.size()) {
+		const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent,
+				MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		sent += n;
+	}
+	return true;
+}
+
+std::string status_line(int code)
+{
+	switch (code) {
+	case 200:
+		return "HTTP/1.1 200 OK\r\n";
+	case 304:
+		return "HTTP/1.1 304 Not Modified\r\n";
+	case 404:
+		return "HTTP/1.1 404 Not Found\r\n";
+	case 405:
+		return "HTTP/1.1 405 Method Not Allowed\r\n";
+	default:
+		return "HTTP/1.1 503 Service Unavailable\r\n";
+	}
+}
+
+} // namespace
+
+namespace BenchHelpers {
+
+ReplayServer::ReplayServer(const std::vector<CorpusFeed>& feeds,
+	const ReplayServerOptions& options)
+	: options(options)
+	, listen_fd(-1)
+	, port(0)
+	, stopping(false)
+	, rng(options.seed)
+{
+	for (const auto& feed : feeds) {
+		Resource resource;
+		resource.content_type = feed.content_type;
+		resource.body = feed.body;
+		if (options.gzip) {
+			resource.gzipped_body = gzip(feed.body);
+		}
+		resource.etag = strprintf::fmt("\"%x\"",
+				static_cast<unsigned int>(
+					std::hash<std::string>()(feed.body)));
+		resource.last_modified = http_date(feed.last_modified);
+		resource.last_modified_time = feed.last_modified;
+		resources[feed.path] = std::move(resource);
+	}
+}
+
+ReplayServer::~ReplayServer()
+{
+	stop();
+}
+
+void ReplayServer::start(uint16_t requested_port)
+{
+	listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_fd == -1) {
+		std::cerr << "ReplayServer: socket() failed: " << strerror(errno)
+			<< std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+
+	const int yes = 1;
+	::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(requested_port);
+	if (::bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr),
+			sizeof(addr)) == -1 ||
+		::listen(listen_fd, SOMAXCONN) == -1) {
+		std::cerr << "ReplayServer: can't listen on port "
+			<< requested_port << ": " << strerror(errno) << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+
+	socklen_t addr_len = sizeof(addr);
+	::getsockname(listen_fd, reinterpret_cast<struct sockaddr*>(&addr),
+		&addr_len);
+	port = ntohs(addr.sin_port);
+
+	stopping = false;
+	acceptor = std::thread(&ReplayServer::accept_connections, this);
+}
+
+void ReplayServer::stop()
+{
+	if (!acceptor.joinable()) {
+		return;
+	}
+
+	stopping = true;
+	acceptor.join();
+
+	std::vector<std::thread> threads;
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		threads.swap(connections);
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	::close(listen_fd);
+	listen_fd = -1;
+}
+
+std::string ReplayServer::url(const CorpusFeed& feed) const
+{
+	return strprintf::fmt("http://127.0.0.1:%u%s",
+			static_cast<unsigned int>(port),
+			feed.path);
+}
+
+ReplayServer::Stats ReplayServer::get_stats() const
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return stats;
+}
+
+void ReplayServer::accept_connections()
+{
+	while (!stopping) {
+		struct pollfd pfd = {listen_fd, POLLIN, 0};
+		if (::poll(&pfd, 1, poll_interval_ms) <= 0) {
+			continue;
+		}
+
+		const int fd = ::accept(listen_fd, nullptr, nullptr);
+		if (fd == -1) {
+			continue;
+		}
+
+		std::lock_guard<std::mutex> guard(mtx);
+		connections.emplace_back(&ReplayServer::serve, this, fd);
+	}
+}
+
+void ReplayServer::serve(int fd)
+{
+	std::string buffer;
+	char chunk[16 * 1024];
+
+	// Reads until the end of the request headers. Returns false if the
+	// connection was closed, or the server is stopping.
+	const auto read_headers = [&](size_t& headers_end) {
+		while ((headers_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+			if (stopping || buffer.size() > max_header_size) {
+				return false;
+			}
+
+			struct pollfd pfd = {fd, POLLIN, 0};
+			const int ready = ::poll(&pfd, 1, poll_interval_ms);
+			if (ready == 0 || (ready < 0 && errno == EINTR)) {
+				continue;
+			} else if (ready < 0) {
+				return false;
+			}
+
+			const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+			if (n <= 0) {
+				return false;
+			}
+			buffer.append(chunk, n);
+		}
+		return true;
+	};
+
+	size_t headers_end = 0;
+	while (read_headers(headers_end)) {
+		Request request;
+		std::string version;
+
+		const std::string head = buffer.substr(0, headers_end);
+		buffer.erase(0, headers_end + 4);
+
+		size_t line_end = head.find("\r\n");
+		const std::string request_line = head.substr(0, line_end);
+		const auto first_space = request_line.find(' ');
+		const auto second_space = request_line.find(' ', first_space + 1);
+		if (first_space == std::string::npos ||
+			second_space == std::string::npos) {
+			break;
+		}
+		request.method = request_line.substr(0, first_space);
+		request.path = request_line.substr(first_space + 1,
+				second_space - first_space - 1);
+		version = request_line.substr(second_space + 1);
+
+		while (line_end != std::string::npos) {
+			const size_t start = line_end + 2;
+			line_end = head.find("\r\n", start);
+			const std::string line = head.substr(start,
+					line_end == std::string::npos
+					? std::string::npos
+					: line_end - start);
+			const auto colon = line.find(':');
+			if (colon != std::string::npos) {
+				request.headers[lowercase(line.substr(0, colon))] =
+					trim(line.substr(colon + 1));
+			}
+		}
+
+		const std::string connection = lowercase(request.headers["connection"]);
+		request.keep_alive = (version == "HTTP/1.1")
+			? (connection != "close")
+			: (connection == "keep-alive");
+
+		const auto delay = pick_delay();
+		if (delay.count() > 0) {
+			std::this_thread::sleep_for(delay);
+		}
+
+		if (!send_all(fd, respond(request)) || !request.keep_alive) {
+			break;
+		}
+	}
+
+	::close(fd);
+}
+
+std::string ReplayServer::respond(const Request& request)
+{
+	const auto count = [this](uint64_t Stats::* field, uint64_t value) {
+		std::lock_guard<std::mutex> guard(mtx);
+		stats.*field += value;
+	};
+	count(&Stats::requests, 1);
+
+	const auto finish = [&](int code,
+	const std::string& headers,
+	const std::string& body) {
+		std::string response = status_line(code);
+		response += headers;
+		response += strprintf::fmt("Content-Length: %u\r\n",
+				static_cast<unsigned int>(body.size()));
+		if (!request.keep_alive) {
+			response += "Connection: close\r\n";
+		}
+		response += "\r\n";
+		if (request.method != "HEAD") {
+			response += body;
+		}
+		count(&Stats::bytes_sent, response.size());
+		return response;
+	};
+
+	if (request.method != "GET" && request.method != "HEAD") {
+		return finish(405, "Allow: GET, HEAD\r\n", "");
+	}
+
+	const auto it = resources.find(request.path);
+	if (it == resources.end()) {
+		return finish(404, "Content-Type: text/plain\r\n", "Not Found\n");
+	}
+	const Resource& resource = it->second;
+
+	if (should_fail()) {
+		count(&Stats::errors, 1);
+		return finish(503, "Content-Type: text/plain\r\nRetry-After: 60\r\n",
+				"Service Unavailable\n");
+	}
+
+	std::string headers;
+	if (options.conditional) {
+		headers += "ETag: " + resource.etag + "\r\n";
+		headers += "Last-Modified: " + resource.last_modified + "\r\n";
+
+		const auto etag = request.headers.find("if-none-match");
+		const auto since = request.headers.find("if-modified-since");
+		bool not_modified = false;
+		if (etag != request.headers.end()) {
+			not_modified = (etag->second == resource.etag);
+		} else if (since != request.headers.end()) {
+			const time_t t = parse_http_date(since->second);
+			not_modified = (t != -1 && t >= resource.last_modified_time);
+		}
+		if (not_modified) {
+			count(&Stats::not_modified, 1);
+			return finish(304, headers, "");
+		}
+	}
+
+	headers += "Content-Type: " + resource.content_type + "\r\n";
+	if (options.gzip) {
+		headers += "Vary: Accept-Encoding\r\n";
+		const auto accept = request.headers.find("accept-encoding");
+		if (accept != request.headers.end() &&
+			accept->second.find("gzip") != std::string::npos) {
+			headers += "Content-Encoding: gzip\r\n";
+			return finish(200, headers, resource.gzipped_body);
+		}
+	}
+	return finish(200, headers, resource.body);
+}
+
+bool ReplayServer::should_fail()
+{
+	if (options.error_rate <= 0) {
+		return false;
+	}
+	std::lock_guard<std::mutex> guard(mtx);
+	return std::uniform_real_distribution<double>(0, 1)(rng) <
+		options.error_rate;
+}
+
+std::chrono::milliseconds ReplayServer::pick_delay()
+{
+	unsigned int delay = options.latency_ms;
+	if (options.jitter_ms > 0) {
+		std::lock_guard<std::mutex> guard(mtx);
+		delay += rng() % (options.jitter_ms + 1);
+	}
+	return std::chrono::milliseconds(delay);
+}
+
+} // namespace BenchHelpers
@@ -0,0 +1,111 @@
+#ifndef NEWSBOAT_BENCH_REPLAYSERVER_H_
+#define NEWSBOAT_BENCH_REPLAYSERVER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench-helpers.h"
+
+namespace BenchHelpers {
+
+struct ReplayServerOptions {
+	/// Delay before each response, in milliseconds
+	unsigned int latency_ms = 0;
+	/// Up to this many milliseconds are randomly added to the latency
+	unsigned int jitter_ms = 0;
+	/// Fraction of requests (0 to 1) answered with "503 Service
+	/// Unavailable"
+	double error_rate = 0;
+	/// Send ETag and Last-Modified, and answer conditional requests with
+	/// "304 Not Modified"
+	bool conditional = true;
+	/// Compress responses if the client accepts gzip
+	bool gzip = true;
+	/// Seed for latency jitter and errors
+	uint32_t seed = 42;
+};
+
+/// \brief HTTP/1.1 server on the loopback interface that serves a fixed
+/// set of feeds, so that reloads can be measured without the network.
+///
+/// Every connection is handled by a thread of its own, and connections
+/// are kept alive, like a typical web server would do.
+class ReplayServer {
+public:
+	struct Stats {
+		uint64_t requests = 0;
+		uint64_t not_modified = 0;
+		uint64_t errors = 0;
+		uint64_t bytes_sent = 0;
+	};
+
+	ReplayServer(const std::vector<CorpusFeed>& feeds,
+		const ReplayServerOptions& options);
+	~ReplayServer();
+	ReplayServer(const ReplayServer&) = delete;
+	ReplayServer& operator=(const ReplayServer&) = delete;
+
+	/// \brief Starts listening on 127.0.0.1:\a port, or on a random free
+	/// port if \a port is 0. Exits the program on failure.
+	void start(uint16_t port = 0);
+
+	/// \brief Closes all connections and waits for their threads.
+	void stop();
+
+	uint16_t get_port() const
+	{
+		return port;
+	}
+
+	/// \brief Returns the URL at which \a feed is served.
+	std::string url(const CorpusFeed& feed) const;
+
+	Stats get_stats() const;
+
+private:
+	struct Resource {
+		std::string content_type;
+		std::string body;
+		std::string gzipped_body;
+		std::string etag;
+		std::string last_modified;
+		time_t last_modified_time;
+	};
+
+	struct Request {
+		std::string method;
+		std::string path;
+		std::map<std::string, std::string> headers;
+		bool keep_alive;
+	};
+
+	void accept_connections();
+	void serve(int fd);
+	std::string respond(const Request& request);
+	bool should_fail();
+	std::chrono::milliseconds pick_delay();
+
+	const ReplayServerOptions options;
+	std::map<std::string, Resource> resources;
+
+	int listen_fd;
+	uint16_t port;
+	std::atomic<bool> stopping;
+	std::thread acceptor;
+
+	mutable std::mutex mtx;
+	std::vector<std::thread> connections;
+	std::mt19937 rng;
+	Stats stats;
+};
+
+} // namespace BenchHelpers
+
+#endif /* NEWSBOAT_BENCH_REPLAYSERVER_H_ */
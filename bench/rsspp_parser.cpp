@@ -0,0 +1,100 @@
+#include "rss/parser.h"
+
+#include "bench.h"
+#include "bench-helpers.h"
+
+using namespace BenchHelpers;
+
+namespace {
+
+void parse(Bench::State& state, const std::string& document)
+{
+	rsspp::Parser parser;
+	state.set_bytes_per_iteration(document.size());
+	while (state.keep_running()) {
+		const auto feed = parser.parse_buffer(document);
+		Bench::do_not_optimize(feed);
+	}
+}
+
+void parse_synthetic(Bench::State& state,
+	FeedFormat format,
+	Encoding encoding = Encoding::UTF_8)
+{
+	const auto document = feed_document(format, 100, 42, encoding);
+	parse(state, document);
+}
+
+void parse_recorded(Bench::State& state, const std::string& path)
+{
+	const auto document = read_file(path);
+	parse(state, document);
+}
+
+Bench::Registration rss091("parse_buffer/rss091/synthetic-100",
+[](Bench::State& state)
+{
+	parse_synthetic(state, FeedFormat::RSS_0_91);
+});
+
+Bench::Registration rss092("parse_buffer/rss092/synthetic-100",
+[](Bench::State& state)
+{
+	parse_synthetic(state, FeedFormat::RSS_0_92);
+});
+
+Bench::Registration rss10("parse_buffer/rss10/synthetic-100",
+[](Bench::State& state)
+{
+	parse_synthetic(state, FeedFormat::RSS_1_0);
+});
+
+Bench::Registration rss20("parse_buffer/rss20/synthetic-100",
+[](Bench::State& state)
+{
+	parse_synthetic(state, FeedFormat::RSS_2_0);
+});
+
+Bench::Registration rss20_latin1("parse_buffer/rss20/synthetic-100-latin1",
+[](Bench::State& state)
+{
+	parse_synthetic(state, FeedFormat::RSS_2_0, Encoding::ISO_8859_1);
+});
+
+Bench::Registration atom10("parse_buffer/atom10/synthetic-100",
+[](Bench::State& state)
+{
+	parse_synthetic(state, FeedFormat::ATOM_1_0);
+});
+
+Bench::Registration rss091_recorded("parse_buffer/rss091/recorded",
+[](Bench::State& state)
+{
+	parse_recorded(state, "test/data/rss091_1.xml");
+});
+
+Bench::Registration rss092_recorded("parse_buffer/rss092/recorded",
+[](Bench::State& state)
+{
+	parse_recorded(state, "test/data/rss092_1.xml");
+});
+
+Bench::Registration rss10_recorded("parse_buffer/rss10/recorded",
+[](Bench::State& state)
+{
+	parse_recorded(state, "test/data/rss10_1.xml");
+});
+
+Bench::Registration rss20_recorded("parse_buffer/rss20/recorded",
+[](Bench::State& state)
+{
+	parse_recorded(state, "test/data/rss.xml");
+});
+
+Bench::Registration atom10_recorded("parse_buffer/atom10/recorded",
+[](Bench::State& state)
+{
+	parse_recorded(state, "test/data/atom10_1.xml");
+});
+
+} // namespace
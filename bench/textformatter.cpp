@@ -0,0 +1,38 @@
+#include "textformatter.h"
+
+#include "bench.h"
+#include "bench-helpers.h"
+
+using namespace newsboat;
+
+namespace {
+
+void wrap(Bench::State& state, unsigned int words, const std::string& indent)
+{
+	auto rng = BenchHelpers::make_rng();
+	const auto line = indent + BenchHelpers::prose(rng, words);
+
+	state.set_bytes_per_iteration(line.size());
+	while (state.keep_running()) {
+		const auto pieces = wrap_line(line, 80);
+		Bench::do_not_optimize(pieces);
+	}
+}
+
+Bench::Registration short_line("wrap_line/20-words", [](Bench::State& state)
+{
+	wrap(state, 20, "");
+});
+
+Bench::Registration paragraph("wrap_line/500-words", [](Bench::State& state)
+{
+	wrap(state, 500, "");
+});
+
+Bench::Registration indented("wrap_line/500-words-indented",
+[](Bench::State& state)
+{
+	wrap(state, 500, "        ");
+});
+
+} // namespace
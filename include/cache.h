@@ -7,6 +7,8 @@
 #include <unordered_set>
 
 #include "configcontainer.h"
+#include "feedreloadstats.h"
+#include "remotechange.h"
 
 namespace newsboat {
 
@@ -43,10 +45,21 @@ class Cache {
 public:
 	Cache(const std::string& cachefile, ConfigContainer* c);
 	~Cache();
+	/// \brief Writes \a feed and its items to the database.
+	///
+	/// If \a stats is not null, fills in its `items_new`, `items_changed`
+	/// and `db_write_us` fields.
 	void externalize_rssfeed(std::shared_ptr<RssFeed> feed,
-		bool reset_unread);
+		bool reset_unread,
+		FeedReloadStats* stats = nullptr);
 	std::shared_ptr<RssFeed> internalize_rssfeed(std::string rssurl,
 		RssIgnores* ign);
+	/// \brief Loads feed's title, link and direction, but none of its
+	/// items.
+	///
+	/// Useful for modes that never look at articles, like OPML export.
+	std::shared_ptr<RssFeed> internalize_rssfeed_without_items(
+		const std::string& rssurl);
 	void update_rssitem_unread_and_enqueued(std::shared_ptr<RssItem> item,
 		const std::string& feedurl);
 	void update_rssitem_unread_and_enqueued(RssItem* item,
@@ -68,22 +81,67 @@ public:
 	void update_lastmodified(const std::string& uri,
 		time_t t,
 		const std::string& etag);
+	/// \brief Returns when \a feedurl was last synced with a remote API
+	/// that can fetch deltas, or 0 if it never was.
+	///
+	/// Tiny Tiny RSS and Nextcloud News store their own sync position here
+	/// instead of a time (the newest article ID and last modification,
+	/// respectively).
+	time_t fetch_sync_watermark(const std::string& feedurl);
+	void update_sync_watermark(const std::string& feedurl, time_t t);
+	/// \brief Returns the newest sync watermark among \a feedurls, or 0 if
+	/// none of them has one.
+	time_t fetch_newest_sync_watermark(
+		const std::vector<std::string>& feedurls);
+	/// \brief Applies the remote API's read states to the articles of
+	/// \a feedurl: ones in \a unread_guids are marked unread and, if the
+	/// list is \a complete, all others are marked read.
+	///
+	/// Articles with changes that weren't sent to the API yet are left
+	/// alone.
+	void update_unread_from_remote(const std::string& feedurl,
+		const std::unordered_set<std::string>& unread_guids,
+		bool complete);
 	void mark_item_deleted(const std::string& guid, bool b);
 	void mark_feed_items_deleted(const std::string& feedurl);
 	void remove_old_deleted_items(RssFeed* feed);
 	void mark_items_read_by_guid(const std::vector<std::string>& guids);
 	std::vector<std::string> get_read_item_guids();
+	/// \brief Returns the GUIDs of all stored articles of \a feedurl.
+	std::vector<std::string> get_item_guids(const std::string& feedurl);
 	void fetch_descriptions(RssFeed* feed);
 
+	/// \brief Stores \a stats as the latest reload of `stats.rssurl`,
+	/// replacing the previous record for that feed.
+	void record_reload_stats(const FeedReloadStats& stats);
+	/// \brief Returns stored reload records, slowest first.
+	std::vector<FeedReloadStats> get_reload_stats(unsigned int limit);
+
+	/// \brief Appends \a change to the queue of changes that still have to
+	/// be sent to the remote API.
+	void queue_remote_change(const RemoteChange& change);
+	/// \brief Returns up to \a limit of the oldest queued remote changes.
+	std::vector<RemoteChange> get_remote_changes(unsigned int limit);
+	/// \brief Removes changes with given IDs from the queue.
+	void remove_remote_changes(const std::vector<int64_t>& ids);
+	/// \brief Counts one more failed attempt for changes with given IDs,
+	/// and removes those that failed \a max_attempts times. Returns the
+	/// number of changes removed.
+	unsigned int fail_remote_changes(const std::vector<int64_t>& ids,
+		unsigned int max_attempts);
+
 private:
 	SchemaVersion get_schema_version();
 	void populate_tables();
 	void set_pragmas();
 	void delete_item(const std::shared_ptr<RssItem>& item);
 	void clean_old_articles();
-	void update_rssitem_unlocked(std::shared_ptr<RssItem> item,
+	enum class ItemUpdate { INSERTED, CHANGED, UNCHANGED };
+	ItemUpdate update_rssitem_unlocked(std::shared_ptr<RssItem> item,
 		const std::string& feedurl,
 		bool reset_unread);
+	void update_sync_watermark_unlocked(const std::string& feedurl,
+		time_t t);
 
 	std::string prepare_query(const std::string& format);
 	template<typename... Args>
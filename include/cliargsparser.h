@@ -20,6 +20,10 @@ public:
 
 	bool do_vacuum() const;
 
+	/// If `do_daemon()` is `true`, Newsboat should run without UI, reloading
+	/// feeds periodically and taking commands from a control socket.
+	bool do_daemon() const;
+
 	std::string importfile() const;
 
 	/// If `do_read_import()` is `true`, Newsboat should import read articles
@@ -1,8 +1,10 @@
 #ifndef NEWSBOAT_CONFIGCONTAINER_H_
 #define NEWSBOAT_CONFIGCONTAINER_H_
 
-#include <unordered_set>
+#include <memory>
 #include <mutex>
+#include <unordered_set>
+#include <vector>
 
 #include "configparser.h"
 
@@ -16,7 +18,8 @@ enum class FeedSortMethod {
 	TITLE,
 	ARTICLE_COUNT,
 	UNREAD_ARTICLE_COUNT,
-	LAST_UPDATED
+	LAST_UPDATED,
+	RELOAD_TIME
 };
 
 enum class ArtSortMethod { TITLE, FLAGS, AUTHOR, LINK, GUID, DATE, RANDOM };
@@ -72,6 +75,68 @@ struct ConfigData {
 	bool multi_option;
 };
 
+/// \brief Settings that are read inside per-feed and per-article loops.
+///
+/// Their values are available through ConfigSnapshot, which doesn't lock
+/// and doesn't parse. Keep in sync with `snapshot_keys` in
+/// configcontainer.cpp.
+enum class ConfigKey {
+	COOKIE_CACHE,
+	DOWNLOAD_RETRIES,
+	DOWNLOAD_TIMEOUT,
+	GOTO_NEXT_FEED,
+	IGNORE_MODE,
+	KEEP_ARTICLES_DAYS,
+	MAX_ITEMS,
+	PROXY,
+	PROXY_AUTH,
+	PROXY_AUTH_METHOD,
+	PROXY_TYPE,
+	SHOW_READ_ARTICLES,
+	SHOW_READ_FEEDS,
+	SSL_VERIFYHOST,
+	SSL_VERIFYPEER,
+	TEXT_WIDTH,
+	USE_PROXY
+};
+
+/// \brief Immutable copy of the ConfigKey settings, with their values
+/// already converted to the types callers need.
+///
+/// ConfigContainer publishes a new snapshot whenever a setting changes, so a
+/// snapshot obtained at the start of a loop stays consistent throughout it.
+class ConfigSnapshot {
+public:
+	/// \brief Same as ConfigContainer::get_configvalue().
+	const std::string& get(ConfigKey key) const
+	{
+		return values[static_cast<size_t>(key)].str;
+	}
+
+	/// \brief Same as ConfigContainer::get_configvalue_as_int().
+	int get_int(ConfigKey key) const
+	{
+		return values[static_cast<size_t>(key)].as_int;
+	}
+
+	/// \brief Same as ConfigContainer::get_configvalue_as_bool().
+	bool get_bool(ConfigKey key) const
+	{
+		return values[static_cast<size_t>(key)].as_bool;
+	}
+
+private:
+	friend class ConfigContainer;
+
+	struct Value {
+		std::string str;
+		int as_int;
+		bool as_bool;
+	};
+
+	std::vector<Value> values;
+};
+
 class ConfigContainer : public ConfigActionHandler {
 public:
 	ConfigContainer();
@@ -91,12 +156,25 @@ public:
 	FeedSortStrategy get_feed_sort_strategy();
 	ArticleSortStrategy get_article_sort_strategy();
 
+	/// \brief Returns current values of the ConfigKey settings.
+	///
+	/// Doesn't take the lock that the other getters do, so it's cheap
+	/// enough to call from any thread as often as needed.
+	std::shared_ptr<const ConfigSnapshot> snapshot() const;
+
 	static const std::string PARTIAL_FILE_SUFFIX;
 
 private:
 	std::map<std::string, ConfigData> config_data;
 	std::recursive_mutex config_data_mtx;
 
+	/// Only accessed through std::atomic_load() and std::atomic_store().
+	std::shared_ptr<const ConfigSnapshot> current_snapshot;
+
+	/// Re-reads the ConfigKey settings and publishes them as a new
+	/// snapshot. Must be called with config_data_mtx held.
+	void publish_snapshot();
+
 	bool is_bool(const std::string& s);
 	bool is_int(const std::string& s);
 };
@@ -1,6 +1,7 @@
 #ifndef NEWSBOAT_CONTROLLER_H_
 #define NEWSBOAT_CONTROLLER_H_
 
+#include <functional>
 #include <libxml/tree.h>
 
 #include "cache.h"
@@ -14,6 +15,7 @@
 #include "regexmanager.h"
 #include "reloader.h"
 #include "remoteapi.h"
+#include "remotesyncqueue.h"
 #include "rssignores.h"
 #include "urlreader.h"
 
@@ -66,6 +68,16 @@ public:
 	void write_item(std::shared_ptr<RssItem> item,
 		const std::string& filename);
 	void write_item(std::shared_ptr<RssItem> item, std::ostream& ostr);
+	/// \brief Writes each of \a items into the file with the same index in
+	/// \a filenames, rendering the items in parallel.
+	///
+	/// \a progress is called with the number of items written so far.
+	/// Returns the names of the files that couldn't be written, including
+	/// those of items that couldn't be rendered.
+	std::vector<std::string> write_items(
+		const std::vector<std::shared_ptr<RssItem>>& items,
+		const std::vector<std::string>& filenames,
+		const std::function<void(size_t)>& progress);
 	std::string write_temporary_item(std::shared_ptr<RssItem> item);
 
 	void update_config();
@@ -84,7 +96,8 @@ public:
 	void replace_feed(std::shared_ptr<RssFeed> oldfeed,
 		std::shared_ptr<RssFeed> newfeed,
 		unsigned int pos,
-		bool unattended);
+		bool unattended,
+		FeedReloadStats* stats = nullptr);
 
 	RssIgnores* get_ignores()
 	{
@@ -97,11 +110,32 @@ public:
 	}
 
 private:
+	/// \brief How much of the cache has to be loaded before a mode can run.
+	enum class CacheData {
+		/// Mode works on the database directly
+		NOTHING,
+		/// Mode needs the list of feeds, but not their articles
+		FEEDS,
+		/// Mode needs feeds along with their articles
+		ARTICLES
+	};
+
+	CacheData needed_cache_data(const CliArgsParser& args);
+
 	void import_opml(const std::string& filename);
 	void export_opml();
 	void rec_find_rss_outlines(xmlNode* node, std::string tag);
 	int execute_commands(const std::vector<std::string>& cmds);
 
+	/// \brief Prints the feeds whose last reload took the longest, along
+	/// with what they transferred.
+	void print_slowest_feeds();
+
+	/// \brief Passes \a cmds to a daemon that holds the cache, printing
+	/// its replies. Fails if no daemon is running.
+	int execute_commands_in_daemon(const std::vector<std::string>& cmds);
+	std::string control_socket_path() const;
+
 	void import_read_information(const std::string& readinfofile);
 	void export_read_information(const std::string& readinfofile);
 
@@ -118,6 +152,8 @@ private:
 	ColorManager colorman;
 	RegexManager rxman;
 	RemoteApi* api;
+	/// Sends changes to `api`; null for local and OPML feeds
+	std::unique_ptr<RemoteSyncQueue> remote_sync;
 	std::mutex feeds_mutex;
 
 	std::unique_ptr<FsLock> fslock;
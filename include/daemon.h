@@ -0,0 +1,74 @@
+#ifndef NEWSBOAT_DAEMON_H_
+#define NEWSBOAT_DAEMON_H_
+
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace newsboat {
+
+class ConfigContainer;
+class Controller;
+class Reloader;
+
+/// \brief Runs Newsboat without UI: keeps feeds in memory, reloads them
+/// periodically and executes commands received over a UNIX socket.
+///
+/// The protocol is line-based: the client sends one command per line, and
+/// the daemon answers each of them with a single line that starts with "OK"
+/// or "ERR".
+class Daemon {
+public:
+	/// \brief Feeds are reloaded through \a reloader, which has to belong
+	/// to \a ctrl.
+	Daemon(Controller* ctrl,
+		Reloader* reloader,
+		ConfigContainer* cfg,
+		const std::string& socket_path);
+	~Daemon();
+
+	/// \brief Serves requests until "quit" command, SIGINT or SIGTERM is
+	/// received. Returns process exit code.
+	int run();
+
+	/// \brief Executes \a command and returns the reply, without the
+	/// trailing newline.
+	std::string execute(const std::string& command);
+
+	/// \brief Sends \a commands to the daemon listening on \a socket_path,
+	/// and puts its replies into \a replies.
+	///
+	/// Returns false if no daemon is listening on \a socket_path.
+	static bool send_commands(const std::string& socket_path,
+		const std::vector<std::string>& commands,
+		std::vector<std::string>& replies);
+
+private:
+	bool open_socket();
+	void handle_connection(int fd);
+	void reload_periodically();
+	bool reload_all();
+	bool reload_feed(const std::string& url);
+	std::string stats();
+	void request_quit();
+
+	Controller* ctrl;
+	Reloader* reloader;
+	ConfigContainer* cfg;
+	const std::string socket_path;
+	int listen_fd;
+
+	std::mutex mtx;
+	std::condition_variable state_changed;
+	bool quitting;
+	bool reloading;
+	time_t last_reload;
+	std::set<int> connections;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_DAEMON_H_ */
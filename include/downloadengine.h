@@ -0,0 +1,267 @@
+#ifndef PODBOAT_DOWNLOADENGINE_H_
+#define PODBOAT_DOWNLOADENGINE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <curl/curl.h>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "configcontainer.h"
+#include "download.h"
+
+namespace podboat {
+
+class EnclosureIndex;
+
+/// \brief Runs all of podboat's downloads on a single thread, multiplexed
+/// with curl_multi.
+///
+/// Transfers share curl's connection and DNS caches, so episodes from the
+/// same host reuse connections. The engine itself makes sure that no more
+/// than get_max_parallel() downloads run at once, and splits the
+/// bandwidth limit between all running transfers.
+///
+/// Large files can be fetched as several byte ranges at once. Their progress
+/// is kept in a `.segments` file next to the partial file, so that each
+/// range resumes where it stopped.
+class DownloadEngine {
+public:
+	enum class Priority {
+		/// Started in the order they were enqueued, whenever fewer than
+		/// get_max_parallel() downloads are running
+		NORMAL,
+		/// Started right away, regardless of the limit; used when the
+		/// user asks for a particular download
+		HIGH
+	};
+
+	/// \brief Finished downloads are recorded in \a index, if given. With
+	/// `podcast-deduplicate` enabled, files already in the index are
+	/// hard-linked instead of being downloaded again.
+	explicit DownloadEngine(newsboat::ConfigContainer* cfg,
+		EnclosureIndex* index = nullptr);
+	~DownloadEngine();
+	DownloadEngine(const DownloadEngine&) = delete;
+	DownloadEngine& operator=(const DownloadEngine&) = delete;
+
+	/// \brief Schedules \a dl for download. Does nothing if it's already
+	/// running, or already waiting with the same or a higher priority.
+	///
+	/// \a dl has to stay at the same address until it's finished, or until
+	/// clear_pending() is called.
+	void enqueue(Download* dl, Priority priority = Priority::NORMAL);
+
+	/// \brief Forgets downloads that didn't start yet. Once this returns,
+	/// each Download is either still queued, or already marked as
+	/// downloading.
+	void clear_pending();
+	/// \brief Like clear_pending(), but only if no download is running;
+	/// otherwise, returns false and leaves everything as it is. After this
+	/// returned true, the engine doesn't touch any Download until the next
+	/// enqueue().
+	bool clear_pending_if_idle();
+
+	void set_max_parallel(unsigned int max);
+	unsigned int get_max_parallel() const
+	{
+		return max_parallel;
+	}
+
+	/// \brief Limits the total speed of all downloads, in bytes per
+	/// second. 0 means no limit.
+	void set_bandwidth_limit(uint64_t bytes_per_second);
+
+	/// \brief Splits downloads of large files into up to \a segments byte
+	/// ranges that are fetched at the same time, if the server supports
+	/// range requests. 1 turns this off.
+	void set_max_segments(unsigned int segments);
+
+	// only public for unit testing purposes:
+	struct Pending {
+		Download* dl;
+		Priority priority;
+		uint64_t sequence;
+	};
+	/// Puts higher priorities first, and otherwise the order in which
+	/// downloads were enqueued
+	struct PendingOrder {
+		bool operator()(const Pending& a, const Pending& b) const
+		{
+			if (a.priority != b.priority) {
+				return a.priority < b.priority;
+			}
+			return a.sequence > b.sequence;
+		}
+	};
+
+	/// \brief Returns the bandwidth budget, in bytes, after \a budget was
+	/// refilled for \a elapsed seconds at \a limit bytes per second. The
+	/// result is never more than a second's worth; without a limit, it's
+	/// 0.
+	static int64_t refill_budget(int64_t budget,
+		uint64_t limit,
+		double elapsed);
+
+	/// Byte range [start, end) of the file. `end` is UNKNOWN_END while the
+	/// server didn't tell the size.
+	struct Segment {
+		uint64_t start;
+		uint64_t end;
+		/// Bytes of this segment that are already in the file
+		uint64_t done;
+	};
+
+	/// \brief Splits a file of \a size bytes into up to \a max_segments
+	/// back-to-back segments, each at least a few megabytes long and
+	/// starting at a multiple of the write buffer size. A file that isn't
+	/// worth splitting gets a single segment.
+	static std::vector<Segment> split_segments(uint64_t size,
+		unsigned int max_segments);
+	/// \brief Reads the contents of a `.segments` state file, as written
+	/// by write_state(), into \a segments. Returns false unless it's a
+	/// complete, non-empty list of back-to-back segments starting at 0.
+	static bool read_state(std::istream& in, std::vector<Segment>& segments);
+	static void write_state(std::ostream& out,
+		const std::vector<Segment>& segments);
+
+private:
+
+	/// A download in progress, fetched by one or more transfers
+	struct Job {
+		Download* dl;
+		/// URL the segments are fetched from; after a split, that's
+		/// where the first transfer got redirected to
+		std::string url;
+		std::string partial_filename;
+		int fd;
+		bool resumed;
+		std::vector<Segment> segments;
+		/// Size of the whole file, or 0 if unknown
+		uint64_t size;
+		/// Bytes that were already downloaded when the job started
+		uint64_t initial_offset;
+		/// Bytes received by this job, not counting the resumed part
+		uint64_t received;
+		/// Number of transfers still running
+		unsigned int transfers;
+		/// The first transfer found out it's worth splitting the file,
+		/// but the other segments aren't started yet
+		bool split_pending;
+		bool failed;
+		/// The file turned out to be downloaded already, and is linked
+		/// to its new name; the transfers are stopped
+		bool duplicate;
+		/// URL of the response with the file, after any redirects
+		std::string effective_url;
+		/// Strong ETag of the file, if the server sent one
+		std::string etag;
+		/// Size curl reported for a download without a Content-Length
+		/// header, e.g. a chunked one; only used for progress
+		double reported_size;
+		std::chrono::steady_clock::time_point started_at;
+		std::chrono::steady_clock::time_point state_saved_at;
+		std::chrono::steady_clock::time_point sampled_at;
+	};
+
+	struct Transfer {
+		DownloadEngine* engine;
+		Job* job;
+		/// Index into job->segments
+		size_t segment;
+		CURL* handle;
+		bool paused;
+		/// Headers of the current response
+		bool accept_ranges;
+		uint64_t content_length;
+		/// The body is compressed or otherwise encoded, so its length and
+		/// byte ranges don't describe the file
+		bool encoded;
+		std::string etag;
+		/// Received data that isn't written yet. It belongs right before
+		/// the segment's `done` mark.
+		std::vector<char> buffer;
+	};
+
+	static size_t write_callback(char* data, size_t size, size_t nmemb,
+		void* userp);
+	static size_t header_callback(char* data, size_t size, size_t nitems,
+		void* userp);
+#if LIBCURL_VERSION_NUM >= 0x072000
+	// CURLOPT_XFERINFOFUNCTION is only available since curl 7.32.0
+	using ProgressValue = curl_off_t;
+#else
+	using ProgressValue = double;
+#endif
+	static int progress_callback(void* clientp,
+		ProgressValue dltotal,
+		ProgressValue dlnow,
+		ProgressValue ultotal,
+		ProgressValue ulnow);
+
+	void run();
+	/// \brief Moves as many pending downloads into transfers as the limit
+	/// allows. Returns false if the engine is stopping.
+	bool start_pending();
+	void start(Download* dl);
+	void start_transfer(Job* job, size_t segment);
+	void headers_received(Transfer* transfer);
+	/// \brief Looks up the job's file in the index by its effective URL or
+	/// ETag and \a size, and links it if found.
+	bool find_duplicate(Job* job, uint64_t size);
+	void split(Job* job);
+	void finish(Transfer* transfer, CURLcode result);
+	void finalize(Job* job);
+	/// \brief Records a finished download in the index, first replacing
+	/// it with a link if the index already has a file with that content.
+	void remember(Job* job);
+	void remove(Transfer* transfer);
+	/// \brief Writes out the transfer's buffer. On failure, the buffered
+	/// bytes are dropped and the job is marked as failed.
+	bool flush(Transfer* transfer);
+	void update_progress(Job* job);
+	void refill_bandwidth();
+	/// \brief Whether \a job's segments have known ends, so its progress
+	/// is kept in a state file.
+	bool has_state(const Job* job) const;
+	bool load_state(Job* job);
+	void save_state(Job* job);
+
+	newsboat::ConfigContainer* cfg;
+	EnclosureIndex* const index;
+	const bool deduplicate;
+	CURLM* multi;
+	std::thread worker;
+
+	// Shared between the worker and the callers of the public methods
+	std::mutex mtx;
+	std::condition_variable wakeup;
+	std::priority_queue<Pending, std::vector<Pending>, PendingOrder> pending;
+	/// Downloads that are pending or running. For pending ones, this is
+	/// the sequence number of their entry in `pending`; older entries were
+	/// superseded by a higher priority and are skipped.
+	std::unordered_map<Download*, uint64_t> scheduled;
+	uint64_t next_sequence;
+	bool stopping;
+	std::atomic<unsigned int> max_parallel;
+	std::atomic<uint64_t> bandwidth_limit;
+	std::atomic<unsigned int> max_segments;
+
+	// Only touched by the worker
+	std::vector<std::unique_ptr<Job>> jobs;
+	std::vector<std::unique_ptr<Transfer>> transfers;
+	int64_t bandwidth_budget;
+	std::chrono::steady_clock::time_point budget_refilled_at;
+};
+
+} // namespace podboat
+
+#endif /* PODBOAT_DOWNLOADENGINE_H_ */
@@ -0,0 +1,76 @@
+#ifndef PODBOAT_ENCLOSUREINDEX_H_
+#define PODBOAT_ENCLOSUREINDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace podboat {
+
+/// \brief Remembers which enclosures podboat downloaded, and where to.
+///
+/// The same episode often shows up in several feeds, under different URLs
+/// and with different filenames. The index lets the download engine
+/// recognise such duplicates by canonical URL, by ETag and size, or by
+/// content, and hard-link the existing file instead of fetching it again.
+///
+/// The index is stored in a text file, one URL per line, similar to the
+/// queue file. Entries whose file is gone are ignored and dropped on load.
+class EnclosureIndex {
+public:
+	explicit EnclosureIndex(const std::string& index_file);
+
+	/// \brief Reads the index file, and rewrites it if some of its entries
+	/// are stale.
+	void load();
+
+	/// \brief Returns the downloaded file for \a url, or an empty string.
+	std::string find_by_url(const std::string& url) const;
+
+	/// \brief Returns a downloaded file that was served with the strong
+	/// ETag \a etag and has \a size bytes, or an empty string.
+	///
+	/// Only files from the same host as \a url are considered: an ETag
+	/// identifies a version of a single resource, and servers that derive
+	/// it from modification time and size give unrelated files the same
+	/// one.
+	std::string find_by_etag(const std::string& url,
+		const std::string& etag,
+		uint64_t size) const;
+
+	/// \brief Returns another downloaded file with the same content as
+	/// \a filename, or an empty string.
+	std::string find_by_content(const std::string& filename) const;
+
+	/// \brief Records that \a path was downloaded from \a urls, and appends
+	/// that to the index file. \a etag may be empty.
+	void add(const std::vector<std::string>& urls,
+		const std::string& path,
+		uint64_t size,
+		const std::string& etag);
+
+	/// \brief Normalises \a url so that trivial variations of it compare
+	/// equal: the scheme, the case of the host name, default ports,
+	/// fragments and "utm_" tracking parameters are ignored.
+	static std::string canonical_url(const std::string& url);
+
+private:
+	struct Entry {
+		std::string path;
+		uint64_t size;
+		std::string etag;
+	};
+
+	/// \brief Whether the file of \a entry still exists and has the size
+	/// it had when it was downloaded.
+	static bool still_there(const Entry& entry);
+
+	std::string index_file;
+	/// Keyed by canonical URL
+	std::unordered_map<std::string, Entry> entries;
+};
+
+} // namespace podboat
+
+#endif /* PODBOAT_ENCLOSUREINDEX_H_ */
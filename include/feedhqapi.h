@@ -16,10 +16,21 @@ public:
 	std::vector<TaggedFeedUrl> get_subscribed_urls() override;
 	void add_custom_headers(curl_slist** custom_headers) override;
 	bool mark_all_read(const std::string& feedurl) override;
+	bool mark_all_read_until(const std::string& feedurl,
+		const std::string& newest,
+		int64_t marked_at) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
+	bool mark_articles_read(const std::vector<std::string>& guids,
+		bool read) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) override;
+	std::string get_delta_url(const std::string& feedurl,
+		time_t since,
+		const std::string& continuation) override;
+	bool get_unread_guids(const std::string& feedurl,
+		unsigned int limit,
+		std::unordered_set<std::string>& guids) override;
 
 private:
 	std::vector<std::string> get_tags(xmlNode* node);
@@ -29,7 +40,8 @@ private:
 		const std::string& postdata);
 	bool star_article(const std::string& guid, bool star);
 	bool share_article(const std::string& guid, bool share);
-	bool mark_article_read_with_token(const std::string& guid,
+	bool mark_articles_read_with_token(
+		const std::vector<std::string>& guids,
 		bool read,
 		const std::string& token);
 	std::string auth;
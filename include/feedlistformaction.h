@@ -1,6 +1,9 @@
 #ifndef NEWSBOAT_FEEDLISTFORMACTION_H_
 #define NEWSBOAT_FEEDLISTFORMACTION_H_
 
+#include <memory>
+
+#include "fmtstrformatter.h"
 #include "history.h"
 #include "listformaction.h"
 #include "matcher.h"
@@ -66,7 +69,7 @@ private:
 
 	std::string get_title(std::shared_ptr<RssFeed> feed);
 
-	std::string format_line(const std::string& feedlist_format,
+	std::string format_line(const CompiledFormat& feedlist_format,
 		std::shared_ptr<RssFeed> feed,
 		unsigned int pos,
 		unsigned int width);
@@ -98,6 +101,8 @@ private:
 	FilterContainer* filters;
 
 	std::string old_sort_order;
+
+	std::unique_ptr<CompiledFormat> compiled_feedlist_format;
 };
 
 } // namespace newsboat
@@ -0,0 +1,40 @@
+#ifndef NEWSBOAT_FEEDRELOADSTATS_H_
+#define NEWSBOAT_FEEDRELOADSTATS_H_
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+namespace newsboat {
+
+/// \brief Where the time went during a single reload of a feed.
+///
+/// Durations are in microseconds. Network-related fields stay zero for
+/// feeds that aren't downloaded over HTTP(S).
+struct FeedReloadStats {
+	std::string rssurl;
+	time_t reloaded_at = 0;
+	uint64_t total_us = 0;
+
+	uint64_t dns_us = 0;
+	uint64_t connect_us = 0;
+	/// Time until the first byte of the response arrived
+	uint64_t ttfb_us = 0;
+	/// Time until the whole response arrived
+	uint64_t transfer_us = 0;
+	uint64_t bytes = 0;
+	long http_status = 0;
+	bool not_modified = false;
+
+	uint64_t parse_us = 0;
+	unsigned int items_new = 0;
+	unsigned int items_changed = 0;
+	uint64_t db_write_us = 0;
+
+	/// Empty if the reload succeeded
+	std::string error;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_FEEDRELOADSTATS_H_ */
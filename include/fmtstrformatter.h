@@ -6,12 +6,36 @@
 
 namespace newsboat {
 
+/// \brief Format string that is parsed once and can then be passed to
+/// FmtStrFormatter::do_format() any number of times.
+class CompiledFormat {
+public:
+	explicit CompiledFormat(const std::string& fmt);
+	~CompiledFormat();
+
+	CompiledFormat(const CompiledFormat&) = delete;
+	CompiledFormat& operator=(const CompiledFormat&) = delete;
+
+	/// \brief Returns the format string this object was created from.
+	const std::string& format() const
+	{
+		return fmt;
+	}
+
+private:
+	friend class FmtStrFormatter;
+
+	std::string fmt;
+	void* rs_compiled = nullptr;
+};
+
 class FmtStrFormatter {
 public:
 	FmtStrFormatter();
 	~FmtStrFormatter();
 	void register_fmt(char f, const std::string& value);
 	std::string do_format(const std::string& fmt, unsigned int width = 0);
+	std::string do_format(const CompiledFormat& fmt, unsigned int width = 0);
 
 private:
 	void* rs_fmt = nullptr;
@@ -0,0 +1,42 @@
+#ifndef NEWSBOAT_INTERNEDSTRING_H_
+#define NEWSBOAT_INTERNEDSTRING_H_
+
+#include <memory>
+#include <string>
+
+namespace newsboat {
+
+/// \brief Immutable string that shares its storage with every other
+/// InternedString of the same value.
+///
+/// Meant for values that repeat across many objects, like the feed URL of
+/// an item: a hundred thousand items of a feed then hold pointers to one
+/// copy of the URL instead of a hundred thousand copies.
+class InternedString {
+public:
+	InternedString() = default;
+	explicit InternedString(const std::string& s);
+
+	const std::string& str() const
+	{
+		return value ? *value : empty_string();
+	}
+
+	bool empty() const
+	{
+		return !value;
+	}
+
+	/// \brief Number of distinct values in the pool, including ones that
+	/// aren't referenced anymore but weren't pruned yet.
+	static size_t pool_size();
+
+private:
+	static const std::string& empty_string();
+
+	std::shared_ptr<const std::string> value;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_INTERNEDSTRING_H_ */
@@ -2,10 +2,13 @@
 #define NEWSBOAT_ITEMLISTFORMACTION_H_
 
 #include <assert.h>
+#include <memory>
 
+#include "fmtstrformatter.h"
 #include "history.h"
 #include "listformaction.h"
 #include "listformatter.h"
+#include "localtimecache.h"
 #include "regexmanager.h"
 #include "view.h"
 
@@ -57,6 +60,12 @@ public:
 	bool jump_to_previous_item(bool start_with_last);
 	bool jump_to_random_unread_item();
 
+	/// \brief Returns up to \a count items that the user is likely to open
+	/// after the current one: the next item in the list, followed by the
+	/// items that jump_to_next_unread_item() would visit.
+	std::vector<std::shared_ptr<RssItem>> get_upcoming_items(
+			unsigned int count);
+
 	void handle_cmdline(const std::string& cmd) override;
 
 	void do_update_visible_items();
@@ -88,6 +97,9 @@ private:
 
 	void save_article(const std::string& filename,
 		std::shared_ptr<RssItem> item);
+	void save_articles(const std::string& directory,
+		const std::vector<std::string>& filenames,
+		const std::vector<std::shared_ptr<RssItem>>& items);
 
 	void save_filterpos();
 
@@ -121,7 +133,7 @@ private:
 
 	std::string item2formatted_line(const ItemPtrPosPair& item,
 		const unsigned int width,
-		const std::string& itemlist_format,
+		const CompiledFormat& itemlist_format,
 		const std::string& datetime_format);
 
 	unsigned int pos;
@@ -152,6 +164,8 @@ private:
 	std::vector<unsigned int> invalidated_itempos;
 
 	ListFormatter listfmt;
+	std::unique_ptr<CompiledFormat> compiled_itemlist_format;
+	LocalTimeCache pubdate_cache;
 	Cache* rsscache;
 	FilterContainer* filters;
 
@@ -0,0 +1,106 @@
+#ifndef NEWSBOAT_ITEMPRERENDERER_H_
+#define NEWSBOAT_ITEMPRERENDERER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "htmlrenderer.h"
+
+namespace newsboat {
+
+class ConfigContainer;
+class RegexManager;
+class RssItem;
+
+/// \brief Article rendered by ItemPrerenderer, ready to be put into the
+/// article view.
+struct PrerenderedItem {
+	std::string text;
+	size_t num_lines;
+	std::vector<LinkPair> links;
+};
+
+/// \brief Renders articles into STFL lists on a background thread, so that
+/// the article view can display them without delay.
+///
+/// Items are copied when they're scheduled, together with their feed's
+/// title, and the copies are detached from the feed. That way, the worker
+/// never touches objects that are shared with the UI or reload threads.
+class ItemPrerenderer {
+public:
+	explicit ItemPrerenderer(ConfigContainer& cfg);
+	~ItemPrerenderer();
+
+	/// \brief Replaces the set of items that should be rendered in the
+	/// background.
+	///
+	/// Results for items that are not in \a items are dropped. \a
+	/// text_width, \a window_width, \a rxman and \a location have the same
+	/// meaning as in item_renderer::to_stfl_list().
+	void schedule(const std::vector<std::shared_ptr<RssItem>>& items,
+		unsigned int text_width,
+		unsigned int window_width,
+		RegexManager* rxman,
+		const std::string& location);
+
+	/// \brief Moves the rendered \a item into \a result.
+	///
+	/// If \a item is being rendered right now, waits for it to finish.
+	/// Returns false if there is no up-to-date result for \a item rendered
+	/// with given widths; the caller should render it by itself then.
+	bool take(const std::shared_ptr<RssItem>& item,
+		unsigned int text_width,
+		unsigned int window_width,
+		PrerenderedItem& result);
+
+	/// \brief Drops all results and pending work.
+	///
+	/// Waits for the item that is currently being rendered, so it's safe
+	/// to modify RegexManager after this returns.
+	void clear();
+
+private:
+	struct Job {
+		std::shared_ptr<RssItem> item;
+		std::string feedtitle;
+		unsigned int text_width;
+		unsigned int window_width;
+	};
+
+	struct Result {
+		Job job;
+		PrerenderedItem rendered;
+	};
+
+	void run();
+	static bool matches(const Job& job,
+		const std::shared_ptr<RssItem>& item,
+		unsigned int text_width,
+		unsigned int window_width);
+
+	ConfigContainer& cfg;
+	RegexManager* rxman;
+	std::string location;
+
+	std::deque<Job> queue;
+	std::map<std::string, Result> results;
+	std::string in_progress;
+	/// Results of jobs started in an earlier generation are dropped
+	unsigned int generation;
+	unsigned int in_progress_generation;
+	bool stopping;
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::thread worker;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_ITEMPRERENDERER_H_ */
@@ -1,6 +1,7 @@
 #ifndef NEWSBOAT_ITEMRENDERER_H_
 #define NEWSBOAT_ITEMRENDERER_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -26,6 +27,24 @@ std::string get_feedtitle(std::shared_ptr<RssItem> item);
 std::string to_plain_text(
 	ConfigContainer& cfg,
 	std::shared_ptr<RssItem> item);
+/// \brief Like to_plain_text() above, but uses \a feedtitle instead of
+/// looking it up in the item's feed, so it can run on threads that mustn't
+/// touch the feed.
+std::string to_plain_text(
+	ConfigContainer& cfg,
+	std::shared_ptr<RssItem> item,
+	const std::string& feedtitle);
+
+/// \brief Renders \a items like to_plain_text(), spreading the work over
+/// several threads.
+///
+/// \a on_rendered is called on the calling thread once for every item, in
+/// the same order as \a items, with the item's index, its text, and whether
+/// it could be rendered at all.
+void to_plain_text_batch(
+	ConfigContainer& cfg,
+	const std::vector<std::shared_ptr<RssItem>>& items,
+	const std::function<void(size_t, const std::string&, bool)>& on_rendered);
 
 /// \brief Returns RssItem as STFL list.
 ///
@@ -43,6 +62,17 @@ std::pair<std::string, size_t> to_stfl_list(
 	RegexManager* rxman,
 	const std::string& location,
 	std::vector<LinkPair>& links);
+/// \brief Like to_stfl_list() above, but uses \a feedtitle instead of
+/// looking it up in the item's feed.
+std::pair<std::string, size_t> to_stfl_list(
+	ConfigContainer& cfg,
+	std::shared_ptr<RssItem> item,
+	const std::string& feedtitle,
+	unsigned int text_width,
+	unsigned int window_width,
+	RegexManager* rxman,
+	const std::string& location,
+	std::vector<LinkPair>& links);
 
 /// \brief Returns RssItem's text source as STFL list.
 ///
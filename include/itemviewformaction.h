@@ -3,6 +3,7 @@
 
 #include "formaction.h"
 #include "htmlrenderer.h"
+#include "itemprerenderer.h"
 #include "regexmanager.h"
 #include "textformatter.h"
 
@@ -52,6 +53,11 @@ public:
 
 	void update_percent();
 
+	/// \brief Stops rendering upcoming articles in the background. Called
+	/// when the user leaves the article view, as other dialogs can change
+	/// the highlighting rules that the renderer is using.
+	void stop_prerendering();
+
 private:
 	void process_operation(Operation op,
 		bool automatic = false,
@@ -68,6 +74,9 @@ private:
 
 	void do_search();
 
+	void prerender_upcoming_items(unsigned int text_width,
+		unsigned int window_width);
+
 	std::string guid;
 	std::shared_ptr<RssFeed> feed;
 	std::shared_ptr<RssItem> item;
@@ -79,6 +88,7 @@ private:
 	std::shared_ptr<ItemListFormAction> itemlist;
 	bool in_search;
 	Cache* rsscache;
+	ItemPrerenderer prerenderer;
 };
 
 } // namespace newsboat
@@ -0,0 +1,39 @@
+#ifndef NEWSBOAT_JSONLISTPARSER_H_
+#define NEWSBOAT_JSONLISTPARSER_H_
+
+#include <functional>
+#include <string>
+
+#include "3rd-party/json.hpp"
+
+namespace newsboat {
+
+/// \brief Parses JSON replies whose bulk is a list of items (e.g. articles),
+/// handing the items out one by one as soon as each of them is parsed.
+///
+/// The list is never held in memory as a whole: each element is built on
+/// its own, passed to the handler and freed again. The rest of the reply
+/// (status codes, error messages) is kept, with the list left empty.
+class JsonListParser {
+public:
+	using ItemHandler = std::function<void(const nlohmann::json&)>;
+
+	/// \brief Streams the elements of the array under \a key in the
+	/// reply's top-level object to \a handler.
+	JsonListParser(const std::string& key, ItemHandler handler);
+
+	/// \brief Parses \a text, putting everything but the list's elements
+	/// into \a rest. Returns false if \a text isn't valid JSON; elements
+	/// that came before the error were already handed out by then.
+	///
+	/// Exceptions thrown by the handler are passed on to the caller.
+	bool parse(const std::string& text, nlohmann::json& rest);
+
+private:
+	const std::string key;
+	const ItemHandler handler;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_JSONLISTPARSER_H_ */
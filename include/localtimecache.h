@@ -0,0 +1,33 @@
+#ifndef NEWSBOAT_LOCALTIMECACHE_H_
+#define NEWSBOAT_LOCALTIMECACHE_H_
+
+#include <ctime>
+#include <string>
+#include <unordered_map>
+
+namespace newsboat {
+
+/// \brief Memoizes utils::mt_strf_localtime() results for a single format.
+///
+/// Lists show the same timestamps on every redraw, and formatting them is a
+/// noticeable part of the cost of drawing a line.
+class LocalTimeCache {
+public:
+	/// \brief Creates a cache that holds up to \a max_entries results.
+	explicit LocalTimeCache(size_t max_entries = 10000);
+
+	/// \brief Returns \a t formatted according to \a format.
+	///
+	/// Passing a different \a format than the last time drops all cached
+	/// results.
+	const std::string& format(const std::string& format, time_t t);
+
+private:
+	size_t max_entries;
+	std::string current_format;
+	std::unordered_map<time_t, std::string> formatted;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_LOCALTIMECACHE_H_ */
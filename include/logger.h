@@ -1,34 +1,48 @@
 #ifndef NEWSBOAT_LOGGER_H_
 #define NEWSBOAT_LOGGER_H_
 
+#include <atomic>
+#include <string>
+
 #include "config.h"
 #include "strprintf.h"
 
-namespace newsboat {
-enum class Level;
-}
-
-extern "C" {
-	uint64_t rs_get_loglevel();
-	void rs_log(newsboat::Level level, const char* message);
-}
-
 namespace newsboat {
 
 // This has to be in sync with logger::Level in rust/libnewsboat/src/logger.rs
 enum class Level { NONE = 0, USERERROR, CRITICAL, ERROR, WARN, INFO, DEBUG };
 
+/* Messages are written to the logfile by a background thread: log() only
+ * formats the message and puts it into a lock-free queue, so logging from
+ * reload threads doesn't serialize them on the logfile. The level is checked
+ * before anything is formatted. USERERROR and CRITICAL messages are written
+ * synchronously, after everything that was queued before them. */
 namespace Logger {
 void set_logfile(const std::string& logfile);
 void set_user_error_logfile(const std::string& logfile);
 void set_loglevel(Level l);
 
+/// \brief Waits until the messages logged so far are written to the
+/// logfile (for up to a second).
+void flush();
+
+namespace detail {
+extern std::atomic<Level> loglevel;
+void write(Level l, std::string message);
+}
+
+/// \brief Returns true if messages at level \a l would be logged.
+inline bool enabled(Level l)
+{
+	return l == Level::USERERROR
+		|| l <= detail::loglevel.load(std::memory_order_relaxed);
+}
+
 template<typename... Args>
 void log(Level l, const std::string& format, Args... args)
 {
-	if (l == Level::USERERROR
-		|| static_cast<uint64_t>(l) <= rs_get_loglevel()) {
-		rs_log(l, strprintf::fmt(format, args...).c_str());
+	if (enabled(l)) {
+		detail::write(l, strprintf::fmt(format, args...));
 	}
 }
 };
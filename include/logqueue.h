@@ -0,0 +1,65 @@
+#ifndef NEWSBOAT_LOGQUEUE_H_
+#define NEWSBOAT_LOGQUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "logger.h"
+
+namespace newsboat {
+
+/// \brief Bounded queue of log messages with many producers and a single
+/// consumer.
+///
+/// Neither side takes a lock: a producer claims a slot with one
+/// compare-and-swap, and the consumer hands it back with a single store.
+/// When the queue is full, push() drops the message and counts it instead
+/// of waiting for the consumer.
+class LogQueue {
+public:
+	/// \brief Creates a queue that holds at least \a capacity messages
+	/// (rounded up to a power of two, and to at least 2).
+	explicit LogQueue(size_t capacity);
+	LogQueue(const LogQueue&) = delete;
+	LogQueue& operator=(const LogQueue&) = delete;
+
+	/// \brief Appends a message. Returns false, and drops the message, if
+	/// the queue is full. Safe to call from any number of threads.
+	bool push(Level level, std::string message);
+
+	/// \brief Takes the oldest message out of the queue. Returns false if
+	/// there's nothing to take. Must only be called from one thread.
+	bool pop(Level& level, std::string& message);
+
+	/// \brief Number of messages pushed since the queue was created,
+	/// including ones that are still being written into their slot.
+	uint64_t pushed() const;
+
+	/// \brief Returns the number of messages dropped since the last call,
+	/// and resets it to zero.
+	uint64_t take_dropped();
+
+	size_t capacity() const
+	{
+		return mask + 1;
+	}
+
+private:
+	struct Slot {
+		std::atomic<uint64_t> sequence;
+		Level level;
+		std::string message;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	const size_t mask;
+	std::atomic<uint64_t> enqueue_pos;
+	std::atomic<uint64_t> dequeue_pos;
+	std::atomic<uint64_t> dropped;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_LOGQUEUE_H_ */
@@ -0,0 +1,151 @@
+#ifndef NEWSBOAT_METRICS_H_
+#define NEWSBOAT_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace newsboat {
+
+/// \brief Number of times something happened.
+class Counter {
+public:
+	Counter()
+		: value(0)
+	{
+	}
+
+	void increment(uint64_t by = 1)
+	{
+		value.fetch_add(by, std::memory_order_relaxed);
+	}
+
+	uint64_t get() const
+	{
+		return value.load(std::memory_order_relaxed);
+	}
+
+	void reset()
+	{
+		value.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<uint64_t> value;
+};
+
+/// \brief A value that can go up and down, like the number of feeds.
+class Gauge {
+public:
+	Gauge()
+		: value(0)
+	{
+	}
+
+	void set(int64_t v)
+	{
+		value.store(v, std::memory_order_relaxed);
+	}
+
+	int64_t get() const
+	{
+		return value.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<int64_t> value;
+};
+
+/// \brief Distribution of durations, in microseconds.
+///
+/// Samples are sorted into power-of-two buckets: bucket `i` counts samples
+/// that are shorter than 2^i microseconds, but not shorter than 2^(i-1).
+/// Percentiles are estimated from the buckets, so they're only accurate to
+/// within a factor of two, which is enough to tell where the time goes.
+class Histogram {
+public:
+	static const size_t BUCKETS = 40;
+
+	Histogram();
+
+	void record(uint64_t microseconds);
+
+	uint64_t count() const;
+	uint64_t total() const;
+	uint64_t max() const;
+
+	/// \brief Returns an upper bound of the \a p-th percentile, where \a p
+	/// is between 0 and 100. Returns 0 if nothing was recorded yet.
+	uint64_t percentile(unsigned int p) const;
+
+	void reset();
+
+private:
+	std::atomic<uint64_t> samples;
+	std::atomic<uint64_t> sum;
+	std::atomic<uint64_t> maximum;
+	std::array<std::atomic<uint64_t>, BUCKETS> buckets;
+};
+
+/// \brief Named counters, gauges and histograms.
+///
+/// Metrics are created on first use and live as long as the registry, so
+/// callers can keep references to them; hot paths should look a metric up
+/// once and store the reference in a function-local static. Updating a
+/// metric is a couple of relaxed atomic operations.
+class MetricsRegistry {
+public:
+	/// \brief The registry that the whole program records into.
+	static MetricsRegistry& global();
+
+	Counter& counter(const std::string& name);
+	Gauge& gauge(const std::string& name);
+	Histogram& histogram(const std::string& name);
+
+	/// \brief Returns all metrics as a single-line JSON object, with
+	/// "counters", "gauges" and "histograms" keys.
+	std::string to_json();
+
+	/// \brief Zeroes all counters and histograms.
+	void reset();
+
+private:
+	std::mutex mtx;
+	std::map<std::string, std::unique_ptr<Counter>> counters;
+	std::map<std::string, std::unique_ptr<Gauge>> gauges;
+	std::map<std::string, std::unique_ptr<Histogram>> histograms;
+};
+
+/// \brief Records the lifetime of the object into a histogram.
+class ScopeTimer {
+public:
+	explicit ScopeTimer(Histogram& histogram)
+		: histogram(histogram)
+		, start(std::chrono::steady_clock::now())
+	{
+	}
+
+	~ScopeTimer()
+	{
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		histogram.record(
+			std::chrono::duration_cast<std::chrono::microseconds>(
+				elapsed).count());
+	}
+
+	ScopeTimer(const ScopeTimer&) = delete;
+	ScopeTimer& operator=(const ScopeTimer&) = delete;
+
+private:
+	Histogram& histogram;
+	const std::chrono::steady_clock::time_point start;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_METRICS_H_ */
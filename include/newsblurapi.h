@@ -20,6 +20,9 @@ public:
 	std::vector<TaggedFeedUrl> get_subscribed_urls() override;
 	void add_custom_headers(curl_slist** custom_headers) override;
 	bool mark_all_read(const std::string& feedurl) override;
+	bool mark_all_read_until(const std::string& feedurl,
+		const std::string& newest,
+		int64_t marked_at) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
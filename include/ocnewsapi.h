@@ -3,7 +3,11 @@
 
 #include <json-c/json.h>
 #include <map>
+#include <mutex>
+#include <vector>
 
+#include "3rd-party/json.hpp"
+#include "jsonlistparser.h"
 #include "remoteapi.h"
 #include "rss/feed.h"
 
@@ -16,6 +20,11 @@ public:
 	bool authenticate() override;
 	std::vector<TaggedFeedUrl> get_subscribed_urls() override;
 	bool mark_all_read(const std::string& feedurl) override;
+	bool mark_all_read_until(const std::string& feedurl,
+		const std::string& newest,
+		int64_t marked_at) override;
+	std::string get_newest_article(
+		const std::vector<std::string>& guids) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
@@ -23,16 +32,49 @@ public:
 	void add_custom_headers(curl_slist**) override;
 	rsspp::Feed fetch_feed(const std::string& feed_id);
 
+	/// \brief Fetches all articles that were added or changed (e.g. read
+	/// or starred) after the last modification time \a since.
+	bool prefetch_feeds(int64_t since) override;
+	void discard_prefetched_feeds() override;
+	/// \brief Fills \a feed with \a feed_id's part of prefetch_feeds()
+	/// result. Returns false if nothing was prefetched, or if the feed is
+	/// only synced up to \a watermark, which is older than the prefetch.
+	bool get_prefetched_feed(const std::string& feed_id,
+		int64_t watermark,
+		rsspp::Feed& feed);
+
+protected:
+	/// \brief Sends \a query to the server and puts the reply into \a
+	/// buff. Returns false if the request failed.
+	virtual bool send_query(const std::string& query,
+		std::string& buff,
+		const std::string& post);
+
 private:
 	typedef std::map<std::string, std::pair<rsspp::Feed, long>> FeedMap;
 	std::string retrieve_auth();
 	bool query(const std::string& query,
 		json_object** result = nullptr,
 		const std::string& post = "");
+	/// \brief Runs \a query, which replies with a list of articles, and
+	/// passes each of them to \a handle as soon as it's parsed.
+	bool query_items(const std::string& query,
+		const JsonListParser::ItemHandler& handle);
 	std::string md5(const std::string& str);
+	rsspp::Item item_from_json(const nlohmann::json& item_j);
+	/// \brief Returns the sync position of the current prefetch_feeds()
+	/// result, or 0 if there is none.
+	int64_t get_prefetched_position();
 	std::string auth;
 	std::string server;
 	FeedMap known_feeds;
+
+	std::mutex prefetch_mtx;
+	bool has_prefetched = false;
+	int64_t prefetched_since = 0;
+	int64_t prefetched_position = 0;
+	/// Added and changed articles by feed title
+	std::map<std::string, std::vector<rsspp::Item>> prefetched_items;
 };
 
 } // namespace newsboat
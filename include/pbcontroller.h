@@ -1,12 +1,14 @@
 #ifndef PODBOAT_CONTROLLER_H_
 #define PODBOAT_CONTROLLER_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "configcontainer.h"
 #include "download.h"
+#include "downloadengine.h"
 #include "fslock.h"
 #include "queueloader.h"
 
@@ -14,6 +16,7 @@ namespace podboat {
 
 class PbView;
 
+class EnclosureIndex;
 class QueueLoader;
 
 class PbController {
@@ -30,10 +33,18 @@ public:
 	{
 		return view_update_;
 	}
-	void set_view_update_necessary(bool b)
+	/// \brief Marks the view as outdated, or up to date. Can be called from
+	/// any thread; the view is woken up through view_wakeup_fd() once per
+	/// batch of updates.
+	void set_view_update_necessary(bool b);
+	/// \brief File descriptor that becomes readable when the view needs an
+	/// update, or -1 if it couldn't be created.
+	int view_wakeup_fd() const
 	{
-		view_update_ = b;
+		return wakeup_pipe[0];
 	}
+	/// \brief Reads pending wakeups from view_wakeup_fd().
+	void drain_view_wakeups();
 	std::vector<Download>& downloads()
 	{
 		return downloads_;
@@ -42,10 +53,19 @@ public:
 	std::string get_formatstr();
 
 	unsigned int downloads_in_progress();
-	void purge_queue();
+	/// \brief Removes finished and deleted downloads from the queue.
+	/// Returns false, without changing anything, if downloads are running.
+	bool purge_queue();
 
 	unsigned int get_maxdownloads();
+	/// \brief Hands all queued downloads to the download engine, which
+	/// starts them as slots become free.
 	void start_downloads();
+	/// \brief Starts the download at \a idx right away, regardless of the
+	/// limit on parallel downloads.
+	void start_download(unsigned int idx);
+	/// \brief Stops downloads that didn't start yet from being started.
+	void clear_pending_downloads();
 
 	void increase_parallel_downloads();
 	void decrease_parallel_downloads();
@@ -66,8 +86,10 @@ private:
 	PbView* v;
 	std::string config_file;
 	std::string queue_file;
+	std::string enclosure_index_file;
 	newsboat::ConfigContainer* cfg;
-	bool view_update_;
+	std::atomic<bool> view_update_;
+	int wakeup_pipe[2];
 	std::vector<Download> downloads_;
 
 	std::string config_dir;
@@ -79,6 +101,8 @@ private:
 	unsigned int max_dls;
 
 	QueueLoader* ql;
+	std::unique_ptr<EnclosureIndex> enclosure_index;
+	std::unique_ptr<DownloadEngine> engine;
 
 	std::string lock_file;
 	std::unique_ptr<newsboat::FsLock> fslock;
@@ -1,6 +1,9 @@
 #ifndef PODBOAT_VIEW_H_
 #define PODBOAT_VIEW_H_
 
+#include <string>
+#include <vector>
+
 #include "colormanager.h"
 #include "keymap.h"
 #include "stflpp.h"
@@ -33,6 +36,12 @@ private:
 		char* text;
 	};
 
+	/// \brief Refreshes the title and the rows of the download list that
+	/// changed since the last call.
+	void update_dllist();
+	/// \brief Waits for a key press or a change of the downloads. Returns
+	/// the STFL event, or nullptr if there was no input.
+	const char* wait_for_event();
 	void run_help();
 	void set_dllist_keymap_hint();
 	void set_help_keymap_hint();
@@ -48,6 +57,10 @@ private:
 	newsboat::Stfl::Form dllist_form;
 	newsboat::Stfl::Form help_form;
 	newsboat::KeyMap* keys;
+
+	/// Rows of the download list as last rendered, and the list's width
+	std::vector<std::string> rendered_lines;
+	unsigned int rendered_width;
 };
 
 } // namespace podboat
@@ -3,7 +3,11 @@
 
 #include <ctime>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <sys/stat.h>
+#include <unordered_set>
+#include <vector>
 
 namespace newsboat {
 
@@ -12,6 +16,11 @@ class ConfigPaths;
 class RssFeed;
 class RssItem;
 
+/// \brief Adds podcasts to the queue file that podboat downloads from.
+///
+/// The URLs in the queue are kept in memory, so checking whether an
+/// enclosure is already queued doesn't read the file. The file is only
+/// read again when someone else (usually podboat) changed it.
 class QueueManager {
 	ConfigContainer* cfg = nullptr;
 	ConfigPaths* paths = nullptr;
@@ -22,11 +31,28 @@ public:
 	void enqueue_url(std::shared_ptr<RssItem> item,
 		std::shared_ptr<RssFeed> feed);
 
-	void autoenqueue(std::shared_ptr<RssFeed> feed);
+	/// \brief Enqueues enclosures of the feed's items that weren't
+	/// enqueued yet, if podcast-auto-enqueue is enabled.
+	///
+	/// Returns the items that were marked as enqueued.
+	std::vector<std::shared_ptr<RssItem>> autoenqueue(
+			std::shared_ptr<RssFeed> feed);
 
 private:
 	std::string generate_enqueue_filename(std::shared_ptr<RssItem> item,
 		std::shared_ptr<RssFeed> feed);
+
+	/// \brief Reads the URLs from the queue file, unless the file didn't
+	/// change since the last time we read or wrote it.
+	void load_queued_urls();
+	/// \brief Appends \a lines to the queue file, and remembers the
+	/// file's state so that the append doesn't trigger a re-read.
+	void append_to_queue(const std::string& lines);
+
+	std::mutex queue_mutex;
+	std::unordered_set<std::string> queued_urls;
+	std::string loaded_file;
+	struct stat loaded_state;
 };
 
 }
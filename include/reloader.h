@@ -1,10 +1,12 @@
 #ifndef NEWSBOAT_RELOADER_H_
 #define NEWSBOAT_RELOADER_H_
 
+#include <chrono>
 #include <mutex>
 #include <vector>
 
 #include "configcontainer.h"
+#include "feedreloadstats.h"
 
 namespace newsboat {
 
@@ -21,6 +23,17 @@ class Reloader {
 
 	std::string prepare_message(unsigned int pos, unsigned int max);
 
+	/// \brief Stores \a stats of the reload that began at \a started in the
+	/// cache, and remembers its duration in the feed at \a pos.
+	void record_reload_stats(unsigned int pos,
+		const std::string& rssurl,
+		std::chrono::steady_clock::time_point started,
+		FeedReloadStats& stats);
+
+	/// \brief Lets the remote API, if any, fetch the new articles of all
+	/// feeds at once. Returns true if reloads should use the result.
+	bool prefetch_remote_feeds();
+
 public:
 	Reloader(Controller* c, Cache* cc, ConfigContainer* cfg);
 
@@ -89,6 +102,10 @@ public:
 	/// notification will contain \a msg passed.
 	void notify(const std::string& msg);
 
+	/// \brief Returns true if any of the settings listed for notify() are
+	/// turned on, i.e. if notify() would do anything at all.
+	bool notifications_enabled();
+
 };
 
 } // namespace newsboat
@@ -1,8 +1,11 @@
 #ifndef NEWSBOAT_REMOTEAPI_H_
 #define NEWSBOAT_REMOTEAPI_H_
 
+#include <cstdint>
+#include <ctime>
 #include <curl/curl.h>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -19,6 +22,19 @@ typedef struct {
 
 class RemoteApi {
 public:
+	/// \brief Why the last request to the server failed
+	enum class RequestError {
+		/// The request succeeded, or the API can't tell
+		NONE,
+		/// The server couldn't be reached, or its reply made no sense
+		CONNECTION,
+		/// The server didn't accept our credentials
+		AUTHENTICATION,
+		/// The server understood the request, but refused it (e.g. for
+		/// an article that no longer exists)
+		REJECTED
+	};
+
 	explicit RemoteApi(ConfigContainer* c)
 		: cfg(c)
 	{
@@ -28,10 +44,84 @@ public:
 	virtual std::vector<TaggedFeedUrl> get_subscribed_urls() = 0;
 	virtual void add_custom_headers(curl_slist** custom_headers) = 0;
 	virtual bool mark_all_read(const std::string& feedurl) = 0;
+	/// \brief Marks the articles of \a feedurl read that the user could
+	/// see when they marked the feed read, leaving ones that reached the
+	/// server later unread. \a newest is what get_newest_article()
+	/// returned for the feed's articles at that point, and \a marked_at
+	/// is when it happened, in microseconds since the epoch.
+	///
+	/// The default implementation marks the whole feed read.
+	virtual bool mark_all_read_until(const std::string& feedurl,
+		const std::string& /* newest */,
+		int64_t /* marked_at */)
+	{
+		return mark_all_read(feedurl);
+	}
+	/// \brief Returns the one of \a guids that reached the server last,
+	/// for mark_all_read_until(). The default implementation returns an
+	/// empty string, for APIs that go by time instead.
+	virtual std::string get_newest_article(
+		const std::vector<std::string>& /* guids */)
+	{
+		return "";
+	}
 	virtual bool mark_article_read(const std::string& guid, bool read) = 0;
+	/// \brief Marks all of \a guids as read or unread. Returns false if
+	/// that failed for any of them.
+	///
+	/// The default implementation marks articles one by one; APIs that
+	/// can change several articles in one request should override it.
+	virtual bool mark_articles_read(const std::vector<std::string>& guids,
+		bool read);
 	virtual bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) = 0;
+
+	/// \brief Returns the URL that fetches only the articles of \a feedurl
+	/// that arrived after \a since, starting at \a continuation (from the
+	/// previous page's rsspp::Feed::continuation, or empty for the first
+	/// page).
+	///
+	/// Returns an empty string if the API can't fetch such deltas; the
+	/// whole feed is downloaded then.
+	virtual std::string get_delta_url(const std::string& /* feedurl */,
+		time_t /* since */,
+		const std::string& /* continuation */)
+	{
+		return "";
+	}
+	/// \brief Fills \a guids with up to \a limit unread articles of \a
+	/// feedurl. Returns false if that failed or isn't supported.
+	virtual bool get_unread_guids(const std::string& /* feedurl */,
+		unsigned int /* limit */,
+		std::unordered_set<std::string>& /* guids */)
+	{
+		return false;
+	}
+
+	/// \brief Fetches the articles of all feeds that changed after \a
+	/// since in a few requests, so that reloading all feeds doesn't take
+	/// a request per feed. \a since is an rsspp::Feed::sync_position
+	/// returned by an earlier fetch.
+	///
+	/// Until discard_prefetched_feeds() is called, feeds that are synced
+	/// up to at least \a since are served from the result. Returns false
+	/// if that failed or isn't supported; feeds are fetched one by one
+	/// then.
+	virtual bool prefetch_feeds(int64_t /* since */)
+	{
+		return false;
+	}
+	virtual void discard_prefetched_feeds() {}
+
+	/// \brief Returns why the last request that the calling thread sent
+	/// through any of the APIs failed, so that callers can tell changes
+	/// the server refused from ones that never reached it.
+	static RequestError last_request_error();
+	/// \brief Records the outcome of a request for last_request_error().
+	/// Callers may reset it to NONE before making requests.
+	static void set_request_error(RequestError error);
+
 	static const std::string read_password(const std::string& file);
 	static const std::string eval_password(const std::string& cmd);
 	// TODO
@@ -39,6 +129,24 @@ protected:
 	ConfigContainer* cfg;
 	Credentials get_credentials(const std::string& scope,
 		const std::string& name);
+
+	/// \brief get_delta_url() for APIs that serve feeds as Atom streams
+	/// under `/reader/atom/`, like Google Reader did: adds `ot` (oldest
+	/// time) and `c` (continuation) parameters to \a feedurl.
+	static std::string greader_delta_url(const std::string& feedurl,
+		time_t since,
+		const std::string& continuation);
+	/// \brief get_unread_guids() for Google Reader-style APIs, using
+	/// their `stream/items/ids` endpoint.
+	bool greader_unread_guids(const std::string& feedurl,
+		unsigned int limit,
+		std::unordered_set<std::string>& guids);
+	/// \brief Turns the `itemRefs` of a `stream/items/ids` reply into the
+	/// IDs that the Atom streams use for the same articles. Returns false
+	/// if \a reply can't be parsed or isn't a list of items, e.g. because
+	/// it's an error message.
+	static bool parse_greader_item_refs(const std::string& reply,
+		std::unordered_set<std::string>& guids);
 };
 
 } // namespace newsboat
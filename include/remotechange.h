@@ -0,0 +1,40 @@
+#ifndef NEWSBOAT_REMOTECHANGE_H_
+#define NEWSBOAT_REMOTECHANGE_H_
+
+#include <cstdint>
+#include <string>
+
+namespace newsboat {
+
+/// \brief A change of article state that still has to be sent to the
+/// remote API configured with `urls-source`.
+struct RemoteChange {
+	/// Stored in the cache as numbers; don't reorder
+	enum class Action {
+		MARK_READ = 0,
+		MARK_UNREAD = 1,
+		UPDATE_FLAGS = 2,
+		MARK_FEED_READ = 3
+	};
+
+	/// Assigned by the cache; changes are sent in the order of their IDs
+	int64_t id = 0;
+	Action action = Action::MARK_READ;
+	/// Article GUID, or feed URL for MARK_FEED_READ
+	std::string target;
+	/// Only used by UPDATE_FLAGS
+	std::string oldflags;
+	std::string newflags;
+	/// Only used by MARK_FEED_READ: the feed's newest article at the time,
+	/// as picked by RemoteApi::get_newest_article()
+	std::string newest;
+	/// Only used by MARK_FEED_READ: when the user marked the feed read, in
+	/// microseconds since the epoch
+	int64_t marked_at = 0;
+	/// How many times the server refused this change
+	unsigned int attempts = 0;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_REMOTECHANGE_H_ */
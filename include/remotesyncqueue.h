@@ -0,0 +1,105 @@
+#ifndef NEWSBOAT_REMOTESYNCQUEUE_H_
+#define NEWSBOAT_REMOTESYNCQUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "remotechange.h"
+
+namespace newsboat {
+
+class Cache;
+class RemoteApi;
+
+/// \brief Sends read states and flags to the remote API in the background.
+///
+/// Changes are stored in the cache first, so the UI never waits on the
+/// network, and changes that couldn't be sent survive a restart. A worker
+/// thread sends them in batches: consecutive changes are coalesced, so only
+/// the latest read state of each article is sent, and APIs that support it
+/// get many articles per request. Failed batches are retried with a growing
+/// delay.
+///
+/// Only changes that the server refused count as failed attempts; while the
+/// server can't be reached, changes are kept for as long as it takes. If a
+/// batch is refused, its articles are retried one by one, so that a single
+/// bad article doesn't hold back the others.
+class RemoteSyncQueue {
+public:
+	/// \brief Called from the worker thread with a message for the user.
+	using ErrorHandler = std::function<void(const std::string&)>;
+
+	/// \brief \a error_handler is told about changes that the queue gave
+	/// up on.
+	RemoteSyncQueue(Cache* cache,
+		RemoteApi* api,
+		ErrorHandler error_handler = nullptr);
+	/// \brief Stops the worker. Changes that weren't sent yet stay in the
+	/// cache and are sent next time.
+	~RemoteSyncQueue();
+	RemoteSyncQueue(const RemoteSyncQueue&) = delete;
+	RemoteSyncQueue& operator=(const RemoteSyncQueue&) = delete;
+
+	void mark_article_read(const std::string& guid, bool read);
+	void update_article_flags(const std::string& oldflags,
+		const std::string& newflags,
+		const std::string& guid);
+	void mark_all_read(const std::string& feedurl);
+
+	/// \brief Sends all queued changes on the calling thread. Returns false
+	/// if some of them couldn't be sent.
+	bool flush();
+
+private:
+	enum class SendResult { NOTHING_QUEUED, SENT, FAILED };
+
+	void queue(const RemoteChange& change);
+	void run();
+	/// \brief Sends the oldest queued changes, up to the next change of a
+	/// different kind (an article change or marking a feed read).
+	SendResult send_batch();
+
+	/// \brief What became of the changes in a batch
+	struct Outcome {
+		std::vector<int64_t> sent;
+		std::vector<RemoteChange> rejected;
+		/// Set if the server couldn't be reached; the batch is cut short
+		bool offline = false;
+	};
+
+	void send_article_changes(const std::vector<RemoteChange>& changes,
+		Outcome& outcome);
+	/// \brief Sorts \a changes into \a outcome depending on whether the
+	/// request that sent them succeeded.
+	void record(bool success,
+		const std::vector<const RemoteChange*>& changes,
+		Outcome& outcome);
+	static bool rejected_by_server();
+	/// \brief Counts a failed attempt for each of \a rejected, and tells
+	/// the user about the ones that are dropped.
+	void give_up_on(const std::vector<RemoteChange>& rejected);
+
+	Cache* cache;
+	RemoteApi* api;
+	const ErrorHandler error_handler;
+
+	/// Held while a batch is being sent, so that flush() and the worker
+	/// don't send the same changes twice
+	std::mutex send_mtx;
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool changed;
+	std::atomic<bool> stopping;
+	std::thread worker;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_REMOTESYNCQUEUE_H_ */
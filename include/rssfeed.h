@@ -1,6 +1,8 @@
 #ifndef NEWSBOAT_RSSFEED_H_
 #define NEWSBOAT_RSSFEED_H_
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -69,13 +71,13 @@ public:
 	void add_item(std::shared_ptr<RssItem> item)
 	{
 		items_.push_back(item);
-		items_guid_map[item->guid()] = item;
+		index_item(item);
 	}
 	void add_items(const std::vector<std::shared_ptr<RssItem>>& items)
 	{
 		for (const auto& item : items) {
 			items_.push_back(item);
-			items_guid_map[item->guid()] = item;
+			index_item(item);
 		}
 	}
 	void set_items(std::vector<std::shared_ptr<RssItem>>& items)
@@ -95,13 +97,13 @@ public:
 		std::vector<std::shared_ptr<RssItem>>::iterator end)
 	{
 		for (auto it = begin; it != end; ++it) {
-			items_guid_map.erase((*it)->guid());
+			items_guid_map.erase(std::cref((*it)->guid()));
 		}
 		items_.erase(begin, end);
 	}
 	void erase_item(std::vector<std::shared_ptr<RssItem>>::iterator pos)
 	{
-		items_guid_map.erase((*pos)->guid());
+		items_guid_map.erase(std::cref((*pos)->guid()));
 		items_.erase(pos);
 	}
 
@@ -194,6 +196,37 @@ public:
 		return order;
 	}
 
+	/// \brief How long the last reload of this feed took, in microseconds.
+	///
+	/// Zero if the feed hasn't been reloaded yet.
+	void set_last_reload_duration(uint64_t us)
+	{
+		last_reload_us = us;
+	}
+	uint64_t last_reload_duration() const
+	{
+		return last_reload_us;
+	}
+
+	/// \brief Has Cache::externalize_rssfeed() record \a t as the feed's
+	/// sync watermark, once the items are stored.
+	///
+	/// The watermark tells where the next reload continues, so it mustn't
+	/// be saved before the articles it covers.
+	void set_sync_watermark(time_t t)
+	{
+		sync_watermark_ = t;
+		has_sync_watermark_ = true;
+	}
+	bool has_sync_watermark() const
+	{
+		return has_sync_watermark_;
+	}
+	time_t sync_watermark() const
+	{
+		return sync_watermark_;
+	}
+
 	void set_feedptrs(std::shared_ptr<RssFeed> self);
 
 	std::string get_status();
@@ -218,14 +251,40 @@ public:
 	std::mutex item_mutex;
 
 private:
+	/// \brief Makes \a item findable by get_item_by_guid(), replacing
+	/// any other item with the same GUID.
+	void index_item(const std::shared_ptr<RssItem>& item)
+	{
+		// Can't just assign: the key would keep pointing at the GUID of
+		// the replaced item
+		items_guid_map.erase(std::cref(item->guid()));
+		items_guid_map.emplace(std::cref(item->guid()), item);
+	}
+
+	// Keys refer to the GUID of the item they map to, so that GUIDs aren't
+	// stored twice. An item's GUID mustn't change while it's in the map.
+	using GuidRef = std::reference_wrapper<const std::string>;
+	struct GuidRefHash {
+		size_t operator()(GuidRef guid) const
+		{
+			return std::hash<std::string>()(guid.get());
+		}
+	};
+	struct GuidRefEqual {
+		bool operator()(GuidRef a, GuidRef b) const
+		{
+			return a.get() == b.get();
+		}
+	};
+
 	std::string title_;
 	std::string description_;
 	std::string link_;
 	time_t pubDate_;
 	std::string rssurl_;
 	std::vector<std::shared_ptr<RssItem>> items_;
-	std::unordered_map<std::string, std::shared_ptr<RssItem>>
-		items_guid_map;
+	std::unordered_map<GuidRef, std::shared_ptr<RssItem>, GuidRefHash,
+		GuidRefEqual> items_guid_map;
 	std::vector<std::string> tags_;
 	std::string query;
 
@@ -236,6 +295,9 @@ private:
 	bool is_rtl_;
 	unsigned int idx;
 	unsigned int order;
+	uint64_t last_reload_us;
+	time_t sync_watermark_;
+	bool has_sync_watermark_;
 	std::mutex items_guid_map_mutex;
 
 	DlStatus status_;
@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 
+#include "internedstring.h"
 #include "matchable.h"
 #include "matcher.h"
 
@@ -36,11 +37,11 @@ public:
 	}
 	void set_author(const std::string& a);
 
-	std::string description() const
+	const std::string& description() const
 	{
 		return description_;
 	}
-	void set_description(const std::string& d);
+	void set_description(std::string d);
 
 	unsigned int size() const
 	{
@@ -82,12 +83,12 @@ public:
 	}
 	void set_feedurl(const std::string& f)
 	{
-		feedurl_ = f;
+		feedurl_ = InternedString(f);
 	}
 
 	const std::string& feedurl() const
 	{
-		return feedurl_;
+		return feedurl_.str();
 	}
 
 	const std::string& enclosure_url() const
@@ -153,11 +154,11 @@ public:
 
 	void set_base(const std::string& b)
 	{
-		base = b;
+		base = InternedString(b);
 	}
 	const std::string& get_base()
 	{
-		return base;
+		return base.str();
 	}
 
 	void set_override_unread(bool b)
@@ -180,14 +181,16 @@ private:
 	std::string author_;
 	std::string description_;
 	std::string guid_;
-	std::string feedurl_;
+	// All items of a feed have the same feed URL, and usually the same
+	// base, so these two are shared rather than copied into each item
+	InternedString feedurl_;
 	Cache* ch;
 	std::string enclosure_url_;
 	std::string enclosure_type_;
 	std::string flags_;
 	std::string oldflags_;
 	std::weak_ptr<RssFeed> feedptr_;
-	std::string base;
+	InternedString base;
 	unsigned int idx;
 	unsigned int size_;
 	time_t pubDate_;
@@ -4,11 +4,14 @@
 #include <memory>
 #include <string>
 
+#include "feedreloadstats.h"
+#include "htmlrenderer.h"
 #include "remoteapi.h"
 #include "rss/feed.h"
 
 namespace rsspp {
 class Item;
+class Parser;
 }
 
 namespace newsboat {
@@ -36,6 +39,15 @@ public:
 		easyhandle = h;
 	}
 
+	/// \brief Returns network and parsing statistics of the last parse().
+	///
+	/// Only fills in the fields that are known before the feed is written
+	/// to the cache.
+	const FeedReloadStats& get_reload_stats() const
+	{
+		return stats;
+	}
+
 private:
 	void replace_newline_characters(std::string& str);
 	std::string render_xhtml_title(const std::string& title,
@@ -44,11 +56,18 @@ private:
 	void set_rtl(std::shared_ptr<RssFeed> feed, const std::string& lang);
 
 	void retrieve_uri(const std::string& uri);
-	void download_http(const std::string& uri);
+	/// \brief Downloads and parses \a uri. If \a conditional, the
+	/// feed's Last-Modified and ETag headers are sent and updated.
+	void download_http(const std::string& uri, bool conditional = true);
+	/// \brief Fetches only the articles that arrived since the previous
+	/// reload, and syncs read states of older ones, if the remote API
+	/// supports that.
+	void download_delta(const std::string& uri);
 	void get_execplugin(const std::string& plugin);
 	void download_filterplugin(const std::string& filter,
 		const std::string& uri);
 	void parse_file(const std::string& file);
+	void record_transfer(const rsspp::Parser& p);
 
 	void fill_feed_fields(std::shared_ptr<RssFeed> feed);
 	void fill_feed_items(std::shared_ptr<RssFeed> feed);
@@ -59,7 +78,7 @@ private:
 	void set_item_author(std::shared_ptr<RssItem> x,
 		const rsspp::Item& item);
 	void set_item_content(std::shared_ptr<RssItem> x,
-		const rsspp::Item& item);
+		rsspp::Item& item);
 	void set_item_enclosure(std::shared_ptr<RssItem> x,
 		const rsspp::Item& item);
 	std::string get_guid(const rsspp::Item& item) const;
@@ -68,13 +87,16 @@ private:
 		std::shared_ptr<RssItem> item);
 
 	void handle_content_encoded(std::shared_ptr<RssItem> x,
-		const rsspp::Item& item) const;
+		rsspp::Item& item) const;
 	void handle_itunes_summary(std::shared_ptr<RssItem> x,
 		const rsspp::Item& item);
 	bool is_html_type(const std::string& type);
 	void fetch_ttrss(const std::string& feed_id);
 	void fetch_newsblur(const std::string& feed_id);
 	void fetch_ocnews(const std::string& feed_id);
+	/// \brief Has the parsed feed carry \a t as its new sync watermark,
+	/// which is saved together with its articles.
+	void set_sync_watermark(time_t t);
 
 	std::string my_uri;
 	Cache* ch;
@@ -85,8 +107,20 @@ private:
 	bool is_ttrss;
 	bool is_newsblur;
 	bool is_ocnews;
+	/// The remote API can fetch just the new articles of this feed
+	bool can_fetch_deltas;
+	/// `f` only holds the articles that arrived (or, for some remote
+	/// APIs, changed) since the previous reload
+	bool is_delta;
+	bool has_sync_watermark;
+	time_t sync_watermark;
 
 	CurlHandle* easyhandle;
+	FeedReloadStats stats;
+
+	// Reused for all XHTML titles so the tag table is only built once
+	// per feed.
+	HtmlRenderer title_renderer;
 };
 
 } // namespace newsboat
@@ -24,6 +24,21 @@ namespace newsboat {
 
 enum class LineType { wrappable = 1, softwrappable, nonwrappable, hr };
 
+/// \brief Returns the number of columns \a text takes up when displayed by
+/// STFL.
+///
+/// Gives the same results as utils::strwidth_stfl(), but is computed in a
+/// single pass, with widths of non-ASCII characters cached per thread.
+size_t stfl_text_width(const std::string& text);
+
+/// \brief Splits \a line into pieces that are at most \a width columns
+/// wide.
+///
+/// Words are kept whole unless they're wider than \a width. Leading
+/// whitespace of \a line is repeated at the start of each piece.
+std::vector<std::string> wrap_line(const std::string& line,
+	const size_t width);
+
 class TextFormatter {
 public:
 	TextFormatter();
@@ -1,9 +1,17 @@
 #ifndef NEWSBOAT_TTRSSAPI_H_
 #define NEWSBOAT_TTRSSAPI_H_
 
+#include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
 #include "3rd-party/json.hpp"
 #include "cache.h"
+#include "jsonlistparser.h"
 #include "remoteapi.h"
+#include "rss/item.h"
 
 namespace rsspp {
 class Feed;
@@ -24,19 +32,71 @@ public:
 	void add_custom_headers(curl_slist** custom_headers) override;
 	bool mark_all_read(const std::string& feedurl) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
+	bool mark_articles_read(const std::vector<std::string>& guids,
+		bool read) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) override;
 	rsspp::Feed fetch_feed(const std::string& id, CURL* cached_handle);
 	bool update_article(const std::string& guid, int mode, int field);
 
+	/// \brief Fetches the articles of all feeds that are newer than the
+	/// article with ID \a since, plus the IDs of all unread articles.
+	bool prefetch_feeds(int64_t since) override;
+	void discard_prefetched_feeds() override;
+	/// \brief Fills \a feed with feed \a id's part of prefetch_feeds()
+	/// result. Returns false if nothing was prefetched, or if the feed is
+	/// only synced up to \a watermark, which is older than the prefetch.
+	bool get_prefetched_feed(const std::string& id,
+		int64_t watermark,
+		rsspp::Feed& feed);
+	/// \brief Answers from the prefetch_feeds() result; returns false if
+	/// there is none, or it didn't get all unread articles.
+	bool get_unread_guids(const std::string& feedurl,
+		unsigned int limit,
+		std::unordered_set<std::string>& guids) override;
+
+protected:
+	/// \brief Sends \a op with \a args and returns the raw reply.
+	virtual std::string send_op(const std::string& op,
+		const std::map<std::string, std::string>& args,
+		CURL* cached_handle);
+
 private:
+	enum class ReplyStatus { OK, LOGGED_IN_AGAIN, FAILED };
+
+	/// \brief Like run_op(), for ops that reply with a list of items:
+	/// passes each of them to \a handle as soon as it's parsed, instead of
+	/// parsing the whole reply first. Returns false if the op failed.
+	bool run_list_op(const std::string& op,
+		const std::map<std::string, std::string>& args,
+		const JsonListParser::ItemHandler& handle,
+		bool try_login = true,
+		CURL* cached_handle = nullptr);
+	/// \brief Moves the content of \a reply into \a content, checking its
+	/// status. If the session expired and \a try_login is set, logs in
+	/// again so that the op can be retried.
+	ReplyStatus check_reply(nlohmann::json& reply,
+		nlohmann::json& content,
+		bool try_login);
 	void fetch_feeds_per_category(const nlohmann::json& cat,
 		std::vector<TaggedFeedUrl>& feeds);
 	bool star_article(const std::string& guid, bool star);
 	bool publish_article(const std::string& guid, bool publish);
 	TaggedFeedUrl feed_from_json(const nlohmann::json& jfeed,
 		const std::vector<std::string>& tags);
+	rsspp::Item item_from_json(const nlohmann::json& item_obj);
+	/// \brief Checks whether getHeadlines with \a args would return more
+	/// headlines than for_all_headlines() fetches, without fetching them.
+	bool too_many_headlines(std::map<std::string, std::string> args);
+	/// \brief Returns the sync position of the current prefetch_feeds()
+	/// result, or 0 if there is none.
+	int64_t get_prefetched_position();
+	/// \brief Runs getHeadlines with \a args for all feeds, page by page,
+	/// and passes each headline to \a handle. Returns false if a request
+	/// failed or there were too many pages.
+	bool for_all_headlines(std::map<std::string, std::string> args,
+		const std::function<void(const nlohmann::json&)>& handle);
 	int parse_category_id(const nlohmann::json& jcatid);
 	unsigned int query_api_level();
 	std::string url_to_id(const std::string& url);
@@ -46,6 +106,16 @@ private:
 	bool single;
 	std::mutex auth_lock;
 	int api_level = -1;
+
+	std::mutex prefetch_mtx;
+	bool has_prefetched = false;
+	int64_t prefetched_since = 0;
+	int64_t prefetched_position = 0;
+	/// New articles by feed ID
+	std::map<std::string, std::vector<rsspp::Item>> prefetched_items;
+	/// Unread article IDs by feed ID; only valid if prefetched_all_unread
+	std::map<std::string, std::unordered_set<std::string>> prefetched_unread;
+	bool prefetched_all_unread = false;
 };
 
 } // namespace newsboat
@@ -149,6 +149,12 @@ unsigned int newsboat_version_major();
 
 /// Threadsafe combination of strftime() and localtime()
 std::string mt_strf_localtime(const std::string& format, time_t t);
+
+/// Returns free heap memory to the operating system, where the C library
+/// supports that. Meant to be called after a burst of short-lived
+/// allocations, like a reload, so that the freed pages don't count towards
+/// the process' resident size until the next burst.
+void release_free_memory();
 }
 
 } // namespace newsboat
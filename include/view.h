@@ -144,6 +144,9 @@ protected:
 
 	void handle_cmdline_completion(std::shared_ptr<FormAction> fa);
 	void clear_line(std::shared_ptr<FormAction> fa);
+	/// \brief If \a fa is an article view, stops its background
+	/// rendering.
+	void stop_prerendering(std::shared_ptr<FormAction> fa);
 	void clear_eol(std::shared_ptr<FormAction> fa);
 	void cancel_input(std::shared_ptr<FormAction> fa);
 	void delete_word(std::shared_ptr<FormAction> fa);
@@ -65,6 +65,13 @@ void print_usage(const std::string& argv0, const std::string& config_path,
 			_s("read configuration from <configfile>")
 		},
 		{'X', "vacuum", "", _s("compact the cache")},
+		{
+			'D',
+			"daemon",
+			"",
+			_s("run without UI, reloading feeds and taking commands from "
+				"a control socket")
+		},
 		{
 			'x',
 			"execute",
@@ -55,6 +55,8 @@ void AtomParser::parse_feed(Feed& f, xmlNode* rootNode)
 			f.pubDate = w3cdtf_to_rfc822(get_content(node));
 		} else if (node_is(node, "entry", ns)) {
 			f.items.push_back(parse_entry(node));
+		} else if (node_is(node, "continuation", GOOGLE_READER_URI)) {
+			f.continuation = get_content(node);
 		}
 	}
 }
@@ -1,6 +1,7 @@
 #ifndef NEWSBOAT_RSSPPFEED_H_
 #define NEWSBOAT_RSSPPFEED_H_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -27,6 +28,7 @@ public:
 
 	Feed()
 		: rss_version(UNKNOWN)
+		, sync_position(0)
 	{
 	}
 
@@ -41,6 +43,12 @@ public:
 	std::string managingeditor;
 	std::string dc_creator;
 	std::string pubDate;
+	/// Google Reader-style APIs' token for fetching the next page of a
+	/// stream; empty if there are no more items
+	std::string continuation;
+	/// Remote APIs' position in their stream of changes that this feed is
+	/// up to date with (e.g. the newest article ID); 0 if unknown
+	int64_t sync_position;
 
 	std::vector<Item> items;
 };
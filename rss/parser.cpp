@@ -1,5 +1,6 @@
 #include "parser.h"
 
+#include <chrono>
 #include <cinttypes>
 #include <cstring>
 #include <curl/curl.h>
@@ -9,6 +10,7 @@
 #include "config.h"
 #include "exception.h"
 #include "logger.h"
+#include "metrics.h"
 #include "remoteapi.h"
 #include "rssparser.h"
 #include "rssparserfactory.h"
@@ -26,6 +28,42 @@ static size_t my_write_data(void* buffer, size_t size, size_t nmemb,
 	return size * nmemb;
 }
 
+static uint64_t get_time_info(CURL* easyhandle, CURLINFO info)
+{
+	double seconds = 0;
+	if (curl_easy_getinfo(easyhandle, info, &seconds) != CURLE_OK) {
+		return 0;
+	}
+	return static_cast<uint64_t>(seconds * 1000000);
+}
+
+static uint64_t get_downloaded_bytes(CURL* easyhandle)
+{
+#if LIBCURL_VERSION_NUM >= 0x073700
+	// CURLINFO_SIZE_DOWNLOAD is deprecated since curl 7.55.0
+	curl_off_t bytes = 0;
+	if (curl_easy_getinfo(easyhandle, CURLINFO_SIZE_DOWNLOAD_T, &bytes)
+		!= CURLE_OK) {
+		return 0;
+	}
+	return static_cast<uint64_t>(bytes);
+#else
+	double bytes = 0;
+	if (curl_easy_getinfo(easyhandle, CURLINFO_SIZE_DOWNLOAD, &bytes)
+		!= CURLE_OK) {
+		return 0;
+	}
+	return static_cast<uint64_t>(bytes);
+#endif
+}
+
+static uint64_t microseconds_since(
+	const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start).count();
+}
+
 namespace rsspp {
 
 Parser::Parser(unsigned int timeout,
@@ -42,13 +80,20 @@ Parser::Parser(unsigned int timeout,
 	, verify_ssl(ssl_verify)
 	, doc(0)
 	, lm(0)
+	, parse_us(0)
 {
 }
 
 Parser::~Parser()
+{
+	free_doc();
+}
+
+void Parser::free_doc()
 {
 	if (doc) {
 		xmlFreeDoc(doc);
+		doc = nullptr;
 	}
 }
 
@@ -189,7 +234,15 @@ Feed Parser::parse_url(const std::string& url,
 			easyhandle, CURLOPT_HTTPHEADER, custom_headers);
 	}
 
-	ret = curl_easy_perform(easyhandle);
+	{
+		static auto& timings =
+			MetricsRegistry::global().histogram("fetch");
+		ScopeTimer timer(timings);
+		ret = curl_easy_perform(easyhandle);
+	}
+	static auto& fetched_bytes =
+		MetricsRegistry::global().counter("fetch.bytes");
+	fetched_bytes.increment(buf.length());
 
 	lm = hdrs.lastmodified;
 	et = hdrs.etag;
@@ -208,6 +261,19 @@ Feed Parser::parse_url(const std::string& url,
 	CURLcode infoOk =
 		curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &status);
 
+	transfer = TransferInfo();
+	transfer.namelookup_us =
+		get_time_info(easyhandle, CURLINFO_NAMELOOKUP_TIME);
+	transfer.connect_us = get_time_info(easyhandle, CURLINFO_CONNECT_TIME);
+	transfer.starttransfer_us =
+		get_time_info(easyhandle, CURLINFO_STARTTRANSFER_TIME);
+	transfer.total_us = get_time_info(easyhandle, CURLINFO_TOTAL_TIME);
+	transfer.bytes = get_downloaded_bytes(easyhandle);
+	if (infoOk == CURLE_OK) {
+		transfer.http_status = status;
+	}
+	parse_us = 0;
+
 	curl_easy_reset(easyhandle);
 	if (cookie_cache != "") {
 		curl_easy_setopt(
@@ -219,6 +285,9 @@ Feed Parser::parse_url(const std::string& url,
 	}
 
 	if (ret != 0) {
+		static auto& errors =
+			MetricsRegistry::global().counter("fetch.errors");
+		errors.increment();
 		LOG(Level::ERROR,
 			"rsspp::Parser::parse_url: curl_easy_perform returned "
 			"err "
@@ -257,6 +326,11 @@ Feed Parser::parse_url(const std::string& url,
 
 Feed Parser::parse_buffer(const std::string& buffer, const std::string& url)
 {
+	static auto& timings = MetricsRegistry::global().histogram("parse");
+	ScopeTimer timer(timings);
+	const auto started = std::chrono::steady_clock::now();
+
+	free_doc();
 	doc = xmlReadMemory(buffer.c_str(),
 			buffer.length(),
 			url.c_str(),
@@ -273,14 +347,19 @@ Feed Parser::parse_buffer(const std::string& buffer, const std::string& url)
 	if (doc->encoding) {
 		f.encoding = (const char*)doc->encoding;
 	}
+	free_doc();
 
 	LOG(Level::INFO, "Parser::parse_buffer: encoding = %s", f.encoding);
 
+	parse_us = microseconds_since(started);
+
 	return f;
 }
 
 Feed Parser::parse_file(const std::string& filename)
 {
+	const auto started = std::chrono::steady_clock::now();
+	free_doc();
 	doc = xmlReadFile(filename.c_str(),
 			nullptr,
 			XML_PARSE_RECOVER | XML_PARSE_NOERROR | XML_PARSE_NOWARNING);
@@ -295,9 +374,12 @@ Feed Parser::parse_file(const std::string& filename)
 	if (doc->encoding) {
 		f.encoding = (const char*)doc->encoding;
 	}
+	free_doc();
 
 	LOG(Level::INFO, "Parser::parse_file: encoding = %s", f.encoding);
 
+	parse_us = microseconds_since(started);
+
 	return f;
 }
 
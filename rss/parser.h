@@ -1,6 +1,7 @@
 #ifndef NEWSBOAT_RSSPPPARSER_H_
 #define NEWSBOAT_RSSPPPARSER_H_
 
+#include <cstdint>
 #include <curl/curl.h>
 #include <libxml/parser.h>
 #include <string>
@@ -10,6 +11,19 @@
 
 namespace rsspp {
 
+/// \brief Details of the last transfer done by Parser::parse_url().
+///
+/// Times are in microseconds since the start of the transfer.
+struct TransferInfo {
+	uint64_t namelookup_us = 0;
+	uint64_t connect_us = 0;
+	uint64_t starttransfer_us = 0;
+	uint64_t total_us = 0;
+	/// Bytes received, before decompression
+	uint64_t bytes = 0;
+	long http_status = 0;
+};
+
 class Parser {
 public:
 	Parser(unsigned int timeout = 30,
@@ -36,12 +50,26 @@ public:
 	{
 		return et;
 	}
+	const TransferInfo& get_transfer_info() const
+	{
+		return transfer;
+	}
+	/// \brief Returns the time spent parsing XML by the last call to
+	/// parse_url(), parse_buffer() or parse_file(), in microseconds.
+	uint64_t get_parse_time() const
+	{
+		return parse_us;
+	}
 
 	static void global_init();
 	static void global_cleanup();
 
 private:
 	Feed parse_xmlnode(xmlNode* node);
+	/// \brief Frees the XML tree once the Feed has been built from it.
+	/// The tree is several times the size of the document, and nothing
+	/// refers to it afterwards.
+	void free_doc();
 	unsigned int to;
 	const std::string ua;
 	const std::string prx;
@@ -51,6 +79,8 @@ private:
 	xmlDocPtr doc;
 	time_t lm;
 	std::string et;
+	TransferInfo transfer;
+	uint64_t parse_us;
 };
 
 } // namespace rsspp
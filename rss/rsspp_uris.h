@@ -7,5 +7,6 @@
 #define ATOM_0_3_URI "http://purl.org/atom/ns#"
 #define ATOM_1_0_URI "http://www.w3.org/2005/Atom"
 #define XML_URI "http://www.w3.org/XML/1998/namespace"
+#define GOOGLE_READER_URI "http://www.google.com/schemas/reader/atom/"
 
 #endif /* NEWSBOAT_RSSPP_URIS_H_ */
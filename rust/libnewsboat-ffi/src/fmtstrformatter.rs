@@ -1,6 +1,6 @@
 use abort_on_panic;
 use libc::{c_char, c_void};
-use libnewsboat::fmtstrformatter::FmtStrFormatter;
+use libnewsboat::fmtstrformatter::{CompiledFormat, FmtStrFormatter};
 use std::ffi::{CStr, CString};
 use std::mem;
 
@@ -72,3 +72,52 @@ pub unsafe extern "C" fn rs_fmtstrformatter_do_format(
         result
     })
 }
+
+#[no_mangle]
+pub unsafe extern "C" fn rs_fmtstrformatter_compile(format: *const c_char) -> *mut c_void {
+    abort_on_panic(|| {
+        let format = {
+            assert!(!format.is_null());
+            CStr::from_ptr(format)
+        }
+        .to_str()
+        .expect("format contained invalid UTF-8");
+        Box::into_raw(Box::new(CompiledFormat::new(format))) as *mut c_void
+    })
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn rs_fmtstrformatter_compiled_free(compiled: *mut c_void) {
+    abort_on_panic(|| {
+        if compiled.is_null() {
+            return;
+        }
+        Box::from_raw(compiled as *mut CompiledFormat);
+    })
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn rs_fmtstrformatter_do_format_compiled(
+    fmt: *mut c_void,
+    compiled: *mut c_void,
+    width: u32,
+) -> *mut c_char {
+    abort_on_panic(|| {
+        let fmt = {
+            assert!(!fmt.is_null());
+            Box::from_raw(fmt as *mut FmtStrFormatter)
+        };
+        let compiled = {
+            assert!(!compiled.is_null());
+            Box::from_raw(compiled as *mut CompiledFormat)
+        };
+        let result = fmt.do_format_compiled(&compiled, width);
+        let result = CString::new(result).unwrap().into_raw();
+
+        // Do not deallocate the objects - C still has pointers to them
+        mem::forget(compiled);
+        mem::forget(fmt);
+
+        result
+    })
+}
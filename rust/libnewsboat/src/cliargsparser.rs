@@ -10,6 +10,9 @@ use utils;
 pub struct CliArgsParser {
     pub do_export: bool,
     pub do_vacuum: bool,
+    /// If `true`, Newsboat should run without UI, reloading feeds periodically and taking commands
+    /// from a control socket.
+    pub do_daemon: bool,
     pub program_name: String,
     pub show_version: usize,
     pub silent: bool,
@@ -75,6 +78,7 @@ impl CliArgsParser {
     pub fn new(opts: Vec<String>) -> CliArgsParser {
         const CACHE_FILE: &str = "cache-file";
         const CONFIG_FILE: &str = "config-file";
+        const DAEMON: &str = "daemon";
         const EXECUTE: &str = "execute";
         const EXPORT_TO_FILE: &str = "export-to-file";
         const EXPORT_TO_OPML: &str = "export-to-opml";
@@ -127,6 +131,7 @@ impl CliArgsParser {
                     .takes_value(true),
             )
             .arg(Arg::with_name(VACUUM).short("X").long(VACUUM))
+            .arg(Arg::with_name(DAEMON).short("D").long(DAEMON))
             .arg(
                 Arg::with_name(VERSION)
                     .short("v")
@@ -201,6 +206,8 @@ impl CliArgsParser {
 
         args.do_vacuum = matches.is_present(VACUUM);
 
+        args.do_daemon = matches.is_present(DAEMON);
+
         args.silent = args.silent || matches.is_present(QUIET);
 
         if let Some(importfile) = matches.value_of(IMPORT_FROM_OPML) {
@@ -508,6 +515,18 @@ mod tests {
         check(vec!["newsboat".to_string(), "--vacuum".to_string()]);
     }
 
+    #[test]
+    fn t_sets_do_daemon_if_dash_capital_d_is_provided() {
+        let check = |opts| {
+            let args = CliArgsParser::new(opts);
+
+            assert!(args.do_daemon);
+        };
+
+        check(vec!["newsboat".to_string(), "-D".to_string()]);
+        check(vec!["newsboat".to_string(), "--daemon".to_string()]);
+    }
+
     #[test]
     fn t_increases_show_version_with_each_dash_v_provided() {
         let check = |opts, expected_version| {
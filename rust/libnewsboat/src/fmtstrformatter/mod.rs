@@ -78,6 +78,11 @@ impl FmtStrFormatter {
         self.formatting_helper(&ast, width)
     }
 
+    /// Like `do_format`, but uses a format string that was parsed in advance.
+    pub fn do_format_compiled(&self, format: &CompiledFormat, width: u32) -> String {
+        self.formatting_helper(&format.ast, width)
+    }
+
     fn format_spacing(&self, c: char, rest: &[Specifier], width: u32, result: &mut LimitedString) {
         let rest = self.formatting_helper(rest, 0);
         if width == 0 {
@@ -162,14 +167,14 @@ impl FmtStrFormatter {
                     self.format_format(c, &padding, width, &mut result);
                 }
 
-                Specifier::Text(s) => {
+                Specifier::Text(ref s) => {
                     if width == 0 {
                         result.push_str(s);
                     } else {
                         let remaining = width as usize - result.length();
-                        let count = utils::graphemes_count(&s);
+                        let count = utils::graphemes_count(s);
                         if remaining >= count {
-                            result.push_str(&s);
+                            result.push_str(s);
                         } else {
                             result.push_str(&utils::take_graphemes(s, remaining));
                         }
@@ -186,6 +191,22 @@ impl FmtStrFormatter {
     }
 }
 
+/// A format string that was parsed once, so that it can be applied to many sets of values without
+/// parsing it again.
+///
+/// Lists format every line with the same format string, so they should compile it once and use
+/// `FmtStrFormatter::do_format_compiled` for each line.
+pub struct CompiledFormat {
+    ast: Vec<Specifier>,
+}
+
+impl CompiledFormat {
+    /// Parses `format`.
+    pub fn new(format: &str) -> CompiledFormat {
+        CompiledFormat { ast: parse(format) }
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -201,6 +222,53 @@ mod tests {
         assert_eq!(fmt.do_format("%?a?[%-4a]&no?", 0), "[AAA ]");
     }
 
+    #[test]
+    fn t_do_format_compiled_gives_the_same_results_as_do_format() {
+        let mut fmt = FmtStrFormatter::new();
+
+        fmt.register_fmt('a', "AAA".to_string());
+        fmt.register_fmt('b', "буква".to_string());
+        fmt.register_fmt('m', String::new());
+
+        let formats = [
+            "",
+            "%%",
+            "<%a> <%5b> | %-5a%%",
+            "%a%> %b",
+            "%?a?%a&no?",
+            "%?m?%m&%-8b?|",
+        ];
+        for format in &formats {
+            let compiled = CompiledFormat::new(format);
+            for width in &[0, 3, 20] {
+                assert_eq!(
+                    fmt.do_format_compiled(&compiled, *width),
+                    fmt.do_format(format, *width)
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn t_compiled_format_can_be_used_with_different_values() {
+        let compiled = CompiledFormat::new("%t (%a)");
+        let mut fmt = FmtStrFormatter::new();
+
+        fmt.register_fmt('a', "John Doe".to_string());
+        fmt.register_fmt('t', "How I Spent My Summer".to_string());
+        assert_eq!(
+            fmt.do_format_compiled(&compiled, 0),
+            "How I Spent My Summer (John Doe)"
+        );
+
+        fmt.register_fmt('a', "Rust Project".to_string());
+        fmt.register_fmt('t', "This Week in Rust".to_string());
+        assert_eq!(
+            fmt.do_format_compiled(&compiled, 0),
+            "This Week in Rust (Rust Project)"
+        );
+    }
+
     #[test]
     fn t_do_format_replaces_variables_with_values_two_variables() {
         let mut fmt = FmtStrFormatter::new();
@@ -14,24 +14,27 @@ pub enum Padding {
 
 /// Describes all the different "format specifiers" we support, plus a chunk of text that would be
 /// copied to the output verbatim.
+///
+/// Specifiers own their text, so parsed format strings can be kept around after the original
+/// string is gone (see `CompiledFormat`).
 #[derive(PartialEq, Eq, Debug)]
-pub enum Specifier<'a> {
+pub enum Specifier {
     /// Will expand to pad everything that comes next to the right. Given char is used for padding.
     Spacing(char),
     /// A format to be replaced with a value (`%a`, `%t` etc.), padded to the given width on the
     /// left (if it's positive) or on the right (if it's negative).
     Format(char, Padding),
     /// A chunk of text that will be copied to the output verbatim.
-    Text(&'a str),
+    Text(String),
     /// Conditional format that is replaced by one of the sub-formats depending on the value of the
     /// given key. "Else" branch might be missing.
-    Conditional(char, Vec<Specifier<'a>>, Option<Vec<Specifier<'a>>>),
+    Conditional(char, Vec<Specifier>, Option<Vec<Specifier>>),
 }
 
 fn escaped_percent_sign(input: CompleteStr) -> IResult<CompleteStr, Specifier> {
     tag!(input, "%%").map(|result| {
         let CompleteStr(s) = result.1;
-        (result.0, Specifier::Text(&s[0..1]))
+        (result.0, Specifier::Text(s[0..1].to_string()))
     })
 }
 
@@ -77,14 +80,14 @@ fn padded_format(input: CompleteStr) -> IResult<CompleteStr, Specifier> {
 fn text_outside_conditional(input: CompleteStr) -> IResult<CompleteStr, Specifier> {
     take_till!(input, |chr: char| chr == '%').map(|result| {
         let CompleteStr(s) = result.1;
-        (result.0, Specifier::Text(s))
+        (result.0, Specifier::Text(s.to_string()))
     })
 }
 
 fn text_inside_conditional(input: CompleteStr) -> IResult<CompleteStr, Specifier> {
     take_till!(input, |chr: char| chr == '%' || chr == '&' || chr == '?').map(|result| {
         let CompleteStr(s) = result.1;
-        (result.0, Specifier::Text(s))
+        (result.0, Specifier::Text(s.to_string()))
     })
 }
 
@@ -147,7 +150,7 @@ fn sanitize(mut input: Vec<Specifier>) -> Vec<Specifier> {
 pub fn parse(input: &str) -> Vec<Specifier> {
     match parser(CompleteStr(input)) {
         Ok((_leftovers, ast)) => sanitize(ast),
-        Err(_) => vec![Specifier::Text("")],
+        Err(_) => vec![Specifier::Text(String::new())],
     }
 }
 
@@ -160,7 +163,7 @@ mod tests {
         let input = "Hello, world!";
         let (leftovers, result) = parser(CompleteStr(input)).unwrap();
         assert_eq!(leftovers, CompleteStr(""));
-        assert_eq!(result, vec![Specifier::Text("Hello, world!")]);
+        assert_eq!(result, vec![Specifier::Text("Hello, world!".to_string())]);
     }
 
     #[test]
@@ -168,7 +171,7 @@ mod tests {
         let input = "%%";
         let (leftovers, result) = parser(CompleteStr(input)).unwrap();
         assert_eq!(leftovers, CompleteStr(""));
-        assert_eq!(result, vec![Specifier::Text("%")]);
+        assert_eq!(result, vec![Specifier::Text("%".to_string())]);
     }
 
     #[test]
@@ -178,9 +181,9 @@ mod tests {
         assert_eq!(leftovers, CompleteStr(""));
 
         let expected = vec![
-            Specifier::Text("100"),
-            Specifier::Text("%"),
-            Specifier::Text(" pure Ceylon tea"),
+            Specifier::Text("100".to_string()),
+            Specifier::Text("%".to_string()),
+            Specifier::Text(" pure Ceylon tea".to_string()),
         ];
         assert_eq!(result, expected);
     }
@@ -194,9 +197,9 @@ mod tests {
 
         let expected = vec![
             Specifier::Format('t', Padding::None),
-            Specifier::Text(" ("),
+            Specifier::Text(" (".to_string()),
             Specifier::Format('a', Padding::None),
-            Specifier::Text(")"),
+            Specifier::Text(")".to_string()),
         ];
         assert_eq!(result, expected);
     }
@@ -257,8 +260,8 @@ mod tests {
 
         let expected = vec![Specifier::Conditional(
             'x',
-            vec![Specifier::Text("success")],
-            Some(vec![Specifier::Text("failure")]),
+            vec![Specifier::Text("success".to_string())],
+            Some(vec![Specifier::Text("failure".to_string())]),
         )];
         assert_eq!(result, expected);
     }
@@ -272,7 +275,7 @@ mod tests {
 
         let expected = vec![Specifier::Conditional(
             'x',
-            vec![Specifier::Text("success")],
+            vec![Specifier::Text("success".to_string())],
             None,
         )];
         assert_eq!(result, expected);
@@ -1,6 +1,7 @@
 #include "cache.h"
 
 #include <cassert>
+#include <chrono>
 #include <cinttypes>
 #include <cstdlib>
 #include <cstring>
@@ -16,8 +17,8 @@
 #include "dbexception.h"
 #include "logger.h"
 #include "matcherexception.h"
+#include "metrics.h"
 #include "rssfeed.h"
-#include "scopemeasure.h"
 #include "strprintf.h"
 #include "utils.h"
 
@@ -92,14 +93,28 @@ static int count_callback(void* handler, int argc, char** argv,
 	return 0;
 }
 
-static int single_string_callback(void* handler,
+struct StoredItem {
+	StoredItem()
+		: found(false)
+	{
+	}
+
+	bool found;
+	std::string title;
+	std::string content;
+};
+
+static int stored_item_callback(void* handler,
 	int argc,
 	char** argv,
 	char** /* azColName */)
 {
-	std::string* value = reinterpret_cast<std::string*>(handler);
-	if (argc > 0 && argv[0]) {
-		*value = argv[0];
+	StoredItem* item = static_cast<StoredItem*>(handler);
+	assert(argc == 2);
+	if (!item->found) {
+		item->found = true;
+		item->title = argv[0] ? argv[0] : "";
+		item->content = argv[1] ? argv[1] : "";
 	}
 	return 0;
 }
@@ -111,13 +126,18 @@ static int rssfeed_callback(void* myfeed, int argc, char** argv,
 		static_cast<std::shared_ptr<RssFeed>*>(myfeed);
 	// normaly, this shouldn't happen, but we keep the assert()s here
 	// nevertheless
-	assert(argc == 3);
+	assert(argc == 4);
 	assert(argv[0] != nullptr);
 	assert(argv[1] != nullptr);
 	assert(argv[2] != nullptr);
 	(*feed)->set_title(argv[0]);
 	(*feed)->set_link(argv[1]);
 	(*feed)->set_rtl(strcmp(argv[2], "1") == 0);
+	// NULL if the feed was never reloaded
+	if (argv[3] != nullptr) {
+		(*feed)->set_last_reload_duration(
+			std::strtoull(argv[3], nullptr, 10));
+	}
 	LOG(Level::INFO,
 		"rssfeed_callback: title = %s link = %s is_rtl = %s",
 		argv[0],
@@ -258,6 +278,77 @@ static int guid_callback(void* myguids, int argc, char** argv,
 	return 0;
 }
 
+static int time_callback(void* vp, int argc, char** argv,
+	char** /* azColName */)
+{
+	auto* t = static_cast<time_t*>(vp);
+	if (argc > 0 && argv[0]) {
+		*t = std::strtoll(argv[0], nullptr, 10);
+	}
+	return 0;
+}
+
+static int remote_change_callback(void* vp, int argc, char** argv,
+	char** /* azColName */)
+{
+	auto* changes = static_cast<std::vector<RemoteChange>*>(vp);
+	assert(argc == 8);
+
+	RemoteChange change;
+	change.id = std::strtoll(argv[0], nullptr, 10);
+	change.action = static_cast<RemoteChange::Action>(std::atoi(argv[1]));
+	change.target = argv[2] ? argv[2] : "";
+	change.oldflags = argv[3] ? argv[3] : "";
+	change.newflags = argv[4] ? argv[4] : "";
+	change.newest = argv[5] ? argv[5] : "";
+	change.marked_at = std::strtoll(argv[6], nullptr, 10);
+	change.attempts = std::strtoul(argv[7], nullptr, 10);
+	changes->push_back(change);
+	return 0;
+}
+
+static std::string join_ids(const std::vector<int64_t>& ids)
+{
+	std::string list;
+	for (const auto id : ids) {
+		if (!list.empty()) {
+			list.push_back(',');
+		}
+		list.append(std::to_string(id));
+	}
+	return list;
+}
+
+static int reload_stats_callback(void* vp, int argc, char** argv,
+	char** /* azColName */)
+{
+	auto* records = static_cast<std::vector<FeedReloadStats>*>(vp);
+	assert(argc == 15);
+
+	const auto number = [&](int column) -> uint64_t {
+		return argv[column] ? std::strtoull(argv[column], nullptr, 10) : 0;
+	};
+
+	FeedReloadStats stats;
+	stats.rssurl = argv[0] ? argv[0] : "";
+	stats.reloaded_at = number(1);
+	stats.total_us = number(2);
+	stats.dns_us = number(3);
+	stats.connect_us = number(4);
+	stats.ttfb_us = number(5);
+	stats.transfer_us = number(6);
+	stats.bytes = number(7);
+	stats.http_status = number(8);
+	stats.not_modified = (number(9) != 0);
+	stats.parse_us = number(10);
+	stats.items_new = number(11);
+	stats.items_changed = number(12);
+	stats.db_write_us = number(13);
+	stats.error = argv[14] ? argv[14] : "";
+	records->push_back(stats);
+	return 0;
+}
+
 Cache::Cache(const std::string& cachefile, ConfigContainer* c)
 	: db(0)
 	, cfg(c)
@@ -380,6 +471,42 @@ static const schema_patches schemaPatches{
 
 			"INSERT INTO metadata VALUES ( 2, 11 );"
 		}
+	},
+	{	{2, 19},
+		{
+			"CREATE TABLE rss_feed_reload ( "
+			" rssurl VARCHAR(1024) PRIMARY KEY NOT NULL, "
+			" reloaded_at INTEGER NOT NULL, "
+			" total_us INTEGER NOT NULL, "
+			" dns_us INTEGER NOT NULL, "
+			" connect_us INTEGER NOT NULL, "
+			" ttfb_us INTEGER NOT NULL, "
+			" transfer_us INTEGER NOT NULL, "
+			" bytes INTEGER NOT NULL, "
+			" http_status INTEGER NOT NULL, "
+			" not_modified INTEGER(1) NOT NULL, "
+			" parse_us INTEGER NOT NULL, "
+			" items_new INTEGER NOT NULL, "
+			" items_changed INTEGER NOT NULL, "
+			" db_write_us INTEGER NOT NULL, "
+			" error VARCHAR(1024) NOT NULL );",
+
+			"CREATE TABLE remote_sync_queue ( "
+			" id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, "
+			" action INTEGER NOT NULL, "
+			" target VARCHAR(1024) NOT NULL, "
+			" oldflags VARCHAR(52) NOT NULL, "
+			" newflags VARCHAR(52) NOT NULL, "
+			" newest VARCHAR(1024) NOT NULL DEFAULT '', "
+			" marked_at INTEGER NOT NULL DEFAULT 0, "
+			" attempts INTEGER NOT NULL DEFAULT 0 );",
+
+			"ALTER TABLE rss_feed ADD sync_watermark INTEGER NOT NULL "
+			"DEFAULT 0;",
+
+			"UPDATE metadata SET db_schema_version_major = 2, "
+			"db_schema_version_minor = 19;"
+		}
 	}};
 
 void Cache::populate_tables()
@@ -464,6 +591,106 @@ void Cache::update_lastmodified(const std::string& feedurl,
 	run_sql_nothrow(query);
 }
 
+time_t Cache::fetch_sync_watermark(const std::string& feedurl)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	const std::string query = prepare_query(
+			"SELECT sync_watermark FROM rss_feed WHERE rssurl = '%q';",
+			feedurl);
+	time_t watermark = 0;
+	run_sql(query, time_callback, &watermark);
+	return watermark;
+}
+
+void Cache::update_sync_watermark(const std::string& feedurl, time_t t)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	update_sync_watermark_unlocked(feedurl, t);
+}
+
+void Cache::update_sync_watermark_unlocked(const std::string& feedurl,
+	time_t t)
+{
+	const std::string query = prepare_query(
+			"UPDATE rss_feed SET sync_watermark = %lld WHERE rssurl = '%q';",
+			static_cast<long long>(t),
+			feedurl);
+	run_sql(query);
+}
+
+time_t Cache::fetch_newest_sync_watermark(
+	const std::vector<std::string>& feedurls)
+{
+	if (feedurls.empty()) {
+		return 0;
+	}
+
+	std::string urlset = "(";
+	for (const auto& feedurl : feedurls) {
+		urlset.append(prepare_query("'%q', ", feedurl));
+	}
+	urlset.append("'')");
+
+	std::lock_guard<std::mutex> lock(mtx);
+	const std::string query = prepare_query(
+			"SELECT MAX(sync_watermark) FROM rss_feed "
+			"WHERE sync_watermark > 0 AND rssurl IN %s;",
+			urlset);
+	time_t watermark = 0;
+	run_sql(query, time_callback, &watermark);
+	return watermark;
+}
+
+void Cache::update_unread_from_remote(const std::string& feedurl,
+	const std::unordered_set<std::string>& unread_guids,
+	bool complete)
+{
+	std::string guidset = "(";
+	for (const auto& guid : unread_guids) {
+		guidset.append(prepare_query("'%q', ", guid));
+	}
+	guidset.append("'')");
+
+	std::lock_guard<std::mutex> lock(mtx);
+	const std::string not_pending =
+		"guid NOT IN (SELECT target FROM remote_sync_queue)";
+
+	// Marking the whole feed read locally mustn't be undone by a reload
+	// that happens before that change reaches the server
+	std::string query = prepare_query(
+			"UPDATE rss_item SET unread = 1 "
+			"WHERE feedurl = '%q' AND unread = 0 AND guid IN %s AND %s "
+			"AND NOT EXISTS (SELECT 1 FROM remote_sync_queue "
+			"WHERE action = %d AND target = '%q');",
+			feedurl,
+			guidset,
+			not_pending,
+			static_cast<int>(RemoteChange::Action::MARK_FEED_READ),
+			feedurl);
+	run_sql(query);
+	const int marked_unread = sqlite3_changes(db);
+
+	int marked_read = 0;
+	if (complete) {
+		query = prepare_query(
+				"UPDATE rss_item SET unread = 0 "
+				"WHERE feedurl = '%q' AND unread = 1 "
+				"AND guid NOT IN %s AND %s;",
+				feedurl,
+				guidset,
+				not_pending);
+		run_sql(query);
+		marked_read = sqlite3_changes(db);
+	}
+
+	LOG(Level::DEBUG,
+		"Cache::update_unread_from_remote: %s: %d marked unread, %d "
+		"marked read",
+		feedurl,
+		marked_unread,
+		marked_read);
+}
+
 void Cache::mark_item_deleted(const std::string& guid, bool b)
 {
 	std::lock_guard<std::mutex> lock(mtx);
@@ -485,9 +712,13 @@ void Cache::mark_feed_items_deleted(const std::string& feedurl)
 
 // this function writes an RssFeed including all RssItems to the database
 void Cache::externalize_rssfeed(std::shared_ptr<RssFeed> feed,
-	bool reset_unread)
+	bool reset_unread,
+	FeedReloadStats* stats)
 {
-	ScopeMeasure m1("Cache::externalize_feed");
+	static auto& timings =
+		MetricsRegistry::global().histogram("db.write_feed");
+	ScopeTimer timer(timings);
+	const auto started = std::chrono::steady_clock::now();
 	if (feed->is_query_feed()) {
 		return;
 	}
@@ -530,7 +761,8 @@ void Cache::externalize_rssfeed(std::shared_ptr<RssFeed> feed,
 		run_sql(insertquery);
 	}
 
-	unsigned int max_items = cfg->get_configvalue_as_int("max-items");
+	const auto config = cfg->snapshot();
+	unsigned int max_items = config->get_int(ConfigKey::MAX_ITEMS);
 
 	LOG(Level::INFO,
 		"Cache::externalize_feed: max_items = %u "
@@ -544,16 +776,43 @@ void Cache::externalize_rssfeed(std::shared_ptr<RssFeed> feed,
 			feed->items().begin() + max_items, feed->items().end());
 	}
 
-	unsigned int days = cfg->get_configvalue_as_int("keep-articles-days");
+	unsigned int days = config->get_int(ConfigKey::KEEP_ARTICLES_DAYS);
 	time_t old_time = time(nullptr) - days * 24 * 60 * 60;
 
 	// the reverse iterator is there for the sorting foo below (think about
 	// it)
+	unsigned int items_new = 0;
+	unsigned int items_changed = 0;
 	for (auto it = feed->items().rbegin(); it != feed->items().rend();
 		++it) {
-		if (days == 0 || (*it)->pubDate_timestamp() >= old_time)
-			update_rssitem_unlocked(
-				*it, feed->rssurl(), reset_unread);
+		if (days == 0 || (*it)->pubDate_timestamp() >= old_time) {
+			switch (update_rssitem_unlocked(
+					*it, feed->rssurl(), reset_unread)) {
+			case ItemUpdate::INSERTED:
+				items_new++;
+				break;
+			case ItemUpdate::CHANGED:
+				items_changed++;
+				break;
+			case ItemUpdate::UNCHANGED:
+				break;
+			}
+		}
+	}
+
+	if (feed->has_sync_watermark()) {
+		// Only now that the articles are stored, and after the feed's row
+		// was created on its first sync
+		update_sync_watermark_unlocked(
+			feed->rssurl(), feed->sync_watermark());
+	}
+
+	if (stats != nullptr) {
+		stats->items_new = items_new;
+		stats->items_changed = items_changed;
+		stats->db_write_us =
+			std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - started).count();
 	}
 }
 
@@ -562,7 +821,9 @@ void Cache::externalize_rssfeed(std::shared_ptr<RssFeed> feed,
 std::shared_ptr<RssFeed> Cache::internalize_rssfeed(std::string rssurl,
 	RssIgnores* ign)
 {
-	ScopeMeasure m1("Cache::internalize_rssfeed");
+	static auto& timings =
+		MetricsRegistry::global().histogram("db.read_feed");
+	ScopeTimer timer(timings);
 
 	std::shared_ptr<RssFeed> feed(new RssFeed(this));
 	feed->set_rssurl(rssurl);
@@ -586,7 +847,12 @@ std::shared_ptr<RssFeed> Cache::internalize_rssfeed(std::string rssurl,
 
 	/* then we first read the feed from the database */
 	query = prepare_query(
-			"SELECT title, url, is_rtl FROM rss_feed WHERE rssurl = '%q';",
+			"SELECT rss_feed.title, rss_feed.url, rss_feed.is_rtl, "
+			"rss_feed_reload.total_us "
+			"FROM rss_feed "
+			"LEFT JOIN rss_feed_reload "
+			"ON rss_feed_reload.rssurl = rss_feed.rssurl "
+			"WHERE rss_feed.rssurl = '%q';",
 			rssurl);
 	run_sql(query, rssfeed_callback, &feed);
 
@@ -630,7 +896,7 @@ std::shared_ptr<RssFeed> Cache::internalize_rssfeed(std::string rssurl,
 		item->set_feedurl(feed->rssurl());
 	}
 
-	unsigned int max_items = cfg->get_configvalue_as_int("max-items");
+	unsigned int max_items = cfg->snapshot()->get_int(ConfigKey::MAX_ITEMS);
 
 	if (max_items > 0 && feed->total_item_count() > max_items) {
 		std::vector<std::shared_ptr<RssItem>> flagged_items;
@@ -654,6 +920,37 @@ std::shared_ptr<RssFeed> Cache::internalize_rssfeed(std::string rssurl,
 	return feed;
 }
 
+std::shared_ptr<RssFeed> Cache::internalize_rssfeed_without_items(
+	const std::string& rssurl)
+{
+	static auto& timings =
+		MetricsRegistry::global().histogram("db.read_feed_without_items");
+	ScopeTimer timer(timings);
+
+	std::shared_ptr<RssFeed> feed(new RssFeed(this));
+	feed->set_rssurl(rssurl);
+
+	if (utils::is_query_url(rssurl)) {
+		return feed;
+	}
+
+	std::lock_guard<std::mutex> lock(mtx);
+
+	// If the feed isn't in the database yet, the callback is never called
+	// and the feed stays empty, just like in internalize_rssfeed().
+	const std::string query = prepare_query(
+			"SELECT rss_feed.title, rss_feed.url, rss_feed.is_rtl, "
+			"rss_feed_reload.total_us "
+			"FROM rss_feed "
+			"LEFT JOIN rss_feed_reload "
+			"ON rss_feed_reload.rssurl = rss_feed.rssurl "
+			"WHERE rss_feed.rssurl = '%q';",
+			rssurl);
+	run_sql(query, rssfeed_callback, &feed);
+
+	return feed;
+}
+
 std::vector<std::shared_ptr<RssItem>> Cache::search_for_items(
 		const std::string& querystr, const std::string& feedurl)
 {
@@ -776,11 +1073,17 @@ void Cache::cleanup_cache(std::vector<std::shared_ptr<RssFeed>>& feeds)
 		cleanup_rss_items_statement.append(list);
 		cleanup_rss_items_statement.push_back(';');
 
+		std::string cleanup_reload_stats_statement(
+			"DELETE FROM rss_feed_reload WHERE rssurl NOT IN ");
+		cleanup_reload_stats_statement.append(list);
+		cleanup_reload_stats_statement.push_back(';');
+
 		std::string cleanup_read_items_statement(
 			"UPDATE rss_item SET deleted = 1 WHERE unread = 0");
 
 		run_sql(cleanup_rss_feeds_statement);
 		run_sql(cleanup_rss_items_statement);
+		run_sql(cleanup_reload_stats_statement);
 		if (cfg->get_configvalue_as_bool(
 				"delete-read-articles-on-quit")) {
 			run_sql(cleanup_read_items_statement);
@@ -795,76 +1098,74 @@ void Cache::cleanup_cache(std::vector<std::shared_ptr<RssFeed>>& feeds)
 	}
 }
 
-void Cache::update_rssitem_unlocked(std::shared_ptr<RssItem> item,
+Cache::ItemUpdate Cache::update_rssitem_unlocked(
+	std::shared_ptr<RssItem> item,
 	const std::string& feedurl,
 	bool reset_unread)
 {
+	// Fetching title and content right away lets us tell changed items
+	// from unchanged ones without a second query
 	std::string query = prepare_query(
-			"SELECT count(*) FROM rss_item WHERE guid = '%q';",
+			"SELECT title, content FROM rss_item WHERE guid = '%q';",
 			item->guid());
-	CbHandler count_cbh;
-	run_sql(query, count_callback, &count_cbh);
-	if (count_cbh.count() > 0) {
-		if (reset_unread) {
-			std::string content;
+	StoredItem stored;
+	run_sql(query, stored_item_callback, &stored);
+	if (stored.found) {
+		const bool content_changed =
+			(stored.content != item->description());
+		if (reset_unread && content_changed) {
+			LOG(Level::DEBUG,
+				"Cache::update_rssitem_unlocked: '%s' "
+				"is "
+				"different from '%s'",
+				stored.content,
+				item->description());
 			query = prepare_query(
-					"SELECT content FROM rss_item WHERE guid = "
-					"'%q';",
+					"UPDATE rss_item SET unread = 1 WHERE "
+					"guid = '%q';",
 					item->guid());
-			run_sql(query, single_string_callback, &content);
-			if (content != item->description()) {
-				LOG(Level::DEBUG,
-					"Cache::update_rssitem_unlocked: '%s' "
-					"is "
-					"different from '%s'",
-					content,
-					item->description());
-				query = prepare_query(
-						"UPDATE rss_item SET unread = 1 WHERE "
-						"guid = '%q';",
-						item->guid());
-				run_sql(query);
-			}
+			run_sql(query);
 		}
-		std::string update;
+		std::string update = prepare_query(
+				"UPDATE rss_item "
+				"SET title = '%q', author = '%q', url = '%q', "
+				"feedurl = '%q', "
+				"content = '%q', enclosure_url = '%q', "
+				"enclosure_type = '%q', base = '%q' "
+				"WHERE guid = '%q'",
+				item->title(),
+				item->author(),
+				item->link(),
+				feedurl,
+				item->description(),
+				item->enclosure_url(),
+				item->enclosure_type(),
+				item->get_base(),
+				item->guid());
+		run_sql(update);
+
 		if (item->override_unread()) {
+			// The server's read state mustn't undo a change that the
+			// user made and that didn't reach the server yet
 			update = prepare_query(
-					"UPDATE rss_item "
-					"SET title = '%q', author = '%q', url = '%q', "
-					"feedurl = '%q', "
-					"content = '%q', enclosure_url = '%q', "
-					"enclosure_type = '%q', base = '%q', unread = "
-					"'%d' "
-					"WHERE guid = '%q'",
-					item->title(),
-					item->author(),
-					item->link(),
-					feedurl,
-					item->description(),
-					item->enclosure_url(),
-					item->enclosure_type(),
-					item->get_base(),
+					"UPDATE rss_item SET unread = %d "
+					"WHERE guid = '%q' "
+					"AND guid NOT IN "
+					"(SELECT target FROM remote_sync_queue) "
+					"AND NOT EXISTS (SELECT 1 FROM remote_sync_queue "
+					"WHERE action = %d AND target = '%q');",
 					(item->unread() ? 1 : 0),
-					item->guid());
-		} else {
-			update = prepare_query(
-					"UPDATE rss_item "
-					"SET title = '%q', author = '%q', url = '%q', "
-					"feedurl = '%q', "
-					"content = '%q', enclosure_url = '%q', "
-					"enclosure_type = '%q', base = '%q' "
-					"WHERE guid = '%q'",
-					item->title(),
-					item->author(),
-					item->link(),
-					feedurl,
-					item->description(),
-					item->enclosure_url(),
-					item->enclosure_type(),
-					item->get_base(),
-					item->guid());
+					item->guid(),
+					static_cast<int>(
+						RemoteChange::Action::MARK_FEED_READ),
+					feedurl);
+			run_sql(update);
 		}
-		run_sql(update);
+
+		if (content_changed || stored.title != item->title()) {
+			return ItemUpdate::CHANGED;
+		}
+		return ItemUpdate::UNCHANGED;
 	} else {
 		std::string insert = prepare_query(
 				"INSERT INTO rss_item (guid, title, author, url, "
@@ -888,6 +1189,7 @@ void Cache::update_rssitem_unlocked(std::shared_ptr<RssItem> item,
 				item->enqueued() ? 1 : 0,
 				item->get_base());
 		run_sql(insert);
+		return ItemUpdate::INSERTED;
 	}
 }
 
@@ -998,7 +1300,9 @@ void Cache::update_rssitem_flags(RssItem* item)
 
 void Cache::remove_old_deleted_items(RssFeed* feed)
 {
-	ScopeMeasure m1("Cache::remove_old_deleted_items");
+	static auto& timings =
+		MetricsRegistry::global().histogram("db.remove_old_deleted_items");
+	ScopeTimer timer(timings);
 
 	std::lock_guard<std::mutex> cache_lock(mtx);
 	std::lock_guard<std::mutex> feed_lock(feed->item_mutex);
@@ -1032,7 +1336,9 @@ void Cache::remove_old_deleted_items(RssFeed* feed)
 
 void Cache::mark_items_read_by_guid(const std::vector<std::string>& guids)
 {
-	ScopeMeasure m1("Cache::mark_items_read_by_guid");
+	static auto& timings =
+		MetricsRegistry::global().histogram("db.mark_items_read_by_guid");
+	ScopeTimer timer(timings);
 	std::string guidset("(");
 	for (const auto& guid : guids) {
 		guidset.append(prepare_query("'%q', ", guid));
@@ -1048,6 +1354,18 @@ void Cache::mark_items_read_by_guid(const std::vector<std::string>& guids)
 	run_sql(updatequery);
 }
 
+std::vector<std::string> Cache::get_item_guids(const std::string& feedurl)
+{
+	std::vector<std::string> guids;
+	const std::string query = prepare_query(
+			"SELECT guid FROM rss_item WHERE feedurl = '%q';", feedurl);
+
+	std::lock_guard<std::mutex> lock(mtx);
+	run_sql(query, vectorofstring_callback, &guids);
+
+	return guids;
+}
+
 std::vector<std::string> Cache::get_read_item_guids()
 {
 	std::vector<std::string> guids;
@@ -1100,6 +1418,113 @@ void Cache::fetch_descriptions(RssFeed* feed)
 	run_sql(query, fill_content_callback, feed);
 }
 
+void Cache::record_reload_stats(const FeedReloadStats& stats)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	const std::string query = prepare_query(
+			"INSERT OR REPLACE INTO rss_feed_reload (rssurl, reloaded_at, "
+			"total_us, dns_us, connect_us, ttfb_us, transfer_us, bytes, "
+			"http_status, not_modified, parse_us, items_new, "
+			"items_changed, db_write_us, error) "
+			"VALUES ('%q', %lld, %lld, %lld, %lld, %lld, %lld, %lld, "
+			"%ld, %d, %lld, %u, %u, %lld, '%q');",
+			stats.rssurl,
+			static_cast<long long>(stats.reloaded_at),
+			static_cast<long long>(stats.total_us),
+			static_cast<long long>(stats.dns_us),
+			static_cast<long long>(stats.connect_us),
+			static_cast<long long>(stats.ttfb_us),
+			static_cast<long long>(stats.transfer_us),
+			static_cast<long long>(stats.bytes),
+			stats.http_status,
+			stats.not_modified ? 1 : 0,
+			static_cast<long long>(stats.parse_us),
+			stats.items_new,
+			stats.items_changed,
+			static_cast<long long>(stats.db_write_us),
+			stats.error);
+	run_sql(query);
+}
+
+std::vector<FeedReloadStats> Cache::get_reload_stats(unsigned int limit)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	const std::string query = prepare_query(
+			"SELECT rssurl, reloaded_at, total_us, dns_us, connect_us, "
+			"ttfb_us, transfer_us, bytes, http_status, not_modified, "
+			"parse_us, items_new, items_changed, db_write_us, error "
+			"FROM rss_feed_reload "
+			"ORDER BY total_us DESC "
+			"LIMIT %u;",
+			limit);
+	std::vector<FeedReloadStats> records;
+	run_sql(query, reload_stats_callback, &records);
+	return records;
+}
+
+void Cache::queue_remote_change(const RemoteChange& change)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	const std::string query = prepare_query(
+			"INSERT INTO remote_sync_queue "
+			"(action, target, oldflags, newflags, newest, marked_at) "
+			"VALUES (%d, '%q', '%q', '%q', '%q', %lld);",
+			static_cast<int>(change.action),
+			change.target,
+			change.oldflags,
+			change.newflags,
+			change.newest,
+			static_cast<long long>(change.marked_at));
+	run_sql(query);
+}
+
+std::vector<RemoteChange> Cache::get_remote_changes(unsigned int limit)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	const std::string query = prepare_query(
+			"SELECT id, action, target, oldflags, newflags, newest, "
+			"marked_at, attempts "
+			"FROM remote_sync_queue "
+			"ORDER BY id ASC "
+			"LIMIT %u;",
+			limit);
+	std::vector<RemoteChange> changes;
+	run_sql(query, remote_change_callback, &changes);
+	return changes;
+}
+
+void Cache::remove_remote_changes(const std::vector<int64_t>& ids)
+{
+	if (ids.empty()) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mtx);
+	run_sql(strprintf::fmt("DELETE FROM remote_sync_queue WHERE id IN (%s);",
+			join_ids(ids)));
+}
+
+unsigned int Cache::fail_remote_changes(const std::vector<int64_t>& ids,
+	unsigned int max_attempts)
+{
+	if (ids.empty()) {
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> lock(mtx);
+	const std::string list = join_ids(ids);
+	run_sql(strprintf::fmt(
+			"UPDATE remote_sync_queue SET attempts = attempts + 1 "
+			"WHERE id IN (%s);",
+			list));
+	run_sql(prepare_query(
+			"DELETE FROM remote_sync_queue "
+			"WHERE attempts >= %u AND id IN (%s);",
+			max_attempts,
+			list));
+	return sqlite3_changes(db);
+}
+
 SchemaVersion Cache::get_schema_version()
 {
 	sqlite3_stmt* stmt{};
@@ -19,6 +19,8 @@ extern "C" {
 
 	bool rs_cliargsparser_do_vacuum(void* rs_cliargsparser);
 
+	bool rs_cliargsparser_do_daemon(void* rs_cliargsparser);
+
 	char* rs_cliargsparser_importfile(void* rs_cliargsparser);
 
 	char* rs_cliargsparser_program_name(void* rs_cliargsparser);
@@ -120,6 +122,11 @@ bool CliArgsParser::do_vacuum() const
 	GET_VALUE(do_vacuum, false);
 }
 
+bool CliArgsParser::do_daemon() const
+{
+	GET_VALUE(do_daemon, false);
+}
+
 std::string CliArgsParser::importfile() const
 {
 	GET_STRING(importfile);
@@ -14,6 +14,32 @@
 #include "strprintf.h"
 #include "utils.h"
 
+namespace {
+
+// Names of the settings in ConfigSnapshot, in the order of ConfigKey
+// enumerators
+const char* const snapshot_keys[] = {
+	"cookie-cache",
+	"download-retries",
+	"download-timeout",
+	"goto-next-feed",
+	"ignore-mode",
+	"keep-articles-days",
+	"max-items",
+	"proxy",
+	"proxy-auth",
+	"proxy-auth-method",
+	"proxy-type",
+	"show-read-articles",
+	"show-read-feeds",
+	"ssl-verifyhost",
+	"ssl-verifypeer",
+	"text-width",
+	"use-proxy",
+};
+
+} // namespace
+
 namespace newsboat {
 
 const std::string ConfigContainer::PARTIAL_FILE_SUFFIX = ".part";
@@ -62,6 +88,7 @@ ConfigContainer::ConfigContainer()
 		ConfigData("false", ConfigDataType::BOOL)},
 	{"download-path", ConfigData("~/", ConfigDataType::PATH)},
 	{"download-retries", ConfigData("1", ConfigDataType::INT)},
+	{"download-segments", ConfigData("1", ConfigDataType::INT)},
 	{"download-timeout", ConfigData("30", ConfigDataType::INT)},
 	{"error-log", ConfigData("", ConfigDataType::PATH)},
 	{"external-url-viewer", ConfigData("", ConfigDataType::PATH)},
@@ -166,12 +193,14 @@ ConfigContainer::ConfigContainer()
 	{
 		"podcast-auto-enqueue",
 		ConfigData("no", ConfigDataType::BOOL)},
+	{"podcast-deduplicate", ConfigData("no", ConfigDataType::BOOL)},
 	{
 		"podlist-format",
 		ConfigData( "%4i [%6dMB/%6tMB] [%5p %%] [%12K] %-20S %u -> %F", ConfigDataType::STR)},
 	{
 		"prepopulate-query-feeds",
 		ConfigData("false", ConfigDataType::BOOL)},
+	{"prerender-articles", ConfigData("3", ConfigDataType::INT)},
 	{"ssl-verifyhost", ConfigData("true", ConfigDataType::BOOL)},
 	{"ssl-verifypeer", ConfigData("true", ConfigDataType::BOOL)},
 	{"proxy", ConfigData("", ConfigDataType::STR)},
@@ -304,6 +333,8 @@ ConfigContainer::ConfigContainer()
 		"urlview-title-format",
 		ConfigData(_("%N %V - URLs"), ConfigDataType::STR)}}
 {
+	std::lock_guard<std::recursive_mutex> guard(config_data_mtx);
+	publish_snapshot();
 }
 
 ConfigContainer::~ConfigContainer()
@@ -386,6 +417,8 @@ void ConfigContainer::handle_action(const std::string& action,
 		// we already handled this at the beginning of the function
 		break;
 	}
+
+	publish_snapshot();
 }
 
 bool ConfigContainer::is_bool(const std::string& s)
@@ -436,12 +469,40 @@ void ConfigContainer::set_configvalue(const std::string& key,
 		value);
 	std::lock_guard<std::recursive_mutex> guard(config_data_mtx);
 	config_data[key].value = value;
+	publish_snapshot();
 }
 
 void ConfigContainer::reset_to_default(const std::string& key)
 {
 	std::lock_guard<std::recursive_mutex> guard(config_data_mtx);
 	config_data[key].value = config_data[key].default_value;
+	publish_snapshot();
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigContainer::snapshot() const
+{
+	return std::atomic_load(&current_snapshot);
+}
+
+void ConfigContainer::publish_snapshot()
+{
+	static_assert(sizeof(snapshot_keys) / sizeof(snapshot_keys[0]) ==
+		static_cast<size_t>(ConfigKey::USE_PROXY) + 1,
+		"snapshot_keys doesn't match ConfigKey");
+
+	auto snapshot = std::make_shared<ConfigSnapshot>();
+	snapshot->values.reserve(
+		sizeof(snapshot_keys) / sizeof(snapshot_keys[0]));
+	for (const auto key : snapshot_keys) {
+		ConfigSnapshot::Value value;
+		value.str = get_configvalue(key);
+		value.as_int = get_configvalue_as_int(key);
+		value.as_bool = get_configvalue_as_bool(key);
+		snapshot->values.push_back(std::move(value));
+	}
+
+	std::atomic_store(&current_snapshot,
+		std::shared_ptr<const ConfigSnapshot>(std::move(snapshot)));
 }
 
 void ConfigContainer::toggle(const std::string& key)
@@ -537,6 +598,8 @@ FeedSortStrategy ConfigContainer::get_feed_sort_strategy()
 		ss.sm = FeedSortMethod::UNREAD_ARTICLE_COUNT;
 	} else if (sortmethod == "lastupdated") {
 		ss.sm = FeedSortMethod::LAST_UPDATED;
+	} else if (sortmethod == "reloadtime") {
+		ss.sm = FeedSortMethod::RELOAD_TIME;
 	}
 
 	if (direction == "asc") {
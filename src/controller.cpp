@@ -1,7 +1,9 @@
 #include "controller.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <cinttypes>
 #include <cstdlib>
 #include <ctime>
 #include <curl/curl.h>
@@ -30,6 +32,7 @@
 #include "configexception.h"
 #include "configparser.h"
 #include "configpaths.h"
+#include "daemon.h"
 #include "dbexception.h"
 #include "downloadthread.h"
 #include "exception.h"
@@ -41,6 +44,7 @@
 #include "inoreaderurlreader.h"
 #include "itemrenderer.h"
 #include "logger.h"
+#include "metrics.h"
 #include "newsblurapi.h"
 #include "newsblururlreader.h"
 #include "ocnewsapi.h"
@@ -52,7 +56,6 @@
 #include "remoteapi.h"
 #include "rssfeed.h"
 #include "rssparser.h"
-#include "scopemeasure.h"
 #include "stflpp.h"
 #include "strprintf.h"
 #include "ttrssapi.h"
@@ -87,6 +90,8 @@ Controller::Controller(ConfigPaths& configpaths)
 
 Controller::~Controller()
 {
+	// The queue's worker uses both the cache and the API
+	remote_sync.reset();
 	delete rsscache;
 	delete urlcfg;
 	delete api;
@@ -157,15 +162,16 @@ int Controller::run(const CliArgsParser& args)
 		fslock = std::unique_ptr<FsLock>(new FsLock());
 		pid_t pid;
 		if (!fslock->try_lock(configpaths.lock_file(), pid)) {
-			if (!args.execute_cmds()) {
-				std::cout << strprintf::fmt(
-						_("Error: an instance of "
-							"%s is already running "
-							"(PID: %u)"),
-						PROGRAM_NAME,
-						pid)
-					<< std::endl;
+			if (args.execute_cmds()) {
+				return execute_commands_in_daemon(args.cmds_to_execute());
 			}
+			std::cout << strprintf::fmt(
+					_("Error: an instance of "
+						"%s is already running "
+						"(PID: %u)"),
+					PROGRAM_NAME,
+					pid)
+				<< std::endl;
 			return EXIT_FAILURE;
 		}
 	}
@@ -216,6 +222,9 @@ int Controller::run(const CliArgsParser& args)
 		fslock = std::unique_ptr<FsLock>(new FsLock());
 		pid_t pid;
 		if (!fslock->try_lock(configpaths.lock_file(), pid)) {
+			if (args.execute_cmds()) {
+				return execute_commands_in_daemon(args.cmds_to_execute());
+			}
 			std::cout << strprintf::fmt(
 					_("Error: an instance of %s is "
 						"already running (PID: %u)"),
@@ -257,6 +266,34 @@ int Controller::run(const CliArgsParser& args)
 	reloader =
 		std::unique_ptr<Reloader>(new Reloader(this, rsscache, &cfg));
 
+	const CacheData needed_data = needed_cache_data(args);
+
+	if (needed_data == CacheData::NOTHING) {
+		if (args.do_vacuum()) {
+			std::cout << _("Cleaning up cache thoroughly...");
+			std::cout.flush();
+			rsscache->do_vacuum();
+			std::cout << _("done.") << std::endl;
+		} else if (args.do_read_import()) {
+			LOG(Level::INFO,
+				"Importing read information file from %s",
+				args.readinfo_import_file());
+			std::cout << _("Importing list of read articles...");
+			std::cout.flush();
+			import_read_information(args.readinfo_import_file());
+			std::cout << _("done.") << std::endl;
+		} else if (args.do_read_export()) {
+			LOG(Level::INFO,
+				"Exporting read information file to %s",
+				args.readinfo_export_file());
+			std::cout << _("Exporting list of read articles...");
+			std::cout.flush();
+			export_read_information(args.readinfo_export_file());
+			std::cout << _("done.") << std::endl;
+		}
+		return EXIT_SUCCESS;
+	}
+
 	std::string type = cfg.get_configvalue("urls-source");
 	if (type == "local") {
 		urlcfg = new FileUrlReader(configpaths.url_file());
@@ -314,6 +351,12 @@ int Controller::run(const CliArgsParser& args)
 			std::cout << "Authentication failed." << std::endl;
 			return EXIT_FAILURE;
 		}
+		remote_sync.reset(new RemoteSyncQueue(rsscache, api,
+		[this](const std::string& message) {
+			if (v) {
+				v->show_error(message);
+			}
+		}));
 	}
 	urlcfg->reload();
 	if (!args.do_export() && !args.silent()) {
@@ -361,32 +404,25 @@ int Controller::run(const CliArgsParser& args)
 		return EXIT_FAILURE;
 	}
 
-	if (!args.do_export() && !args.do_vacuum() && !args.silent()) {
+	const bool load_articles = (needed_data == CacheData::ARTICLES);
+	const bool ignore_disp =
+		(cfg.snapshot()->get(ConfigKey::IGNORE_MODE) == "display");
+	if (load_articles && !args.silent()) {
 		std::cout << _("Loading articles from cache...");
 	}
-	if (args.do_vacuum()) {
-		std::cout << _("Opening cache...");
-	}
 	std::cout.flush();
 
-	if (args.do_vacuum()) {
-		std::cout << _("done.") << std::endl;
-		std::cout << _("Cleaning up cache thoroughly...");
-		std::cout.flush();
-		rsscache->do_vacuum();
-		std::cout << _("done.") << std::endl;
-		return EXIT_SUCCESS;
-	}
-
 	unsigned int i = 0;
 	for (const auto& url : urlcfg->get_urls()) {
 		try {
-			bool ignore_disp =
-				(cfg.get_configvalue("ignore-mode") ==
-					"display");
-			std::shared_ptr<RssFeed> feed =
-				rsscache->internalize_rssfeed(
-					url, ignore_disp ? &ign : nullptr);
+			std::shared_ptr<RssFeed> feed;
+			if (load_articles) {
+				feed = rsscache->internalize_rssfeed(
+						url, ignore_disp ? &ign : nullptr);
+			} else {
+				feed = rsscache->internalize_rssfeed_without_items(
+						url);
+			}
 			feed->set_tags(urlcfg->get_tags(url));
 			feed->set_order(i);
 			feedcontainer.add_feed(feed);
@@ -409,21 +445,22 @@ int Controller::run(const CliArgsParser& args)
 
 	std::vector<std::string> tags = urlcfg->get_alltags();
 
-	if (!args.do_export() && !args.silent()) {
+	if (load_articles && !args.silent()) {
 		std::cout << _("done.") << std::endl;
 	}
 
 	// if configured, we fill all query feeds with some data; no need to
 	// sort it, it will be refilled when actually opening it.
-	if (cfg.get_configvalue_as_bool("prepopulate-query-feeds")) {
-		if (!args.do_export() && !args.silent()) {
+	if (load_articles &&
+		cfg.get_configvalue_as_bool("prepopulate-query-feeds")) {
+		if (!args.silent()) {
 			std::cout << _("Prepopulating query feeds...");
 			std::cout.flush();
 		}
 
 		feedcontainer.populate_query_feeds();
 
-		if (!args.do_export() && !args.silent()) {
+		if (!args.silent()) {
 			std::cout << _("done.") << std::endl;
 		}
 	}
@@ -435,28 +472,6 @@ int Controller::run(const CliArgsParser& args)
 		return EXIT_SUCCESS;
 	}
 
-	if (args.do_read_import()) {
-		LOG(Level::INFO,
-			"Importing read information file from %s",
-			args.readinfo_import_file());
-		std::cout << _("Importing list of read articles...");
-		std::cout.flush();
-		import_read_information(args.readinfo_import_file());
-		std::cout << _("done.") << std::endl;
-		return EXIT_SUCCESS;
-	}
-
-	if (args.do_read_export()) {
-		LOG(Level::INFO,
-			"Exporting read information file to %s",
-			args.readinfo_export_file());
-		std::cout << _("Exporting list of read articles...");
-		std::cout.flush();
-		export_read_information(args.readinfo_export_file());
-		std::cout << _("done.") << std::endl;
-		return EXIT_SUCCESS;
-	}
-
 	// hand over the important objects to the View
 	v->set_config_container(&cfg);
 	v->set_keymap(&keys);
@@ -469,25 +484,51 @@ int Controller::run(const CliArgsParser& args)
 		return EXIT_SUCCESS;
 	}
 
-	// if the user wants to refresh on startup via configuration file, then
-	// do so, but only if -r hasn't been supplied.
-	if (!refresh_on_start &&
-		cfg.get_configvalue_as_bool("refresh-on-startup")) {
-		refresh_on_start = true;
-	}
+	int ret;
+	if (args.do_daemon()) {
+		if (!args.silent()) {
+			std::cout << strprintf::fmt(
+					_("Running as a daemon, listening on %s"),
+					control_socket_path())
+				<< std::endl;
+		}
+		Daemon daemon(this, reloader.get(), &cfg, control_socket_path());
+		ret = daemon.run();
+	} else {
+		// if the user wants to refresh on startup via configuration file,
+		// then do so, but only if -r hasn't been supplied.
+		if (!refresh_on_start &&
+			cfg.get_configvalue_as_bool("refresh-on-startup")) {
+			refresh_on_start = true;
+		}
+
+		FormAction::load_histories(
+			configpaths.search_file(), configpaths.cmdline_file());
 
-	FormAction::load_histories(
-		configpaths.search_file(), configpaths.cmdline_file());
+		// run the View
+		ret = v->run();
 
-	// run the View
-	int ret = v->run();
+		unsigned int history_limit =
+			cfg.get_configvalue_as_int("history-limit");
+		LOG(Level::DEBUG,
+			"Controller::run: history-limit = %u",
+			history_limit);
+		FormAction::save_histories(configpaths.search_file(),
+			configpaths.cmdline_file(),
+			history_limit);
+	}
 
-	unsigned int history_limit =
-		cfg.get_configvalue_as_int("history-limit");
-	LOG(Level::DEBUG, "Controller::run: history-limit = %u", history_limit);
-	FormAction::save_histories(configpaths.search_file(),
-		configpaths.cmdline_file(),
-		history_limit);
+	if (remote_sync) {
+		// Whatever can't be sent now is sent on the next start
+		if (!args.silent()) {
+			std::cout << _("Sending changes to the server...");
+			std::cout.flush();
+		}
+		const bool synced = remote_sync->flush();
+		if (!args.silent()) {
+			std::cout << (synced ? _("done.") : _("failed.")) << std::endl;
+		}
+	}
 
 	if (!args.silent()) {
 		std::cout << _("Cleaning up cache...");
@@ -510,6 +551,44 @@ int Controller::run(const CliArgsParser& args)
 	return ret;
 }
 
+Controller::CacheData Controller::needed_cache_data(const CliArgsParser& args)
+{
+	// The order of checks mirrors the order in which run() handles the
+	// modes, so that the mode which actually runs gets what it needs.
+	if (args.do_vacuum()) {
+		return CacheData::NOTHING;
+	}
+
+	if (args.do_export()) {
+		// OPML only contains feeds' URLs and titles
+		return CacheData::FEEDS;
+	}
+
+	if (args.do_read_import() || args.do_read_export()) {
+		// These work on the database directly
+		return CacheData::NOTHING;
+	}
+
+	if (args.execute_cmds()) {
+		CacheData needed = CacheData::FEEDS;
+		for (const auto& cmd : args.cmds_to_execute()) {
+			if (cmd == "print-unread") {
+				// Unread count has to respect ignores and max-items,
+				// which are applied while loading articles
+				needed = CacheData::ARTICLES;
+			} else if (cmd == "reload" &&
+				reloader->notifications_enabled()) {
+				// Notifications report how many unread articles were
+				// added, so we need to know how many there were before
+				needed = CacheData::ARTICLES;
+			}
+		}
+		return needed;
+	}
+
+	return CacheData::ARTICLES;
+}
+
 void Controller::update_feedlist()
 {
 	std::lock_guard<std::mutex> feedslock(feeds_mutex);
@@ -534,10 +613,10 @@ void Controller::mark_all_read(const std::string& feedurl)
 	}
 
 	if (feedurl.empty()) { // Mark all feeds as read
-		if (api) {
+		if (remote_sync) {
 			std::lock_guard<std::mutex> feedslock(feeds_mutex);
 			for (const auto& feed : feedcontainer.feeds) {
-				api->mark_all_read(feed->rssurl());
+				remote_sync->mark_all_read(feed->rssurl());
 			}
 		}
 		feedcontainer.mark_all_feeds_read();
@@ -548,8 +627,8 @@ void Controller::mark_all_read(const std::string& feedurl)
 			return;
 		}
 
-		if (api) {
-			api->mark_all_read(feed->rssurl());
+		if (remote_sync) {
+			remote_sync->mark_all_read(feed->rssurl());
 		}
 
 		feed->mark_all_items_read();
@@ -558,28 +637,27 @@ void Controller::mark_all_read(const std::string& feedurl)
 
 void Controller::mark_article_read(const std::string& guid, bool read)
 {
-	if (api) {
-		api->mark_article_read(guid, read);
+	if (remote_sync) {
+		remote_sync->mark_article_read(guid, read);
 	}
 }
 
 void Controller::mark_all_read(unsigned int pos)
 {
 	if (pos < feedcontainer.feeds.size()) {
-		ScopeMeasure m("Controller::mark_all_read");
+		static auto& timings =
+			MetricsRegistry::global().histogram("controller.mark_feed_read");
+		ScopeTimer timer(timings);
 		std::lock_guard<std::mutex> feedslock(feeds_mutex);
 		const auto feed = feedcontainer.get_feed(pos);
 		if (feed->is_query_feed()) {
 			rsscache->mark_all_read(feed);
 		} else {
 			rsscache->mark_all_read(feed->rssurl());
-			if (api) {
-				api->mark_all_read(feed->rssurl());
+			if (remote_sync) {
+				remote_sync->mark_all_read(feed->rssurl());
 			}
 		}
-		m.stopover(
-			"after rsscache->mark_all_read, before iteration over "
-			"items");
 
 		feedcontainer.mark_all_feed_items_read(pos);
 	}
@@ -588,17 +666,24 @@ void Controller::mark_all_read(unsigned int pos)
 void Controller::replace_feed(std::shared_ptr<RssFeed> oldfeed,
 	std::shared_ptr<RssFeed> newfeed,
 	unsigned int pos,
-	bool unattended)
+	bool unattended,
+	FeedReloadStats* stats)
 {
 	std::lock_guard<std::mutex> feedslock(feeds_mutex);
 
 	LOG(Level::DEBUG, "Controller::replace_feed: saving");
 	rsscache->externalize_rssfeed(
-		newfeed, ign.matches_resetunread(newfeed->rssurl()));
+		newfeed, ign.matches_resetunread(newfeed->rssurl()), stats);
 	LOG(Level::DEBUG,
 		"Controller::replace_feed: after externalize_rssfeed");
 
-	bool ignore_disp = (cfg.get_configvalue("ignore-mode") == "display");
+	// The parsed articles are in the cache now. Free them before reading
+	// the feed back, so that the long-lived articles aren't interleaved
+	// with dead ones on the heap.
+	newfeed->clear_items();
+
+	bool ignore_disp =
+		(cfg.snapshot()->get(ConfigKey::IGNORE_MODE) == "display");
 	std::shared_ptr<RssFeed> feed = rsscache->internalize_rssfeed(
 			oldfeed->rssurl(), ignore_disp ? &ign : nullptr);
 	LOG(Level::DEBUG,
@@ -607,8 +692,9 @@ void Controller::replace_feed(std::shared_ptr<RssFeed> oldfeed,
 	feed->set_tags(urlcfg->get_tags(oldfeed->rssurl()));
 	feed->set_order(oldfeed->get_order());
 	feedcontainer.feeds[pos] = feed;
-	queueManager.autoenqueue(feed);
-	for (const auto& item : feed->items()) {
+	// Articles were just read from the cache, so only the ones that got
+	// enqueued need to be written back
+	for (const auto& item : queueManager.autoenqueue(feed)) {
 		rsscache->update_rssitem_unread_and_enqueued(item, feed->rssurl());
 	}
 
@@ -686,6 +772,8 @@ void Controller::reload_urls_file()
 	urlcfg->reload();
 	std::vector<std::shared_ptr<RssFeed>> new_feeds;
 	unsigned int i = 0;
+	const bool ignore_disp =
+		(cfg.snapshot()->get(ConfigKey::IGNORE_MODE) == "display");
 
 	for (const auto& url : urlcfg->get_urls()) {
 		const auto feed = feedcontainer.get_feed_by_url(url);
@@ -695,9 +783,6 @@ void Controller::reload_urls_file()
 			new_feeds.push_back(feed);
 		} else {
 			try {
-				bool ignore_disp =
-					(cfg.get_configvalue("ignore-mode") ==
-						"display");
 				std::shared_ptr<RssFeed> new_feed =
 					rsscache->internalize_rssfeed(url,
 						ignore_disp ? &ign : nullptr);
@@ -748,6 +833,29 @@ void Controller::edit_urls_file()
 	reload_urls_file();
 }
 
+void Controller::print_slowest_feeds()
+{
+	for (const auto& stats : rsscache->get_reload_stats(10)) {
+		std::string outcome;
+		if (!stats.error.empty()) {
+			outcome = _("error");
+		} else if (stats.not_modified) {
+			outcome = _("not modified");
+		} else {
+			outcome = strprintf::fmt(_("%" PRIu64 " bytes, %u new, "
+						"%u changed"),
+					stats.bytes,
+					stats.items_new,
+					stats.items_changed);
+		}
+		std::cout << strprintf::fmt("%7.1fs  %s  (%s)",
+				stats.total_us / 1000000.0,
+				utils::censor_url(stats.rssurl),
+				outcome)
+			<< std::endl;
+	}
+}
+
 int Controller::execute_commands(const std::vector<std::string>& cmds)
 {
 	if (v->formaction_stack_size() > 0) {
@@ -763,6 +871,11 @@ int Controller::execute_commands(const std::vector<std::string>& cmds)
 			std::cout << strprintf::fmt(_("%u unread articles"),
 					feedcontainer.unread_item_count())
 				<< std::endl;
+		} else if (cmd == "stats") {
+			std::cout << MetricsRegistry::global().to_json()
+				<< std::endl;
+		} else if (cmd == "slowest-feeds") {
+			print_slowest_feeds();
 		} else {
 			std::cerr
 					<< strprintf::fmt(_("%s: %s: unknown command"),
@@ -775,6 +888,36 @@ int Controller::execute_commands(const std::vector<std::string>& cmds)
 	return EXIT_SUCCESS;
 }
 
+std::string Controller::control_socket_path() const
+{
+	return configpaths.cache_file() + ".sock";
+}
+
+int Controller::execute_commands_in_daemon(
+	const std::vector<std::string>& cmds)
+{
+	std::vector<std::string> replies;
+	if (!Daemon::send_commands(control_socket_path(), cmds, replies)) {
+		return EXIT_FAILURE;
+	}
+
+	int ret = EXIT_SUCCESS;
+	for (const auto& reply : replies) {
+		if (reply.compare(0, 2, "OK") == 0) {
+			if (reply.length() > 3) {
+				std::cout << reply.substr(3) << std::endl;
+			}
+		} else {
+			std::cerr << strprintf::fmt("%s: %s",
+					"newsboat",
+					reply.substr(std::min<size_t>(4, reply.length())))
+				<< std::endl;
+			ret = EXIT_FAILURE;
+		}
+	}
+	return ret;
+}
+
 std::string Controller::write_temporary_item(std::shared_ptr<RssItem> item)
 {
 	char filename[_POSIX_PATH_MAX];
@@ -816,6 +959,38 @@ void Controller::write_item(std::shared_ptr<RssItem> item, std::ostream& ostr)
 	ostr << item_renderer::to_plain_text(cfg, item) << std::endl;
 }
 
+std::vector<std::string> Controller::write_items(
+	const std::vector<std::shared_ptr<RssItem>>& items,
+	const std::vector<std::string>& filenames,
+	const std::function<void(size_t)>& progress)
+{
+	std::vector<std::string> failed;
+	item_renderer::to_plain_text_batch(cfg, items,
+	[&](size_t idx, const std::string& text, bool rendered) {
+		if (!rendered) {
+			// Don't leave an empty file behind that looks like it was
+			// saved
+			failed.push_back(filenames[idx]);
+			progress(idx + 1);
+			return;
+		}
+
+		std::fstream f;
+		f.open(filenames[idx].c_str(), std::fstream::out);
+		if (f.is_open()) {
+			f << text << std::endl;
+		}
+		if (!f.is_open() || !f.good()) {
+			LOG(Level::ERROR,
+				"Controller::write_items: couldn't write `%s'",
+				filenames[idx]);
+			failed.push_back(filenames[idx]);
+		}
+		progress(idx + 1);
+	});
+	return failed;
+}
+
 void Controller::import_read_information(const std::string& readinfofile)
 {
 	std::vector<std::string> guids;
@@ -905,8 +1080,8 @@ void Controller::dump_config(const std::string& filename)
 
 void Controller::update_flags(std::shared_ptr<RssItem> item)
 {
-	if (api) {
-		api->update_article_flags(
+	if (remote_sync) {
+		remote_sync->update_article_flags(
 			item->oldflags(), item->flags(), item->guid());
 	}
 	item->update_flags();
@@ -0,0 +1,442 @@
+#include "daemon.h"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+#include "config.h"
+#include "configcontainer.h"
+#include "controller.h"
+#include "feedcontainer.h"
+#include "logger.h"
+#include "metrics.h"
+#include "reloader.h"
+#include "rssfeed.h"
+#include "strprintf.h"
+#include "utils.h"
+
+namespace {
+
+volatile std::sig_atomic_t got_quit_signal = 0;
+
+void quit_signal_handler(int /* sig */)
+{
+	got_quit_signal = 1;
+}
+
+bool fill_address(const std::string& path, struct sockaddr_un& addr)
+{
+	if (path.length() >= sizeof(addr.sun_path)) {
+		return false;
+	}
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+	return true;
+}
+
+bool send_all(int fd, const std::string& data)
+{
+	size_t sent = 0;
+	while (sent < data.length()) {
+		const ssize_t n = ::send(fd,
+				data.data() + sent,
+				data.length() - sent,
+				MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		sent += n;
+	}
+	return true;
+}
+
+/// Reads the next line from \a fd into \a line, using \a buffer to keep the
+/// data that was received past the end of the line.
+bool receive_line(int fd, std::string& buffer, std::string& line)
+{
+	for (;;) {
+		const auto newline = buffer.find('\n');
+		if (newline != std::string::npos) {
+			line = buffer.substr(0, newline);
+			buffer.erase(0, newline + 1);
+			return true;
+		}
+
+		char chunk[1024];
+		const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		buffer.append(chunk, n);
+	}
+}
+
+} // namespace
+
+namespace newsboat {
+
+Daemon::Daemon(Controller* ctrl,
+	Reloader* reloader,
+	ConfigContainer* cfg,
+	const std::string& socket_path)
+	: ctrl(ctrl)
+	, reloader(reloader)
+	, cfg(cfg)
+	, socket_path(socket_path)
+	, listen_fd(-1)
+	, quitting(false)
+	, reloading(false)
+	, last_reload(0)
+{
+}
+
+Daemon::~Daemon()
+{
+	if (listen_fd != -1) {
+		::close(listen_fd);
+		::unlink(socket_path.c_str());
+	}
+}
+
+bool Daemon::open_socket()
+{
+	struct sockaddr_un addr;
+	if (!fill_address(socket_path, addr)) {
+		LOG(Level::USERERROR,
+			"Daemon: socket path `%s' is too long",
+			socket_path);
+		return false;
+	}
+
+	listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd == -1) {
+		LOG(Level::USERERROR,
+			"Daemon: couldn't create socket: %s",
+			std::strerror(errno));
+		return false;
+	}
+
+	// We're holding the cache lock, so nobody else can be listening on
+	// this socket; whatever is left there is from a crashed daemon.
+	::unlink(socket_path.c_str());
+
+	// Commands can mark articles read and trigger network traffic, so only
+	// the owner should be able to connect.
+	const mode_t old_umask = ::umask(0077);
+	const int bound = ::bind(listen_fd,
+			reinterpret_cast<struct sockaddr*>(&addr),
+			sizeof(addr));
+	::umask(old_umask);
+
+	if (bound == -1 || ::listen(listen_fd, 8) == -1) {
+		LOG(Level::USERERROR,
+			"Daemon: couldn't listen on `%s': %s",
+			socket_path,
+			std::strerror(errno));
+		::close(listen_fd);
+		listen_fd = -1;
+		return false;
+	}
+
+	LOG(Level::INFO, "Daemon: listening on `%s'", socket_path);
+	return true;
+}
+
+int Daemon::run()
+{
+	if (!open_socket()) {
+		return EXIT_FAILURE;
+	}
+
+	got_quit_signal = 0;
+	::signal(SIGINT, quit_signal_handler);
+	::signal(SIGTERM, quit_signal_handler);
+
+	std::thread scheduler(&Daemon::reload_periodically, this);
+
+	for (;;) {
+		if (got_quit_signal) {
+			LOG(Level::INFO, "Daemon::run: got a signal, quitting");
+			request_quit();
+		}
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if (quitting) {
+				break;
+			}
+		}
+
+		// Wake up every second to check for signals and "quit" commands
+		struct pollfd pfd;
+		pfd.fd = listen_fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		const int ready = ::poll(&pfd, 1, 1000);
+		if (ready < 0 && errno != EINTR) {
+			LOG(Level::ERROR,
+				"Daemon::run: poll() failed: %s",
+				std::strerror(errno));
+			request_quit();
+		}
+		if (ready <= 0) {
+			continue;
+		}
+
+		const int fd = ::accept(listen_fd, nullptr, nullptr);
+		if (fd == -1) {
+			continue;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			connections.insert(fd);
+		}
+		std::thread(&Daemon::handle_connection, this, fd).detach();
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mtx);
+		for (const int fd : connections) {
+			::shutdown(fd, SHUT_RDWR);
+		}
+		state_changed.wait(lock, [this]() {
+			return connections.empty();
+		});
+	}
+	scheduler.join();
+
+	return EXIT_SUCCESS;
+}
+
+void Daemon::handle_connection(int fd)
+{
+	// Don't let a client that never sends anything occupy a thread forever
+	struct timeval timeout;
+	timeout.tv_sec = 30;
+	timeout.tv_usec = 0;
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	std::string buffer;
+	std::string command;
+	while (receive_line(fd, buffer, command)) {
+		if (!send_all(fd, execute(command) + "\n")) {
+			break;
+		}
+	}
+
+	// Notify while holding the lock: once run() sees no connections, it
+	// returns and the Daemon is destroyed, so this thread mustn't touch it
+	// after unlocking
+	std::lock_guard<std::mutex> lock(mtx);
+	connections.erase(fd);
+	::close(fd);
+	state_changed.notify_all();
+}
+
+std::string Daemon::execute(const std::string& line)
+{
+	std::string command = line;
+	utils::trim(command);
+
+	std::string argument;
+	const auto space = command.find(' ');
+	if (space != std::string::npos) {
+		argument = command.substr(space + 1);
+		utils::trim(argument);
+		command.erase(space);
+	}
+
+	LOG(Level::DEBUG,
+		"Daemon::execute: command = `%s' argument = `%s'",
+		command,
+		argument);
+
+	if (command == "reload") {
+		if (argument.empty()) {
+			if (!reload_all()) {
+				return "ERR " + std::string(_("a reload is already in progress"));
+			}
+		} else if (!reload_feed(argument)) {
+			return "ERR " + strprintf::fmt(
+					_("couldn't reload `%s': no such feed, or a reload is "
+						"already in progress"),
+					argument);
+		}
+		return "OK";
+	} else if (command == "mark-read") {
+		if (!argument.empty() &&
+			!ctrl->get_feedcontainer()->get_feed_by_url(argument)) {
+			return "ERR " + strprintf::fmt(_("no such feed: %s"), argument);
+		}
+		ctrl->mark_all_read(argument);
+		return "OK";
+	} else if (command == "print-unread") {
+		return "OK " + strprintf::fmt(_("%u unread articles"),
+				ctrl->get_feedcontainer()->unread_item_count());
+	} else if (command == "stats") {
+		return "OK " + stats();
+	} else if (command == "quit") {
+		request_quit();
+		return "OK";
+	}
+
+	return "ERR " + strprintf::fmt(_("unknown command: %s"), command);
+}
+
+std::string Daemon::stats()
+{
+	unsigned int total_articles = 0;
+	const auto feeds = ctrl->get_feedcontainer()->get_all_feeds();
+	for (const auto& feed : feeds) {
+		total_articles += feed->total_item_count();
+	}
+
+	bool is_reloading;
+	time_t last;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		is_reloading = reloading;
+		last = last_reload;
+	}
+
+	auto& metrics = MetricsRegistry::global();
+	metrics.gauge("feeds").set(feeds.size());
+	metrics.gauge("feeds.unread").set(
+		ctrl->get_feedcontainer()->unread_feed_count());
+	metrics.gauge("articles").set(total_articles);
+	metrics.gauge("articles.unread").set(
+		ctrl->get_feedcontainer()->unread_item_count());
+	metrics.gauge("daemon.reloading").set(is_reloading ? 1 : 0);
+	metrics.gauge("daemon.last_reload").set(last);
+
+	return metrics.to_json();
+}
+
+void Daemon::reload_periodically()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	while (!quitting) {
+		lock.unlock();
+		reload_all();
+		lock.lock();
+
+		int minutes = cfg->get_configvalue_as_int("reload-time");
+		if (minutes <= 0) {
+			minutes = 60;
+		}
+		state_changed.wait_for(lock,
+			std::chrono::minutes(minutes),
+		[this]() {
+			return quitting;
+		});
+	}
+}
+
+bool Daemon::reload_all()
+{
+	if (!reloader->trylock_reload_mutex()) {
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		reloading = true;
+	}
+	reloader->reload_all(true);
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		reloading = false;
+		last_reload = time(nullptr);
+	}
+
+	reloader->unlock_reload_mutex();
+	return true;
+}
+
+bool Daemon::reload_feed(const std::string& url)
+{
+	if (!reloader->trylock_reload_mutex()) {
+		return false;
+	}
+
+	// Reloads sort the feeds, so the position is only good while we're
+	// holding the lock
+	const auto all_feeds = ctrl->get_feedcontainer()->get_all_feeds();
+	unsigned int pos = 0;
+	while (pos < all_feeds.size() && all_feeds[pos]->rssurl() != url) {
+		pos++;
+	}
+	const bool found = pos < all_feeds.size();
+	if (found) {
+		reloader->reload(pos, all_feeds.size(), true);
+	}
+
+	reloader->unlock_reload_mutex();
+	return found;
+}
+
+void Daemon::request_quit()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		quitting = true;
+	}
+	state_changed.notify_all();
+}
+
+bool Daemon::send_commands(const std::string& socket_path,
+	const std::vector<std::string>& commands,
+	std::vector<std::string>& replies)
+{
+	struct sockaddr_un addr;
+	if (!fill_address(socket_path, addr)) {
+		return false;
+	}
+
+	const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1) {
+		return false;
+	}
+	if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+			sizeof(addr)) == -1) {
+		LOG(Level::DEBUG,
+			"Daemon::send_commands: couldn't connect to `%s': %s",
+			socket_path,
+			std::strerror(errno));
+		::close(fd);
+		return false;
+	}
+
+	// Commands are sent one at a time, so that a command like "quit" can't
+	// prevent the ones before it from being answered.
+	std::string buffer;
+	for (const auto& command : commands) {
+		std::string reply;
+		if (!send_all(fd, command + "\n") ||
+			!receive_line(fd, buffer, reply)) {
+			replies.push_back("ERR " + std::string(
+					_("connection to the daemon was lost")));
+			break;
+		}
+		replies.push_back(reply);
+	}
+
+	::close(fd);
+	return true;
+}
+
+} // namespace newsboat
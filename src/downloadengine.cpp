@@ -0,0 +1,1066 @@
+#include "downloadengine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <libgen.h>
+#include <limits>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "enclosureindex.h"
+#include "logger.h"
+#include "strprintf.h"
+#include "utils.h"
+
+using namespace newsboat;
+
+namespace podboat {
+
+namespace {
+
+// How long curl_multi_wait() may block. New downloads and changed limits
+// are picked up at least this often.
+const int POLL_INTERVAL_MS = 100;
+
+// Shorter wait while transfers are paused by the bandwidth limit, so that
+// they resume soon after the budget is refilled
+const int THROTTLED_POLL_INTERVAL_MS = 20;
+
+// Value in `scheduled` for downloads that already started; sequence numbers
+// start at 1
+const uint64_t RUNNING = 0;
+
+const uint64_t UNKNOWN_END = std::numeric_limits<uint64_t>::max();
+
+// Files are only split if each segment gets at least this many bytes
+const uint64_t MIN_SEGMENT_SIZE = 4 * 1024 * 1024;
+
+// How often the progress of downloads of known size is written to their
+// state file
+const std::chrono::seconds STATE_SAVE_INTERVAL(1);
+
+// How often progress and speed shown in the UI are updated
+const std::chrono::milliseconds PROGRESS_INTERVAL(250);
+
+// Received data is collected in buffers of this size per transfer before
+// it's written out. Segments start at multiples of this, so that writes
+// are aligned too.
+const size_t WRITE_BUFFER_SIZE = 256 * 1024;
+
+const std::string SEGMENTS_FILE_SUFFIX = ".segments";
+
+bool write_at(int fd, const char* data, size_t count, uint64_t offset)
+{
+	while (count > 0) {
+		const ssize_t written = ::pwrite(fd, data, count, offset);
+		if (written == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += written;
+		count -= written;
+		offset += written;
+	}
+	return true;
+}
+
+// Returns 0 or an errno value
+int preallocate(int fd, uint64_t size)
+{
+#ifdef __APPLE__
+	// No posix_fallocate() on macOS; at least have the file at its full
+	// size, so that writes don't keep extending it
+	return ftruncate(fd, size) == 0 ? 0 : errno;
+#else
+	return posix_fallocate(fd, 0, size);
+#endif
+}
+
+bool starts_with_nocase(const std::string& str, const std::string& prefix)
+{
+	return strncasecmp(str.c_str(), prefix.c_str(), prefix.size()) == 0;
+}
+
+// Returns the value of an ETag header without quotes, or an empty string for
+// weak ETags, which don't promise identical bytes
+std::string strong_etag(const std::string& value)
+{
+	const std::string whitespace = " \t\r\n";
+	const std::string::size_type first = value.find_first_not_of(whitespace);
+	if (first == std::string::npos || value.compare(first, 2, "W/") == 0) {
+		return "";
+	}
+	std::string etag =
+		value.substr(first, value.find_last_not_of(whitespace) - first + 1);
+	if (etag.size() >= 2 && etag.front() == '"' && etag.back() == '"') {
+		etag = etag.substr(1, etag.size() - 2);
+	}
+	return etag;
+}
+
+void create_parent_directories(const std::string& path)
+{
+	// ::dirname() needs a non-const char*
+	std::vector<char> directory(path.begin(), path.end());
+	directory.push_back('\0');
+	utils::mkdir_parents(dirname(&directory[0]));
+}
+
+// Makes \a target another name of the downloaded file \a existing
+bool link_duplicate(const std::string& existing, const std::string& target)
+{
+	if (existing.empty()) {
+		return false;
+	}
+	if (existing == target) {
+		return access(target.c_str(), F_OK) == 0;
+	}
+
+	create_parent_directories(target);
+	if (::link(existing.c_str(), target.c_str()) != 0) {
+		// E.g. the download path is on another filesystem
+		LOG(Level::INFO,
+			"DownloadEngine: couldn't link %s to %s: %s",
+			existing,
+			target,
+			strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+// Replaces \a filename with a link to \a existing, which has the same content
+bool replace_with_link(const std::string& existing, const std::string& filename)
+{
+	const std::string temporary = filename + ".dedup";
+	if (::link(existing.c_str(), temporary.c_str()) != 0) {
+		return false;
+	}
+	if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+		::unlink(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+} // namespace
+
+DownloadEngine::DownloadEngine(ConfigContainer* cfg, EnclosureIndex* index)
+	: cfg(cfg)
+	, index(index)
+	, deduplicate(index != nullptr
+		  && cfg->get_configvalue_as_bool("podcast-deduplicate"))
+	, multi(curl_multi_init())
+	, next_sequence(RUNNING + 1)
+	, stopping(false)
+	, max_parallel(1)
+	, bandwidth_limit(0)
+	, max_segments(1)
+	, bandwidth_budget(0)
+{
+	worker = std::thread(&DownloadEngine::run, this);
+}
+
+DownloadEngine::~DownloadEngine()
+{
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		stopping = true;
+	}
+	wakeup.notify_all();
+	worker.join();
+	curl_multi_cleanup(multi);
+}
+
+void DownloadEngine::enqueue(Download* dl, Priority priority)
+{
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		const auto it = scheduled.find(dl);
+		if (it != scheduled.end()
+			&& (it->second == RUNNING || priority == Priority::NORMAL)) {
+			return;
+		}
+		const uint64_t sequence = next_sequence++;
+		scheduled[dl] = sequence;
+		pending.push({dl, priority, sequence});
+	}
+	wakeup.notify_all();
+}
+
+void DownloadEngine::clear_pending()
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	while (!pending.empty()) {
+		const Pending& entry = pending.top();
+		const auto it = scheduled.find(entry.dl);
+		if (it != scheduled.end() && it->second == entry.sequence) {
+			scheduled.erase(it);
+		}
+		pending.pop();
+	}
+}
+
+bool DownloadEngine::clear_pending_if_idle()
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	// Running downloads only leave `scheduled` with `mtx` held, once the
+	// worker is done with them
+	for (const auto& entry : scheduled) {
+		if (entry.second == RUNNING) {
+			return false;
+		}
+	}
+	while (!pending.empty()) {
+		pending.pop();
+	}
+	scheduled.clear();
+	return true;
+}
+
+void DownloadEngine::set_max_parallel(unsigned int max)
+{
+	max_parallel = max;
+	wakeup.notify_all();
+}
+
+void DownloadEngine::set_bandwidth_limit(uint64_t bytes_per_second)
+{
+	bandwidth_limit = bytes_per_second;
+}
+
+void DownloadEngine::set_max_segments(unsigned int segments)
+{
+	max_segments = segments;
+}
+
+void DownloadEngine::run()
+{
+	budget_refilled_at = std::chrono::steady_clock::now();
+
+	while (start_pending()) {
+		if (jobs.empty()) {
+			std::unique_lock<std::mutex> lock(mtx);
+			wakeup.wait(lock, [&]() {
+				return stopping || !pending.empty();
+			});
+			continue;
+		}
+
+		int running = 0;
+		curl_multi_perform(multi, &running);
+
+		// Messages don't survive curl_multi_remove_handle(), so collect
+		// them before finishing any transfer
+		std::vector<std::pair<Transfer*, CURLcode>> done;
+		int remaining = 0;
+		while (CURLMsg* msg = curl_multi_info_read(multi, &remaining)) {
+			if (msg->msg == CURLMSG_DONE) {
+				char* transfer = nullptr;
+				curl_easy_getinfo(msg->easy_handle,
+					CURLINFO_PRIVATE,
+					&transfer);
+				done.emplace_back(
+					reinterpret_cast<Transfer*>(transfer),
+					msg->data.result);
+			}
+		}
+		for (const auto& d : done) {
+			finish(d.first, d.second);
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		for (const auto& job : jobs) {
+			if (job->split_pending) {
+				split(job.get());
+			} else if (has_state(job.get())
+				&& now - job->state_saved_at >= STATE_SAVE_INTERVAL) {
+				save_state(job.get());
+			}
+			if (now - job->sampled_at >= PROGRESS_INTERVAL) {
+				update_progress(job.get());
+			}
+		}
+
+		for (size_t i = 0; i < jobs.size();) {
+			if (jobs[i]->transfers == 0) {
+				finalize(jobs[i].get());
+			} else {
+				++i;
+			}
+		}
+
+		refill_bandwidth();
+
+		const bool throttled = std::any_of(transfers.begin(),
+				transfers.end(),
+		[](const std::unique_ptr<Transfer>& t) {
+			return t->paused;
+		});
+		curl_multi_wait(multi,
+			nullptr,
+			0,
+			throttled ? THROTTLED_POLL_INTERVAL_MS : POLL_INTERVAL_MS,
+			nullptr);
+	}
+
+	// Whatever is still running is aborted; the partial files stay, so
+	// the downloads can be resumed later
+	while (!transfers.empty()) {
+		Transfer* transfer = transfers.back().get();
+		transfer->job->dl->set_status(DlStatus::CANCELLED);
+		transfer->job->failed = true;
+		--transfer->job->transfers;
+		remove(transfer);
+	}
+	while (!jobs.empty()) {
+		finalize(jobs.back().get());
+	}
+}
+
+bool DownloadEngine::start_pending()
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	if (stopping) {
+		return false;
+	}
+
+	while (!pending.empty()) {
+		const Pending next = pending.top();
+		const auto it = scheduled.find(next.dl);
+		if (it == scheduled.end() || it->second != next.sequence) {
+			pending.pop();
+			continue;
+		}
+		if (next.priority == Priority::NORMAL
+			&& jobs.size() >= max_parallel) {
+			break;
+		}
+		pending.pop();
+		it->second = RUNNING;
+		start(next.dl);
+	}
+	return true;
+}
+
+void DownloadEngine::start(Download* dl)
+{
+	// Called with `mtx` held, so that clear_pending() can't return while a
+	// download is neither pending nor marked as downloading
+
+	if (deduplicate
+		&& access((dl->filename()
+				+ ConfigContainer::PARTIAL_FILE_SUFFIX).c_str(),
+			F_OK) != 0) {
+		const std::string existing = index->find_by_url(dl->url());
+		if (link_duplicate(existing, dl->filename())) {
+			LOG(Level::INFO,
+				"DownloadEngine::start: %s was already downloaded to %s",
+				dl->url(),
+				existing);
+			dl->set_status(DlStatus::READY);
+			scheduled.erase(dl);
+			return;
+		}
+	}
+
+	std::unique_ptr<Job> job(new Job());
+	job->dl = dl;
+	job->url = dl->url();
+	job->partial_filename =
+		dl->filename() + ConfigContainer::PARTIAL_FILE_SUFFIX;
+	job->fd = -1;
+	job->resumed = false;
+	job->size = 0;
+	job->initial_offset = 0;
+	job->received = 0;
+	job->transfers = 0;
+	job->split_pending = false;
+	job->failed = false;
+	job->duplicate = false;
+	job->reported_size = 0;
+	job->started_at = std::chrono::steady_clock::now();
+	job->state_saved_at = job->started_at;
+	job->sampled_at = job->started_at;
+
+	int flags = O_WRONLY | O_CREAT;
+	struct stat sb;
+	if (load_state(job.get())) {
+		LOG(Level::INFO,
+			"DownloadEngine::start: resuming %s in %" PRIu64
+			" segments, %" PRIu64 " of %" PRIu64 " bytes done",
+			dl->url(),
+			static_cast<uint64_t>(job->segments.size()),
+			job->initial_offset,
+			job->size);
+		job->resumed = true;
+	} else if (stat(job->partial_filename.c_str(), &sb) == 0) {
+		LOG(Level::INFO,
+			"DownloadEngine::start: stat ok: resuming %s from %" PRIi64,
+			dl->url(),
+			static_cast<int64_t>(sb.st_size));
+		job->segments.push_back({
+			0,
+			UNKNOWN_END,
+			static_cast<uint64_t>(sb.st_size)});
+		job->initial_offset = sb.st_size;
+		job->resumed = true;
+	} else {
+		LOG(Level::INFO,
+			"DownloadEngine::start: stat failed: starting normal "
+			"download of %s",
+			dl->url());
+
+		create_parent_directories(job->partial_filename);
+		job->segments.push_back({0, UNKNOWN_END, 0});
+		flags |= O_TRUNC;
+	}
+
+	job->fd = ::open(job->partial_filename.c_str(), flags, 0666);
+	if (job->fd == -1) {
+		LOG(Level::ERROR,
+			"DownloadEngine::start: couldn't open %s: %s",
+			job->partial_filename,
+			strerror(errno));
+		dl->set_status(DlStatus::FAILED);
+		scheduled.erase(dl);
+		return;
+	}
+
+	dl->set_offset(job->initial_offset);
+	dl->set_status(DlStatus::DOWNLOADING);
+
+	Job* started = job.get();
+	jobs.push_back(std::move(job));
+	for (size_t i = 0; i < started->segments.size(); ++i) {
+		const Segment& segment = started->segments[i];
+		if (segment.end == UNKNOWN_END
+			|| segment.done < segment.end - segment.start) {
+			start_transfer(started, i);
+		}
+	}
+}
+
+void DownloadEngine::start_transfer(Job* job, size_t segment)
+{
+	std::unique_ptr<Transfer> transfer(new Transfer());
+	transfer->engine = this;
+	transfer->job = job;
+	transfer->segment = segment;
+	transfer->handle = curl_easy_init();
+	transfer->paused = false;
+	transfer->accept_ranges = false;
+	transfer->content_length = 0;
+	transfer->encoded = false;
+	transfer->buffer.reserve(WRITE_BUFFER_SIZE);
+
+	CURL* handle = transfer->handle;
+	utils::set_common_curl_options(handle, cfg);
+	// Content-Length and byte ranges count the bytes as they're sent, so
+	// those have to be what ends up in the file. Enclosures are compressed
+	// already, so asking for gzip wouldn't save much anyway.
+	curl_easy_setopt(handle, CURLOPT_ENCODING, "identity");
+	curl_easy_setopt(handle, CURLOPT_HTTP_CONTENT_DECODING, 0L);
+	curl_easy_setopt(handle, CURLOPT_URL, job->url.c_str());
+	curl_easy_setopt(handle, CURLOPT_TIMEOUT, 0);
+	curl_easy_setopt(handle, CURLOPT_PRIVATE, transfer.get());
+	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, write_callback);
+	curl_easy_setopt(handle, CURLOPT_WRITEDATA, transfer.get());
+	curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, header_callback);
+	curl_easy_setopt(handle, CURLOPT_HEADERDATA, transfer.get());
+	curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0);
+#if LIBCURL_VERSION_NUM >= 0x072000
+	curl_easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, progress_callback);
+	curl_easy_setopt(handle, CURLOPT_XFERINFODATA, transfer.get());
+#else
+	curl_easy_setopt(handle, CURLOPT_PROGRESSFUNCTION, progress_callback);
+	curl_easy_setopt(handle, CURLOPT_PROGRESSDATA, transfer.get());
+#endif
+
+	const Segment& s = job->segments[segment];
+	if (s.end != UNKNOWN_END) {
+		const std::string range = strprintf::fmt("%" PRIu64 "-%" PRIu64,
+				s.start + s.done,
+				s.end - 1);
+		curl_easy_setopt(handle, CURLOPT_RANGE, range.c_str());
+	} else if (s.done > 0) {
+		curl_easy_setopt(handle,
+			CURLOPT_RESUME_FROM_LARGE,
+			static_cast<curl_off_t>(s.done));
+	}
+
+	curl_multi_add_handle(multi, handle);
+	++job->transfers;
+	transfers.push_back(std::move(transfer));
+}
+
+void DownloadEngine::headers_received(Transfer* transfer)
+{
+	long code = 0;
+	curl_easy_getinfo(transfer->handle, CURLINFO_RESPONSE_CODE, &code);
+	if (code != 200 && code != 206) {
+		// Redirect, or an error that curl will report
+		return;
+	}
+
+	Job* job = transfer->job;
+	const Segment& segment = job->segments[transfer->segment];
+	if (segment.end != UNKNOWN_END) {
+		if (code != 206) {
+			// The server sends the whole file rather than the range;
+			// writing that at the segment's offset would garble it
+			LOG(Level::WARN,
+				"DownloadEngine::headers_received: %s ignored a range "
+				"request",
+				job->url);
+			job->failed = true;
+		}
+		return;
+	}
+
+	// Anything else is a resume gone wrong, which curl reports
+	const bool resuming = segment.done > 0;
+	if (resuming != (code == 206)) {
+		return;
+	}
+
+	char* url = nullptr;
+	curl_easy_getinfo(transfer->handle, CURLINFO_EFFECTIVE_URL, &url);
+	if (url) {
+		job->effective_url = url;
+	}
+	job->etag = transfer->etag;
+	if (!resuming && find_duplicate(job, transfer->content_length)) {
+		return;
+	}
+
+	if (transfer->content_length == 0) {
+		return;
+	}
+	if (transfer->encoded) {
+		// We didn't ask for that, and ranges of an encoded body might not
+		// line up with each other, so the file is fetched in one piece
+		LOG(Level::INFO,
+			"DownloadEngine::headers_received: %s is sent encoded; not "
+			"splitting it",
+			job->url);
+		return;
+	}
+
+	// Now that the size is known, the download keeps a state file like
+	// split ones do, so that the preallocated partial file can be resumed
+	job->size = segment.done + transfer->content_length;
+	job->segments[0].end = job->size;
+	const int rc = preallocate(job->fd, job->size);
+	if (rc != 0) {
+		LOG(Level::WARN,
+			"DownloadEngine::headers_received: couldn't preallocate "
+			"%s: %s",
+			job->partial_filename,
+			strerror(rc));
+	}
+
+	const auto segments = split_segments(job->size, max_segments);
+	if (resuming || !transfer->accept_ranges || segments.size() < 2) {
+		save_state(job);
+		return;
+	}
+
+	// Other segments skip the redirects this transfer went through
+	if (!job->effective_url.empty()) {
+		job->url = job->effective_url;
+	}
+
+	// This transfer keeps going, but stops at the end of the first
+	// segment. The others are started by split() once curl returns.
+	job->segments = segments;
+	job->split_pending = true;
+
+	LOG(Level::INFO,
+		"DownloadEngine::headers_received: splitting %s (%" PRIu64
+		" bytes) into %" PRIu64 " segments",
+		job->dl->url(),
+		job->size,
+		static_cast<uint64_t>(segments.size()));
+}
+
+std::vector<DownloadEngine::Segment> DownloadEngine::split_segments(
+	uint64_t size,
+	unsigned int max_segments)
+{
+	const uint64_t count = std::max<uint64_t>(1,
+			std::min<uint64_t>(max_segments, size / MIN_SEGMENT_SIZE));
+
+	std::vector<Segment> segments;
+	for (uint64_t i = 0; i < count; ++i) {
+		const uint64_t start = i * size / count;
+		segments.push_back({start - start % WRITE_BUFFER_SIZE, size, 0});
+		if (i > 0) {
+			segments[i - 1].end = segments[i].start;
+		}
+	}
+	return segments;
+}
+
+bool DownloadEngine::find_duplicate(Job* job, uint64_t size)
+{
+	if (!deduplicate) {
+		return false;
+	}
+
+	// The URL we got redirected to often identifies the file better than
+	// the one in the feed, which may go through a tracking service
+	std::string existing = index->find_by_url(job->effective_url);
+	if (existing.empty() && size > 0) {
+		existing = index->find_by_etag(job->effective_url,
+				job->etag,
+				size);
+	}
+	if (!link_duplicate(existing, job->dl->filename())) {
+		return false;
+	}
+
+	LOG(Level::INFO,
+		"DownloadEngine::find_duplicate: %s is the same as %s",
+		job->dl->url(),
+		existing);
+	job->duplicate = true;
+	return true;
+}
+
+void DownloadEngine::split(Job* job)
+{
+	job->split_pending = false;
+	if (job->failed || job->dl->status() == DlStatus::CANCELLED) {
+		return;
+	}
+
+	for (size_t i = 1; i < job->segments.size(); ++i) {
+		start_transfer(job, i);
+	}
+	save_state(job);
+}
+
+void DownloadEngine::finish(Transfer* transfer, CURLcode result)
+{
+	Job* job = transfer->job;
+	const Segment& segment = job->segments[transfer->segment];
+
+	// A transfer that fetches more than its segment is stopped by the
+	// write callback, which curl reports as an error
+	const bool complete = (segment.end == UNKNOWN_END)
+		? (result == CURLE_OK)
+		: (segment.done == segment.end - segment.start);
+
+	LOG(Level::INFO,
+		"DownloadEngine::finish: %s, segment %" PRIu64 ": rc = %u (%s)",
+		job->dl->url(),
+		static_cast<uint64_t>(transfer->segment),
+		result,
+		curl_easy_strerror(result));
+
+	if (!complete && !job->duplicate) {
+		job->failed = true;
+	}
+	--job->transfers;
+	remove(transfer);
+}
+
+void DownloadEngine::finalize(Job* job)
+{
+	::close(job->fd);
+	update_progress(job);
+
+	Download* dl = job->dl;
+	const std::string partial_filename = job->partial_filename;
+	const std::string state_filename =
+		partial_filename + SEGMENTS_FILE_SUFFIX;
+	const bool tracked = has_state(job);
+	const bool downloaded = !job->failed && !job->duplicate;
+	bool restart = false;
+
+	if (downloaded) {
+		std::rename(partial_filename.c_str(), dl->filename().c_str());
+		if (tracked) {
+			::unlink(state_filename.c_str());
+		}
+		remember(job);
+	} else if (job->duplicate) {
+		// Only the headers were fetched
+		::unlink(partial_filename.c_str());
+		remember(job);
+	}
+
+	std::lock_guard<std::mutex> guard(mtx);
+	if (downloaded || job->duplicate) {
+		dl->set_status(DlStatus::READY);
+	} else if (dl->status() == DlStatus::CANCELLED) {
+		if (tracked) {
+			save_state(job);
+		}
+	} else if (job->resumed && job->received == 0) {
+		// The partial file might be what the server choked on, so try
+		// once more from scratch
+		::unlink(partial_filename.c_str());
+		::unlink(state_filename.c_str());
+		restart = true;
+	} else {
+		if (tracked) {
+			// Keep what we have; the next attempt resumes each segment
+			save_state(job);
+		} else {
+			::unlink(partial_filename.c_str());
+		}
+		dl->set_status(DlStatus::FAILED);
+	}
+
+	jobs.erase(std::remove_if(jobs.begin(),
+			jobs.end(),
+	[&](const std::unique_ptr<Job>& j) {
+		return j.get() == job;
+	}),
+	jobs.end());
+
+	if (restart) {
+		start(dl);
+	} else {
+		scheduled.erase(dl);
+	}
+}
+
+void DownloadEngine::remember(Job* job)
+{
+	if (!index) {
+		return;
+	}
+
+	const std::string filename = job->dl->filename();
+	if (deduplicate && !job->duplicate) {
+		const std::string existing = index->find_by_content(filename);
+		if (!existing.empty() && replace_with_link(existing, filename)) {
+			LOG(Level::INFO,
+				"DownloadEngine::remember: %s has the same content as %s, "
+				"linked them",
+				filename,
+				existing);
+		}
+	}
+
+	struct stat sb;
+	if (stat(filename.c_str(), &sb) != 0) {
+		return;
+	}
+	std::vector<std::string> urls = {job->dl->url()};
+	if (!job->effective_url.empty() && job->effective_url != job->dl->url()) {
+		urls.push_back(job->effective_url);
+	}
+	index->add(urls, filename, sb.st_size, job->etag);
+}
+
+void DownloadEngine::remove(Transfer* transfer)
+{
+	flush(transfer);
+	curl_multi_remove_handle(multi, transfer->handle);
+	curl_easy_cleanup(transfer->handle);
+
+	transfers.erase(std::remove_if(transfers.begin(),
+			transfers.end(),
+	[&](const std::unique_ptr<Transfer>& t) {
+		return t.get() == transfer;
+	}),
+	transfers.end());
+}
+
+bool DownloadEngine::flush(Transfer* transfer)
+{
+	if (transfer->buffer.empty()) {
+		return true;
+	}
+
+	Job* job = transfer->job;
+	Segment& segment = job->segments[transfer->segment];
+	const size_t count = transfer->buffer.size();
+	const uint64_t offset = segment.start + segment.done - count;
+	const bool written =
+		write_at(job->fd, transfer->buffer.data(), count, offset);
+	transfer->buffer.clear();
+	if (written) {
+		return true;
+	}
+
+	LOG(Level::ERROR,
+		"DownloadEngine::flush: couldn't write to %s: %s",
+		job->partial_filename,
+		strerror(errno));
+	// These bytes have to be fetched again
+	segment.done -= count;
+	job->received -= count;
+	job->failed = true;
+	return false;
+}
+
+bool DownloadEngine::has_state(const Job* job) const
+{
+	return job->segments.size() > 1 || job->segments[0].end != UNKNOWN_END;
+}
+
+bool DownloadEngine::load_state(Job* job)
+{
+	const std::string state_filename =
+		job->partial_filename + SEGMENTS_FILE_SUFFIX;
+	std::ifstream f(state_filename);
+	if (!f.is_open()) {
+		return false;
+	}
+
+	std::vector<Segment> segments;
+	const bool valid = read_state(f, segments)
+		&& access(job->partial_filename.c_str(), F_OK) == 0;
+
+	if (!valid) {
+		// Without a trustworthy state, there's no telling which parts
+		// of the partial file are filled in
+		LOG(Level::WARN,
+			"DownloadEngine::load_state: ignoring invalid %s",
+			state_filename);
+		::unlink(state_filename.c_str());
+		::unlink(job->partial_filename.c_str());
+		return false;
+	}
+
+	job->segments = segments;
+	job->size = segments.back().end;
+	for (const auto& segment : segments) {
+		job->initial_offset += segment.done;
+	}
+	return true;
+}
+
+void DownloadEngine::save_state(Job* job)
+{
+	job->state_saved_at = std::chrono::steady_clock::now();
+
+	// The state mustn't claim bytes that are still in buffers
+	for (const auto& transfer : transfers) {
+		if (transfer->job == job) {
+			flush(transfer.get());
+		}
+	}
+
+	std::ofstream f(job->partial_filename + SEGMENTS_FILE_SUFFIX,
+		std::ofstream::out | std::ofstream::trunc);
+	write_state(f, job->segments);
+}
+
+bool DownloadEngine::read_state(std::istream& in,
+	std::vector<Segment>& segments)
+{
+	// The number of segments comes first, so that a file that was cut
+	// short is noticed even if it ends between two segments. Each line has
+	// to be complete, or the last number might be cut short.
+	const auto line_ends = [&in]() {
+		return in.get() == '\n';
+	};
+
+	segments.clear();
+	uint64_t count = 0;
+	if (!(in >> count) || !line_ends() || count == 0) {
+		return false;
+	}
+
+	// Segments have to be back to back, starting at 0
+	for (uint64_t i = 0; i < count; ++i) {
+		uint64_t start = 0;
+		uint64_t end = 0;
+		uint64_t done = 0;
+		if (!(in >> start >> end >> done) || !line_ends()) {
+			return false;
+		}
+		const uint64_t expected_start =
+			segments.empty() ? 0 : segments.back().end;
+		if (start != expected_start || end <= start
+			|| done > end - start) {
+			return false;
+		}
+		segments.push_back({start, end, done});
+	}
+
+	return in.peek() == std::istream::traits_type::eof();
+}
+
+void DownloadEngine::write_state(std::ostream& out,
+	const std::vector<Segment>& segments)
+{
+	out << segments.size() << '\n';
+	for (const auto& segment : segments) {
+		out << segment.start << ' ' << segment.end << ' ' << segment.done
+			<< '\n';
+	}
+}
+
+void DownloadEngine::refill_bandwidth()
+{
+	const auto now = std::chrono::steady_clock::now();
+	const double elapsed =
+		std::chrono::duration<double>(now - budget_refilled_at).count();
+	budget_refilled_at = now;
+
+	const uint64_t limit = bandwidth_limit;
+	bandwidth_budget = refill_budget(bandwidth_budget, limit, elapsed);
+	if (limit > 0 && bandwidth_budget <= 0) {
+		return;
+	}
+
+	// Resume paused transfers, taking turns so that the same one doesn't
+	// always get the fresh budget first
+	if (!transfers.empty()) {
+		std::rotate(transfers.begin(),
+			transfers.begin() + 1,
+			transfers.end());
+	}
+	for (const auto& transfer : transfers) {
+		if (transfer->paused) {
+			transfer->paused = false;
+			curl_easy_pause(transfer->handle, CURLPAUSE_CONT);
+		}
+	}
+}
+
+int64_t DownloadEngine::refill_budget(int64_t budget,
+	uint64_t limit,
+	double elapsed)
+{
+	if (limit == 0) {
+		return 0;
+	}
+	// At most a second's worth, so that an idle period doesn't allow a
+	// burst above the limit afterwards
+	return std::min<int64_t>(budget + static_cast<int64_t>(limit * elapsed),
+			limit);
+}
+
+size_t DownloadEngine::write_callback(char* data, size_t size, size_t nmemb,
+	void* userp)
+{
+	Transfer* transfer = static_cast<Transfer*>(userp);
+	DownloadEngine* engine = transfer->engine;
+	Job* job = transfer->job;
+	const size_t bytes = size * nmemb;
+
+	if (job->failed || job->duplicate
+		|| job->dl->status() == DlStatus::CANCELLED) {
+		return 0;
+	}
+
+	if (engine->bandwidth_limit > 0) {
+		if (engine->bandwidth_budget <= 0) {
+			// curl hands us the same data again once we unpause
+			transfer->paused = true;
+			return CURL_WRITEFUNC_PAUSE;
+		}
+		engine->bandwidth_budget -= bytes;
+	}
+
+	Segment& segment = job->segments[transfer->segment];
+	size_t count = bytes;
+	if (segment.end != UNKNOWN_END) {
+		count = std::min<uint64_t>(count,
+				segment.end - segment.start - segment.done);
+	}
+
+	transfer->buffer.insert(transfer->buffer.end(), data, data + count);
+	segment.done += count;
+	job->received += count;
+	if (transfer->buffer.size() >= WRITE_BUFFER_SIZE
+		&& !engine->flush(transfer)) {
+		return 0;
+	}
+
+	// Less than `bytes` once the segment is complete, which stops the
+	// transfer
+	return count;
+}
+
+size_t DownloadEngine::header_callback(char* data, size_t size,
+	size_t nitems, void* userp)
+{
+	Transfer* transfer = static_cast<Transfer*>(userp);
+	const size_t bytes = size * nitems;
+	const std::string line(data, bytes);
+
+	const std::string accept_ranges = "accept-ranges:";
+	const std::string content_encoding = "content-encoding:";
+	const std::string content_length = "content-length:";
+	const std::string etag = "etag:";
+	if (starts_with_nocase(line, "HTTP/")) {
+		// Status line of a new response, e.g. after a redirect
+		transfer->accept_ranges = false;
+		transfer->content_length = 0;
+		transfer->encoded = false;
+		transfer->etag.clear();
+	} else if (starts_with_nocase(line, etag)) {
+		transfer->etag = strong_etag(line.substr(etag.size()));
+	} else if (starts_with_nocase(line, accept_ranges)) {
+		transfer->accept_ranges =
+			line.find("bytes", accept_ranges.size()) != std::string::npos;
+	} else if (starts_with_nocase(line, content_encoding)) {
+		std::string value = line.substr(content_encoding.size());
+		utils::trim(value);
+		transfer->encoded = !value.empty()
+			&& strcasecmp(value.c_str(), "identity") != 0;
+	} else if (starts_with_nocase(line, content_length)) {
+		transfer->content_length = std::strtoull(
+				line.c_str() + content_length.size(), nullptr, 10);
+	} else if (line == "\r\n" || line == "\n") {
+		transfer->engine->headers_received(transfer);
+	}
+	return bytes;
+}
+
+int DownloadEngine::progress_callback(void* clientp,
+	ProgressValue dltotal,
+	ProgressValue /* dlnow */,
+	ProgressValue /* ultotal */,
+	ProgressValue /* ulnow */)
+{
+	// Progress shown in the UI is updated by update_progress(); this is
+	// only here to notice cancellation while no data arrives
+	Transfer* transfer = static_cast<Transfer*>(clientp);
+	Job* job = transfer->job;
+	if (job->size == 0 && dltotal > 0) {
+		job->reported_size = static_cast<double>(dltotal);
+	}
+	if (job->failed || job->duplicate
+		|| job->dl->status() == DlStatus::CANCELLED) {
+		return -1;
+	}
+	return 0;
+}
+
+void DownloadEngine::update_progress(Job* job)
+{
+	const auto now = std::chrono::steady_clock::now();
+	job->sampled_at = now;
+
+	Download* dl = job->dl;
+	const double seconds =
+		std::chrono::duration<double>(now - job->started_at).count();
+	if (seconds > 0) {
+		dl->set_kbps(job->received / seconds / 1024);
+	}
+	const double total = job->size > 0
+		? job->size - job->initial_offset
+		: job->reported_size;
+	dl->set_progress(job->received, total);
+}
+
+} // namespace podboat
@@ -0,0 +1,232 @@
+#include "enclosureindex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "logger.h"
+#include "utils.h"
+
+using namespace newsboat;
+
+namespace podboat {
+
+namespace {
+
+const std::string NO_ETAG = "-";
+
+bool same_content(const std::string& a, const std::string& b)
+{
+	std::ifstream fa(a, std::ifstream::binary);
+	std::ifstream fb(b, std::ifstream::binary);
+	if (!fa.is_open() || !fb.is_open()) {
+		return false;
+	}
+
+	std::vector<char> buf_a(1024 * 1024);
+	std::vector<char> buf_b(buf_a.size());
+	while (fa && fb) {
+		fa.read(buf_a.data(), buf_a.size());
+		fb.read(buf_b.data(), buf_b.size());
+		if (fa.gcount() != fb.gcount()
+			|| !std::equal(buf_a.begin(),
+				buf_a.begin() + fa.gcount(),
+				buf_b.begin())) {
+			return false;
+		}
+	}
+	return fa.eof() && fb.eof();
+}
+
+// Host name part of a canonical URL
+std::string host_of(const std::string& canonical)
+{
+	return canonical.substr(0, canonical.find('/'));
+}
+
+} // namespace
+
+EnclosureIndex::EnclosureIndex(const std::string& index_file)
+	: index_file(index_file)
+{
+}
+
+void EnclosureIndex::load()
+{
+	entries.clear();
+
+	std::ifstream f(index_file);
+	std::string line;
+	unsigned int lines = 0;
+	while (std::getline(f, line)) {
+		const std::vector<std::string> fields = utils::tokenize_quoted(line);
+		if (fields.size() != 4) {
+			continue;
+		}
+		lines++;
+		Entry entry;
+		entry.size = std::strtoull(fields[1].c_str(), nullptr, 10);
+		entry.etag = (fields[2] == NO_ETAG) ? "" : fields[2];
+		entry.path = fields[3];
+		if (still_there(entry)) {
+			entries[fields[0]] = entry;
+		} else {
+			entries.erase(fields[0]);
+		}
+	}
+	f.close();
+
+	LOG(Level::DEBUG,
+		"EnclosureIndex::load: %u lines, %u entries",
+		lines,
+		static_cast<unsigned int>(entries.size()));
+	if (lines == entries.size()) {
+		return;
+	}
+
+	// Drop stale and overridden lines
+	std::ofstream out(index_file, std::ofstream::trunc);
+	for (const auto& entry : entries) {
+		out << utils::quote(entry.first) << " " << entry.second.size
+			<< " "
+			<< utils::quote(entry.second.etag.empty()
+				? NO_ETAG
+				: entry.second.etag)
+			<< " " << utils::quote(entry.second.path) << "\n";
+	}
+}
+
+std::string EnclosureIndex::find_by_url(const std::string& url) const
+{
+	const auto it = entries.find(canonical_url(url));
+	if (it != entries.end() && still_there(it->second)) {
+		return it->second.path;
+	}
+	return "";
+}
+
+std::string EnclosureIndex::find_by_etag(const std::string& url,
+	const std::string& etag,
+	uint64_t size) const
+{
+	if (etag.empty()) {
+		return "";
+	}
+	const std::string host = host_of(canonical_url(url));
+	for (const auto& entry : entries) {
+		if (entry.second.etag == etag && entry.second.size == size
+			&& host_of(entry.first) == host
+			&& still_there(entry.second)) {
+			return entry.second.path;
+		}
+	}
+	return "";
+}
+
+std::string EnclosureIndex::find_by_content(const std::string& filename)
+const
+{
+	struct stat sb;
+	if (stat(filename.c_str(), &sb) != 0) {
+		return "";
+	}
+
+	for (const auto& entry : entries) {
+		const Entry& e = entry.second;
+		if (e.size != static_cast<uint64_t>(sb.st_size)
+			|| e.path == filename) {
+			continue;
+		}
+		struct stat other;
+		if (stat(e.path.c_str(), &other) != 0
+			|| other.st_size != sb.st_size) {
+			continue;
+		}
+		if (other.st_dev == sb.st_dev && other.st_ino == sb.st_ino) {
+			// Already linked
+			continue;
+		}
+		if (same_content(filename, e.path)) {
+			return e.path;
+		}
+	}
+	return "";
+}
+
+void EnclosureIndex::add(const std::vector<std::string>& urls,
+	const std::string& path,
+	uint64_t size,
+	const std::string& etag)
+{
+	std::ofstream f(index_file, std::ofstream::app);
+	for (const auto& url : urls) {
+		const std::string key = canonical_url(url);
+		entries[key] = Entry{path, size, etag};
+		f << utils::quote(key) << " " << size << " "
+			<< utils::quote(etag.empty() ? NO_ETAG : etag) << " "
+			<< utils::quote(path) << "\n";
+	}
+}
+
+std::string EnclosureIndex::canonical_url(const std::string& url)
+{
+	// The scheme is dropped, as the same file is usually served over both
+	// HTTP and HTTPS
+	std::string rest = url;
+	const std::string::size_type scheme_end = rest.find("://");
+	if (scheme_end != std::string::npos) {
+		rest.erase(0, scheme_end + 3);
+	}
+
+	// Fragments are never sent to the server
+	rest = rest.substr(0, rest.find('#'));
+
+	const std::string::size_type path_start = rest.find_first_of("/?");
+	std::string host = rest.substr(0, path_start);
+	std::string path = (path_start == std::string::npos)
+		? "/"
+		: rest.substr(path_start);
+
+	std::transform(host.begin(), host.end(), host.begin(), ::tolower);
+	const std::vector<std::string> default_ports = {":80", ":443"};
+	for (const auto& port : default_ports) {
+		if (host.size() > port.size()
+			&& host.compare(host.size() - port.size(),
+				port.size(),
+				port) == 0) {
+			host.erase(host.size() - port.size());
+		}
+	}
+
+	std::string query;
+	const std::string::size_type query_start = path.find('?');
+	if (query_start != std::string::npos) {
+		std::istringstream params(path.substr(query_start + 1));
+		path.erase(query_start);
+		std::string param;
+		while (std::getline(params, param, '&')) {
+			if (param.empty() || param.compare(0, 4, "utm_") == 0) {
+				continue;
+			}
+			query.append(query.empty() ? "?" : "&");
+			query.append(param);
+		}
+	}
+	if (path.empty()) {
+		path = "/";
+	}
+
+	return host + path + query;
+}
+
+bool EnclosureIndex::still_there(const Entry& entry)
+{
+	struct stat sb;
+	return stat(entry.path.c_str(), &sb) == 0
+		&& static_cast<uint64_t>(sb.st_size) == entry.size;
+}
+
+} // namespace podboat
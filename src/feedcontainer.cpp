@@ -88,6 +88,15 @@ void FeedContainer::sort_feeds(const FeedSortStrategy& sort_strategy)
 			return cmp(a_item, b_item);
 		});
 		break;
+	case FeedSortMethod::RELOAD_TIME:
+		std::stable_sort(feeds.begin(),
+			feeds.end(),
+			[](std::shared_ptr<RssFeed> a,
+		std::shared_ptr<RssFeed> b) {
+			return a->last_reload_duration() <
+				b->last_reload_duration();
+		});
+		break;
 	}
 
 	switch (sort_strategy.sd) {
@@ -13,9 +13,9 @@
 #include "fmtstrformatter.h"
 #include "listformatter.h"
 #include "logger.h"
+#include "metrics.h"
 #include "reloader.h"
 #include "rssfeed.h"
-#include "scopemeasure.h"
 #include "strprintf.h"
 #include "utils.h"
 #include "view.h"
@@ -531,7 +531,7 @@ void FeedListFormAction::update_visible_feeds(
 
 	visible_feeds.clear();
 
-	bool show_read = cfg->get_configvalue_as_bool("show-read-feeds");
+	bool show_read = cfg->snapshot()->get_bool(ConfigKey::SHOW_READ_FEEDS);
 
 	unsigned int i = 0;
 	for (const auto& feed : feeds) {
@@ -558,7 +558,12 @@ void FeedListFormAction::set_feedlist(
 	unsigned int i = 0;
 	unread_feeds = 0;
 
-	std::string feedlist_format = cfg->get_configvalue("feedlist-format");
+	const std::string feedlist_format =
+		cfg->get_configvalue("feedlist-format");
+	if (!compiled_feedlist_format ||
+		compiled_feedlist_format->format() != feedlist_format) {
+		compiled_feedlist_format.reset(new CompiledFormat(feedlist_format));
+	}
 
 	ListFormatter listfmt;
 
@@ -569,7 +574,7 @@ void FeedListFormAction::set_feedlist(
 			++unread_feeds;
 		}
 
-		listfmt.add_line(format_line(feedlist_format,
+		listfmt.add_line(format_line(*compiled_feedlist_format,
 				feed.first,
 				feed.second,
 				width),
@@ -851,7 +856,9 @@ void FeedListFormAction::finished_qna(Operation op)
 
 void FeedListFormAction::mark_pos_if_visible(unsigned int pos)
 {
-	ScopeMeasure m1("FeedListFormAction::mark_pos_if_visible");
+	static auto& timings =
+		MetricsRegistry::global().histogram("ui.feedlist.mark_pos_if_visible");
+	ScopeTimer timer(timings);
 	unsigned int vpos = 0;
 	v->get_ctrl()->update_visible_feeds();
 	for (const auto& feed : visible_feeds) {
@@ -1010,7 +1017,8 @@ std::string FeedListFormAction::get_title(std::shared_ptr<RssFeed> feed)
 	return title;
 }
 
-std::string FeedListFormAction::format_line(const std::string& feedlist_format,
+std::string FeedListFormAction::format_line(
+	const CompiledFormat& feedlist_format,
 	std::shared_ptr<RssFeed> feed,
 	unsigned int pos,
 	unsigned int width)
@@ -1032,6 +1040,11 @@ std::string FeedListFormAction::format_line(const std::string& feedlist_format,
 	fmt.register_fmt('l', utils::censor_url(feed->link()));
 	fmt.register_fmt('L', utils::censor_url(feed->rssurl()));
 	fmt.register_fmt('d', utils::utf8_to_locale(feed->description()));
+	const uint64_t reload_us = feed->last_reload_duration();
+	fmt.register_fmt('R',
+		reload_us == 0
+		? ""
+		: strprintf::fmt("%.1fs", reload_us / 1000000.0));
 
 	auto formattedLine = fmt.do_format(feedlist_format, width);
 	if (unread_count > 0) {
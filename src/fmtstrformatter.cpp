@@ -22,10 +22,30 @@ extern "C" {
 		void* fmt,
 		const char* format,
 		std::uint32_t width);
+
+	void* rs_fmtstrformatter_compile(const char* format);
+
+	void rs_fmtstrformatter_compiled_free(void* compiled);
+
+	char* rs_fmtstrformatter_do_format_compiled(
+		void* fmt,
+		void* compiled,
+		std::uint32_t width);
 }
 
 namespace newsboat {
 
+CompiledFormat::CompiledFormat(const std::string& fmt)
+	: fmt(fmt)
+{
+	rs_compiled = rs_fmtstrformatter_compile(fmt.c_str());
+}
+
+CompiledFormat::~CompiledFormat()
+{
+	rs_fmtstrformatter_compiled_free(rs_compiled);
+}
+
 FmtStrFormatter::FmtStrFormatter()
 {
 	rs_fmt = rs_fmtstrformatter_new();
@@ -47,4 +67,11 @@ std::string FmtStrFormatter::do_format(const std::string& fmt,
 	return RustString(rs_fmtstrformatter_do_format(rs_fmt, fmt.c_str(), width));
 }
 
+std::string FmtStrFormatter::do_format(const CompiledFormat& fmt,
+	unsigned int width)
+{
+	return RustString(rs_fmtstrformatter_do_format_compiled(
+				rs_fmt, fmt.rs_compiled, width));
+}
+
 } // namespace newsboat
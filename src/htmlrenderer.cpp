@@ -662,8 +662,7 @@ void HtmlRenderer::render(std::istream& input,
 			case HtmlTag::H1:
 				if (line_is_nonempty(curline)) {
 					add_line(curline, tables, lines);
-					size_t llen =
-						utils::strwidth_stfl(curline);
+					size_t llen = stfl_text_width(curline);
 					prepare_new_line(curline,
 						tables.size() ? 0
 						: indent_level);
@@ -1125,7 +1124,7 @@ void HtmlRenderer::render_table(const HtmlRenderer::Table& table,
 					table.rows[row].cells[cell].text.size();
 					idx++)
 					width = std::max(width,
-							utils::strwidth_stfl(
+							stfl_text_width(
 								table.rows[row]
 								.cells[cell]
 								.text[idx]));
@@ -1190,7 +1189,7 @@ void HtmlRenderer::render_table(const HtmlRenderer::Table& table,
 						table.rows[row]
 						.cells[cell]
 						.text[idx]);
-					cell_width = utils::strwidth_stfl(
+					cell_width = stfl_text_width(
 							table.rows[row]
 							.cells[cell]
 							.text[idx]);
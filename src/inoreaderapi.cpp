@@ -1,5 +1,6 @@
 #include "inoreaderapi.h"
 
+#include <cinttypes>
 #include <cstring>
 #include <curl/curl.h>
 #include <json.h>
@@ -196,6 +197,13 @@ void InoreaderApi::add_custom_headers(curl_slist** custom_headers)
 }
 
 bool InoreaderApi::mark_all_read(const std::string& feedurl)
+{
+	return mark_all_read_until(feedurl, "", 0);
+}
+
+bool InoreaderApi::mark_all_read_until(const std::string& feedurl,
+	const std::string& /* newest */,
+	int64_t marked_at)
 {
 	std::string real_feedurl =
 		feedurl.substr(strlen(INOREADER_FEED_PREFIX));
@@ -205,6 +213,11 @@ bool InoreaderApi::mark_all_read(const std::string& feedurl)
 
 	std::string postcontent =
 		strprintf::fmt("s=%s&T=%s", real_feedurl, token);
+	// Articles that arrived after the user marked the feed read stay
+	// unread
+	if (marked_at > 0) {
+		postcontent.append(strprintf::fmt("&ts=%" PRId64, marked_at));
+	}
 
 	std::string result =
 		post_content(INOREADER_API_MARK_ALL_READ_URL, postcontent);
@@ -214,28 +227,44 @@ bool InoreaderApi::mark_all_read(const std::string& feedurl)
 
 bool InoreaderApi::mark_article_read(const std::string& guid, bool read)
 {
+	return mark_articles_read({guid}, read);
+}
+
+bool InoreaderApi::mark_articles_read(const std::vector<std::string>& guids,
+	bool read)
+{
+	if (guids.empty()) {
+		return true;
+	}
 	std::string token = get_new_token();
-	return mark_article_read_with_token(guid, read, token);
+	return mark_articles_read_with_token(guids, read, token);
 }
 
-bool InoreaderApi::mark_article_read_with_token(const std::string& guid,
+bool InoreaderApi::mark_articles_read_with_token(
+	const std::vector<std::string>& guids,
 	bool read,
 	const std::string& token)
 {
+	// Google Reader-style APIs take any number of `i` parameters
+	std::string ids;
+	for (const auto& guid : guids) {
+		ids.append(strprintf::fmt("i=%s&", guid));
+	}
+
 	std::string postcontent;
 
 	if (read) {
 		postcontent = strprintf::fmt(
-				"i=%s&a=user/-/state/com.google/read&r=user/-/state/"
+				"%sa=user/-/state/com.google/read&r=user/-/state/"
 				"com.google/kept-unread&ac=edit&T=%s",
-				guid,
+				ids,
 				token);
 	} else {
 		postcontent = strprintf::fmt(
-				"i=%s&r=user/-/state/com.google/read&a=user/-/state/"
+				"%sr=user/-/state/com.google/read&a=user/-/state/"
 				"com.google/kept-unread&a=user/-/state/com.google/"
 				"tracking-kept-unread&ac=edit&T=%s",
-				guid,
+				ids,
 				token);
 	}
 
@@ -243,7 +272,7 @@ bool InoreaderApi::mark_article_read_with_token(const std::string& guid,
 		post_content(INOREADER_API_EDIT_TAG_URL, postcontent);
 
 	LOG(Level::DEBUG,
-		"InoreaderApi::mark_article_read_with_token: postcontent = %s "
+		"InoreaderApi::mark_articles_read_with_token: postcontent = %s "
 		"result = %s",
 		postcontent,
 		result);
@@ -272,6 +301,20 @@ std::string InoreaderApi::get_new_token()
 	return result;
 }
 
+std::string InoreaderApi::get_delta_url(const std::string& feedurl,
+	time_t since,
+	const std::string& continuation)
+{
+	return greader_delta_url(feedurl, since, continuation);
+}
+
+bool InoreaderApi::get_unread_guids(const std::string& feedurl,
+	unsigned int limit,
+	std::unordered_set<std::string>& guids)
+{
+	return greader_unread_guids(feedurl, limit, guids);
+}
+
 bool InoreaderApi::update_article_flags(const std::string& inoflags,
 	const std::string& newflags,
 	const std::string& guid)
@@ -363,10 +406,23 @@ std::string InoreaderApi::post_content(const std::string& url,
 	curl_easy_setopt(handle, CURLOPT_WRITEDATA, &result);
 	curl_easy_setopt(handle, CURLOPT_POSTFIELDS, postdata.c_str());
 	curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
-	curl_easy_perform(handle);
+	const CURLcode res = curl_easy_perform(handle);
+	long response_code = 0;
+	curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response_code);
 	curl_easy_cleanup(handle);
 	curl_slist_free_all(custom_headers);
 
+	// Write requests are answered with a plain "OK"
+	if (res != CURLE_OK || response_code == 0 || response_code >= 500) {
+		set_request_error(RequestError::CONNECTION);
+	} else if (response_code == 401 || response_code == 403) {
+		set_request_error(RequestError::AUTHENTICATION);
+	} else if (result != "OK") {
+		set_request_error(RequestError::REJECTED);
+	} else {
+		set_request_error(RequestError::NONE);
+	}
+
 	LOG(Level::DEBUG,
 		"InoreaderApi::post_content: url = %s postdata = %s result = "
 		"%s",
@@ -0,0 +1,92 @@
+#include "internedstring.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace newsboat {
+
+namespace {
+
+class Pool {
+public:
+	Pool()
+		: prune_at(MIN_PRUNE_AT)
+	{
+	}
+
+	std::shared_ptr<const std::string> intern(const std::string& s)
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+
+		auto& entry = strings[s];
+		auto value = entry.lock();
+		if (!value) {
+			value = std::make_shared<const std::string>(s);
+			entry = value;
+
+			if (strings.size() >= prune_at) {
+				prune();
+			}
+		}
+		return value;
+	}
+
+	size_t size()
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		return strings.size();
+	}
+
+private:
+	static const size_t MIN_PRUNE_AT = 1024;
+
+	// Drops the values nobody refers to anymore. Done when the pool
+	// doubles in size, so the cost is amortized over the insertions.
+	void prune()
+	{
+		for (auto it = strings.begin(); it != strings.end();) {
+			if (it->second.expired()) {
+				it = strings.erase(it);
+			} else {
+				++it;
+			}
+		}
+		prune_at = std::max(MIN_PRUNE_AT, strings.size() * 2);
+	}
+
+	std::mutex mtx;
+	std::unordered_map<std::string, std::weak_ptr<const std::string>> strings;
+	size_t prune_at;
+};
+
+const size_t Pool::MIN_PRUNE_AT;
+
+// Never destroyed, because items can outlive any other static object
+Pool& pool()
+{
+	static Pool* p = new Pool();
+	return *p;
+}
+
+} // namespace
+
+InternedString::InternedString(const std::string& s)
+{
+	if (!s.empty()) {
+		value = pool().intern(s);
+	}
+}
+
+size_t InternedString::pool_size()
+{
+	return pool().size();
+}
+
+const std::string& InternedString::empty_string()
+{
+	static const std::string empty;
+	return empty;
+}
+
+} // namespace newsboat
@@ -1,5 +1,6 @@
 #include <itemlistformaction.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cinttypes>
 #include <cstdio>
@@ -13,8 +14,8 @@
 #include "fmtstrformatter.h"
 #include "logger.h"
 #include "matcherexception.h"
+#include "metrics.h"
 #include "rssfeed.h"
-#include "scopemeasure.h"
 #include "strprintf.h"
 #include "utils.h"
 #include "view.h"
@@ -83,7 +84,9 @@ void ItemListFormAction::process_operation(Operation op,
 	}
 	break;
 	case OP_DELETE: {
-		ScopeMeasure m1("OP_DELETE");
+		static auto& timings =
+			MetricsRegistry::global().histogram("ui.itemlist.delete");
+		ScopeTimer timer(timings);
 		if (itemposname.length() > 0 && visible_items.size() != 0) {
 			// mark as read
 			v->get_ctrl()->mark_article_read(
@@ -106,7 +109,9 @@ void ItemListFormAction::process_operation(Operation op,
 	}
 	break;
 	case OP_DELETE_ALL: {
-		ScopeMeasure m1("OP_DELETE_ALL");
+		static auto& timings =
+			MetricsRegistry::global().histogram("ui.itemlist.delete_all");
+		ScopeTimer timer(timings);
 		if (visible_items.size() > 0) {
 			v->get_ctrl()->mark_all_read(pos);
 			for (const auto& pair : visible_items) {
@@ -124,7 +129,9 @@ void ItemListFormAction::process_operation(Operation op,
 	}
 	break;
 	case OP_PURGE_DELETED: {
-		ScopeMeasure m1("OP_PURGE_DELETED");
+		static auto& timings =
+			MetricsRegistry::global().histogram("ui.itemlist.purge_deleted");
+		ScopeTimer timer(timings);
 		feed->purge_deleted_items();
 		invalidate_everything();
 	}
@@ -904,7 +911,8 @@ void ItemListFormAction::do_update_visible_items()
 	 * (if applicable) whether an items matches the currently active filter.
 	 */
 
-	bool show_read = cfg->get_configvalue_as_bool("show-read-articles");
+	bool show_read =
+		cfg->snapshot()->get_bool(ConfigKey::SHOW_READ_ARTICLES);
 
 	unsigned int i = 0;
 	for (const auto& item : items) {
@@ -967,9 +975,13 @@ void ItemListFormAction::prepare()
 		return;
 	}
 
-	auto datetime_format = cfg->get_configvalue("datetime-format");
-	auto itemlist_format =
+	const auto datetime_format = cfg->get_configvalue("datetime-format");
+	const auto itemlist_format =
 		cfg->get_configvalue("articlelist-format");
+	if (!compiled_itemlist_format ||
+		compiled_itemlist_format->format() != itemlist_format) {
+		compiled_itemlist_format.reset(new CompiledFormat(itemlist_format));
+	}
 
 	switch (invalidation_mode) {
 	case InvalidationMode::COMPLETE:
@@ -978,7 +990,7 @@ void ItemListFormAction::prepare()
 		for (const auto& item : visible_items) {
 			auto line = item2formatted_line(item,
 					width,
-					itemlist_format,
+					*compiled_itemlist_format,
 					datetime_format);
 			listfmt.add_line(line, item.second);
 		}
@@ -989,7 +1001,7 @@ void ItemListFormAction::prepare()
 			auto item = visible_items[itempos];
 			auto line = item2formatted_line(item,
 					width,
-					itemlist_format,
+					*compiled_itemlist_format,
 					datetime_format);
 			listfmt.set_line(itempos, line, item.second);
 		}
@@ -1013,14 +1025,14 @@ void ItemListFormAction::prepare()
 
 std::string ItemListFormAction::item2formatted_line(const ItemPtrPosPair& item,
 	const unsigned int width,
-	const std::string& itemlist_format,
+	const CompiledFormat& itemlist_format,
 	const std::string& datetime_format)
 {
 	FmtStrFormatter fmt;
 	fmt.register_fmt('i', strprintf::fmt("%u", item.second + 1));
 	fmt.register_fmt('f', gen_flags(item.first));
 	fmt.register_fmt('D',
-		utils::mt_strf_localtime(
+		pubdate_cache.format(
 			datetime_format,
 			item.first->pubDate_timestamp()));
 	if (feed->rssurl() != item.first->feedurl() &&
@@ -1223,6 +1235,38 @@ bool ItemListFormAction::jump_to_next_item(bool start_with_first)
 	return false;
 }
 
+std::vector<std::shared_ptr<RssItem>> ItemListFormAction::get_upcoming_items(
+		unsigned int count)
+{
+	std::vector<std::shared_ptr<RssItem>> result;
+	if (count == 0 || visible_items.empty()) {
+		return result;
+	}
+
+	const unsigned int itempos = utils::to_u(f->get("itempos"));
+	const auto add_item = [&result](const std::shared_ptr<RssItem>& item) {
+		if (std::find(result.begin(), result.end(), item) == result.end()) {
+			result.push_back(item);
+		}
+	};
+
+	if (itempos + 1 < visible_items.size()) {
+		add_item(visible_items[itempos + 1].first);
+	}
+
+	// Same order as in jump_to_next_unread_item()
+	const unsigned int size = visible_items.size();
+	for (unsigned int offset = 1; offset < size && result.size() < count;
+		++offset) {
+		const auto& item = visible_items[(itempos + offset) % size].first;
+		if (item->unread()) {
+			add_item(item);
+		}
+	}
+
+	return result;
+}
+
 std::string ItemListFormAction::get_guid()
 {
 	unsigned int itempos = utils::to_u(f->get("itempos"));
@@ -1518,6 +1562,19 @@ void ItemListFormAction::handle_op_saveall()
 			return;
 		}
 
+		// Articles are only collected here and written all at once after
+		// the user has answered every question, so that rendering them can
+		// be spread over several threads.
+		std::vector<std::shared_ptr<RssItem>> items_to_save;
+		std::vector<std::string> paths_to_save;
+		std::set<std::string> pending_paths;
+		const auto schedule_save = [&](const std::string& filepath,
+		std::shared_ptr<RssItem> item) {
+			items_to_save.push_back(item);
+			paths_to_save.push_back(filepath);
+			pending_paths.insert(filepath);
+		};
+
 		bool overwrite_all = false;
 		for (size_t item_idx = 0; item_idx < filenames.size(); ++item_idx) {
 			const auto filename = filenames[item_idx];
@@ -1525,9 +1582,10 @@ void ItemListFormAction::handle_op_saveall()
 			auto item = visible_items[item_idx].first;
 
 			struct stat sbuf;
-			if (::stat(filepath.c_str(), &sbuf) != -1) {
+			if (pending_paths.count(filepath) != 0 ||
+				::stat(filepath.c_str(), &sbuf) != -1) {
 				if (overwrite_all) {
-					save_article(filepath, item);
+					schedule_save(filepath, item);
 					continue;
 				}
 
@@ -1552,10 +1610,10 @@ void ItemListFormAction::handle_op_saveall()
 				}
 
 				if (c == input_options.at(0)) {
-					save_article(filepath, item);
+					schedule_save(filepath, item);
 				} else if (c == input_options.at(1)) {
 					overwrite_all = true;
-					save_article(filepath, item);
+					schedule_save(filepath, item);
 				} else if (c == input_options.at(2)) {
 					continue;
 				} else if (c == input_options.at(3)) {
@@ -1563,9 +1621,47 @@ void ItemListFormAction::handle_op_saveall()
 				}
 			} else {
 				// Create file since it does not exist
-				save_article(filepath, item);
+				schedule_save(filepath, item);
 			}
 		}
+
+		save_articles(directory, paths_to_save, items_to_save);
+	}
+}
+
+void ItemListFormAction::save_articles(const std::string& directory,
+	const std::vector<std::string>& filenames,
+	const std::vector<std::shared_ptr<RssItem>>& items)
+{
+	if (items.empty()) {
+		return;
+	}
+
+	// Redrawing the status line for every single article would take longer
+	// than saving it, so only update it about a hundred times.
+	const size_t total = items.size();
+	const size_t step = std::max<size_t>(1, total / 100);
+	const auto failed = v->get_ctrl()->write_items(items, filenames,
+	[&](size_t done) {
+		if (done % step == 0 || done == total) {
+			v->set_status(strprintf::fmt(
+					_("Saving articles... (%u/%u)"),
+					static_cast<unsigned int>(done),
+					static_cast<unsigned int>(total)));
+		}
+	});
+
+	if (failed.empty()) {
+		v->show_error(strprintf::fmt(
+				_("Saved %u articles to %s"),
+				static_cast<unsigned int>(total),
+				directory));
+	} else {
+		v->show_error(strprintf::fmt(
+				_("Error: couldn't save %u of %u articles, e.g. to %s"),
+				static_cast<unsigned int>(failed.size()),
+				static_cast<unsigned int>(total),
+				failed.front()));
 	}
 }
 
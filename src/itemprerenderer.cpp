@@ -0,0 +1,212 @@
+#include "itemprerenderer.h"
+
+#include <algorithm>
+
+#include "configcontainer.h"
+#include "itemrenderer.h"
+#include "logger.h"
+#include "rssitem.h"
+
+namespace newsboat {
+
+ItemPrerenderer::ItemPrerenderer(ConfigContainer& cfg)
+	: cfg(cfg)
+	, rxman(nullptr)
+	, generation(0)
+	, in_progress_generation(0)
+	, stopping(false)
+{
+}
+
+ItemPrerenderer::~ItemPrerenderer()
+{
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		stopping = true;
+		queue.clear();
+	}
+	cv.notify_all();
+
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+void ItemPrerenderer::schedule(
+	const std::vector<std::shared_ptr<RssItem>>& items,
+	unsigned int text_width,
+	unsigned int window_width,
+	RegexManager* rxman_,
+	const std::string& location_)
+{
+	std::unique_lock<std::mutex> lock(mtx);
+
+	if (rxman_ != rxman || location_ != location) {
+		// Whatever the worker renders right now uses the old
+		// highlighting rules; its result is dropped when it's done.
+		generation++;
+		results.clear();
+		rxman = rxman_;
+		location = location_;
+	}
+
+	queue.clear();
+
+	std::map<std::string, Result> kept;
+	for (const auto& item : items) {
+		const auto result = results.find(item->guid());
+		if (result != results.end() &&
+			matches(result->second.job, item, text_width, window_width)) {
+			kept.insert(*result);
+			continue;
+		}
+		if (item->guid() == in_progress
+			&& in_progress_generation == generation) {
+			continue;
+		}
+
+		// The copy is what the worker renders, so that reloads and
+		// flag changes on the UI thread don't race with it. The feed is
+		// shared as well, so the copy doesn't get to see it.
+		Job job;
+		job.item = std::make_shared<RssItem>(*item);
+		job.item->set_feedptr(std::shared_ptr<RssFeed>());
+		job.feedtitle = item_renderer::get_feedtitle(item);
+		job.text_width = text_width;
+		job.window_width = window_width;
+		queue.push_back(job);
+	}
+	results.swap(kept);
+
+	if (!queue.empty() && !worker.joinable()) {
+		worker = std::thread(&ItemPrerenderer::run, this);
+	}
+	lock.unlock();
+	cv.notify_all();
+}
+
+bool ItemPrerenderer::take(const std::shared_ptr<RssItem>& item,
+	unsigned int text_width,
+	unsigned int window_width,
+	PrerenderedItem& result)
+{
+	std::unique_lock<std::mutex> lock(mtx);
+
+	const std::string& guid = item->guid();
+	cv.wait(lock, [this, &guid]() {
+		return in_progress != guid || in_progress_generation != generation;
+	});
+
+	queue.erase(std::remove_if(queue.begin(), queue.end(),
+	[&guid](const Job& job) {
+		return job.item->guid() == guid;
+	}),
+	queue.end());
+
+	const auto it = results.find(guid);
+	if (it == results.end()) {
+		return false;
+	}
+
+	const bool usable = matches(it->second.job, item, text_width,
+			window_width);
+	if (usable) {
+		result = std::move(it->second.rendered);
+	}
+	results.erase(it);
+
+	LOG(Level::DEBUG,
+		"ItemPrerenderer::take: guid = `%s' usable = %s",
+		guid,
+		usable ? "true" : "false");
+
+	return usable;
+}
+
+void ItemPrerenderer::clear()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	queue.clear();
+	results.clear();
+	generation++;
+	cv.wait(lock, [this]() {
+		return in_progress.empty();
+	});
+}
+
+bool ItemPrerenderer::matches(const Job& job,
+	const std::shared_ptr<RssItem>& item,
+	unsigned int text_width,
+	unsigned int window_width)
+{
+	// Everything that ends up in the article header or body has to be
+	// compared, because reloads and the user can change the item after it
+	// was scheduled.
+	const auto& rendered = *job.item;
+	return job.text_width == text_width &&
+		job.window_width == window_width &&
+		job.feedtitle == item_renderer::get_feedtitle(item) &&
+		rendered.title() == item->title() &&
+		rendered.author() == item->author() &&
+		rendered.link() == item->link() &&
+		rendered.flags() == item->flags() &&
+		rendered.pubDate_timestamp() == item->pubDate_timestamp() &&
+		rendered.enclosure_url() == item->enclosure_url() &&
+		rendered.enclosure_type() == item->enclosure_type() &&
+		rendered.description() == item->description();
+}
+
+void ItemPrerenderer::run()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	for (;;) {
+		cv.wait(lock, [this]() {
+			return stopping || !queue.empty();
+		});
+		if (stopping) {
+			break;
+		}
+
+		Job job = queue.front();
+		queue.pop_front();
+		in_progress = job.item->guid();
+		in_progress_generation = generation;
+		const unsigned int job_generation = generation;
+		RegexManager* job_rxman = rxman;
+		const std::string job_location = location;
+		lock.unlock();
+
+		PrerenderedItem rendered;
+		bool success = true;
+		try {
+			std::tie(rendered.text, rendered.num_lines) =
+				item_renderer::to_stfl_list(
+					cfg,
+					job.item,
+					job.feedtitle,
+					job.text_width,
+					job.window_width,
+					job_rxman,
+					job_location,
+					rendered.links);
+		} catch (const std::exception& e) {
+			LOG(Level::ERROR,
+				"ItemPrerenderer::run: failed to render `%s': %s",
+				job.item->guid(),
+				e.what());
+			success = false;
+		}
+
+		lock.lock();
+		if (success && job_generation == generation && !stopping) {
+			Result result;
+			result.job = job;
+			result.rendered = std::move(rendered);
+			results[job.item->guid()] = std::move(result);
+		}
+		in_progress.clear();
+		cv.notify_all();
+	}
+}
+
+} // namespace newsboat
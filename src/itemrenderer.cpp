@@ -1,9 +1,16 @@
 #include "itemrenderer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 #include "configcontainer.h"
 #include "htmlrenderer.h"
+#include "logger.h"
+#include "metrics.h"
 #include "rssfeed.h"
 #include "textformatter.h"
 
@@ -32,6 +39,7 @@ std::string item_renderer::get_feedtitle(std::shared_ptr<RssItem> item)
 
 void prepare_header(
 	std::shared_ptr<RssItem> item,
+	const std::string& feedtitle,
 	std::vector<std::pair<LineType, std::string>>& lines,
 	std::vector<LinkPair>& /*links*/)
 {
@@ -46,7 +54,6 @@ void prepare_header(
 		}
 	};
 
-	const std::string feedtitle = item_renderer::get_feedtitle(item);
 	add_line(feedtitle, _("Feed: "));
 	add_line(utils::utf8_to_locale(item->title()), _("Title: "));
 	add_line(utils::utf8_to_locale(item->author()), _("Author: "));
@@ -122,10 +129,22 @@ std::string item_renderer::to_plain_text(
 	ConfigContainer& cfg,
 	std::shared_ptr<RssItem> item)
 {
+	return to_plain_text(cfg, item, get_feedtitle(item));
+}
+
+std::string item_renderer::to_plain_text(
+	ConfigContainer& cfg,
+	std::shared_ptr<RssItem> item,
+	const std::string& feedtitle)
+{
+	static auto& timings =
+		MetricsRegistry::global().histogram("render.plain_text");
+	ScopeTimer timer(timings);
+
 	std::vector<std::pair<LineType, std::string>> lines;
 	std::vector<LinkPair> links;
 
-	prepare_header(item, lines, links);
+	prepare_header(item, feedtitle, lines, links);
 	const auto base = get_item_base_link(item);
 	render_html(cfg, utils::utf8_to_locale(item->description()), lines, links,
 		base, true);
@@ -133,7 +152,7 @@ std::string item_renderer::to_plain_text(
 	TextFormatter txtfmt;
 	txtfmt.add_lines(lines);
 
-	unsigned int width = cfg.get_configvalue_as_int("text-width");
+	unsigned int width = cfg.snapshot()->get_int(ConfigKey::TEXT_WIDTH);
 	if (width == 0) {
 		width = 80;
 	}
@@ -141,6 +160,114 @@ std::string item_renderer::to_plain_text(
 	return txtfmt.format_text_plain(width);
 }
 
+void item_renderer::to_plain_text_batch(
+	ConfigContainer& cfg,
+	const std::vector<std::shared_ptr<RssItem>>& items,
+	const std::function<void(size_t, const std::string&, bool)>& on_rendered)
+{
+	const auto render = [&cfg](std::shared_ptr<RssItem> item,
+		const std::string& feedtitle,
+	std::string& text) -> bool {
+		try {
+			text = to_plain_text(cfg, item, feedtitle);
+			return true;
+		} catch (const std::exception& e) {
+			LOG(Level::ERROR,
+				"item_renderer::to_plain_text_batch: "
+				"failed to render `%s': %s",
+				item->guid(),
+				e.what());
+			return false;
+		}
+	};
+
+	const size_t num_threads = std::min<size_t>(
+			std::max(1u, std::thread::hardware_concurrency()),
+			items.size());
+	if (num_threads <= 1) {
+		for (size_t i = 0; i < items.size(); ++i) {
+			std::string text;
+			const bool rendered = render(items[i], get_feedtitle(items[i]),
+					text);
+			on_rendered(i, text, rendered);
+		}
+		return;
+	}
+
+	// Workers render copies, so that a reload running at the same time
+	// can't change an item under their feet. The feeds are shared as well,
+	// so their titles are looked up here and the copies are detached.
+	std::vector<std::shared_ptr<RssItem>> copies;
+	std::vector<std::string> feedtitles;
+	copies.reserve(items.size());
+	feedtitles.reserve(items.size());
+	for (const auto& item : items) {
+		feedtitles.push_back(get_feedtitle(item));
+		copies.push_back(std::make_shared<RssItem>(*item));
+		copies.back()->set_feedptr(std::shared_ptr<RssFeed>());
+	}
+
+	std::vector<std::string> results(items.size());
+	std::vector<bool> ready(items.size(), false);
+	std::vector<bool> rendered(items.size(), false);
+	std::atomic<size_t> next_item(0);
+	std::mutex results_mtx;
+	std::condition_variable result_ready;
+
+	const auto render_items = [&]() {
+		for (;;) {
+			const size_t idx = next_item++;
+			if (idx >= items.size()) {
+				break;
+			}
+			std::string text;
+			const bool success = render(copies[idx], feedtitles[idx],
+					text);
+			{
+				std::lock_guard<std::mutex> guard(results_mtx);
+				results[idx] = std::move(text);
+				rendered[idx] = success;
+				ready[idx] = true;
+			}
+			result_ready.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < num_threads; ++i) {
+		threads.emplace_back(render_items);
+	}
+
+	const auto join_threads = [&threads]() {
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	};
+
+	try {
+		for (size_t i = 0; i < items.size(); ++i) {
+			std::string text;
+			bool success;
+			{
+				std::unique_lock<std::mutex> lock(results_mtx);
+				result_ready.wait(lock, [&ready, i]() {
+					return ready[i];
+				});
+				text = std::move(results[i]);
+				success = rendered[i];
+			}
+			on_rendered(i, text, success);
+		}
+	} catch (...) {
+		// Stop the workers before the state they reference goes away
+		next_item = items.size();
+		join_threads();
+		throw;
+	}
+
+	join_threads();
+}
+
 std::pair<std::string, size_t> item_renderer::to_stfl_list(
 	ConfigContainer& cfg,
 	std::shared_ptr<RssItem> item,
@@ -150,9 +277,27 @@ std::pair<std::string, size_t> item_renderer::to_stfl_list(
 	const std::string& location,
 	std::vector<LinkPair>& links)
 {
+	return to_stfl_list(cfg, item, get_feedtitle(item), text_width,
+			window_width, rxman, location, links);
+}
+
+std::pair<std::string, size_t> item_renderer::to_stfl_list(
+	ConfigContainer& cfg,
+	std::shared_ptr<RssItem> item,
+	const std::string& feedtitle,
+	unsigned int text_width,
+	unsigned int window_width,
+	RegexManager* rxman,
+	const std::string& location,
+	std::vector<LinkPair>& links)
+{
+	static auto& timings =
+		MetricsRegistry::global().histogram("render.article");
+	ScopeTimer timer(timings);
+
 	std::vector<std::pair<LineType, std::string>> lines;
 
-	prepare_header(item, lines, links);
+	prepare_header(item, feedtitle, lines, links);
 	const std::string baseurl = get_item_base_link(item);
 	const auto body = utils::utf8_to_locale(item->description());
 	render_html(cfg, body, lines, links, baseurl, false);
@@ -195,7 +340,7 @@ std::pair<std::string, size_t> item_renderer::source_to_stfl_list(
 	std::vector<std::pair<LineType, std::string>> lines;
 	std::vector<LinkPair> links;
 
-	prepare_header(item, lines, links);
+	prepare_header(item, item_renderer::get_feedtitle(item), lines, links);
 	render_source(lines, utils::quote_for_stfl(utils::utf8_to_locale(
 				item->description())));
 
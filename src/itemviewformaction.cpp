@@ -8,10 +8,10 @@
 #include "confighandlerexception.h"
 #include "dbexception.h"
 #include "fmtstrformatter.h"
+#include "itemlistformaction.h"
 #include "itemrenderer.h"
 #include "logger.h"
 #include "rssfeed.h"
-#include "scopemeasure.h"
 #include "strprintf.h"
 #include "textformatter.h"
 #include "utils.h"
@@ -32,6 +32,7 @@ ItemViewFormAction::ItemViewFormAction(View* vv,
 	, itemlist(il)
 	, in_search(false)
 	, rsscache(cc)
+	, prerenderer(*cfg)
 {
 	valid_cmds.push_back("save");
 	std::sort(valid_cmds.begin(), valid_cmds.end());
@@ -87,11 +88,8 @@ void ItemViewFormAction::prepare()
 	 * HTML. The links extracted by the renderer are then appended, too.
 	 */
 	if (do_redraw) {
-		{
-			ScopeMeasure("itemview::prepare: rendering");
-			// XXX HACK: render once so that we get a proper widget width
-			f->run(-3);
-		}
+		// XXX HACK: render once so that we get a proper widget width
+		f->run(-3);
 
 		update_head(item);
 
@@ -117,31 +115,61 @@ void ItemViewFormAction::prepare()
 					rxman,
 					"article");
 		} else {
-			std::tie(formatted_text, num_lines) =
-				item_renderer::to_stfl_list(
-					// cfg can't be nullptr because that's a long-lived object
-					// created at the very start of the program.
-					*cfg,
-					item,
-					text_width,
-					window_width,
-					rxman,
-					"article",
-					links);
+			PrerenderedItem prerendered;
+			if (prerenderer.take(item, text_width, window_width,
+					prerendered)) {
+				formatted_text = std::move(prerendered.text);
+				num_lines = prerendered.num_lines;
+				links = std::move(prerendered.links);
+			} else {
+				std::tie(formatted_text, num_lines) =
+					item_renderer::to_stfl_list(
+						// cfg can't be nullptr because that's a long-lived object
+						// created at the very start of the program.
+						*cfg,
+						item,
+						text_width,
+						window_width,
+						rxman,
+						"article",
+						links);
+			}
 		}
 
 		f->modify("article", "replace_inner", formatted_text);
 		f->set("articleoffset", "0");
 
 		if (in_search) {
+			prerenderer.clear();
 			rxman->remove_last_regex("article");
 			in_search = false;
 		}
 
+		if (!show_source) {
+			prerender_upcoming_items(text_width, window_width);
+		}
+
 		do_redraw = false;
 	}
 }
 
+void ItemViewFormAction::stop_prerendering()
+{
+	prerenderer.clear();
+}
+
+void ItemViewFormAction::prerender_upcoming_items(unsigned int text_width,
+	unsigned int window_width)
+{
+	const int count = cfg->get_configvalue_as_int("prerender-articles");
+	std::vector<std::shared_ptr<RssItem>> upcoming;
+	if (count > 0) {
+		upcoming = itemlist->get_upcoming_items(count);
+	}
+	prerenderer.schedule(
+		upcoming, text_width, window_width, rxman, "article");
+}
+
 void ItemViewFormAction::process_operation(Operation op,
 	bool automatic,
 	std::vector<std::string>* args)
@@ -491,6 +519,9 @@ void ItemViewFormAction::handle_cmdline(const std::string& cmd)
 			}
 
 		} else {
+			// Commands like `source` can change highlighting rules
+			// that the background renderer is reading.
+			prerenderer.clear();
 			FormAction::handle_cmdline(cmd);
 		}
 	}
@@ -630,6 +661,7 @@ void ItemViewFormAction::highlight_text(const std::string& searchphrase)
 	std::copy(colors.begin(), colors.end(), std::back_inserter(params));
 
 	try {
+		prerenderer.clear();
 		rxman->handle_action("highlight", params);
 
 		LOG(Level::DEBUG,
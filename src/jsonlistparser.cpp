@@ -0,0 +1,178 @@
+#include "jsonlistparser.h"
+
+#include <utility>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace newsboat {
+
+namespace {
+
+/// \brief Handler for nlohmann::json::sax_parse(). Builds values the way the
+/// library's own parser does, except that each element of the list is built
+/// separately and handed out once it's complete.
+class ListSax {
+public:
+	ListSax(const std::string& list_key,
+		const JsonListParser::ItemHandler& handler,
+		json& root)
+		: list_key(list_key)
+		, handler(handler)
+		, root(root)
+		, list(nullptr)
+		, object_element(nullptr)
+	{
+	}
+
+	bool null()
+	{
+		handle_value(nullptr);
+		return true;
+	}
+
+	bool boolean(bool val)
+	{
+		handle_value(val);
+		return true;
+	}
+
+	bool number_integer(json::number_integer_t val)
+	{
+		handle_value(val);
+		return true;
+	}
+
+	bool number_unsigned(json::number_unsigned_t val)
+	{
+		handle_value(val);
+		return true;
+	}
+
+	bool number_float(json::number_float_t val, const json::string_t&)
+	{
+		handle_value(val);
+		return true;
+	}
+
+	bool string(json::string_t& val)
+	{
+		handle_value(std::move(val));
+		return true;
+	}
+
+	bool start_object(std::size_t)
+	{
+		ref_stack.push_back(handle_value(json::value_t::object));
+		return true;
+	}
+
+	bool key(json::string_t& val)
+	{
+		if (ref_stack.size() == 1) {
+			top_level_key = val;
+		}
+		object_element = &(*ref_stack.back())[val];
+		return true;
+	}
+
+	bool end_object()
+	{
+		return end_value();
+	}
+
+	bool start_array(std::size_t)
+	{
+		json* array = handle_value(json::value_t::array);
+		if (list == nullptr && ref_stack.size() == 1 && root.is_object() &&
+			top_level_key == list_key) {
+			list = array;
+		}
+		ref_stack.push_back(array);
+		return true;
+	}
+
+	bool end_array()
+	{
+		return end_value();
+	}
+
+	bool parse_error(std::size_t,
+		const std::string&,
+		const nlohmann::detail::exception&)
+	{
+		return false;
+	}
+
+private:
+	/// Returns where the value was stored, so that objects and arrays can
+	/// be filled in
+	template<typename Value>
+	json* handle_value(Value&& value)
+	{
+		if (ref_stack.empty()) {
+			root = json(std::forward<Value>(value));
+			return &root;
+		}
+
+		json* parent = ref_stack.back();
+		if (parent == list) {
+			item = json(std::forward<Value>(value));
+			if (!item.is_structured()) {
+				emit_item();
+			}
+			return &item;
+		}
+		if (parent->is_array()) {
+			parent->push_back(json(std::forward<Value>(value)));
+			return &parent->back();
+		}
+		*object_element = json(std::forward<Value>(value));
+		return object_element;
+	}
+
+	bool end_value()
+	{
+		ref_stack.pop_back();
+		if (!ref_stack.empty() && ref_stack.back() == list) {
+			emit_item();
+		}
+		return true;
+	}
+
+	void emit_item()
+	{
+		handler(item);
+		item = json();
+	}
+
+	const std::string& list_key;
+	const JsonListParser::ItemHandler& handler;
+	json& root;
+
+	/// The array whose elements are streamed; stays empty
+	json* list;
+	/// The element of the list that is being parsed
+	json item;
+
+	std::vector<json*> ref_stack;
+	json* object_element;
+	std::string top_level_key;
+};
+
+} // namespace
+
+JsonListParser::JsonListParser(const std::string& key, ItemHandler handler)
+	: key(key)
+	, handler(std::move(handler))
+{
+}
+
+bool JsonListParser::parse(const std::string& text, json& rest)
+{
+	rest = json();
+	ListSax sax(key, handler, rest);
+	return json::sax_parse(text, &sax);
+}
+
+} // namespace newsboat
@@ -0,0 +1,34 @@
+#include "localtimecache.h"
+
+#include "utils.h"
+
+namespace newsboat {
+
+LocalTimeCache::LocalTimeCache(size_t max_entries)
+	: max_entries(max_entries)
+{
+}
+
+const std::string& LocalTimeCache::format(const std::string& format, time_t t)
+{
+	if (format != current_format) {
+		formatted.clear();
+		current_format = format;
+	}
+
+	const auto it = formatted.find(t);
+	if (it != formatted.end()) {
+		return it->second;
+	}
+
+	if (formatted.size() >= max_entries) {
+		// Simpler than tracking usage, and the cache refills within a
+		// single redraw anyway.
+		formatted.clear();
+	}
+
+	return formatted.emplace(t, utils::mt_strf_localtime(format, t))
+		.first->second;
+}
+
+} // namespace newsboat
@@ -1,25 +1,222 @@
 #include "logger.h"
 
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#include "logqueue.h"
+#include "metrics.h"
+
 extern "C" {
+	void rs_log(newsboat::Level level, const char* message);
 	void rs_set_logfile(const char* logfile);
 	void rs_set_user_error_logfile(const char* logfile);
 	void rs_set_loglevel(newsboat::Level level);
 }
 
 namespace newsboat {
+
+namespace {
+
+// Enough for a burst of debug messages from all reload threads; when the
+// writer falls this far behind, messages are dropped rather than slowing
+// the threads down.
+const size_t QUEUE_CAPACITY = 16384;
+
+// The writer wakes up this often even if nobody notified it, so that a
+// missed notification can't delay messages for long.
+const std::chrono::milliseconds WRITER_POLL_INTERVAL(100);
+
+const std::chrono::seconds FLUSH_TIMEOUT(1);
+
+enum class WriterState { NOT_STARTED, RUNNING, STOPPED };
+
+/// \brief The queue, and the thread that drains it into rs_log().
+///
+/// It's never destroyed, so that messages logged by destructors of other
+/// static objects don't touch a dead object. An atexit() handler stops the
+/// thread instead, and from then on messages are written synchronously.
+class Writer {
+public:
+	Writer()
+		: queue(QUEUE_CAPACITY)
+		, state(WriterState::NOT_STARTED)
+		, sleeping(false)
+		, stopping(false)
+		, written(0)
+	{
+	}
+
+	void write(Level l, std::string message)
+	{
+		if (state.load(std::memory_order_acquire) == WriterState::NOT_STARTED) {
+			start();
+		}
+		if (state.load(std::memory_order_acquire) != WriterState::RUNNING) {
+			rs_log(l, message.c_str());
+			return;
+		}
+
+		queue.push(l, std::move(message));
+		wake_up();
+	}
+
+	void flush()
+	{
+		if (state.load(std::memory_order_acquire) != WriterState::RUNNING) {
+			return;
+		}
+
+		const uint64_t target = queue.pushed();
+		wake_up();
+
+		std::unique_lock<std::mutex> lock(mtx);
+		flushed.wait_for(lock, FLUSH_TIMEOUT, [&]() {
+			return written.load(std::memory_order_acquire) >= target;
+		});
+	}
+
+private:
+	void start()
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		if (state.load(std::memory_order_relaxed) != WriterState::NOT_STARTED) {
+			return;
+		}
+
+		thread = std::thread(&Writer::run, this);
+		state.store(WriterState::RUNNING, std::memory_order_release);
+		std::atexit([]() {
+			instance().stop();
+		});
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			state.store(WriterState::STOPPED, std::memory_order_release);
+			stopping = true;
+		}
+		wakeup.notify_one();
+		thread.join();
+
+		// Whatever was pushed while the thread was exiting
+		drain();
+	}
+
+	void wake_up()
+	{
+		if (sleeping.exchange(false)) {
+			wakeup.notify_one();
+		}
+	}
+
+	void run()
+	{
+		for (;;) {
+			drain();
+
+			std::unique_lock<std::mutex> lock(mtx);
+			flushed.notify_all();
+			if (stopping) {
+				return;
+			}
+			// Producers only notify us if they see this flag, so check
+			// for messages that arrived while it was still unset
+			sleeping.store(true);
+			wakeup.wait_for(lock, WRITER_POLL_INTERVAL, [&]() {
+				return stopping
+					|| !sleeping.load()
+					|| queue.pushed() > written.load();
+			});
+			sleeping.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	void drain()
+	{
+		Level level;
+		std::string message;
+		while (queue.pop(level, message)) {
+			rs_log(level, message.c_str());
+			written.fetch_add(1, std::memory_order_release);
+		}
+
+		const uint64_t dropped = queue.take_dropped();
+		if (dropped > 0) {
+			static auto& dropped_messages =
+				MetricsRegistry::global().counter("log.dropped_messages");
+			dropped_messages.increment(dropped);
+			rs_log(Level::WARN, strprintf::fmt(
+					"Logger: dropped %" PRIu64 " messages because the "
+					"logfile couldn't keep up",
+					dropped).c_str());
+		}
+	}
+
+public:
+	static Writer& instance()
+	{
+		static Writer* writer = new Writer();
+		return *writer;
+	}
+
+private:
+	LogQueue queue;
+	std::atomic<WriterState> state;
+	std::atomic<bool> sleeping;
+	bool stopping;
+	std::atomic<uint64_t> written;
+
+	std::mutex mtx;
+	std::condition_variable wakeup;
+	std::condition_variable flushed;
+	std::thread thread;
+};
+
+} // namespace
+
+std::atomic<Level> Logger::detail::loglevel(Level::NONE);
+
+void Logger::detail::write(Level l, std::string message)
+{
+	if (l == Level::USERERROR || l == Level::CRITICAL) {
+		// These are rare and often followed by an exit, so write them
+		// right away, in order with what came before
+		Writer::instance().flush();
+		rs_log(l, message.c_str());
+		return;
+	}
+
+	Writer::instance().write(l, std::move(message));
+}
+
+void Logger::flush()
+{
+	Writer::instance().flush();
+}
+
 void Logger::set_logfile(const std::string& logfile)
 {
+	flush();
 	rs_set_logfile(logfile.c_str());
 }
 
 void Logger::set_user_error_logfile(const std::string& logfile)
 {
+	flush();
 	rs_set_user_error_logfile(logfile.c_str());
 }
 
 void Logger::set_loglevel(Level l)
 {
+	flush();
 	rs_set_loglevel(l);
+	detail::loglevel.store(l, std::memory_order_relaxed);
 }
 
 } // namespace newsboat
@@ -0,0 +1,94 @@
+#include "logqueue.h"
+
+namespace newsboat {
+
+namespace {
+
+// A single slot wouldn't work: its sequence for "free for the next push"
+// would be the same as for "holds the previous message", so the second push
+// would overwrite a message that wasn't popped yet.
+size_t slot_count(size_t capacity)
+{
+	size_t result = 2;
+	while (result < capacity) {
+		result <<= 1;
+	}
+	return result;
+}
+
+} // namespace
+
+// This is Dmitry Vyukov's bounded queue: each slot carries a sequence
+// number that tells whose turn it is. A slot is free for the producer that
+// claimed position `pos` when its sequence equals `pos`, and holds a message
+// for the consumer when it equals `pos + 1`.
+LogQueue::LogQueue(size_t capacity)
+	: slots(new Slot[slot_count(capacity)])
+	, mask(slot_count(capacity) - 1)
+	, enqueue_pos(0)
+	, dequeue_pos(0)
+	, dropped(0)
+{
+	for (size_t i = 0; i <= mask; ++i) {
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+bool LogQueue::push(Level level, std::string message)
+{
+	uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+	Slot* slot;
+	for (;;) {
+		slot = &slots[pos & mask];
+		const uint64_t sequence =
+			slot->sequence.load(std::memory_order_acquire);
+		const int64_t diff = static_cast<int64_t>(sequence - pos);
+		if (diff == 0) {
+			if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+					std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// The consumer hasn't freed this slot yet: we're full
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		} else {
+			pos = enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->level = level;
+	slot->message = std::move(message);
+	slot->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+bool LogQueue::pop(Level& level, std::string& message)
+{
+	const uint64_t pos = dequeue_pos.load(std::memory_order_relaxed);
+	Slot& slot = slots[pos & mask];
+	const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+	if (sequence != pos + 1) {
+		// Either empty, or the producer is still writing into the slot
+		return false;
+	}
+
+	dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+	level = slot.level;
+	message = std::move(slot.message);
+	slot.message.clear();
+	slot.sequence.store(pos + mask + 1, std::memory_order_release);
+	return true;
+}
+
+uint64_t LogQueue::pushed() const
+{
+	return enqueue_pos.load();
+}
+
+uint64_t LogQueue::take_dropped()
+{
+	return dropped.exchange(0, std::memory_order_relaxed);
+}
+
+} // namespace newsboat
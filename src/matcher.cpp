@@ -11,7 +11,7 @@
 #include "logger.h"
 #include "matchable.h"
 #include "matcherexception.h"
-#include "scopemeasure.h"
+#include "metrics.h"
 #include "utils.h"
 
 namespace newsboat {
@@ -78,7 +78,9 @@ bool Matcher::matches(Matchable* item)
 	 */
 	bool retval = false;
 	if (item) {
-		ScopeMeasure m1("Matcher::matches");
+		static auto& timings =
+			MetricsRegistry::global().histogram("match");
+		ScopeTimer timer(timings);
 		retval = matches_r(p.get_root(), item);
 	}
 	return retval;
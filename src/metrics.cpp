@@ -0,0 +1,198 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+#include "strprintf.h"
+
+namespace {
+
+size_t bucket_index(uint64_t microseconds)
+{
+	size_t index = 0;
+	while (microseconds > 0 && index + 1 < newsboat::Histogram::BUCKETS) {
+		microseconds >>= 1;
+		index++;
+	}
+	return index;
+}
+
+std::string quote(const std::string& name)
+{
+	std::string result = "\"";
+	for (const char c : name) {
+		if (c == '"' || c == '\\') {
+			result.push_back('\\');
+		}
+		result.push_back(c);
+	}
+	result.push_back('"');
+	return result;
+}
+
+template<typename T>
+T& find_or_create(std::map<std::string, std::unique_ptr<T>>& metrics,
+	const std::string& name)
+{
+	auto& metric = metrics[name];
+	if (!metric) {
+		metric.reset(new T());
+	}
+	return *metric;
+}
+
+} // namespace
+
+namespace newsboat {
+
+Histogram::Histogram()
+{
+	reset();
+}
+
+void Histogram::record(uint64_t microseconds)
+{
+	samples.fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(microseconds, std::memory_order_relaxed);
+	buckets[bucket_index(microseconds)].fetch_add(1,
+		std::memory_order_relaxed);
+
+	uint64_t current = maximum.load(std::memory_order_relaxed);
+	while (current < microseconds &&
+		!maximum.compare_exchange_weak(current, microseconds,
+			std::memory_order_relaxed)) {
+	}
+}
+
+uint64_t Histogram::count() const
+{
+	return samples.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::total() const
+{
+	return sum.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::max() const
+{
+	return maximum.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::percentile(unsigned int p) const
+{
+	uint64_t in_buckets = 0;
+	for (const auto& bucket : buckets) {
+		in_buckets += bucket.load(std::memory_order_relaxed);
+	}
+	if (in_buckets == 0) {
+		return 0;
+	}
+
+	const uint64_t wanted =
+		std::max<uint64_t>(1, (in_buckets * std::min(p, 100u) + 99) / 100);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < BUCKETS; ++i) {
+		seen += buckets[i].load(std::memory_order_relaxed);
+		if (seen >= wanted) {
+			return std::min(uint64_t(1) << i, max());
+		}
+	}
+	return max();
+}
+
+void Histogram::reset()
+{
+	samples.store(0, std::memory_order_relaxed);
+	sum.store(0, std::memory_order_relaxed);
+	maximum.store(0, std::memory_order_relaxed);
+	for (auto& bucket : buckets) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+}
+
+MetricsRegistry& MetricsRegistry::global()
+{
+	static MetricsRegistry registry;
+	return registry;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return find_or_create(counters, name);
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return find_or_create(gauges, name);
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return find_or_create(histograms, name);
+}
+
+std::string MetricsRegistry::to_json()
+{
+	std::lock_guard<std::mutex> guard(mtx);
+
+	std::string result = "{\"counters\":{";
+	bool first = true;
+	for (const auto& counter : counters) {
+		result += strprintf::fmt("%s%s:%" PRIu64,
+				first ? "" : ",",
+				quote(counter.first),
+				counter.second->get());
+		first = false;
+	}
+
+	result += "},\"gauges\":{";
+	first = true;
+	for (const auto& gauge : gauges) {
+		result += strprintf::fmt("%s%s:%" PRId64,
+				first ? "" : ",",
+				quote(gauge.first),
+				gauge.second->get());
+		first = false;
+	}
+
+	result += "},\"histograms\":{";
+	first = true;
+	for (const auto& entry : histograms) {
+		const Histogram& h = *entry.second;
+		result += strprintf::fmt("%s%s:{\"count\":%" PRIu64
+				",\"total_us\":%" PRIu64
+				",\"max_us\":%" PRIu64
+				",\"p50_us\":%" PRIu64
+				",\"p90_us\":%" PRIu64
+				",\"p99_us\":%" PRIu64 "}",
+				first ? "" : ",",
+				quote(entry.first),
+				h.count(),
+				h.total(),
+				h.max(),
+				h.percentile(50),
+				h.percentile(90),
+				h.percentile(99));
+		first = false;
+	}
+	result += "}}";
+
+	return result;
+}
+
+void MetricsRegistry::reset()
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	for (auto& counter : counters) {
+		counter.second->reset();
+	}
+	for (auto& histogram : histograms) {
+		histogram.second->reset();
+	}
+}
+
+} // namespace newsboat
@@ -1,16 +1,21 @@
 #include "newsblurapi.h"
 
 #include <algorithm>
+#include <cinttypes>
 #include <string.h>
 #include <time.h>
 
+#include "3rd-party/json.hpp"
 #include "json.h"
+#include "jsonlistparser.h"
 #include "remoteapi.h"
 #include "strprintf.h"
 #include "utils.h"
 
 #define NEWSBLUR_ITEMS_PER_PAGE 6
 
+using json = nlohmann::json;
+
 namespace newsboat {
 
 NewsBlurApi::NewsBlurApi(ConfigContainer* c)
@@ -167,14 +172,29 @@ bool request_successfull(json_object* payload)
 	json_object* result{};
 	if (json_object_object_get_ex(payload, "result", &result) == FALSE) {
 		return false;
-	} else {
-		return !strcmp("ok", json_object_get_string(result));
+	} else if (strcmp("ok", json_object_get_string(result)) != 0) {
+		// The server replied, so query_api() didn't record an error
+		RemoteApi::set_request_error(RemoteApi::RequestError::REJECTED);
+		return false;
 	}
+	return true;
 }
 
 bool NewsBlurApi::mark_all_read(const std::string& feed_url)
+{
+	return mark_all_read_until(feed_url, "", 0);
+}
+
+bool NewsBlurApi::mark_all_read_until(const std::string& feed_url,
+	const std::string& /* newest */,
+	int64_t marked_at)
 {
 	std::string post_data = strprintf::fmt("feed_id=%s", feed_url);
+	if (marked_at > 0) {
+		// Stories that arrived after that stay unread
+		post_data.append(strprintf::fmt("&cutoff_timestamp=%" PRId64,
+				marked_at / 1000000));
+	}
 	json_object* query_result =
 		query_api("/reader/mark_feed_as_read", &post_data);
 	return request_successfull(query_result);
@@ -184,6 +204,7 @@ bool NewsBlurApi::mark_article_read(const std::string& guid, bool read)
 {
 	// handle dummy articles
 	if (guid.empty()) {
+		set_request_error(RequestError::REJECTED);
 		return false;
 	}
 	std::string endpoint;
@@ -211,6 +232,23 @@ bool NewsBlurApi::update_article_flags(const std::string& /* oldflags */,
 	return false;
 }
 
+namespace {
+
+// Same as json_object_get_string() for the json-c objects elsewhere in this
+// file: values that aren't strings are serialized
+std::string json_to_string(const json& value)
+{
+	if (value.is_string()) {
+		return value.get<std::string>();
+	}
+	if (value.is_null()) {
+		return "";
+	}
+	return value.dump();
+}
+
+} // namespace
+
 time_t parse_date(const char* raw)
 {
 	struct tm tm;
@@ -229,100 +267,99 @@ rsspp::Feed NewsBlurApi::fetch_feed(const std::string& id)
 		min_pages,
 		id);
 
+	const auto add_story = [&f, &id](const json& item_obj) {
+		rsspp::Item item;
+
+		auto node = item_obj.find("story_title");
+		if (node != item_obj.end()) {
+			item.title = json_to_string(*node);
+		}
+
+		node = item_obj.find("story_authors");
+		if (node != item_obj.end()) {
+			item.author = json_to_string(*node);
+		}
+
+		node = item_obj.find("story_permalink");
+		if (node != item_obj.end()) {
+			item.link = json_to_string(*node);
+		}
+
+		node = item_obj.find("story_content");
+		if (node != item_obj.end()) {
+			item.content_encoded = json_to_string(*node);
+		}
+
+		std::string article_id;
+		node = item_obj.find("id");
+		if (node != item_obj.end()) {
+			article_id = json_to_string(*node);
+		}
+		item.guid = id + ID_SEPARATOR + article_id;
+
+		node = item_obj.find("read_status");
+		if (node != item_obj.end()) {
+			if (!node->is_number() || node->get<int>() == 0) {
+				item.labels.push_back("newsblur:unread");
+			} else {
+				item.labels.push_back("newsblur:read");
+			}
+		}
+
+		node = item_obj.find("story_date");
+		if (node != item_obj.end()) {
+			item.pubDate_ts = parse_date(json_to_string(*node).c_str());
+
+			item.pubDate = utils::mt_strf_localtime(
+					"%a, %d %b %Y %H:%M:%S %z",
+					item.pubDate_ts);
+		}
+
+		f.items.push_back(item);
+	};
+
 	for (unsigned int i = 1; i <= min_pages; i++) {
 		std::string page = std::to_string(i);
 
-		json_object* query_result = query_api(
-				"/reader/feed/" + id + "?page=" + page, nullptr);
-
-		if (!query_result) {
+		// Stories are turned into items as they are parsed, so the reply
+		// is never held in memory as a whole
+		const std::string url =
+			api_location + "/reader/feed/" + id + "?page=" + page;
+		const std::string data = utils::retrieve_url(url, cfg, "", nullptr);
+
+		json rest;
+		try {
+			if (!JsonListParser("stories", add_story).parse(data, rest)) {
+				LOG(Level::WARN,
+					"NewsBlurApi::fetch_feed: request to %s failed",
+					url);
+				return f;
+			}
+		} catch (json::exception& e) {
+			LOG(Level::ERROR,
+				"NewsBlurApi::fetch_feed: couldn't parse story: %s",
+				e.what());
 			return f;
 		}
 
-		json_object* stories{};
-		if (json_object_object_get_ex(
-				query_result, "stories", &stories) == FALSE) {
+		const auto stories = rest.find("stories");
+		if (stories == rest.end()) {
 			LOG(Level::ERROR,
 				"NewsBlurApi::fetch_feed: request returned no "
 				"stories");
 			return f;
 		}
 
-		if (json_object_get_type(stories) != json_type_array) {
+		if (!stories->is_array()) {
 			LOG(Level::ERROR,
 				"NewsBlurApi::fetch_feed: content is not an "
 				"array");
 			return f;
 		}
 
-		struct array_list* items = json_object_get_array(stories);
-		int items_size = array_list_length(items);
 		LOG(Level::DEBUG,
-			"NewsBlurApi::fetch_feed: %d items",
-			items_size);
-
-		for (int i = 0; i < items_size; i++) {
-			json_object* item_obj =
-				(json_object*)array_list_get_idx(items, i);
-
-			rsspp::Item item;
-
-			json_object* node{};
-
-			if (json_object_object_get_ex(
-					item_obj, "story_title", &node) == TRUE) {
-				item.title = json_object_get_string(node);
-			}
-
-			if (json_object_object_get_ex(
-					item_obj, "story_authors", &node) == TRUE) {
-				item.author = json_object_get_string(node);
-			}
-
-			if (json_object_object_get_ex(item_obj,
-					"story_permalink",
-					&node) == TRUE) {
-				item.link = json_object_get_string(node);
-			}
-
-			if (json_object_object_get_ex(
-					item_obj, "story_content", &node) == TRUE) {
-				item.content_encoded =
-					json_object_get_string(node);
-			}
-
-			const char* article_id{};
-			if (json_object_object_get_ex(item_obj, "id", &node) ==
-				TRUE) {
-				article_id = json_object_get_string(node);
-			}
-			item.guid = id + ID_SEPARATOR +
-				(article_id ? article_id : "");
-
-			if (json_object_object_get_ex(
-					item_obj, "read_status", &node) == TRUE) {
-				if (!static_cast<bool>(
-						json_object_get_int(node))) {
-					item.labels.push_back(
-						"newsblur:unread");
-				} else {
-					item.labels.push_back("newsblur:read");
-				}
-			}
-
-			if (json_object_object_get_ex(
-					item_obj, "story_date", &node) == TRUE) {
-				const char* pub_date =
-					json_object_get_string(node);
-				item.pubDate_ts = parse_date(pub_date);
-
-				item.pubDate = utils::mt_strf_localtime(
-						"%a, %d %b %Y %H:%M:%S %z",
-						item.pubDate_ts);
-			}
-
-			f.items.push_back(item);
-		}
+			"NewsBlurApi::fetch_feed: %" PRIu64 " items so far",
+			static_cast<uint64_t>(f.items.size()));
 	}
 
 	std::sort(f.items.begin(),
@@ -341,10 +378,14 @@ json_object* NewsBlurApi::query_api(const std::string& endpoint,
 	std::string data = utils::retrieve_url(url, cfg, "", postdata);
 
 	json_object* result = json_tokener_parse(data.c_str());
-	if (!result)
+	if (!result) {
 		LOG(Level::WARN,
 			"NewsBlurApi::query_api: request to %s failed",
 			url);
+		set_request_error(RequestError::CONNECTION);
+	} else {
+		set_request_error(RequestError::NONE);
+	}
 	return result;
 }
 
@@ -1,7 +1,9 @@
 #include "ocnewsapi.h"
 
 #include <algorithm>
+#include <cinttypes>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <curl/curl.h>
 #include <json-c/json.h>
@@ -12,11 +14,45 @@
 
 #define OCNEWS_API "/index.php/apps/news/api/v1-2/"
 
+using json = nlohmann::json;
+
 namespace newsboat {
 
 typedef std::unique_ptr<json_object, decltype(*json_object_put)> JsonUptr;
 typedef std::unique_ptr<CURL, decltype(*curl_easy_cleanup)> CurlUptr;
 
+namespace {
+
+/// Returns the string at \a key of \a obj, or an empty string if there's
+/// none (e.g. an article without an author)
+std::string get_string(const json& obj, const char* key)
+{
+	const auto value = obj.find(key);
+	if (value == obj.end() || !value->is_string()) {
+		return "";
+	}
+	return value->get<std::string>();
+}
+
+/// Returns the number at \a key of \a obj, or 0 if there's none. Some
+/// versions of the News app send `lastModified` as a string.
+int64_t get_int(const json& obj, const char* key)
+{
+	const auto value = obj.find(key);
+	if (value == obj.end()) {
+		return 0;
+	}
+	if (value->is_string()) {
+		return std::strtoll(value->get<std::string>().c_str(), nullptr, 10);
+	}
+	if (value->is_number()) {
+		return value->get<int64_t>();
+	}
+	return 0;
+}
+
+} // namespace
+
 OcNewsApi::OcNewsApi(ConfigContainer* c)
 	: RemoteApi(c)
 {
@@ -144,16 +180,44 @@ std::vector<TaggedFeedUrl> OcNewsApi::get_subscribed_urls()
 }
 
 bool OcNewsApi::mark_all_read(const std::string& feedurl)
+{
+	return mark_all_read_until(feedurl, "", 0);
+}
+
+bool OcNewsApi::mark_all_read_until(const std::string& feedurl,
+	const std::string& newest,
+	int64_t /* marked_at */)
 {
 	long id = known_feeds[feedurl].second;
 
-	std::string max = std::to_string(std::numeric_limits<long>::max());
+	// Item IDs grow as items arrive, so anything newer than the newest
+	// item the user saw stays unread
+	std::string newest_id = newest.substr(0, newest.find_first_of(":"));
+	if (newest_id.empty()) {
+		newest_id = std::to_string(std::numeric_limits<long>::max());
+	}
 	std::string query =
-		"feeds/" + std::to_string(id) + "/read?newestItemId=" + max;
+		"feeds/" + std::to_string(id) + "/read?newestItemId=" + newest_id;
 
 	return this->query(query, nullptr, "{}");
 }
 
+std::string OcNewsApi::get_newest_article(
+	const std::vector<std::string>& guids)
+{
+	// GUIDs start with the item ID, see item_from_json()
+	std::string newest;
+	long newest_id = -1;
+	for (const auto& guid : guids) {
+		const long id = std::strtol(guid.c_str(), nullptr, 10);
+		if (id > newest_id) {
+			newest_id = id;
+			newest = guid;
+		}
+	}
+	return newest;
+}
+
 bool OcNewsApi::mark_article_read(const std::string& guid, bool read)
 {
 	std::string query = "items/";
@@ -199,92 +263,140 @@ rsspp::Feed OcNewsApi::fetch_feed(const std::string& feed_id)
 		std::to_string(known_feeds[feed_id].second != 0 ? 0 : 2);
 	query += "&id=" + std::to_string(known_feeds[feed_id].second);
 
-	json_object* response;
-	if (!this->query(query, &response)) {
-		return feed;
-	}
-	JsonUptr response_uptr(response, json_object_put);
+	// Changes that the last prefetch saw happened before this request, so
+	// they're in the reply. That lets feeds that were too far behind to be
+	// served from the prefetch catch up with it.
+	const int64_t prefetched = get_prefetched_position();
 
-	json_object* items;
-	json_object_object_get_ex(response, "items", &items);
-	if (json_object_get_type(items) != json_type_array) {
-		LOG(Level::ERROR,
-			"OcNewsApi::fetch_feed: items is not an array");
+	std::vector<rsspp::Item> items;
+	int64_t position = 0;
+	const auto add_item = [&items, &position, this](const json& item_j) {
+		items.push_back(item_from_json(item_j));
+		position = std::max(position, get_int(item_j, "lastModified"));
+	};
+	if (!query_items(query, add_item)) {
 		return feed;
 	}
+	position = std::max(position, prefetched);
 
-	array_list* list = json_object_get_array(items);
-	int array_length = list->length;
+	feed.items = std::move(items);
+	feed.sync_position = position;
+	return feed;
+}
 
-	feed.items.clear();
+bool OcNewsApi::prefetch_feeds(int64_t since)
+{
+	// Type 3 with ID 0 means all articles
+	const std::string query =
+		"items/updated?type=3&id=0&lastModified=" + std::to_string(since);
+
+	// Feeds are known by their titles. Starred articles are fetched on
+	// their own, as "Starred" isn't a real feed.
+	std::map<int64_t, std::string> titles;
+	for (const auto& feed : known_feeds) {
+		if (feed.second.second != 0) {
+			titles[feed.second.second] = feed.first;
+		}
+	}
 
-	for (int i = 0; i < array_length; i++) {
-		json_object* item_j = static_cast<json_object*>(list->array[i]);
-		json_object* node;
-		rsspp::Item item;
+	std::map<std::string, std::vector<rsspp::Item>> changed;
+	int64_t position = since;
+	unsigned int count = 0;
 
-		json_object_object_get_ex(item_j, "title", &node);
-		item.title = json_object_get_string(node);
+	const auto add_item = [&](const json& item_j) {
+		count++;
+		position = std::max(position, get_int(item_j, "lastModified"));
 
-		json_object_object_get_ex(item_j, "url", &node);
-		if (node) {
-			item.link = json_object_get_string(node);
+		const auto title = titles.find(get_int(item_j, "feedId"));
+		if (title != titles.end()) {
+			changed[title->second].push_back(item_from_json(item_j));
 		}
+	};
+	if (!query_items(query, add_item)) {
+		return false;
+	}
 
-		json_object_object_get_ex(item_j, "author", &node);
-		item.author = json_object_get_string(node);
-
-		json_object_object_get_ex(item_j, "body", &node);
-		item.content_encoded = json_object_get_string(node);
-
-		{
-			json_object* type_obj;
-
-			json_object_object_get_ex(
-				item_j, "enclosureMime", &type_obj);
-			json_object_object_get_ex(
-				item_j, "enclosureLink", &node);
-
-			if (type_obj && node) {
-				const std::string type =
-					json_object_get_string(type_obj);
-				if (utils::is_valid_podcast_type(type)) {
-					item.enclosure_url =
-						json_object_get_string(node);
-					item.enclosure_type = std::move(type);
-				}
-			}
-		}
+	LOG(Level::DEBUG,
+		"OcNewsApi::prefetch_feeds: %u articles changed since %" PRId64,
+		count,
+		since);
 
-		json_object_object_get_ex(item_j, "id", &node);
-		long id = json_object_get_int(node);
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	has_prefetched = true;
+	prefetched_since = since;
+	prefetched_position = position;
+	prefetched_items = std::move(changed);
+	return true;
+}
 
-		json_object_object_get_ex(item_j, "feedId", &node);
-		long f_id = json_object_get_int(node);
+void OcNewsApi::discard_prefetched_feeds()
+{
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	has_prefetched = false;
+	prefetched_items.clear();
+}
 
-		json_object_object_get_ex(item_j, "guid", &node);
-		item.guid = std::to_string(id) + ":" + std::to_string(f_id) +
-			"/" + json_object_get_string(node);
+int64_t OcNewsApi::get_prefetched_position()
+{
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	return has_prefetched ? prefetched_position : 0;
+}
 
-		json_object_object_get_ex(item_j, "unread", &node);
-		bool unread = json_object_get_boolean(node);
-		if (unread) {
-			item.labels.push_back("ocnews:unread");
-		} else {
-			item.labels.push_back("ocnews:read");
-		}
+bool OcNewsApi::get_prefetched_feed(const std::string& feed_id,
+	int64_t watermark,
+	rsspp::Feed& feed)
+{
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	const auto known = known_feeds.find(feed_id);
+	if (!has_prefetched || watermark < prefetched_since ||
+		known == known_feeds.end() || known->second.second == 0) {
+		return false;
+	}
+
+	feed = known->second.first;
+	feed.items.clear();
+	feed.sync_position = prefetched_position;
+	const auto it = prefetched_items.find(feed_id);
+	if (it != prefetched_items.end()) {
+		feed.items = it->second;
+	}
+	return true;
+}
 
-		json_object_object_get_ex(item_j, "pubDate", &node);
-		time_t updated = (time_t)json_object_get_int(node);
+rsspp::Item OcNewsApi::item_from_json(const json& item_j)
+{
+	rsspp::Item item;
+
+	item.title = get_string(item_j, "title");
+	item.link = get_string(item_j, "url");
+	item.author = get_string(item_j, "author");
+	item.content_encoded = get_string(item_j, "body");
+
+	const std::string type = get_string(item_j, "enclosureMime");
+	const std::string link = get_string(item_j, "enclosureLink");
+	if (!link.empty() && utils::is_valid_podcast_type(type)) {
+		item.enclosure_url = link;
+		item.enclosure_type = type;
+	}
 
-		item.pubDate = utils::mt_strf_localtime(
-				"%a, %d %b %Y %H:%M:%S %z",
-				updated);
+	item.guid = std::to_string(get_int(item_j, "id")) + ":" +
+		std::to_string(get_int(item_j, "feedId")) + "/" +
+		get_string(item_j, "guid");
 
-		feed.items.push_back(item);
+	const auto unread = item_j.find("unread");
+	if (unread != item_j.end() && unread->is_boolean() &&
+		unread->get<bool>()) {
+		item.labels.push_back("ocnews:unread");
+	} else {
+		item.labels.push_back("ocnews:read");
 	}
 
-	return feed;
+	const time_t updated = get_int(item_j, "pubDate");
+	item.pubDate = utils::mt_strf_localtime(
+			"%a, %d %b %Y %H:%M:%S %z",
+			updated);
+
+	return item;
 }
 
 void OcNewsApi::add_custom_headers(curl_slist** /* custom_headers */)
@@ -295,6 +407,46 @@ void OcNewsApi::add_custom_headers(curl_slist** /* custom_headers */)
 bool OcNewsApi::query(const std::string& query,
 	json_object** result,
 	const std::string& post)
+{
+	std::string buff;
+	if (!send_query(query, buff, post)) {
+		return false;
+	}
+
+	if (result) {
+		*result = json_tokener_parse(buff.c_str());
+	}
+	return true;
+}
+
+bool OcNewsApi::query_items(const std::string& query,
+	const JsonListParser::ItemHandler& handle)
+{
+	std::string buff;
+	if (!send_query(query, buff, "")) {
+		return false;
+	}
+
+	json rest;
+	if (!JsonListParser("items", handle).parse(buff, rest)) {
+		LOG(Level::ERROR,
+			"OcNewsApi::query_items: reply to %s failed to parse",
+			query);
+		return false;
+	}
+
+	const auto items = rest.find("items");
+	if (items == rest.end() || !items->is_array()) {
+		LOG(Level::ERROR,
+			"OcNewsApi::query_items: items is not an array");
+		return false;
+	}
+	return true;
+}
+
+bool OcNewsApi::send_query(const std::string& query,
+	std::string& buff,
+	const std::string& post)
 {
 	CurlUptr curlhandle(curl_easy_init(), curl_easy_cleanup);
 	CURL* handle = curlhandle.get();
@@ -311,7 +463,6 @@ bool OcNewsApi::query(const std::string& query,
 			static_cast<const char*>(buffer), size * nmemb);
 		return size * nmemb;
 	};
-	std::string buff;
 	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, *write_fn);
 	curl_easy_setopt(handle, CURLOPT_WRITEDATA, &buff);
 
@@ -331,26 +482,29 @@ bool OcNewsApi::query(const std::string& query,
 			"OcNewsApi::query: connection error code %i (%s)",
 			res,
 			curl_easy_strerror(res));
+		set_request_error(RequestError::CONNECTION);
 		return false;
 	}
 
 	long response_code;
 	curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response_code);
 	if (response_code != 200) {
-		if (response_code == 401)
+		if (response_code == 401) {
 			LOG(Level::CRITICAL,
 				"OcNewsApi::query: authentication error");
-		else {
+			set_request_error(RequestError::AUTHENTICATION);
+		} else {
 			std::string msg = "OcNewsApi::query: error ";
 			msg += response_code;
 			LOG(Level::CRITICAL, msg);
+			set_request_error(response_code >= 500
+				? RequestError::CONNECTION
+				: RequestError::REJECTED);
 		}
 		return false;
 	}
 
-	if (result) {
-		*result = json_tokener_parse(buff.c_str());
-	}
+	set_request_error(RequestError::NONE);
 	return true;
 }
 
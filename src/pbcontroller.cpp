@@ -3,26 +3,26 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <getopt.h>
 #include <iostream>
 #include <pwd.h>
 #include <signal.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <thread>
 #include <unistd.h>
 
 #include "colormanager.h"
 #include "config.h"
 #include "configcontainer.h"
 #include "configexception.h"
+#include "enclosureindex.h"
 #include "globals.h"
 #include "keymap.h"
 #include "logger.h"
 #include "matcherexception.h"
 #include "nullconfigactionhandler.h"
 #include "pbview.h"
-#include "poddlthread.h"
 #include "queueloader.h"
 #include "strprintf.h"
 #include "utils.h"
@@ -118,6 +118,8 @@ bool PbController::setup_dirs_xdg(const char* env_home)
 	lock_file = cache_file + LOCK_SUFFIX;
 	queue_file =
 		xdg_data_dir + NEWSBEUTER_PATH_SEP + queue_file;
+	enclosure_index_file =
+		xdg_data_dir + NEWSBEUTER_PATH_SEP + enclosure_index_file;
 	searchfile = strprintf::fmt(
 			"%s%chistory.search", xdg_data_dir, NEWSBEUTER_PATH_SEP);
 	cmdlinefile = strprintf::fmt(
@@ -130,12 +132,22 @@ PbController::PbController()
 	: v(0)
 	, config_file("config")
 	, queue_file("queue")
+	, enclosure_index_file("enclosures")
 	, cfg(0)
 	, view_update_(true)
 	, max_dls(1)
 	, ql(0)
 	, lock_file("pb-lock.pid")
 {
+	if (::pipe(wakeup_pipe) == 0) {
+		for (int fd : wakeup_pipe) {
+			::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+			::fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+	} else {
+		wakeup_pipe[0] = wakeup_pipe[1] = -1;
+	}
+
 	char* cfgdir;
 	if (!(cfgdir = ::getenv("HOME"))) {
 		struct passwd* spw = ::getpwuid(::getuid());
@@ -178,12 +190,40 @@ PbController::PbController()
 
 	config_file = config_dir + NEWSBEUTER_PATH_SEP + config_file;
 	queue_file = config_dir + NEWSBEUTER_PATH_SEP + queue_file;
+	enclosure_index_file =
+		config_dir + NEWSBEUTER_PATH_SEP + enclosure_index_file;
 	lock_file = config_dir + NEWSBEUTER_PATH_SEP + lock_file;
 }
 
 PbController::~PbController()
 {
 	delete cfg;
+	if (wakeup_pipe[0] != -1) {
+		::close(wakeup_pipe[0]);
+		::close(wakeup_pipe[1]);
+	}
+}
+
+void PbController::set_view_update_necessary(bool b)
+{
+	// Only the first of a batch of updates writes to the pipe; the rest
+	// are picked up by the same redraw
+	if (b && !view_update_.exchange(true) && wakeup_pipe[1] != -1) {
+		const char byte = 0;
+		if (::write(wakeup_pipe[1], &byte, 1) == -1) {
+			// The pipe is full, so the view is going to wake up anyway
+		}
+	} else if (!b) {
+		view_update_ = false;
+	}
+}
+
+void PbController::drain_view_wakeups()
+{
+	char buf[64];
+	while (wakeup_pipe[0] != -1
+		&& ::read(wakeup_pipe[0], buf, sizeof(buf)) > 0) {
+	}
 }
 
 int PbController::run(int argc, char* argv[])
@@ -304,12 +344,31 @@ int PbController::run(int argc, char* argv[])
 		std::bind(&PbController::set_view_update_necessary, this, true));
 	ql->reload(downloads_);
 
+	enclosure_index.reset(new EnclosureIndex(enclosure_index_file));
+	enclosure_index->load();
+
+	engine.reset(new DownloadEngine(cfg, enclosure_index.get()));
+	engine->set_max_parallel(max_dls);
+	const int max_dl_speed =
+		cfg->get_configvalue_as_int("max-download-speed");
+	if (max_dl_speed > 0) {
+		engine->set_bandwidth_limit(max_dl_speed * 1024ull);
+	}
+	const int segments = cfg->get_configvalue_as_int("download-segments");
+	if (segments > 1) {
+		engine->set_max_segments(segments);
+	}
+
 	v->set_keymap(&keys);
 
 	v->run(automatic_dl);
 
 	Stfl::reset();
 
+	// The view doesn't let the user quit while downloads are running, so
+	// this only drops the pending ones
+	engine.reset();
+
 	std::cout << _("Cleaning up queue...");
 	std::cout.flush();
 
@@ -402,11 +461,23 @@ unsigned int PbController::get_maxdownloads()
 	return max_dls;
 }
 
-void PbController::purge_queue()
+bool PbController::purge_queue()
 {
+	// The reload below moves downloads around in memory, so the engine
+	// mustn't keep pointers to them. Checking for running downloads and
+	// forgetting the pending ones happens in one go, so that none can start
+	// in between.
+	if (engine) {
+		if (!engine->clear_pending_if_idle()) {
+			return false;
+		}
+	} else if (downloads_in_progress() > 0) {
+		return false;
+	}
 	if (ql) {
 		ql->reload(downloads_, true);
 	}
+	return true;
 }
 
 double PbController::get_total_kbps()
@@ -422,23 +493,37 @@ double PbController::get_total_kbps()
 
 void PbController::start_downloads()
 {
-	int dl2start = get_maxdownloads() - downloads_in_progress();
+	if (!engine) {
+		return;
+	}
 	for (auto& download : downloads_) {
-		if (dl2start == 0) {
-			break;
-		}
-
 		if (download.status() == DlStatus::QUEUED) {
-			std::thread t{PodDlThread(&download, cfg)};
-			--dl2start;
-			t.detach();
+			engine->enqueue(&download);
 		}
 	}
 }
 
+void PbController::start_download(unsigned int idx)
+{
+	if (engine && idx < downloads_.size()) {
+		engine->enqueue(&downloads_[idx],
+			DownloadEngine::Priority::HIGH);
+	}
+}
+
+void PbController::clear_pending_downloads()
+{
+	if (engine) {
+		engine->clear_pending();
+	}
+}
+
 void PbController::increase_parallel_downloads()
 {
 	++max_dls;
+	if (engine) {
+		engine->set_max_parallel(max_dls);
+	}
 }
 
 void PbController::decrease_parallel_downloads()
@@ -446,6 +531,9 @@ void PbController::decrease_parallel_downloads()
 	if (max_dls > 1) {
 		--max_dls;
 	}
+	if (engine) {
+		engine->set_max_parallel(max_dls);
+	}
 }
 
 void PbController::play_file(const std::string& file)
@@ -5,7 +5,9 @@
 #include <cstring>
 #include <curses.h>
 #include <iostream>
+#include <poll.h>
 #include <sstream>
+#include <unistd.h>
 
 #include "config.h"
 #include "configcontainer.h"
@@ -15,7 +17,6 @@
 #include "help.h"
 #include "logger.h"
 #include "pbcontroller.h"
-#include "poddlthread.h"
 #include "strprintf.h"
 #include "utils.h"
 
@@ -28,6 +29,7 @@ PbView::PbView(PbController* c)
 	, dllist_form(dllist_str)
 	, help_form(help_str)
 	, keys(0)
+	, rendered_width(0)
 {
 	if (getenv("ESCDELAY") == nullptr) {
 		set_escdelay(25);
@@ -47,70 +49,20 @@ void PbView::run(bool auto_download)
 
 	do {
 		if (ctrl->view_update_necessary()) {
-			const double total_kbps = ctrl->get_total_kbps();
-			const auto speed = get_speed_human_readable(total_kbps);
-
-			char parbuf[128] = "";
-			if (ctrl->get_maxdownloads() > 1) {
-				snprintf(parbuf,
-					sizeof(parbuf),
-					_(" - %u parallel downloads"),
-					ctrl->get_maxdownloads());
-			}
-
-			char buf[1024];
-			snprintf(buf,
-				sizeof(buf),
-				_("Queue (%u downloads in progress, %u total) "
-					"- %.2f %s total%s"),
-				static_cast<unsigned int>(
-					ctrl->downloads_in_progress()),
-				static_cast<unsigned int>(
-					ctrl->downloads().size()),
-				speed.first,
-				speed.second.c_str(),
-				parbuf);
-
-			dllist_form.set("head", buf);
-
-			LOG(Level::DEBUG,
-				"PbView::run: updating view... "
-				"downloads().size() "
-				"= %" PRIu64,
-				static_cast<uint64_t>(ctrl->downloads().size()));
-
-			std::string code = "{list";
-			std::string formatstring = ctrl->get_formatstr();
-
-			dllist_form.run(-3); // compute all widget dimensions
-			unsigned int width = utils::to_u(dllist_form.get("dls:w"));
-
-			unsigned int i = 0;
-			for (const auto& dl : ctrl->downloads()) {
-				auto lbuf = format_line(formatstring, dl, i, width);
-				code.append(
-					strprintf::fmt("{listitem[%u] text:%s}",
-						i,
-						Stfl::quote(lbuf)));
-				i++;
-			}
-
-			code.append("}");
-
-			dllist_form.modify("dls", "replace_inner", code);
-
+			// Cleared before rendering, so that updates coming in
+			// meanwhile trigger another round
 			ctrl->set_view_update_necessary(false);
+			update_dllist();
 		}
 
-		const char* event = dllist_form.run(500);
-
 		if (auto_download) {
-			if (ctrl->get_maxdownloads() >
-				ctrl->downloads_in_progress()) {
-				ctrl->start_downloads();
-			}
+			// The engine ignores downloads it already knows about and
+			// only runs as many as allowed at once
+			ctrl->start_downloads();
 		}
 
+		const char* event = wait_for_event();
+
 		if (!event || strcmp(event, "TIMEOUT") == 0) {
 			continue;
 		}
@@ -125,6 +77,9 @@ void PbView::run(bool auto_download)
 		switch (op) {
 		case OP_PB_TOGGLE_DLALL:
 			auto_download = !auto_download;
+			if (!auto_download) {
+				ctrl->clear_pending_downloads();
+			}
 			break;
 		case OP_HARDQUIT:
 		case OP_QUIT:
@@ -150,10 +105,7 @@ void PbView::run(bool auto_download)
 			if (idx != -1) {
 				if (ctrl->downloads()[idx].status() !=
 					DlStatus::DOWNLOADING) {
-					std::thread t{PodDlThread(
-							&ctrl->downloads()[idx],
-							ctrl->get_cfgcont())};
-					t.detach();
+					ctrl->start_download(idx);
 				}
 			}
 		}
@@ -222,12 +174,10 @@ void PbView::run(bool auto_download)
 		}
 		break;
 		case OP_PB_PURGE:
-			if (ctrl->downloads_in_progress() > 0) {
+			if (!ctrl->purge_queue()) {
 				dllist_form.set("msg",
 					_("Error: unable to perform operation: "
 						"download(s) in progress."));
-			} else {
-				ctrl->purge_queue();
 			}
 			ctrl->set_view_update_necessary(true);
 			break;
@@ -241,6 +191,105 @@ void PbView::run(bool auto_download)
 	} while (!quit);
 }
 
+void PbView::update_dllist()
+{
+	const double total_kbps = ctrl->get_total_kbps();
+	const auto speed = get_speed_human_readable(total_kbps);
+
+	char parbuf[128] = "";
+	if (ctrl->get_maxdownloads() > 1) {
+		snprintf(parbuf,
+			sizeof(parbuf),
+			_(" - %u parallel downloads"),
+			ctrl->get_maxdownloads());
+	}
+
+	char buf[1024];
+	snprintf(buf,
+		sizeof(buf),
+		_("Queue (%u downloads in progress, %u total) "
+			"- %.2f %s total%s"),
+		static_cast<unsigned int>(
+			ctrl->downloads_in_progress()),
+		static_cast<unsigned int>(
+			ctrl->downloads().size()),
+		speed.first,
+		speed.second.c_str(),
+		parbuf);
+
+	dllist_form.set("head", buf);
+
+	LOG(Level::DEBUG,
+		"PbView::update_dllist: updating view... "
+		"downloads().size() "
+		"= %" PRIu64,
+		static_cast<uint64_t>(ctrl->downloads().size()));
+
+	const std::string formatstring = ctrl->get_formatstr();
+
+	dllist_form.run(-3); // compute all widget dimensions
+	const unsigned int width = utils::to_u(dllist_form.get("dls:w"));
+
+	std::vector<std::string> lines;
+	lines.reserve(ctrl->downloads().size());
+	unsigned int i = 0;
+	for (const auto& dl : ctrl->downloads()) {
+		lines.push_back(format_line(formatstring, dl, i, width));
+		i++;
+	}
+
+	if (lines.size() != rendered_lines.size() || width != rendered_width) {
+		std::string code = "{list";
+		for (i = 0; i < lines.size(); ++i) {
+			code.append(strprintf::fmt("{listitem[%u] text[dl_%u]:%s}",
+					i,
+					i,
+					Stfl::quote(lines[i])));
+		}
+		code.append("}");
+
+		dllist_form.modify("dls", "replace_inner", code);
+	} else {
+		// Most of the time, only the rows of running downloads change
+		for (i = 0; i < lines.size(); ++i) {
+			if (lines[i] != rendered_lines[i]) {
+				dllist_form.set(strprintf::fmt("dl_%u", i), lines[i]);
+			}
+		}
+	}
+
+	rendered_lines = std::move(lines);
+	rendered_width = width;
+}
+
+const char* PbView::wait_for_event()
+{
+	const int wakeup_fd = ctrl->view_wakeup_fd();
+	if (wakeup_fd == -1) {
+		return dllist_form.run(500);
+	}
+
+	dllist_form.run(-1); // draw the changes, don't wait for input
+
+	// Sleep until either a key is pressed or a download changes
+	struct pollfd fds[2];
+	fds[0].fd = STDIN_FILENO;
+	fds[0].events = POLLIN;
+	fds[1].fd = wakeup_fd;
+	fds[1].events = POLLIN;
+	const int ready = ::poll(fds, 2, -1);
+
+	if (ready > 0 && (fds[1].revents & POLLIN)) {
+		ctrl->drain_view_wakeups();
+	}
+	if (ready > 0 && !(fds[0].revents & POLLIN)) {
+		return nullptr;
+	}
+
+	// Input, or a signal like SIGWINCH that curses has to handle
+	return dllist_form.run(1);
+}
+
 void PbView::set_bindings()
 {
 	if (keys) {
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <libgen.h>
 #include <unistd.h>
+#include <unordered_set>
 
 #include "config.h"
 #include "configcontainer.h"
@@ -77,6 +78,16 @@ void QueueLoader::reload(std::vector<Download>& downloads,
 		}
 	}
 
+	// URLs that are either kept or about to be deleted, i.e. that must
+	// not be loaded from the queue file again
+	std::unordered_set<std::string> known_urls;
+	for (const auto& dl : dltemp) {
+		known_urls.insert(dl.url());
+	}
+	for (const auto& dl : deletion_list) {
+		known_urls.insert(dl.url());
+	}
+
 	f.open(queuefile.c_str(), std::fstream::in);
 	bool comments_ignored = false;
 	if (f.is_open()) {
@@ -90,7 +101,6 @@ void QueueLoader::reload(std::vector<Download>& downloads,
 					line);
 				std::vector<std::string> fields =
 					utils::tokenize_quoted(line);
-				bool url_found = false;
 
 				if (fields.empty()) {
 					if (!comments_ignored) {
@@ -108,31 +118,12 @@ void QueueLoader::reload(std::vector<Download>& downloads,
 					continue;
 				}
 
-				for (const auto& dl : dltemp) {
-					if (fields[0] == dl.url()) {
-						LOG(Level::INFO,
-							"QueueLoader::reload: "
-							"found `%s' in old "
-							"vector",
-							fields[0]);
-						url_found = true;
-						break;
-					}
-				}
-
-				for (const auto& dl : deletion_list) {
-					if (fields[0] == dl.url()) {
-						LOG(Level::INFO,
-							"QueueLoader::reload: "
-							"found `%s' in scheduled for deletion "
-							"vector",
-							fields[0]);
-						url_found = true;
-						break;
-					}
-				}
-
-				if (!url_found) {
+				if (known_urls.count(fields[0]) > 0) {
+					LOG(Level::INFO,
+						"QueueLoader::reload: found `%s' in old "
+						"vector or scheduled for deletion",
+						fields[0]);
+				} else {
 					LOG(Level::INFO,
 						"QueueLoader::reload: found "
 						"`%s' "
@@ -195,6 +186,7 @@ void QueueLoader::reload(std::vector<Download>& downloads,
 
 					d.set_url(fields[0]);
 					dltemp.push_back(d);
+					known_urls.insert(fields[0]);
 				}
 			}
 		} while (!f.eof());
@@ -1,7 +1,9 @@
 #include "queuemanager.h"
 
+#include <cstring>
 #include <fstream>
 #include <libxml/uri.h>
+#include <sstream>
 
 #include "configpaths.h"
 #include "fmtstrformatter.h"
@@ -11,40 +13,96 @@
 
 namespace newsboat {
 
+namespace {
+
+// st_mtime only has a resolution of a second, which misses a file that is
+// rewritten with the same size right after we read it. The change time is
+// compared as well, as tools that copy files may restore the old mtime.
+bool same_file_state(const struct stat& a, const struct stat& b)
+{
+#ifdef __APPLE__
+	const auto& a_mtime = a.st_mtimespec;
+	const auto& b_mtime = b.st_mtimespec;
+	const auto& a_ctime = a.st_ctimespec;
+	const auto& b_ctime = b.st_ctimespec;
+#else
+	const auto& a_mtime = a.st_mtim;
+	const auto& b_mtime = b.st_mtim;
+	const auto& a_ctime = a.st_ctim;
+	const auto& b_ctime = b.st_ctim;
+#endif
+	return a.st_dev == b.st_dev
+		&& a.st_ino == b.st_ino
+		&& a.st_size == b.st_size
+		&& a_mtime.tv_sec == b_mtime.tv_sec
+		&& a_mtime.tv_nsec == b_mtime.tv_nsec
+		&& a_ctime.tv_sec == b_ctime.tv_sec
+		&& a_ctime.tv_nsec == b_ctime.tv_nsec;
+}
+
+} // namespace
+
 QueueManager::QueueManager(ConfigContainer* cfg_, ConfigPaths* paths_)
 	: cfg(cfg_)
 	, paths(paths_)
-{}
+{
+	memset(&loaded_state, 0, sizeof(loaded_state));
+}
 
 void QueueManager::enqueue_url(std::shared_ptr<RssItem> item,
 	std::shared_ptr<RssFeed> feed)
 {
 	const std::string& url = item->enclosure_url();
-	bool url_found = false;
-	std::fstream f;
-	f.open(paths->queue_file(), std::fstream::in);
-	if (f.is_open()) {
-		do {
-			std::string line;
-			getline(f, line);
-			if (!f.eof() && !line.empty()) {
-				std::vector<std::string> fields =
-					utils::tokenize_quoted(line);
-				if (!fields.empty() && fields[0] == url) {
-					url_found = true;
-					break;
-				}
-			}
-		} while (!f.eof());
-		f.close();
-	}
-	if (!url_found) {
-		f.open(paths->queue_file(),
-			std::fstream::app | std::fstream::out);
+
+	std::lock_guard<std::mutex> guard(queue_mutex);
+	load_queued_urls();
+	if (queued_urls.insert(url).second) {
 		const std::string filename =
 			generate_enqueue_filename(item, feed);
-		f << url << " " << utils::quote(filename) << std::endl;
-		f.close();
+		append_to_queue(url + " " + utils::quote(filename) + "\n");
+	}
+}
+
+void QueueManager::load_queued_urls()
+{
+	const std::string queue_file = paths->queue_file();
+
+	struct stat state;
+	if (stat(queue_file.c_str(), &state) != 0) {
+		memset(&state, 0, sizeof(state));
+	}
+	if (queue_file == loaded_file && same_file_state(state, loaded_state)) {
+		return;
+	}
+
+	LOG(Level::DEBUG,
+		"QueueManager::load_queued_urls: reading %s",
+		queue_file);
+	queued_urls.clear();
+	std::ifstream f(queue_file);
+	std::string line;
+	while (std::getline(f, line)) {
+		if (line.empty()) {
+			continue;
+		}
+		const std::vector<std::string> fields = utils::tokenize_quoted(line);
+		if (!fields.empty()) {
+			queued_urls.insert(fields[0]);
+		}
+	}
+
+	loaded_file = queue_file;
+	loaded_state = state;
+}
+
+void QueueManager::append_to_queue(const std::string& lines)
+{
+	std::ofstream f(loaded_file, std::ofstream::app);
+	f << lines;
+	f.close();
+
+	if (stat(loaded_file.c_str(), &loaded_state) != 0) {
+		memset(&loaded_state, 0, sizeof(loaded_state));
 	}
 }
 
@@ -112,13 +170,20 @@ std::string QueueManager::generate_enqueue_filename(std::shared_ptr<RssItem>
 	return dlpath;
 }
 
-void QueueManager::autoenqueue(std::shared_ptr<RssFeed> feed)
+std::vector<std::shared_ptr<RssItem>> QueueManager::autoenqueue(
+		std::shared_ptr<RssFeed> feed)
 {
+	std::vector<std::shared_ptr<RssItem>> enqueued;
 	if (!cfg->get_configvalue_as_bool("podcast-auto-enqueue")) {
-		return;
+		return enqueued;
 	}
 
 	std::lock_guard<std::mutex> lock(feed->item_mutex);
+	std::lock_guard<std::mutex> guard(queue_mutex);
+	load_queued_urls();
+
+	// Written to the file all at once, after the loop
+	std::ostringstream lines;
 	for (const auto& item : feed->items()) {
 		if (!item->enqueued() && item->enclosure_url().length() > 0) {
 			LOG(Level::DEBUG,
@@ -132,11 +197,23 @@ void QueueManager::autoenqueue(std::shared_ptr<RssFeed> feed)
 					"QueueManager::autoenqueue: enqueuing "
 					"`%s'",
 					item->enclosure_url());
-				enqueue_url(item, feed);
+				const std::string& url = item->enclosure_url();
+				if (queued_urls.insert(url).second) {
+					lines << url << " "
+						<< utils::quote(
+							generate_enqueue_filename(item, feed))
+						<< "\n";
+				}
 				item->set_enqueued(true);
+				enqueued.push_back(item);
 			}
 		}
 	}
+
+	if (lines.tellp() > 0) {
+		append_to_queue(lines.str());
+	}
+	return enqueued;
 }
 
 } // namespace newsboat
@@ -1,6 +1,7 @@
 #include "reloader.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cinttypes>
 #include <iostream>
 #include <ncurses.h>
@@ -11,12 +12,13 @@
 #include "dbexception.h"
 #include "downloadthread.h"
 #include "fmtstrformatter.h"
+#include "metrics.h"
+#include "remoteapi.h"
 #include "reloadrangethread.h"
 #include "reloadthread.h"
 #include "rss/exception.h"
 #include "rssfeed.h"
 #include "rssparser.h"
-#include "scopemeasure.h"
 #include "utils.h"
 #include "view.h"
 
@@ -78,7 +80,8 @@ void Reloader::reload(unsigned int pos,
 		}
 
 		const bool ignore_dl =
-			(cfg->get_configvalue("ignore-mode") == "download");
+			(cfg->snapshot()->get(ConfigKey::IGNORE_MODE) ==
+				"download");
 
 		RssParser parser(oldfeed->rssurl(),
 			rsscache,
@@ -87,16 +90,22 @@ void Reloader::reload(unsigned int pos,
 			ctrl->get_api());
 		parser.set_easyhandle(easyhandle);
 		LOG(Level::DEBUG, "Reloader::reload: created parser");
+		static auto& timings =
+			MetricsRegistry::global().histogram("reload.feed");
+		ScopeTimer timer(timings);
+		const auto started = std::chrono::steady_clock::now();
+		FeedReloadStats stats;
 		try {
 			oldfeed->set_status(DlStatus::DURING_DOWNLOAD);
 			std::shared_ptr<RssFeed> newfeed = parser.parse();
+			stats = parser.get_reload_stats();
 			if (newfeed != nullptr) {
-				ctrl->replace_feed(
-					oldfeed, newfeed, pos, unattended);
 				if (newfeed->total_item_count() == 0) {
 					LOG(Level::DEBUG,
 						"Reloader::reload: feed is empty");
 				}
+				ctrl->replace_feed(
+					oldfeed, newfeed, pos, unattended, &stats);
 			}
 			oldfeed->set_status(DlStatus::SUCCESS);
 			ctrl->get_view()->set_status("");
@@ -117,6 +126,18 @@ void Reloader::reload(unsigned int pos,
 					e.what());
 		}
 		if (!errmsg.empty()) {
+			if (stats.rssurl.empty()) {
+				// The parser threw before we could fetch its stats
+				stats = parser.get_reload_stats();
+			}
+			stats.error = errmsg;
+		}
+		record_reload_stats(pos, oldfeed->rssurl(), started, stats);
+
+		if (!errmsg.empty()) {
+			static auto& errors =
+				MetricsRegistry::global().counter("reload.errors");
+			errors.increment();
 			oldfeed->set_status(DlStatus::DL_ERROR);
 			ctrl->get_view()->set_status(errmsg);
 			LOG(Level::USERERROR, "%s", errmsg);
@@ -126,6 +147,35 @@ void Reloader::reload(unsigned int pos,
 	}
 }
 
+void Reloader::record_reload_stats(unsigned int pos,
+	const std::string& rssurl,
+	std::chrono::steady_clock::time_point started,
+	FeedReloadStats& stats)
+{
+	stats.rssurl = rssurl;
+	stats.reloaded_at = time(nullptr);
+	stats.total_us = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - started).count();
+
+	try {
+		rsscache->record_reload_stats(stats);
+	} catch (const DbException& e) {
+		LOG(Level::ERROR,
+			"Reloader::record_reload_stats: failed to store stats for "
+			"`%s': %s",
+			rssurl,
+			e.what());
+	}
+
+	FeedContainer* feeds = ctrl->get_feedcontainer();
+	if (pos < feeds->feeds_size()) {
+		const auto feed = feeds->get_feed(pos);
+		if (feed->rssurl() == rssurl) {
+			feed->set_last_reload_duration(stats.total_us);
+		}
+	}
+}
+
 std::string Reloader::prepare_message(unsigned int pos, unsigned int max)
 {
 	if (max > 0) {
@@ -134,8 +184,52 @@ std::string Reloader::prepare_message(unsigned int pos, unsigned int max)
 	return "";
 }
 
+bool Reloader::prefetch_remote_feeds()
+{
+	RemoteApi* api = ctrl->get_api();
+	if (api == nullptr) {
+		return false;
+	}
+
+	std::vector<std::string> feedurls;
+	for (const auto& feed : ctrl->get_feedcontainer()->feeds) {
+		if (!feed->is_query_feed()) {
+			feedurls.push_back(feed->rssurl());
+		}
+	}
+
+	// The prefetch picks up where the last one left off. Feeds that are
+	// behind that, like ones that were never synced, are fetched one by
+	// one, which brings them up to the prefetch's position; starting at the
+	// oldest watermark instead would let a single feed make every prefetch
+	// huge.
+	time_t since = 0;
+	try {
+		since = rsscache->fetch_newest_sync_watermark(feedurls);
+	} catch (const DbException& e) {
+		LOG(Level::ERROR,
+			"Reloader::prefetch_remote_feeds: couldn't read sync "
+			"watermarks: %s",
+			e.what());
+	}
+	if (since == 0) {
+		return false;
+	}
+
+	const bool prefetched = api->prefetch_feeds(since);
+	LOG(Level::DEBUG,
+		"Reloader::prefetch_remote_feeds: since = %" PRId64 ", success "
+		"= %d",
+		static_cast<int64_t>(since),
+		prefetched ? 1 : 0);
+	return prefetched;
+}
+
 void Reloader::reload_all(bool unattended)
 {
+	static auto& timings = MetricsRegistry::global().histogram("reload.all");
+	ScopeTimer timer(timings);
+
 	const auto unread_feeds =
 		ctrl->get_feedcontainer()->unread_feed_count();
 	const auto unread_articles =
@@ -153,6 +247,8 @@ void Reloader::reload_all(bool unattended)
 
 	t1 = time(nullptr);
 
+	const bool prefetched = prefetch_remote_feeds();
+
 	LOG(Level::DEBUG, "Reloader::reload_all: starting with reload all...");
 	if (num_threads == 1) {
 		reload_range(0, num_feeds - 1, num_feeds, unattended);
@@ -182,6 +278,10 @@ void Reloader::reload_all(bool unattended)
 		}
 	}
 
+	if (prefetched) {
+		ctrl->get_api()->discard_prefetched_feeds();
+	}
+
 	// refresh query feeds (update and sort)
 	LOG(Level::DEBUG, "Reloader::reload_all: refresh query feeds");
 	for (const auto& feed : ctrl->get_feedcontainer()->feeds) {
@@ -195,6 +295,10 @@ void Reloader::reload_all(bool unattended)
 	ctrl->get_feedcontainer()->sort_feeds(cfg->get_feed_sort_strategy());
 	ctrl->update_feedlist();
 
+	// The parsed feeds are gone by now; only the articles read back from
+	// the cache remain
+	utils::release_free_memory();
+
 	t2 = time(nullptr);
 	dt = t2 - t1;
 	// On GCC, `time_t` is `long int`, which is at least 32 bits. On x86_64,
@@ -230,7 +334,9 @@ void Reloader::reload_all(bool unattended)
 
 void Reloader::reload_indexes(const std::vector<int>& indexes, bool unattended)
 {
-	ScopeMeasure m1("Reloader::reload_indexes");
+	static auto& timings =
+		MetricsRegistry::global().histogram("reload.indexes");
+	ScopeTimer timer(timings);
 	const auto unread_feeds =
 		ctrl->get_feedcontainer()->unread_feed_count();
 	const auto unread_articles =
@@ -324,4 +430,12 @@ void Reloader::notify(const std::string& msg)
 	}
 }
 
+bool Reloader::notifications_enabled()
+{
+	return cfg->get_configvalue_as_bool("notify-screen") ||
+		cfg->get_configvalue_as_bool("notify-xterm") ||
+		cfg->get_configvalue_as_bool("notify-beep") ||
+		cfg->get_configvalue("notify-program").length() > 0;
+}
+
 } // namespace newsboat
@@ -1,14 +1,57 @@
 #include "remoteapi.h"
 
+#include <cinttypes>
+#include <cstdlib>
 #include <fstream>
 #include <glob.h>
 #include <iostream>
 #include <unistd.h>
 
+#include "3rd-party/json.hpp"
+#include "logger.h"
+#include "strprintf.h"
 #include "utils.h"
 
+using json = nlohmann::json;
+
 namespace newsboat {
 
+namespace {
+
+// Reload threads and the remote sync queue use the API at the same time, so
+// each of them gets to see the outcome of its own requests only
+thread_local RemoteApi::RequestError request_error =
+	RemoteApi::RequestError::NONE;
+
+} // namespace
+
+bool RemoteApi::mark_articles_read(const std::vector<std::string>& guids,
+	bool read)
+{
+	bool success = true;
+	RequestError error = RequestError::NONE;
+	for (const auto& guid : guids) {
+		if (!mark_article_read(guid, read)) {
+			if (success) {
+				error = last_request_error();
+			}
+			success = false;
+		}
+	}
+	set_request_error(error);
+	return success;
+}
+
+RemoteApi::RequestError RemoteApi::last_request_error()
+{
+	return request_error;
+}
+
+void RemoteApi::set_request_error(RequestError error)
+{
+	request_error = error;
+}
+
 const std::string RemoteApi::read_password(const std::string& file)
 {
 	glob_t exp;
@@ -86,4 +129,140 @@ Credentials RemoteApi::get_credentials(const std::string& scope,
 	return {user, pass};
 }
 
+namespace {
+
+const std::string GREADER_FEED_PATH = "/reader/atom/";
+const std::string GREADER_ITEM_IDS_PATH = "/reader/api/0/stream/items/ids";
+const std::string GREADER_ITEM_PREFIX = "tag:google.com,2005:reader/item/";
+
+size_t append_to_string(void* buffer, size_t size, size_t nmemb, void* userp)
+{
+	std::string* pbuf = static_cast<std::string*>(userp);
+	pbuf->append(static_cast<const char*>(buffer), size * nmemb);
+	return size * nmemb;
+}
+
+} // namespace
+
+std::string RemoteApi::greader_delta_url(const std::string& feedurl,
+	time_t since,
+	const std::string& continuation)
+{
+	std::string url = feedurl;
+	url.append(feedurl.find('?') == std::string::npos ? "?" : "&");
+	url.append(strprintf::fmt("ot=%" PRId64, static_cast<int64_t>(since)));
+	if (!continuation.empty()) {
+		CURL* handle = curl_easy_init();
+		char* escaped = curl_easy_escape(handle, continuation.c_str(), 0);
+		url.append("&c=");
+		url.append(escaped);
+		curl_free(escaped);
+		curl_easy_cleanup(handle);
+	}
+	return url;
+}
+
+bool RemoteApi::greader_unread_guids(const std::string& feedurl,
+	unsigned int limit,
+	std::unordered_set<std::string>& guids)
+{
+	// Feeds are at <prefix>/reader/atom/<stream ID>?n=..., and the
+	// stream ID is already URL-encoded there
+	const std::string::size_type feed_path = feedurl.find(GREADER_FEED_PATH);
+	if (feed_path == std::string::npos) {
+		return false;
+	}
+	const std::string::size_type stream_start =
+		feed_path + GREADER_FEED_PATH.size();
+	const std::string stream = feedurl.substr(stream_start,
+			feedurl.find('?', stream_start) - stream_start);
+	const std::string url = strprintf::fmt(
+			"%s%s?s=%s&xt=user/-/state/com.google/read&n=%u&output=json",
+			feedurl.substr(0, feed_path),
+			GREADER_ITEM_IDS_PATH,
+			stream,
+			limit);
+
+	std::string reply;
+	curl_slist* custom_headers{};
+	CURL* handle = curl_easy_init();
+	utils::set_common_curl_options(handle, cfg);
+	add_custom_headers(&custom_headers);
+	curl_easy_setopt(handle, CURLOPT_HTTPHEADER, custom_headers);
+	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, append_to_string);
+	curl_easy_setopt(handle, CURLOPT_WRITEDATA, &reply);
+	curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+	const CURLcode result = curl_easy_perform(handle);
+	long status = 0;
+	curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status);
+	curl_easy_cleanup(handle);
+	curl_slist_free_all(custom_headers);
+
+	LOG(Level::DEBUG,
+		"RemoteApi::greader_unread_guids: %s returned %ld, %" PRIu64
+		" bytes",
+		url,
+		status,
+		static_cast<uint64_t>(reply.size()));
+	if (result != CURLE_OK || status != 200) {
+		return false;
+	}
+	return parse_greader_item_refs(reply, guids);
+}
+
+bool RemoteApi::parse_greader_item_refs(const std::string& reply,
+	std::unordered_set<std::string>& guids)
+{
+	json content;
+	try {
+		content = json::parse(reply);
+	} catch (const json::exception& e) {
+		LOG(Level::ERROR,
+			"RemoteApi::parse_greader_item_refs: failed to parse "
+			"reply: %s",
+			e.what());
+		return false;
+	}
+
+	if (!content.is_object()) {
+		return false;
+	}
+	const auto refs = content.find("itemRefs");
+	if (refs == content.end()) {
+		// Some servers leave the list out of an empty stream, but still
+		// send its (empty) list of items. Anything else, like a reply that
+		// only holds an error, would make all articles look read.
+		const auto items = content.find("items");
+		return items != content.end() && items->is_array()
+			&& items->empty();
+	}
+	if (!refs->is_array()) {
+		return false;
+	}
+
+	for (const auto& ref : *refs) {
+		const auto id_node = ref.find("id");
+		if (id_node == ref.end() || !id_node->is_string()) {
+			continue;
+		}
+		const std::string id = id_node->get<std::string>();
+		if (id.empty()) {
+			continue;
+		}
+
+		// The IDs are either decimal numbers, which the Atom streams show
+		// as 16 hexadecimal digits, or already in hexadecimal
+		if (id.find_first_not_of("0123456789") == std::string::npos) {
+			const uint64_t number = std::strtoull(id.c_str(), nullptr, 10);
+			guids.insert(GREADER_ITEM_PREFIX
+				+ strprintf::fmt("%016" PRIx64, number));
+		} else if (id.compare(0, 4, "tag:") == 0) {
+			guids.insert(id);
+		} else {
+			guids.insert(GREADER_ITEM_PREFIX + id);
+		}
+	}
+	return true;
+}
+
 } // namespace newsboat
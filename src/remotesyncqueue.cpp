@@ -0,0 +1,394 @@
+#include "remotesyncqueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "cache.h"
+#include "config.h"
+#include "dbexception.h"
+#include "logger.h"
+#include "remoteapi.h"
+#include "strprintf.h"
+
+namespace newsboat {
+
+namespace {
+
+/// Changes are sent this long after the first of them, so that marking
+/// several articles in a row results in a single request
+const std::chrono::seconds BATCH_DELAY(2);
+const std::chrono::seconds MIN_RETRY_DELAY(30);
+const std::chrono::seconds MAX_RETRY_DELAY(15 * 60);
+
+/// Upper limit on the number of changes sent at once; keeps requests to
+/// Google Reader-style APIs at a reasonable size
+const unsigned int MAX_BATCH_SIZE = 250;
+
+/// Changes that the server refused this many times are dropped, so that e.g.
+/// an article that was deleted on the server isn't retried forever. Failures
+/// to reach the server don't count.
+const unsigned int MAX_ATTEMPTS = 10;
+
+} // namespace
+
+RemoteSyncQueue::RemoteSyncQueue(Cache* cache,
+	RemoteApi* api,
+	ErrorHandler error_handler)
+	: cache(cache)
+	, api(api)
+	, error_handler(std::move(error_handler))
+	, changed(true)
+	, stopping(false)
+{
+	worker = std::thread(&RemoteSyncQueue::run, this);
+}
+
+RemoteSyncQueue::~RemoteSyncQueue()
+{
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		stopping = true;
+	}
+	cv.notify_all();
+
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+void RemoteSyncQueue::mark_article_read(const std::string& guid, bool read)
+{
+	RemoteChange change;
+	change.action = read
+		? RemoteChange::Action::MARK_READ
+		: RemoteChange::Action::MARK_UNREAD;
+	change.target = guid;
+	queue(change);
+}
+
+void RemoteSyncQueue::update_article_flags(const std::string& oldflags,
+	const std::string& newflags,
+	const std::string& guid)
+{
+	RemoteChange change;
+	change.action = RemoteChange::Action::UPDATE_FLAGS;
+	change.target = guid;
+	change.oldflags = oldflags;
+	change.newflags = newflags;
+	queue(change);
+}
+
+void RemoteSyncQueue::mark_all_read(const std::string& feedurl)
+{
+	RemoteChange change;
+	change.action = RemoteChange::Action::MARK_FEED_READ;
+	change.target = feedurl;
+	// The change may be sent much later; remember what the user saw, so
+	// that articles that arrive in the meantime aren't marked read too
+	change.marked_at = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+	try {
+		change.newest = api->get_newest_article(
+				cache->get_item_guids(feedurl));
+	} catch (const DbException& e) {
+		LOG(Level::ERROR,
+			"RemoteSyncQueue::mark_all_read: couldn't read articles of "
+			"%s: %s",
+			feedurl,
+			e.what());
+	}
+	queue(change);
+}
+
+bool RemoteSyncQueue::flush()
+{
+	SendResult result = SendResult::SENT;
+	while (result == SendResult::SENT) {
+		result = send_batch();
+	}
+	return result == SendResult::NOTHING_QUEUED;
+}
+
+void RemoteSyncQueue::queue(const RemoteChange& change)
+{
+	try {
+		cache->queue_remote_change(change);
+	} catch (const DbException& e) {
+		LOG(Level::ERROR,
+			"RemoteSyncQueue::queue: couldn't store change of %s: %s",
+			change.target,
+			e.what());
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		changed = true;
+	}
+	cv.notify_one();
+}
+
+void RemoteSyncQueue::run()
+{
+	const auto is_stopping = [this]() {
+		return stopping.load();
+	};
+
+	// `changed` starts out true, so changes left over from the previous
+	// session are sent shortly after the start
+	bool pending = false;
+	std::chrono::seconds retry_delay = MIN_RETRY_DELAY;
+
+	std::unique_lock<std::mutex> lock(mtx);
+	while (!stopping) {
+		if (!pending) {
+			cv.wait(lock, [this]() {
+				return stopping || changed;
+			});
+			cv.wait_for(lock, BATCH_DELAY, is_stopping);
+		}
+		if (stopping) {
+			break;
+		}
+		changed = false;
+		lock.unlock();
+
+		SendResult result = SendResult::SENT;
+		while (result == SendResult::SENT && !stopping) {
+			result = send_batch();
+		}
+
+		lock.lock();
+		pending = (result != SendResult::NOTHING_QUEUED);
+		if (result == SendResult::FAILED) {
+			LOG(Level::INFO,
+				"RemoteSyncQueue::run: retrying in %u seconds",
+				static_cast<unsigned int>(retry_delay.count()));
+			cv.wait_for(lock, retry_delay, is_stopping);
+			retry_delay = std::min(retry_delay * 2, MAX_RETRY_DELAY);
+		} else {
+			retry_delay = MIN_RETRY_DELAY;
+		}
+	}
+}
+
+RemoteSyncQueue::SendResult RemoteSyncQueue::send_batch()
+{
+	std::lock_guard<std::mutex> guard(send_mtx);
+
+	std::vector<RemoteChange> changes;
+	try {
+		changes = cache->get_remote_changes(MAX_BATCH_SIZE);
+	} catch (const DbException& e) {
+		LOG(Level::ERROR,
+			"RemoteSyncQueue::send_batch: couldn't read queue: %s",
+			e.what());
+		return SendResult::FAILED;
+	}
+	if (changes.empty()) {
+		return SendResult::NOTHING_QUEUED;
+	}
+
+	Outcome outcome;
+
+	if (changes[0].action == RemoteChange::Action::MARK_FEED_READ) {
+		// Marking the same feed read several times in a row is sent once,
+		// up to the last time
+		const std::string feedurl = changes[0].target;
+		std::vector<const RemoteChange*> run;
+		for (const auto& change : changes) {
+			if (change.action != RemoteChange::Action::MARK_FEED_READ
+				|| change.target != feedurl) {
+				break;
+			}
+			run.push_back(&change);
+		}
+		RemoteApi::set_request_error(RemoteApi::RequestError::NONE);
+		record(api->mark_all_read_until(feedurl,
+				run.back()->newest,
+				run.back()->marked_at),
+			run,
+			outcome);
+	} else {
+		send_article_changes(changes, outcome);
+	}
+
+	LOG(Level::DEBUG,
+		"RemoteSyncQueue::send_batch: sent %u changes, %u rejected, "
+		"offline = %d",
+		static_cast<unsigned int>(outcome.sent.size()),
+		static_cast<unsigned int>(outcome.rejected.size()),
+		outcome.offline ? 1 : 0);
+
+	try {
+		cache->remove_remote_changes(outcome.sent);
+		give_up_on(outcome.rejected);
+	} catch (const DbException& e) {
+		LOG(Level::ERROR,
+			"RemoteSyncQueue::send_batch: couldn't update queue: %s",
+			e.what());
+		return SendResult::FAILED;
+	}
+
+	// Rejected changes are retried after a delay, like ones that didn't
+	// reach the server, rather than running through their attempts at once
+	if (outcome.offline || !outcome.rejected.empty()) {
+		return SendResult::FAILED;
+	}
+	return SendResult::SENT;
+}
+
+void RemoteSyncQueue::send_article_changes(
+	const std::vector<RemoteChange>& changes,
+	Outcome& outcome)
+{
+	// Article changes are coalesced up to the next time a feed is marked
+	// read, as that has to reach the server after them.
+	std::map<std::string, bool> read_states;
+	std::map<std::string, std::vector<const RemoteChange*>> read_changes;
+	std::map<std::string, std::pair<std::string, std::string>> flags;
+	std::map<std::string, std::vector<const RemoteChange*>> flag_changes;
+	for (const auto& change : changes) {
+		if (change.action == RemoteChange::Action::MARK_FEED_READ) {
+			break;
+		}
+
+		switch (change.action) {
+		case RemoteChange::Action::MARK_READ:
+		case RemoteChange::Action::MARK_UNREAD:
+			read_states[change.target] =
+				(change.action == RemoteChange::Action::MARK_READ);
+			read_changes[change.target].push_back(&change);
+			break;
+		case RemoteChange::Action::UPDATE_FLAGS: {
+			const auto it = flags.find(change.target);
+			if (it == flags.end()) {
+				flags[change.target] =
+					std::make_pair(change.oldflags, change.newflags);
+			} else {
+				it->second.second = change.newflags;
+			}
+			flag_changes[change.target].push_back(&change);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	const bool read_states_to_send[] = {true, false};
+	for (const bool read : read_states_to_send) {
+		std::vector<std::string> guids;
+		for (const auto& state : read_states) {
+			if (state.second == read) {
+				guids.push_back(state.first);
+			}
+		}
+		if (guids.empty()) {
+			continue;
+		}
+
+		RemoteApi::set_request_error(RemoteApi::RequestError::NONE);
+		const bool success = api->mark_articles_read(guids, read);
+		if (success || guids.size() == 1 || !rejected_by_server()) {
+			for (const auto& guid : guids) {
+				record(success, read_changes[guid], outcome);
+			}
+			if (outcome.offline) {
+				return;
+			}
+			continue;
+		}
+
+		// A single article that the server refuses fails the whole
+		// request, so the others are sent one by one
+		for (const auto& guid : guids) {
+			RemoteApi::set_request_error(RemoteApi::RequestError::NONE);
+			record(api->mark_article_read(guid, read),
+				read_changes[guid],
+				outcome);
+			if (outcome.offline) {
+				return;
+			}
+		}
+	}
+
+	for (const auto& flag : flags) {
+		const auto& oldflags = flag.second.first;
+		const auto& newflags = flag.second.second;
+		bool success = true;
+		if (oldflags != newflags) {
+			RemoteApi::set_request_error(RemoteApi::RequestError::NONE);
+			success = api->update_article_flags(oldflags, newflags,
+					flag.first);
+		}
+		record(success, flag_changes[flag.first], outcome);
+		if (outcome.offline) {
+			return;
+		}
+	}
+}
+
+void RemoteSyncQueue::record(bool success,
+	const std::vector<const RemoteChange*>& changes,
+	Outcome& outcome)
+{
+	if (success) {
+		for (const auto change : changes) {
+			outcome.sent.push_back(change->id);
+		}
+	} else if (rejected_by_server()) {
+		for (const auto change : changes) {
+			outcome.rejected.push_back(*change);
+		}
+	} else {
+		// The server couldn't be reached or didn't accept our
+		// credentials; that's no reason to give up on the changes
+		outcome.offline = true;
+	}
+}
+
+bool RemoteSyncQueue::rejected_by_server()
+{
+	return RemoteApi::last_request_error() ==
+		RemoteApi::RequestError::REJECTED;
+}
+
+void RemoteSyncQueue::give_up_on(const std::vector<RemoteChange>& rejected)
+{
+	if (rejected.empty()) {
+		return;
+	}
+
+	std::vector<int64_t> ids;
+	std::string targets;
+	for (const auto& change : rejected) {
+		ids.push_back(change.id);
+		if (change.attempts + 1 >= MAX_ATTEMPTS) {
+			if (!targets.empty()) {
+				targets.append(", ");
+			}
+			targets.append(change.target);
+		}
+	}
+
+	const unsigned int dropped = cache->fail_remote_changes(ids, MAX_ATTEMPTS);
+	if (dropped == 0) {
+		return;
+	}
+
+	const std::string message = strprintf::fmt(
+			_("The server refused %u changes %u times, giving up on them: %s"),
+			dropped,
+			MAX_ATTEMPTS,
+			targets);
+	LOG(Level::USERERROR, "%s", message);
+	if (error_handler) {
+		error_handler(message);
+	}
+}
+
+} // namespace newsboat
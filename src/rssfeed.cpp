@@ -20,7 +20,7 @@
 #include "dbexception.h"
 #include "htmlrenderer.h"
 #include "logger.h"
-#include "scopemeasure.h"
+#include "metrics.h"
 #include "strprintf.h"
 #include "tagsouppullparser.h"
 #include "utils.h"
@@ -35,6 +35,9 @@ RssFeed::RssFeed(Cache* c)
 	, is_rtl_(false)
 	, idx(0)
 	, order(0)
+	, last_reload_us(0)
+	, sync_watermark_(0)
+	, has_sync_watermark_(false)
 	, status_(DlStatus::SUCCESS)
 {
 }
@@ -118,7 +121,7 @@ std::shared_ptr<RssItem> RssFeed::get_item_by_guid(const std::string& guid)
 std::shared_ptr<RssItem> RssFeed::get_item_by_guid_unlocked(
 	const std::string& guid)
 {
-	auto it = items_guid_map.find(guid);
+	auto it = items_guid_map.find(std::cref(guid));
 	if (it != items_guid_map.end()) {
 		return it->second;
 	}
@@ -177,7 +180,9 @@ void RssFeed::update_items(std::vector<std::shared_ptr<RssFeed>> feeds)
 
 	LOG(Level::DEBUG, "RssFeed::update_items: query = `%s'", query);
 
-	ScopeMeasure sm("RssFeed::update_items");
+	static auto& timings =
+		MetricsRegistry::global().histogram("feed.update_items");
+	ScopeTimer timer(timings);
 
 	Matcher m(query);
 
@@ -194,16 +199,15 @@ void RssFeed::update_items(std::vector<std::shared_ptr<RssFeed>> feeds)
 				LOG(Level::DEBUG, "RssFeed::update_items: Matcher matches!");
 				item->set_feedptr(feed);
 				items_.push_back(item);
-				items_guid_map[item->guid()] = item;
+				index_item(item);
 			}
 		}
 	}
 
-	sm.stopover("matching");
-
+	static auto& sort_timings =
+		MetricsRegistry::global().histogram("feed.sort_items");
+	ScopeTimer sort_timer(sort_timings);
 	std::sort(items_.begin(), items_.end());
-
-	sm.stopover("sorting");
 }
 
 void RssFeed::set_rssurl(const std::string& u)
@@ -339,14 +343,16 @@ void RssFeed::sort_unlocked(const ArticleSortStrategy& sort_strategy)
 void RssFeed::purge_deleted_items()
 {
 	std::lock_guard<std::mutex> lock(item_mutex);
-	ScopeMeasure m1("RssFeed::purge_deleted_items");
+	static auto& timings =
+		MetricsRegistry::global().histogram("feed.purge_deleted_items");
+	ScopeTimer timer(timings);
 
 	// Purge in items_guid_map
 	{
 		std::lock_guard<std::mutex> lock2(items_guid_map_mutex);
 		for (const auto& item : items_) {
 			if (item->deleted()) {
-				items_guid_map.erase(item->guid());
+				items_guid_map.erase(std::cref(item->guid()));
 			}
 		}
 	}
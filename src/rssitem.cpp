@@ -45,9 +45,9 @@ void RssItem::set_author(const std::string& a)
 	author_ = a;
 }
 
-void RssItem::set_description(const std::string& d)
+void RssItem::set_description(std::string d)
 {
-	description_ = d;
+	description_ = std::move(d);
 }
 
 void RssItem::set_size(unsigned int size)
@@ -108,7 +108,7 @@ void RssItem::set_unread(bool u)
 		try {
 			if (ch) {
 				ch->update_rssitem_unread_and_enqueued(
-					this, feedurl_);
+					this, feedurl_.str());
 			}
 		} catch (const DbException& e) {
 			// if the update failed, restore the old unread flag and
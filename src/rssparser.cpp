@@ -2,10 +2,13 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cinttypes>
 #include <cstring>
 #include <curl/curl.h>
+#include <iterator>
 #include <sstream>
+#include <unordered_set>
 
 #include "cache.h"
 #include "config.h"
@@ -26,6 +29,21 @@
 
 namespace newsboat {
 
+namespace {
+
+/// Deltas start this long before the previous sync, in case the server's
+/// clock is off, or articles arrived while the previous sync ran
+const time_t DELTA_OVERLAP = 10 * 60;
+
+/// Feeds that got more new articles than fit on this many pages since the
+/// previous sync are downloaded in full the next time
+const unsigned int MAX_DELTA_PAGES = 10;
+
+/// Read states are only synced for this many unread articles per feed
+const unsigned int MAX_UNREAD_IDS = 1000;
+
+} // namespace
+
 RssParser::RssParser(const std::string& uri,
 	Cache* c,
 	ConfigContainer* cfg,
@@ -37,16 +55,25 @@ RssParser::RssParser(const std::string& uri,
 	, ign(ii)
 	, api(a)
 	, easyhandle(0)
+	, title_renderer(true)
 {
 	is_ttrss = cfgcont->get_configvalue("urls-source") == "ttrss";
 	is_newsblur = cfgcont->get_configvalue("urls-source") == "newsblur";
 	is_ocnews = cfgcont->get_configvalue("urls-source") == "ocnews";
+	can_fetch_deltas = api && !api->get_delta_url(uri, 0, "").empty();
+	is_delta = false;
+	has_sync_watermark = false;
+	sync_watermark = 0;
 }
 
 RssParser::~RssParser() {}
 
 std::shared_ptr<RssFeed> RssParser::parse()
 {
+	stats = FeedReloadStats();
+	stats.rssurl = my_uri;
+	has_sync_watermark = false;
+
 	retrieve_uri(my_uri);
 
 	if (f.rss_version == rsspp::Feed::Version::UNKNOWN) {
@@ -66,10 +93,19 @@ std::shared_ptr<RssFeed> RssParser::parse()
 	 * unlike other non-Unicode encodings.
 	 */
 
+	const auto fill_started = std::chrono::steady_clock::now();
 	fill_feed_fields(feed);
 	fill_feed_items(feed);
+	if (has_sync_watermark) {
+		feed->set_sync_watermark(sync_watermark);
+	}
+	stats.parse_us += std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - fill_started).count();
 
-	ch->remove_old_deleted_items(feed.get());
+	if (!is_delta) {
+		// Articles that aren't in a delta are still in the feed
+		ch->remove_old_deleted_items(feed.get());
+	}
 
 	feed->set_empty(false);
 
@@ -100,18 +136,31 @@ time_t RssParser::parse_date(const std::string& datestr)
 
 void RssParser::replace_newline_characters(std::string& str)
 {
-	str = utils::replace_all(str, "\r", " ");
-	str = utils::replace_all(str, "\n", " ");
+	std::replace_if(str.begin(), str.end(), [](char c) {
+		return c == '\r' || c == '\n';
+	}, ' ');
 	utils::trim(str);
 }
 
 std::string RssParser::render_xhtml_title(const std::string& title,
 	const std::string& link)
 {
-	HtmlRenderer rnd(true);
+	if (title.find_first_of("<&") == std::string::npos) {
+		// Without tags and entities, HtmlRenderer would only strip
+		// leading whitespace, soft hyphens and newlines, so do just
+		// that.
+		std::string result = title;
+		if (result.find("\u00AD") != std::string::npos) {
+			utils::remove_soft_hyphens(result);
+		}
+		result.erase(0, result.find_first_not_of(" \t\n\v\f\r"));
+		std::replace(result.begin(), result.end(), '\n', ' ');
+		return result;
+	}
+
 	std::vector<std::pair<LineType, std::string>> lines;
 	std::vector<LinkPair> links; // not needed
-	rnd.render(title, lines, links, link);
+	title_renderer.render(title, lines, links, link);
 	if (!lines.empty()) {
 		return lines[0].second;
 	}
@@ -162,6 +211,8 @@ void RssParser::retrieve_uri(const std::string& uri)
 		fetch_newsblur(uri);
 	} else if (is_ocnews) {
 		fetch_ocnews(uri);
+	} else if (can_fetch_deltas && utils::is_http_url(uri)) {
+		download_delta(uri);
 	} else if (utils::is_http_url(uri)) {
 		download_http(uri);
 	} else if (utils::is_exec_url(uri)) {
@@ -179,18 +230,18 @@ void RssParser::retrieve_uri(const std::string& uri)
 	}
 }
 
-void RssParser::download_http(const std::string& uri)
+void RssParser::download_http(const std::string& uri, bool conditional)
 {
-	unsigned int retrycount =
-		cfgcont->get_configvalue_as_int("download-retries");
+	const auto config = cfgcont->snapshot();
+	unsigned int retrycount = config->get_int(ConfigKey::DOWNLOAD_RETRIES);
 	std::string proxy;
 	std::string proxy_auth;
 	std::string proxy_type;
 
-	if (cfgcont->get_configvalue_as_bool("use-proxy") == true) {
-		proxy = cfgcont->get_configvalue("proxy");
-		proxy_auth = cfgcont->get_configvalue("proxy-auth");
-		proxy_type = cfgcont->get_configvalue("proxy-type");
+	if (config->get_bool(ConfigKey::USE_PROXY)) {
+		proxy = config->get(ConfigKey::PROXY);
+		proxy_auth = config->get(ConfigKey::PROXY_AUTH);
+		proxy_type = config->get(ConfigKey::PROXY_TYPE);
 	}
 
 	for (unsigned int i = 0; i < retrycount
@@ -199,25 +250,29 @@ void RssParser::download_http(const std::string& uri)
 		LOG(Level::DEBUG,
 			"RssParser::download_http: user-agent = %s",
 			useragent);
-		rsspp::Parser p(cfgcont->get_configvalue_as_int(
-				"download-timeout"),
+		rsspp::Parser p(config->get_int(ConfigKey::DOWNLOAD_TIMEOUT),
 			useragent.c_str(),
 			proxy.c_str(),
 			proxy_auth.c_str(),
 			utils::get_proxy_type(proxy_type),
-			cfgcont->get_configvalue_as_bool(
-				"ssl-verifypeer"));
+			config->get_bool(ConfigKey::SSL_VERIFYPEER));
 		time_t lm = 0;
 		std::string etag;
-		if (!ign || !ign->matches_lastmodified(uri)) {
+		if (conditional && (!ign || !ign->matches_lastmodified(uri))) {
 			ch->fetch_lastmodified(uri, lm, etag);
 		}
-		f = p.parse_url(uri,
-				lm,
-				etag,
-				api,
-				cfgcont->get_configvalue("cookie-cache"),
-				easyhandle ? easyhandle->ptr() : 0);
+		try {
+			f = p.parse_url(uri,
+					lm,
+					etag,
+					api,
+					config->get(ConfigKey::COOKIE_CACHE),
+					easyhandle ? easyhandle->ptr() : 0);
+		} catch (const rsspp::Exception&) {
+			record_transfer(p);
+			throw;
+		}
+		record_transfer(p);
 		LOG(Level::DEBUG,
 			"RssParser::download_http: lm = %" PRId64 " etag = %s",
 			// On GCC, `time_t` is `long int`, which is at least 32 bits
@@ -226,8 +281,8 @@ void RssParser::download_http(const std::string& uri)
 			// up-cast which are always safe.
 			static_cast<int64_t>(p.get_last_modified()),
 			p.get_etag());
-		if (p.get_last_modified() != 0 ||
-			p.get_etag().length() > 0) {
+		if (conditional && (p.get_last_modified() != 0 ||
+				p.get_etag().length() > 0)) {
 			LOG(Level::DEBUG,
 				"RssParser::download_http: "
 				"lastmodified "
@@ -258,11 +313,92 @@ void RssParser::download_http(const std::string& uri)
 		(f.rss_version != rsspp::Feed::Version::UNKNOWN) ? "true" : "false");
 }
 
+void RssParser::download_delta(const std::string& uri)
+{
+	const time_t started = ::time(nullptr);
+	time_t watermark = 0;
+	if (!ign || !ign->matches_lastmodified(uri)) {
+		watermark = ch->fetch_sync_watermark(uri);
+	}
+
+	if (watermark == 0) {
+		// First sync; get the newest articles like without deltas
+		download_http(uri);
+		set_sync_watermark(started);
+		return;
+	}
+
+	rsspp::Feed delta;
+	std::string continuation;
+	unsigned int pages = 0;
+	do {
+		f = rsspp::Feed();
+		download_http(api->get_delta_url(
+				uri, watermark - DELTA_OVERLAP, continuation),
+			false);
+		if (f.rss_version == rsspp::Feed::Version::UNKNOWN) {
+			return;
+		}
+
+		continuation = f.continuation;
+		if (pages == 0) {
+			delta = std::move(f);
+		} else {
+			std::move(f.items.begin(),
+				f.items.end(),
+				std::back_inserter(delta.items));
+		}
+		pages++;
+	} while (!continuation.empty() && pages < MAX_DELTA_PAGES);
+	f = std::move(delta);
+	is_delta = true;
+
+	LOG(Level::DEBUG,
+		"RssParser::download_delta: %s: %" PRIu64 " new articles "
+		"in %u pages",
+		uri,
+		static_cast<uint64_t>(f.items.size()),
+		pages);
+
+	// If there's still more, the feed is downloaded in full next time,
+	// which gets the newest articles as if there were no deltas
+	set_sync_watermark(continuation.empty() ? started : 0);
+
+	std::unordered_set<std::string> unread;
+	if (api->get_unread_guids(uri, MAX_UNREAD_IDS, unread)) {
+		// A full page means there might be more unread articles, so
+		// the others can't be marked read
+		ch->update_unread_from_remote(
+			uri, unread, unread.size() < MAX_UNREAD_IDS);
+	}
+}
+
+void RssParser::set_sync_watermark(time_t t)
+{
+	has_sync_watermark = true;
+	sync_watermark = t;
+}
+
+void RssParser::record_transfer(const rsspp::Parser& p)
+{
+	const auto& transfer = p.get_transfer_info();
+	stats.dns_us = transfer.namelookup_us;
+	stats.connect_us = transfer.connect_us;
+	stats.ttfb_us = transfer.starttransfer_us;
+	// Deltas can take several requests
+	stats.transfer_us += transfer.total_us;
+	stats.bytes += transfer.bytes;
+	stats.http_status = transfer.http_status;
+	stats.not_modified = (transfer.http_status == 304);
+	stats.parse_us += p.get_parse_time();
+}
+
 void RssParser::get_execplugin(const std::string& plugin)
 {
 	std::string buf = utils::get_command_output(plugin);
 	rsspp::Parser p;
 	f = p.parse_buffer(buf);
+	stats.parse_us += p.get_parse_time();
 	LOG(Level::DEBUG,
 		"RssParser::parse: execplugin %s, valid = %s",
 		plugin,
@@ -273,6 +409,7 @@ void RssParser::parse_file(const std::string& file)
 {
 	rsspp::Parser p;
 	f = p.parse_file(file);
+	stats.parse_us += p.get_parse_time();
 	LOG(Level::DEBUG,
 		"RssParser::parse: parsed file %s, valid = %s",
 		file,
@@ -296,6 +433,7 @@ void RssParser::download_filterplugin(const std::string& filter,
 		result);
 	rsspp::Parser p;
 	f = p.parse_buffer(result);
+	stats.parse_us += p.get_parse_time();
 	LOG(Level::DEBUG,
 		"RssParser::parse: filterplugin %s, valid = %s",
 		filter,
@@ -337,10 +475,11 @@ void RssParser::fill_feed_items(std::shared_ptr<RssFeed> feed)
 	/*
 	 * we iterate over all items of a feed, create an RssItem object for
 	 * each item, and fill it with the appropriate values from the data
-	 * structure.
+	 * structure. Article bodies are moved rather than copied, since the
+	 * parsed items are dropped right afterwards.
 	 */
-	for (const auto& item : f.items) {
-		std::shared_ptr<RssItem> x(new RssItem(ch));
+	for (auto& item : f.items) {
+		auto x = std::make_shared<RssItem>(ch);
 
 		set_item_title(feed, x, item);
 
@@ -440,6 +579,10 @@ void RssParser::fill_feed_items(std::shared_ptr<RssFeed> feed)
 
 		add_item_to_feed(feed, x);
 	}
+
+	// Don't keep a second copy of the feed around while it's written to
+	// and read back from the cache
+	std::vector<rsspp::Item>().swap(f.items);
 }
 
 void RssParser::set_item_title(std::shared_ptr<RssFeed> feed,
@@ -479,14 +622,14 @@ void RssParser::set_item_author(std::shared_ptr<RssItem> x,
 }
 
 void RssParser::set_item_content(std::shared_ptr<RssItem> x,
-	const rsspp::Item& item)
+	rsspp::Item& item)
 {
 	handle_content_encoded(x, item);
 
 	handle_itunes_summary(x, item);
 
 	if (x->description().empty()) {
-		x->set_description(item.description);
+		x->set_description(std::move(item.description));
 	} else {
 		if (cfgcont->get_configvalue_as_bool(
 				"always-display-description") &&
@@ -568,7 +711,7 @@ void RssParser::add_item_to_feed(std::shared_ptr<RssFeed> feed,
 }
 
 void RssParser::handle_content_encoded(std::shared_ptr<RssItem> x,
-	const rsspp::Item& item) const
+	rsspp::Item& item) const
 {
 	if (!x->description().empty()) {
 		return;
@@ -577,7 +720,7 @@ void RssParser::handle_content_encoded(std::shared_ptr<RssItem> x,
 	/* here we handle content:encoded tags that are an extension but very
 	 * widespread */
 	if (!item.content_encoded.empty()) {
-		x->set_description(item.content_encoded);
+		x->set_description(std::move(item.content_encoded));
 	} else {
 		LOG(Level::DEBUG,
 			"RssParser::parse: found no content:encoded");
@@ -596,7 +739,7 @@ void RssParser::handle_itunes_summary(std::shared_ptr<RssItem> x,
 		std::string desc = "<ituneshack>";
 		desc.append(summary);
 		desc.append("</ituneshack>");
-		x->set_description(desc);
+		x->set_description(std::move(desc));
 	}
 }
 
@@ -610,8 +753,21 @@ void RssParser::fetch_ttrss(const std::string& feed_id)
 {
 	TtRssApi* tapi = dynamic_cast<TtRssApi*>(api);
 	if (tapi) {
-		f = tapi->fetch_feed(
-				feed_id, easyhandle ? easyhandle->ptr() : nullptr);
+		const time_t watermark = ch->fetch_sync_watermark(my_uri);
+		if (tapi->get_prefetched_feed(feed_id, watermark, f)) {
+			is_delta = true;
+			std::unordered_set<std::string> unread;
+			if (tapi->get_unread_guids(my_uri, MAX_UNREAD_IDS, unread)) {
+				ch->update_unread_from_remote(
+					my_uri, unread, unread.size() < MAX_UNREAD_IDS);
+			}
+		} else {
+			f = tapi->fetch_feed(
+					feed_id, easyhandle ? easyhandle->ptr() : nullptr);
+		}
+		if (f.sync_position > watermark) {
+			set_sync_watermark(f.sync_position);
+		}
 	}
 	LOG(Level::DEBUG,
 		"RssParser::fetch_ttrss: f.items.size = %" PRIu64,
@@ -633,7 +789,17 @@ void RssParser::fetch_ocnews(const std::string& feed_id)
 {
 	OcNewsApi* napi = dynamic_cast<OcNewsApi*>(api);
 	if (napi) {
-		f = napi->fetch_feed(feed_id);
+		// Prefetched articles include changes of read states, so there's
+		// no need to sync them separately
+		const time_t watermark = ch->fetch_sync_watermark(my_uri);
+		if (napi->get_prefetched_feed(feed_id, watermark, f)) {
+			is_delta = true;
+		} else {
+			f = napi->fetch_feed(feed_id);
+		}
+		if (f.sync_position > watermark) {
+			set_sync_watermark(f.sync_position);
+		}
 	}
 	LOG(Level::INFO,
 		"RssParser::fetch_ocnews: f.items.size = %" PRIu64,
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <cinttypes>
 #include <limits.h>
+#include <unordered_map>
 
 #include "htmlrenderer.h"
 #include "stflpp.h"
@@ -37,6 +38,228 @@ void TextFormatter::add_lines(
 	}
 }
 
+namespace {
+
+/*
+ * Width of a piece of text as STFL displays it. Besides the sum of the
+ * character widths we keep the number of STFL tags (a '<' not followed by
+ * '>'), since each of those is three columns narrower than it looks. That
+ * is enough to compute the width of a concatenation without measuring it
+ * again, which is what makes wrap_line() linear.
+ */
+struct StflWidth {
+	size_t columns = 0;
+	size_t tags = 0;
+	bool empty = true;
+	bool starts_with_gt = false;
+	bool ends_with_lt = false;
+
+	size_t value() const
+	{
+		const size_t reduce = 3 * tags;
+		return columns < reduce ? 0 : columns - reduce;
+	}
+
+	void append(const StflWidth& other)
+	{
+		if (other.empty) {
+			return;
+		}
+		columns += other.columns;
+		tags += other.tags;
+		if (ends_with_lt && !other.starts_with_gt) {
+			tags++;
+		}
+		if (empty) {
+			starts_with_gt = other.starts_with_gt;
+		}
+		ends_with_lt = other.ends_with_lt;
+		empty = false;
+	}
+};
+
+bool is_continuation(unsigned char c)
+{
+	return (c & 0xC0) == 0x80;
+}
+
+/*
+ * Decodes the UTF-8 sequence at \a pos and returns its length in bytes. On
+ * malformed input, \a valid is set to false and the maximal invalid
+ * subsequence is skipped, which is what Rust's to_string_lossy() replaces
+ * with a single U+FFFD.
+ */
+size_t decode_utf8(const std::string& s, size_t pos, uint32_t& cp,
+	bool& valid)
+{
+	const unsigned char lead = s[pos];
+	valid = true;
+	if (lead < 0x80) {
+		cp = lead;
+		return 1;
+	}
+
+	size_t len = 0;
+	unsigned char min_next = 0x80;
+	unsigned char max_next = 0xBF;
+	if (lead >= 0xC2 && lead <= 0xDF) {
+		len = 2;
+		cp = lead & 0x1F;
+	} else if (lead >= 0xE0 && lead <= 0xEF) {
+		len = 3;
+		cp = lead & 0x0F;
+		if (lead == 0xE0) {
+			min_next = 0xA0;
+		} else if (lead == 0xED) {
+			max_next = 0x9F;
+		}
+	} else if (lead >= 0xF0 && lead <= 0xF4) {
+		len = 4;
+		cp = lead & 0x07;
+		if (lead == 0xF0) {
+			min_next = 0x90;
+		} else if (lead == 0xF4) {
+			max_next = 0x8F;
+		}
+	} else {
+		valid = false;
+		return 1;
+	}
+
+	for (size_t i = 1; i < len; ++i) {
+		if (pos + i >= s.size()) {
+			valid = false;
+			return i;
+		}
+		const unsigned char c = s[pos + i];
+		const bool in_range = (i == 1)
+			? (c >= min_next && c <= max_next)
+			: is_continuation(c);
+		if (!in_range) {
+			valid = false;
+			return i;
+		}
+		cp = (cp << 6) | (c & 0x3F);
+	}
+
+	return len;
+}
+
+size_t char_width(const std::string& s, size_t pos, size_t len, uint32_t cp,
+	bool valid)
+{
+	if (cp < 0x80 && valid) {
+		// Control characters take no space.
+		return (cp < 0x20 || cp == 0x7F) ? 0 : 1;
+	}
+	if (!valid) {
+		// U+FFFD REPLACEMENT CHARACTER
+		return 1;
+	}
+
+	// Unicode width tables live in Rust; ask once per character and
+	// thread, since articles use a rather small set of them.
+	thread_local std::unordered_map<uint32_t, unsigned char> widths;
+	const auto cached = widths.find(cp);
+	if (cached != widths.end()) {
+		return cached->second;
+	}
+	const size_t width = utils::strwidth(s.substr(pos, len));
+	widths.emplace(cp, static_cast<unsigned char>(width));
+	return width;
+}
+
+StflWidth measure(const std::string& s, size_t begin, size_t end)
+{
+	StflWidth result;
+	bool prev_is_lt = false;
+	for (size_t pos = begin; pos < end;) {
+		uint32_t cp = 0;
+		bool valid = true;
+		const size_t len = decode_utf8(s, pos, cp, valid);
+		const bool is_lt = valid && cp == '<';
+		const bool is_gt = valid && cp == '>';
+
+		result.columns += char_width(s, pos, len, cp, valid);
+		if (prev_is_lt && !is_gt) {
+			result.tags++;
+		}
+		if (result.empty) {
+			result.starts_with_gt = is_gt;
+			result.empty = false;
+		}
+		prev_is_lt = is_lt;
+		pos += len;
+	}
+	result.ends_with_lt = prev_is_lt;
+	return result;
+}
+
+StflWidth measure(const std::string& s)
+{
+	return measure(s, 0, s.size());
+}
+
+/*
+ * Returns the length in bytes of the longest part of \a s, starting at \a
+ * begin, that fits into \a max_width columns. STFL tags take no space, and
+ * an escaped less-than sign ("<>") takes one column. Matches
+ * utils::substr_with_width().
+ */
+size_t fitting_prefix_length(const std::string& s, size_t begin,
+	size_t max_width)
+{
+	size_t width = 0;
+	size_t accepted = begin;
+	bool in_bracket = false;
+	size_t tag_start = begin;
+	for (size_t pos = begin; pos < s.size();) {
+		uint32_t cp = 0;
+		bool valid = true;
+		const size_t len = decode_utf8(s, pos, cp, valid);
+		if (in_bracket) {
+			if (valid && cp == '>') {
+				in_bracket = false;
+				if (pos == tag_start + 1) {
+					if (width + 1 > max_width) {
+						break;
+					}
+					width++;
+				}
+				accepted = pos + len;
+			}
+		} else if (valid && cp == '<') {
+			in_bracket = true;
+			tag_start = pos;
+		} else {
+			const size_t w = char_width(s, pos, len, cp, valid);
+			if (width + w > max_width) {
+				break;
+			}
+			width += w;
+			accepted = pos + len;
+		}
+		pos += len;
+	}
+	return accepted - begin;
+}
+
+bool is_whitespace(const std::string& input, size_t begin)
+{
+	return std::all_of(input.cbegin() + begin,
+			input.cend(),
+	[](std::string::value_type c) {
+		return std::isspace(c);
+	});
+}
+
+} // namespace
+
+size_t stfl_text_width(const std::string& text)
+{
+	return measure(text).value();
+}
+
 std::vector<std::string> wrap_line(const std::string& line, const size_t width)
 {
 	if (line.empty()) {
@@ -47,54 +270,66 @@ std::vector<std::string> wrap_line(const std::string& line, const size_t width)
 	std::vector<std::string> words = utils::tokenize_spaced(line);
 
 	std::string prefix;
-	size_t prefix_width = 0;
-	auto iswhitespace = [](const std::string& input) {
-		return std::all_of(input.cbegin(),
-				input.cend(),
-		[](std::string::value_type c) {
-			return std::isspace(c);
-		});
-	};
-	if (iswhitespace(words[0])) {
-		prefix = utils::substr_with_width(words[0], width);
-		prefix_width = utils::strwidth_stfl(prefix);
+	StflWidth prefix_width;
+	if (is_whitespace(words[0], 0)) {
+		prefix = words[0].substr(0,
+				fitting_prefix_length(words[0], 0, width));
+		prefix_width = measure(prefix);
 		words.erase(words.cbegin());
 	}
 
 	std::string curline = prefix;
+	StflWidth curline_width = prefix_width;
 
-	for (auto& word : words) {
-		size_t word_width = utils::strwidth_stfl(word);
-		size_t curline_width = utils::strwidth_stfl(curline);
+	for (const auto& word : words) {
+		// Instead of erasing the parts that were already put on
+		// previous lines, we keep an offset into the word.
+		size_t offset = 0;
+		StflWidth word_width = measure(word);
 
 		// for languages (e.g., CJK) don't use a space as a word
 		// boundary
-		while (word_width > (width - prefix_width)) {
-			size_t space_left = width - curline_width;
-			std::string part =
-				utils::substr_with_width(word, space_left);
-			curline.append(part);
-			word.erase(0, part.length());
+		while (word_width.value() > (width - prefix_width.value())) {
+			const size_t space_left = width - curline_width.value();
+			const size_t part_length =
+				fitting_prefix_length(word, offset, space_left);
+			curline.append(word, offset, part_length);
 			result.push_back(curline);
 			curline = prefix;
-			if (part.empty()) {
+			curline_width = prefix_width;
+			if (part_length == 0) {
 				// discard the current word
-				word.clear();
+				offset = word.size();
+				word_width = StflWidth();
+				break;
 			}
 
-			word_width = utils::strwidth_stfl(word);
-			curline_width = utils::strwidth_stfl(curline);
+			const StflWidth part_width =
+				measure(word, offset, offset + part_length);
+			offset += part_length;
+			word_width.columns -= part_width.columns;
+			word_width.tags -= part_width.tags;
+			word_width.empty = (offset == word.size());
+			word_width.starts_with_gt =
+				!word_width.empty && word[offset] == '>';
+			if (part_width.ends_with_lt && !word_width.empty &&
+				!word_width.starts_with_gt) {
+				// This tag straddled the split point
+				word_width.tags--;
+			}
 		}
 
-		if ((curline_width + word_width) > width) {
+		if ((curline_width.value() + word_width.value()) > width) {
 			result.push_back(curline);
-			if (iswhitespace(word)) {
-				curline = prefix;
-			} else {
-				curline = prefix + word;
+			curline = prefix;
+			curline_width = prefix_width;
+			if (!is_whitespace(word, offset)) {
+				curline.append(word, offset, std::string::npos);
+				curline_width.append(word_width);
 			}
 		} else {
-			curline.append(word);
+			curline.append(word, offset, std::string::npos);
+			curline_width.append(word_width);
 		}
 	}
 
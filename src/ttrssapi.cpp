@@ -7,6 +7,7 @@
 #include <time.h>
 
 #include "3rd-party/json.hpp"
+#include "jsonlistparser.h"
 #include "logger.h"
 #include "remoteapi.h"
 #include "rss/feed.h"
@@ -17,6 +18,27 @@ using json = nlohmann::json;
 
 namespace newsboat {
 
+namespace {
+
+/// getHeadlines returns at most this many articles per request
+const unsigned int HEADLINES_PER_PAGE = 200;
+
+/// Prefetching gives up after this many pages; feeds are fetched one by one
+/// then, like before the first prefetch
+const unsigned int MAX_PREFETCH_PAGES = 25;
+
+// Depending on the version, TT-RSS returns IDs either as numbers or as
+// strings
+std::string id_to_string(const json& jid)
+{
+	if (jid.is_string()) {
+		return jid.get<std::string>();
+	}
+	return std::to_string(jid.get<int64_t>());
+}
+
+} // namespace
+
 TtRssApi::TtRssApi(ConfigContainer* c)
 	: RemoteApi(c)
 {
@@ -126,6 +148,69 @@ json TtRssApi::run_op(const std::string& op,
 	const std::map<std::string, std::string>& args,
 	bool try_login, /* = true */
 	CURL* cached_handle /* = nullptr */)
+{
+	const std::string result = send_op(op, args, cached_handle);
+
+	json reply;
+	try {
+		reply = json::parse(result);
+	} catch (json::parse_error& e) {
+		LOG(Level::ERROR,
+			"TtRssApi::run_op: reply failed to parse: %s",
+			result);
+		set_request_error(RequestError::CONNECTION);
+		return json(nullptr);
+	}
+
+	json content;
+	switch (check_reply(reply, content, try_login)) {
+	case ReplyStatus::OK:
+		return content;
+	case ReplyStatus::LOGGED_IN_AGAIN:
+		return run_op(op, args, false, cached_handle);
+	default:
+		return json(nullptr);
+	}
+}
+
+bool TtRssApi::run_list_op(const std::string& op,
+	const std::map<std::string, std::string>& args,
+	const JsonListParser::ItemHandler& handle,
+	bool try_login, /* = true */
+	CURL* cached_handle /* = nullptr */)
+{
+	const std::string result = send_op(op, args, cached_handle);
+
+	// Error replies have an object instead of a list, so nothing is
+	// handed out for them
+	json reply;
+	if (!JsonListParser("content", handle).parse(result, reply)) {
+		LOG(Level::ERROR,
+			"TtRssApi::run_list_op: reply failed to parse: %s",
+			result);
+		set_request_error(RequestError::CONNECTION);
+		return false;
+	}
+
+	json content;
+	switch (check_reply(reply, content, try_login)) {
+	case ReplyStatus::OK:
+		if (!content.is_array()) {
+			LOG(Level::ERROR,
+				"TtRssApi::run_list_op: content is not an array");
+			return false;
+		}
+		return true;
+	case ReplyStatus::LOGGED_IN_AGAIN:
+		return run_list_op(op, args, handle, false, cached_handle);
+	default:
+		return false;
+	}
+}
+
+std::string TtRssApi::send_op(const std::string& op,
+	const std::map<std::string, std::string>& args,
+	CURL* cached_handle)
 {
 	std::string url =
 		strprintf::fmt("%s/api/", cfg->get_configvalue("ttrss-url"));
@@ -153,60 +238,63 @@ json TtRssApi::run_op(const std::string& op,
 
 	std::string result = utils::retrieve_url(
 			url, cfg, auth_info, &req_data, cached_handle);
+	set_request_error(result.empty()
+		? RequestError::CONNECTION
+		: RequestError::NONE);
 
 	LOG(Level::DEBUG,
-		"TtRssApi::run_op(%s,...): post=%s reply = %s",
+		"TtRssApi::send_op(%s,...): post=%s reply = %s",
 		op,
 		req_data,
 		result);
 
-	json reply;
-	try {
-		reply = json::parse(result);
-	} catch (json::parse_error& e) {
-		LOG(Level::ERROR,
-			"TtRssApi::run_op: reply failed to parse: %s",
-			result);
-		return json(nullptr);
-	}
+	return result;
+}
 
+TtRssApi::ReplyStatus TtRssApi::check_reply(json& reply,
+	json& content,
+	bool try_login)
+{
 	int status;
 	try {
 		status = reply.at("status");
 	} catch (json::exception& e) {
 		LOG(Level::ERROR,
-			"TtRssApi::run_op: no status code: %s",
+			"TtRssApi::check_reply: no status code: %s",
 			e.what());
-		return json(nullptr);
+		set_request_error(RequestError::CONNECTION);
+		return ReplyStatus::FAILED;
 	}
 
-	json content;
 	try {
-		content = reply.at("content");
+		content = std::move(reply.at("content"));
 	} catch (json::exception& e) {
 		LOG(Level::ERROR,
-			"TtRssApi::run_op: no content part in answer from "
+			"TtRssApi::check_reply: no content part in answer from "
 			"server");
-		return json(nullptr);
+		set_request_error(RequestError::CONNECTION);
+		return ReplyStatus::FAILED;
 	}
 
 	if (status != 0) {
-		if (content["error"] == "NOT_LOGGED_IN" && try_login) {
-			if (authenticate()) {
-				return run_op(op, args, false, cached_handle);
+		if (content["error"] == "NOT_LOGGED_IN") {
+			if (try_login && authenticate()) {
+				return ReplyStatus::LOGGED_IN_AGAIN;
 			} else {
-				return json(nullptr);
+				set_request_error(RequestError::AUTHENTICATION);
+				return ReplyStatus::FAILED;
 			}
 		} else {
 			LOG(Level::ERROR,
-				"TtRssApi::run_op: status: %d, error: '%s'",
+				"TtRssApi::check_reply: status: %d, error: '%s'",
 				status,
 				content["error"].dump());
-			return json(nullptr);
+			set_request_error(RequestError::REJECTED);
+			return ReplyStatus::FAILED;
 		}
 	}
 
-	return content;
+	return ReplyStatus::OK;
 }
 
 TaggedFeedUrl TtRssApi::feed_from_json(const json& jfeed,
@@ -321,19 +409,25 @@ bool TtRssApi::mark_all_read(const std::string& feed_url)
 
 bool TtRssApi::mark_article_read(const std::string& guid, bool read)
 {
-	// Do this in a thread, as we don't care about the result enough to wait
-	// for it.
-	std::thread t{[=]()
-	{
-		LOG(Level::DEBUG,
-			"TtRssApi::mark_article_read: inside thread, marking "
-			"thread as read...");
-
-		// Call the TtRssApi's update_article function as a thread.
-		this->update_article(guid, 2, read ? 0 : 1);
-	}};
-	t.detach();
-	return true;
+	return update_article(guid, 2, read ? 0 : 1);
+}
+
+bool TtRssApi::mark_articles_read(const std::vector<std::string>& guids,
+	bool read)
+{
+	if (guids.empty()) {
+		return true;
+	}
+
+	// updateArticle takes a comma-separated list of article IDs
+	std::string ids;
+	for (const auto& guid : guids) {
+		if (!ids.empty()) {
+			ids.push_back(',');
+		}
+		ids.append(guid);
+	}
+	return update_article(ids, 2, read ? 0 : 1);
 }
 
 bool TtRssApi::update_article_flags(const std::string& oldflags,
@@ -374,94 +468,274 @@ rsspp::Feed TtRssApi::fetch_feed(const std::string& id, CURL* cached_handle)
 
 	f.rss_version = rsspp::Feed::TTRSS_JSON;
 
+	// Articles that the last prefetch saw existed before this request, so
+	// the feed's ones are in the reply. That lets feeds that were too far
+	// behind to be served from the prefetch catch up with it.
+	const int64_t prefetched = get_prefetched_position();
+
 	std::map<std::string, std::string> args;
 	args["feed_id"] = id;
 	args["show_content"] = "1";
 	args["include_attachments"] = "1";
-	json content = run_op("getHeadlines", args, true, cached_handle);
-
-	if (content.is_null()) {
-		return f;
-	}
+	const auto add_item = [&f, this](const json& item_obj) {
+		f.items.push_back(item_from_json(item_obj));
+		const int64_t item_id = item_obj["id"];
+		f.sync_position = std::max(f.sync_position, item_id);
+	};
 
-	if (!content.is_array()) {
+	try {
+		if (!run_list_op(
+				"getHeadlines", args, add_item, true, cached_handle)) {
+			// Articles before a broken part of the reply aren't kept
+			f.items.clear();
+			f.sync_position = 0;
+			return f;
+		}
+		f.sync_position = std::max(f.sync_position, prefetched);
+	} catch (json::exception& e) {
 		LOG(Level::ERROR,
-			"TtRssApi::fetch_feed: content is not an array");
-		return f;
+			"Exception occurred while parsing feeed: ",
+			e.what());
 	}
 
 	LOG(Level::DEBUG,
 		"TtRssApi::fetch_feed: %" PRIu64 " items",
-		static_cast<uint64_t>(content.size()));
+		static_cast<uint64_t>(f.items.size()));
+
+	std::sort(f.items.begin(),
+		f.items.end(),
+	[](const rsspp::Item& a, const rsspp::Item& b) {
+		return a.pubDate_ts > b.pubDate_ts;
+	});
+
+	return f;
+}
+
+bool TtRssApi::prefetch_feeds(int64_t since)
+{
+	std::map<std::string, std::vector<rsspp::Item>> items;
+	std::map<std::string, std::unordered_set<std::string>> unread;
+	bool all_unread = false;
+	int64_t position = since;
 
 	try {
-		for (const auto& item_obj : content) {
-			rsspp::Item item;
+		std::map<std::string, std::string> args;
+		args["since_id"] = std::to_string(since);
+		if (too_many_headlines(args)) {
+			LOG(Level::INFO,
+				"TtRssApi::prefetch_feeds: more than %u articles are "
+				"newer than %" PRId64 ", fetching feeds one by one",
+				HEADLINES_PER_PAGE * MAX_PREFETCH_PAGES,
+				since);
+			return false;
+		}
 
-			if (!item_obj["title"].is_null()) {
-				item.title = item_obj["title"];
-			}
+		args["show_content"] = "1";
+		args["include_attachments"] = "1";
+		const bool complete = for_all_headlines(args,
+		[&](const json& item_obj) {
+			const int64_t item_id = item_obj["id"];
+			position = std::max(position, item_id);
+			items[id_to_string(item_obj["feed_id"])].push_back(
+				item_from_json(item_obj));
+		});
+		if (!complete) {
+			return false;
+		}
 
-			if (!item_obj["link"].is_null()) {
-				item.link = item_obj["link"];
-			}
+		args.clear();
+		args["view_mode"] = "unread";
+		args["show_content"] = "0";
+		all_unread = for_all_headlines(args, [&](const json& headline) {
+			unread[id_to_string(headline["feed_id"])].insert(
+				id_to_string(headline["id"]));
+		});
+	} catch (json::exception& e) {
+		LOG(Level::ERROR,
+			"TtRssApi::prefetch_feeds: couldn't parse headlines: %s",
+			e.what());
+		return false;
+	}
 
-			if (!item_obj["author"].is_null()) {
-				item.author = item_obj["author"];
-			}
+	for (auto& feed_items : items) {
+		std::sort(feed_items.second.begin(),
+			feed_items.second.end(),
+		[](const rsspp::Item& a, const rsspp::Item& b) {
+			return a.pubDate_ts > b.pubDate_ts;
+		});
+	}
 
-			if (!item_obj["content"].is_null()) {
-				item.content_encoded = item_obj["content"];
-			}
+	LOG(Level::DEBUG,
+		"TtRssApi::prefetch_feeds: %" PRIu64 " feeds have articles newer "
+		"than %" PRId64 ", all unread articles fetched: %d",
+		static_cast<uint64_t>(items.size()),
+		since,
+		all_unread ? 1 : 0);
+
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	has_prefetched = true;
+	prefetched_since = since;
+	prefetched_position = position;
+	prefetched_items = std::move(items);
+	prefetched_unread = std::move(unread);
+	prefetched_all_unread = all_unread;
+	return true;
+}
 
-			if (!item_obj["attachments"].is_null()) {
-				if (item_obj["attachments"].size() >= 1) {
-					json a =
-						item_obj["attachments"].front();
-					if (!a["content_url"].is_null()) {
-						item.enclosure_url =
-							a["content_url"];
-					}
-					if (!a["content_type"].is_null()) {
-						item.enclosure_type =
-							a["content_type"];
-					}
-				}
-			}
+void TtRssApi::discard_prefetched_feeds()
+{
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	has_prefetched = false;
+	prefetched_items.clear();
+	prefetched_unread.clear();
+	prefetched_all_unread = false;
+}
 
-			int id = item_obj["id"];
-			item.guid = strprintf::fmt("%d", id);
+bool TtRssApi::get_prefetched_feed(const std::string& id,
+	int64_t watermark,
+	rsspp::Feed& feed)
+{
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	if (!has_prefetched || watermark < prefetched_since) {
+		return false;
+	}
 
-			bool unread = item_obj["unread"];
-			if (unread) {
-				item.labels.push_back("ttrss:unread");
-			} else {
-				item.labels.push_back("ttrss:read");
+	feed = rsspp::Feed();
+	feed.rss_version = rsspp::Feed::TTRSS_JSON;
+	feed.sync_position = prefetched_position;
+	const auto it = prefetched_items.find(id);
+	if (it != prefetched_items.end()) {
+		feed.items = it->second;
+	}
+	return true;
+}
+
+int64_t TtRssApi::get_prefetched_position()
+{
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	return has_prefetched ? prefetched_position : 0;
+}
+
+bool TtRssApi::get_unread_guids(const std::string& feedurl,
+	unsigned int limit,
+	std::unordered_set<std::string>& guids)
+{
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	if (!has_prefetched || !prefetched_all_unread) {
+		return false;
+	}
+
+	const auto it = prefetched_unread.find(url_to_id(feedurl));
+	if (it != prefetched_unread.end()) {
+		for (const auto& guid : it->second) {
+			if (guids.size() >= limit) {
+				break;
 			}
+			guids.insert(guid);
+		}
+	}
+	return true;
+}
+
+bool TtRssApi::too_many_headlines(std::map<std::string, std::string> args)
+{
+	// Asks for a single headline past the last page that
+	// for_all_headlines() would fetch
+	args["feed_id"] = "-4";
+	args["limit"] = "1";
+	args["skip"] = std::to_string(HEADLINES_PER_PAGE * MAX_PREFETCH_PAGES);
+	args["show_content"] = "0";
+
+	unsigned int count = 0;
+	const auto count_headline = [&count](const json&) {
+		count++;
+	};
+	if (!run_list_op("getHeadlines", args, count_headline)) {
+		// The prefetch itself would fail as well then
+		return true;
+	}
+	return count > 0;
+}
+
+bool TtRssApi::for_all_headlines(std::map<std::string, std::string> args,
+	const std::function<void(const json&)>& handle)
+{
+	// -4 is the special feed that has all articles
+	args["feed_id"] = "-4";
+	args["limit"] = std::to_string(HEADLINES_PER_PAGE);
+
+	for (unsigned int page = 0; page < MAX_PREFETCH_PAGES; page++) {
+		args["skip"] = std::to_string(page * HEADLINES_PER_PAGE);
+		unsigned int count = 0;
+		const auto count_headline = [&count, &handle](const json& headline) {
+			count++;
+			handle(headline);
+		};
+		if (!run_list_op("getHeadlines", args, count_headline)) {
+			return false;
+		}
+		if (count < HEADLINES_PER_PAGE) {
+			return true;
+		}
+	}
+
+	LOG(Level::INFO,
+		"TtRssApi::for_all_headlines: more than %u pages of headlines",
+		MAX_PREFETCH_PAGES);
+	return false;
+}
+
+rsspp::Item TtRssApi::item_from_json(const json& item_obj)
+{
+	rsspp::Item item;
+
+	if (!item_obj["title"].is_null()) {
+		item.title = item_obj["title"];
+	}
+
+	if (!item_obj["link"].is_null()) {
+		item.link = item_obj["link"];
+	}
 
-			int updated_time = item_obj["updated"];
-			time_t updated = static_cast<time_t>(updated_time);
+	if (!item_obj["author"].is_null()) {
+		item.author = item_obj["author"];
+	}
 
-			item.pubDate = utils::mt_strf_localtime(
-					"%a, %d %b %Y %H:%M:%S %z",
-					updated);
-			item.pubDate_ts = updated;
+	if (!item_obj["content"].is_null()) {
+		item.content_encoded = item_obj["content"];
+	}
 
-			f.items.push_back(item);
+	if (!item_obj["attachments"].is_null()) {
+		if (item_obj["attachments"].size() >= 1) {
+			json a = item_obj["attachments"].front();
+			if (!a["content_url"].is_null()) {
+				item.enclosure_url = a["content_url"];
+			}
+			if (!a["content_type"].is_null()) {
+				item.enclosure_type = a["content_type"];
+			}
 		}
-	} catch (json::exception& e) {
-		LOG(Level::ERROR,
-			"Exception occurred while parsing feeed: ",
-			e.what());
 	}
 
-	std::sort(f.items.begin(),
-		f.items.end(),
-	[](const rsspp::Item& a, const rsspp::Item& b) {
-		return a.pubDate_ts > b.pubDate_ts;
-	});
+	int id = item_obj["id"];
+	item.guid = strprintf::fmt("%d", id);
 
-	return f;
+	bool unread = item_obj["unread"];
+	if (unread) {
+		item.labels.push_back("ttrss:unread");
+	} else {
+		item.labels.push_back("ttrss:read");
+	}
+
+	int updated_time = item_obj["updated"];
+	time_t updated = static_cast<time_t>(updated_time);
+
+	item.pubDate = utils::mt_strf_localtime(
+			"%a, %d %b %Y %H:%M:%S %z",
+			updated);
+	item.pubDate_ts = updated;
+
+	return item;
 }
 
 void TtRssApi::fetch_feeds_per_category(const json& cat,
@@ -15,6 +15,9 @@
 #include <langinfo.h>
 #include <libxml/uri.h>
 #include <locale>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #include <mutex>
 #include <pwd.h>
 #include <regex>
@@ -707,6 +710,17 @@ std::string utils::quote_for_stfl(std::string str)
 
 void utils::trim(std::string& str)
 {
+	// Most strings have nothing to trim; if both ends are printable ASCII,
+	// we can tell that without calling into Rust.
+	if (!str.empty()) {
+		const unsigned char first = str.front();
+		const unsigned char last = str.back();
+		if (first < 0x80 && last < 0x80 && !::isspace(first) &&
+			!::isspace(last)) {
+			return;
+		}
+	}
+
 	str = RustString(rs_trim(str.c_str()));
 }
 
@@ -733,16 +747,18 @@ std::string utils::quote_if_necessary(const std::string& str)
 void utils::set_common_curl_options(CURL* handle, ConfigContainer* cfg)
 {
 	if (cfg) {
-		if (cfg->get_configvalue_as_bool("use-proxy")) {
-			const std::string proxy = cfg->get_configvalue("proxy");
+		const auto config = cfg->snapshot();
+		if (config->get_bool(ConfigKey::USE_PROXY)) {
+			const std::string& proxy =
+				config->get(ConfigKey::PROXY);
 			if (proxy != "")
 				curl_easy_setopt(
 					handle, CURLOPT_PROXY, proxy.c_str());
 
-			const std::string proxyauth =
-				cfg->get_configvalue("proxy-auth");
-			const std::string proxyauthmethod =
-				cfg->get_configvalue("proxy-auth-method");
+			const std::string& proxyauth =
+				config->get(ConfigKey::PROXY_AUTH);
+			const std::string& proxyauthmethod =
+				config->get(ConfigKey::PROXY_AUTH_METHOD);
 			if (proxyauth != "") {
 				curl_easy_setopt(handle,
 					CURLOPT_PROXYAUTH,
@@ -752,8 +768,8 @@ void utils::set_common_curl_options(CURL* handle, ConfigContainer* cfg)
 					proxyauth.c_str());
 			}
 
-			const std::string proxytype =
-				cfg->get_configvalue("proxy-type");
+			const std::string& proxytype =
+				config->get(ConfigKey::PROXY_TYPE);
 			if (proxytype != "") {
 				LOG(Level::DEBUG,
 					"utils::set_common_curl_options: "
@@ -770,11 +786,11 @@ void utils::set_common_curl_options(CURL* handle, ConfigContainer* cfg)
 		curl_easy_setopt(handle, CURLOPT_USERAGENT, useragent.c_str());
 
 		const unsigned int dl_timeout =
-			cfg->get_configvalue_as_int("download-timeout");
+			config->get_int(ConfigKey::DOWNLOAD_TIMEOUT);
 		curl_easy_setopt(handle, CURLOPT_TIMEOUT, dl_timeout);
 
-		const std::string cookie_cache =
-			cfg->get_configvalue("cookie-cache");
+		const std::string& cookie_cache =
+			config->get(ConfigKey::COOKIE_CACHE);
 		if (cookie_cache != "") {
 			curl_easy_setopt(handle,
 				CURLOPT_COOKIEFILE,
@@ -786,10 +802,10 @@ void utils::set_common_curl_options(CURL* handle, ConfigContainer* cfg)
 
 		curl_easy_setopt(handle,
 			CURLOPT_SSL_VERIFYHOST,
-			cfg->get_configvalue_as_bool("ssl-verifyhost") ? 2 : 0);
+			config->get_bool(ConfigKey::SSL_VERIFYHOST) ? 2 : 0);
 		curl_easy_setopt(handle,
 			CURLOPT_SSL_VERIFYPEER,
-			cfg->get_configvalue_as_bool("ssl-verifypeer"));
+			config->get_bool(ConfigKey::SSL_VERIFYPEER));
 	}
 
 	curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1);
@@ -1024,4 +1040,14 @@ std::string utils::mt_strf_localtime(const std::string& format, time_t t)
 	return std::string(buffer, written);
 }
 
+void utils::release_free_memory()
+{
+#ifdef __GLIBC__
+	// glibc only gives memory back from the top of the heap on its own, so
+	// a single long-lived allocation made late in a reload pins everything
+	// below it
+	malloc_trim(0);
+#endif
+}
+
 } // namespace newsboat
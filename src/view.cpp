@@ -196,10 +196,17 @@ int View::run()
 	 * This is the main "event" loop of newsboat.
 	 */
 
+	std::weak_ptr<FormAction> previous_fa;
 	while (formaction_stack_size() > 0) {
 		// first, we take the current formaction.
 		std::shared_ptr<FormAction> fa = get_current_formaction();
 
+		const auto left_fa = previous_fa.lock();
+		if (left_fa && left_fa != fa) {
+			stop_prerendering(left_fa);
+		}
+		previous_fa = fa;
+
 		// we signal "oh, you will receive an operation soon"
 		fa->prepare();
 
@@ -304,6 +311,8 @@ std::string View::run_modal(std::shared_ptr<FormAction> f,
 	f->init();
 	unsigned int stacksize = formaction_stack.size();
 
+	stop_prerendering(get_current_formaction());
+
 	formaction_stack.push_back(f);
 	current_formaction = formaction_stack_size() - 1;
 
@@ -748,7 +757,7 @@ bool View::get_random_unread(ItemListFormAction* itemlist,
 	std::shared_ptr<FeedListFormAction> feedlist =
 		std::dynamic_pointer_cast<FeedListFormAction, FormAction>(
 			formaction_stack[0]);
-	if (!cfg->get_configvalue_as_bool("goto-next-feed")) {
+	if (!cfg->snapshot()->get_bool(ConfigKey::GOTO_NEXT_FEED)) {
 		return false;
 	}
 	if (feedlist->jump_to_random_unread_feed(feedpos)) {
@@ -791,7 +800,7 @@ bool View::get_previous_unread(ItemListFormAction* itemlist,
 			itemview->init();
 		}
 		return true;
-	} else if (cfg->get_configvalue_as_bool("goto-next-feed") == false) {
+	} else if (!cfg->snapshot()->get_bool(ConfigKey::GOTO_NEXT_FEED)) {
 		LOG(Level::DEBUG,
 			"View::get_previous_unread: goto-next-feed = false");
 		show_error(_("No unread items."));
@@ -867,7 +876,7 @@ bool View::get_next_unread(ItemListFormAction* itemlist,
 			itemview->init();
 		}
 		return true;
-	} else if (cfg->get_configvalue_as_bool("goto-next-feed") == false) {
+	} else if (!cfg->snapshot()->get_bool(ConfigKey::GOTO_NEXT_FEED)) {
 		LOG(Level::DEBUG,
 			"View::get_next_unread: goto-next-feed = false");
 		show_error(_("No unread items."));
@@ -906,7 +915,7 @@ bool View::get_previous(ItemListFormAction* itemlist,
 			itemview->init();
 		}
 		return true;
-	} else if (cfg->get_configvalue_as_bool("goto-next-feed") == false) {
+	} else if (!cfg->snapshot()->get_bool(ConfigKey::GOTO_NEXT_FEED)) {
 		LOG(Level::DEBUG, "View::get_previous: goto-next-feed = false");
 		show_error(_("Already on first item."));
 	} else if (feedlist->jump_to_previous_feed(feedpos)) {
@@ -941,7 +950,7 @@ bool View::get_next(ItemListFormAction* itemlist, ItemViewFormAction* itemview)
 			itemview->init();
 		}
 		return true;
-	} else if (cfg->get_configvalue_as_bool("goto-next-feed") == false) {
+	} else if (!cfg->snapshot()->get_bool(ConfigKey::GOTO_NEXT_FEED)) {
 		LOG(Level::DEBUG, "View::get_next: goto-next-feed = false");
 		show_error(_("Already on last item."));
 	} else if (feedlist->jump_to_next_feed(feedpos)) {
@@ -1235,6 +1244,14 @@ void View::inside_cmdline(bool f)
 	is_inside_cmdline = f;
 }
 
+void View::stop_prerendering(std::shared_ptr<FormAction> fa)
+{
+	if (fa && fa->id() == "article") {
+		std::dynamic_pointer_cast<ItemViewFormAction, FormAction>(fa)
+		->stop_prerendering();
+	}
+}
+
 void View::clear_line(std::shared_ptr<FormAction> fa)
 {
 	fa->get_form()->set("qna_value", "");
@@ -757,6 +757,271 @@ TEST_CASE(
 	}
 }
 
+TEST_CASE("externalize_rssfeed counts new and changed items", "[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	const std::string feedurl("file://data/rss092_1.xml");
+	RssParser parser(feedurl, &rsscache, &cfg, nullptr);
+	auto feed = parser.parse();
+	REQUIRE(feed->total_item_count() == 3);
+
+	FeedReloadStats stats;
+	rsscache.externalize_rssfeed(feed, false, &stats);
+	REQUIRE(stats.items_new == 3);
+	REQUIRE(stats.items_changed == 0);
+
+	feed->items()[0]->set_title("A brand new title");
+	stats = FeedReloadStats();
+	rsscache.externalize_rssfeed(feed, false, &stats);
+	REQUIRE(stats.items_new == 0);
+	REQUIRE(stats.items_changed == 1);
+}
+
+TEST_CASE("update_unread_from_remote applies the server's read states",
+	"[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const std::string feedurl = "file://data/rss.xml";
+	RssParser parser(feedurl, &rsscache, &cfg, nullptr);
+	std::shared_ptr<RssFeed> feed = parser.parse();
+	REQUIRE(feed->total_item_count() == 8);
+	rsscache.externalize_rssfeed(feed, false);
+
+	std::vector<std::string> guids;
+	for (const auto& item : feed->items()) {
+		guids.push_back(item->guid());
+	}
+	rsscache.mark_items_read_by_guid({guids[0]});
+
+	const auto unread_guids = [&]() {
+		std::unordered_set<std::string> result;
+		for (const auto& item :
+			rsscache.internalize_rssfeed(feedurl, nullptr)->items()) {
+			if (item->unread()) {
+				result.insert(item->guid());
+			}
+		}
+		return result;
+	};
+
+	const std::unordered_set<std::string> remote_unread = {
+		guids[0], guids[1], "not in this feed"
+	};
+
+	SECTION("an incomplete list only marks articles unread") {
+		rsscache.update_unread_from_remote(feedurl, remote_unread, false);
+		REQUIRE(unread_guids().size() == 8);
+	}
+
+	SECTION("a complete list also marks the others read") {
+		rsscache.update_unread_from_remote(feedurl, remote_unread, true);
+		REQUIRE(unread_guids() ==
+			std::unordered_set<std::string>({guids[0], guids[1]}));
+	}
+
+	SECTION("articles with unsent changes are left alone") {
+		RemoteChange change;
+		change.action = RemoteChange::Action::MARK_READ;
+		change.target = guids[0];
+		rsscache.queue_remote_change(change);
+		change.target = guids[2];
+		rsscache.queue_remote_change(change);
+
+		rsscache.update_unread_from_remote(feedurl, remote_unread, true);
+		REQUIRE(unread_guids() ==
+			std::unordered_set<std::string>({guids[1], guids[2]}));
+	}
+
+	SECTION("nothing is marked unread while marking the feed read is "
+		"unsent") {
+		rsscache.mark_all_read(feedurl);
+		RemoteChange change;
+		change.action = RemoteChange::Action::MARK_FEED_READ;
+		change.target = feedurl;
+		rsscache.queue_remote_change(change);
+
+		rsscache.update_unread_from_remote(feedurl, remote_unread, true);
+		REQUIRE(unread_guids().empty());
+	}
+}
+
+TEST_CASE("Sync watermark is stored per feed", "[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	RssParser parser("file://data/rss.xml", &rsscache, &cfg, nullptr);
+	rsscache.externalize_rssfeed(parser.parse(), false);
+
+	REQUIRE(rsscache.fetch_sync_watermark("file://data/rss.xml") == 0);
+	REQUIRE(rsscache.fetch_sync_watermark("file://data/atom10_1.xml") == 0);
+
+	rsscache.update_sync_watermark("file://data/rss.xml", 1581847200);
+	REQUIRE(rsscache.fetch_sync_watermark("file://data/rss.xml") ==
+		1581847200);
+	REQUIRE(rsscache.fetch_sync_watermark("file://data/atom10_1.xml") == 0);
+}
+
+TEST_CASE("externalize_rssfeed saves the feed's sync watermark along with "
+	"its articles",
+	"[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const std::string feedurl = "file://data/rss.xml";
+
+	SECTION("including on the feed's first sync") {
+		RssParser parser(feedurl, &rsscache, &cfg, nullptr);
+		auto feed = parser.parse();
+		feed->set_sync_watermark(1581847200);
+		REQUIRE(rsscache.fetch_sync_watermark(feedurl) == 0);
+
+		rsscache.externalize_rssfeed(feed, false);
+		REQUIRE(rsscache.fetch_sync_watermark(feedurl) == 1581847200);
+		REQUIRE(rsscache.internalize_rssfeed(feedurl, nullptr)
+			->total_item_count() == feed->total_item_count());
+	}
+
+	SECTION("feeds without a watermark leave it as it is") {
+		RssParser parser(feedurl, &rsscache, &cfg, nullptr);
+		rsscache.externalize_rssfeed(parser.parse(), false);
+		rsscache.update_sync_watermark(feedurl, 1581847200);
+
+		RssParser reload(feedurl, &rsscache, &cfg, nullptr);
+		auto feed = reload.parse();
+		REQUIRE_FALSE(feed->has_sync_watermark());
+		rsscache.externalize_rssfeed(feed, false);
+		REQUIRE(rsscache.fetch_sync_watermark(feedurl) == 1581847200);
+
+		SECTION("a watermark of 0 resets it") {
+			feed->set_sync_watermark(0);
+			rsscache.externalize_rssfeed(feed, false);
+			REQUIRE(rsscache.fetch_sync_watermark(feedurl) == 0);
+		}
+	}
+}
+
+TEST_CASE("fetch_newest_sync_watermark only considers given, synced feeds",
+	"[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const std::vector<std::string> feedurls = {
+		"file://data/rss.xml",
+		"file://data/atom10_1.xml",
+		"file://data/rss092_1.xml",
+	};
+	for (const auto& feedurl : feedurls) {
+		RssParser parser(feedurl, &rsscache, &cfg, nullptr);
+		rsscache.externalize_rssfeed(parser.parse(), false);
+	}
+
+	REQUIRE(rsscache.fetch_newest_sync_watermark(feedurls) == 0);
+	REQUIRE(rsscache.fetch_newest_sync_watermark({}) == 0);
+
+	rsscache.update_sync_watermark("file://data/rss.xml", 200);
+	rsscache.update_sync_watermark("file://data/atom10_1.xml", 100);
+	REQUIRE(rsscache.fetch_newest_sync_watermark(feedurls) == 200);
+	REQUIRE(rsscache.fetch_newest_sync_watermark(
+			{"file://data/atom10_1.xml", "file://data/rss092_1.xml"}) == 100);
+	REQUIRE(rsscache.fetch_newest_sync_watermark(
+			{"https://example.com/unknown.xml"}) == 0);
+}
+
+TEST_CASE("get_reload_stats returns recorded stats, slowest first", "[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	REQUIRE(rsscache.get_reload_stats(10).empty());
+
+	FeedReloadStats fast;
+	fast.rssurl = "https://example.com/fast.xml";
+	fast.reloaded_at = 1500000000;
+	fast.total_us = 1200;
+	fast.http_status = 304;
+	fast.not_modified = true;
+	rsscache.record_reload_stats(fast);
+
+	FeedReloadStats slow;
+	slow.rssurl = "https://example.com/slow.xml";
+	slow.total_us = 7000000;
+	slow.dns_us = 10;
+	slow.connect_us = 20;
+	slow.ttfb_us = 30;
+	slow.transfer_us = 40;
+	slow.bytes = 123456;
+	slow.http_status = 200;
+	slow.parse_us = 50;
+	slow.items_new = 3;
+	slow.items_changed = 1;
+	slow.db_write_us = 60;
+	rsscache.record_reload_stats(slow);
+
+	auto records = rsscache.get_reload_stats(10);
+	REQUIRE(records.size() == 2);
+	REQUIRE(records[0].rssurl == slow.rssurl);
+	REQUIRE(records[0].total_us == 7000000);
+	REQUIRE(records[0].dns_us == 10);
+	REQUIRE(records[0].connect_us == 20);
+	REQUIRE(records[0].ttfb_us == 30);
+	REQUIRE(records[0].transfer_us == 40);
+	REQUIRE(records[0].bytes == 123456);
+	REQUIRE(records[0].http_status == 200);
+	REQUIRE_FALSE(records[0].not_modified);
+	REQUIRE(records[0].parse_us == 50);
+	REQUIRE(records[0].items_new == 3);
+	REQUIRE(records[0].items_changed == 1);
+	REQUIRE(records[0].db_write_us == 60);
+	REQUIRE(records[0].error.empty());
+	REQUIRE(records[1].rssurl == fast.rssurl);
+	REQUIRE(records[1].reloaded_at == 1500000000);
+	REQUIRE(records[1].not_modified);
+
+	SECTION("only the latest reload of each feed is kept") {
+		slow.total_us = 100;
+		slow.error = "Could not resolve host";
+		rsscache.record_reload_stats(slow);
+
+		records = rsscache.get_reload_stats(10);
+		REQUIRE(records.size() == 2);
+		REQUIRE(records[0].rssurl == fast.rssurl);
+		REQUIRE(records[1].rssurl == slow.rssurl);
+		REQUIRE(records[1].error == "Could not resolve host");
+	}
+
+	SECTION("limit caps the number of returned records") {
+		records = rsscache.get_reload_stats(1);
+		REQUIRE(records.size() == 1);
+		REQUIRE(records[0].rssurl == slow.rssurl);
+	}
+}
+
+TEST_CASE("internalize_rssfeed sets the duration of the last reload",
+	"[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	const std::string feedurl("file://data/rss092_1.xml");
+	RssParser parser(feedurl, &rsscache, &cfg, nullptr);
+	auto feed = parser.parse();
+	rsscache.externalize_rssfeed(feed, false);
+
+	feed = rsscache.internalize_rssfeed(feedurl, nullptr);
+	REQUIRE(feed->last_reload_duration() == 0);
+
+	FeedReloadStats stats;
+	stats.rssurl = feedurl;
+	stats.total_us = 31337;
+	rsscache.record_reload_stats(stats);
+
+	feed = rsscache.internalize_rssfeed(feedurl, nullptr);
+	REQUIRE(feed->last_reload_duration() == 31337);
+}
+
 TEST_CASE(
 	"internalize_rssfeed returns feed without items but specified RSS URL",
 	"[Cache]")
@@ -791,6 +1056,35 @@ TEST_CASE("internalize_rssfeed doesn't return items that are ignored",
 	REQUIRE(feed->total_item_count() == 2);
 }
 
+TEST_CASE("internalize_rssfeed_without_items returns feed's metadata only",
+	"[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	const std::string feedurl("file://data/rss.xml");
+	RssParser parser(feedurl, &rsscache, &cfg, nullptr);
+	auto feed = parser.parse();
+	REQUIRE(feed->total_item_count() == 8);
+	rsscache.externalize_rssfeed(feed, false);
+
+	const auto full = rsscache.internalize_rssfeed(feedurl, nullptr);
+	const auto bare = rsscache.internalize_rssfeed_without_items(feedurl);
+
+	REQUIRE(bare->rssurl() == feedurl);
+	REQUIRE(bare->title() == full->title());
+	REQUIRE(bare->link() == full->link());
+	REQUIRE(bare->total_item_count() == 0);
+
+	SECTION("Unknown feeds are returned empty") {
+		const std::string unknown("https://example.com/unknown.xml");
+		const auto feed = rsscache.internalize_rssfeed_without_items(unknown);
+		REQUIRE(feed->rssurl() == unknown);
+		REQUIRE(feed->title_raw().empty());
+		REQUIRE(feed->total_item_count() == 0);
+	}
+}
+
 TEST_CASE(
 	"externalize_rssfeed resets \"unread\" field if item's content "
 	"changed and reset_unread = \"yes\"",
@@ -860,6 +1154,34 @@ TEST_CASE(
 		feed = rsscache->internalize_rssfeed(feedurl, nullptr);
 		REQUIRE(feed->items()[0]->unread());
 	}
+
+	SECTION("override_unread is set, but the user's change of the item "
+		"wasn't sent to the server yet; item remains read") {
+		RemoteChange change;
+		change.action = RemoteChange::Action::MARK_READ;
+		change.target = item->guid();
+		rsscache->queue_remote_change(change);
+
+		item->set_override_unread(true);
+		rsscache->externalize_rssfeed(feed, false);
+		rsscache.reset(new Cache(dbfile.get_path(), &cfg));
+		feed = rsscache->internalize_rssfeed(feedurl, nullptr);
+		REQUIRE_FALSE(feed->items()[0]->unread());
+	}
+
+	SECTION("override_unread is set, but the user marked the feed read and "
+		"that wasn't sent yet; item remains read") {
+		RemoteChange change;
+		change.action = RemoteChange::Action::MARK_FEED_READ;
+		change.target = feedurl;
+		rsscache->queue_remote_change(change);
+
+		item->set_override_unread(true);
+		rsscache->externalize_rssfeed(feed, false);
+		rsscache.reset(new Cache(dbfile.get_path(), &cfg));
+		feed = rsscache->internalize_rssfeed(feedurl, nullptr);
+		REQUIRE_FALSE(feed->items()[0]->unread());
+	}
 }
 
 TEST_CASE(
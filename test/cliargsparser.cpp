@@ -351,6 +351,23 @@ TEST_CASE("Sets `do_vacuum` if -X/--vacuum is provided", "[CliArgsParser]")
 	}
 }
 
+TEST_CASE("Sets `do_daemon` if -D/--daemon is provided", "[CliArgsParser]")
+{
+	auto check = [](TestHelpers::Opts opts) {
+		CliArgsParser args(opts.argc(), opts.argv());
+
+		REQUIRE(args.do_daemon());
+	};
+
+	SECTION("-D") {
+		check({"newsboat", "-D"});
+	}
+
+	SECTION("--daemon") {
+		check({"newsboat", "--daemon"});
+	}
+}
+
 TEST_CASE("Increases `show_version` with each -v/-V/--version provided",
 	"[CliArgsParser]")
 {
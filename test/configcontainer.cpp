@@ -168,6 +168,63 @@ TEST_CASE("toggle() inverts the value of a boolean setting",
 	}
 }
 
+TEST_CASE("snapshot() returns the same values as the getters",
+	"[ConfigContainer]")
+{
+	ConfigContainer cfg;
+
+	const auto snapshot = cfg.snapshot();
+	REQUIRE(snapshot->get(ConfigKey::IGNORE_MODE) ==
+		cfg.get_configvalue("ignore-mode"));
+	REQUIRE(snapshot->get_int(ConfigKey::DOWNLOAD_RETRIES) ==
+		cfg.get_configvalue_as_int("download-retries"));
+	REQUIRE(snapshot->get_bool(ConfigKey::SHOW_READ_ARTICLES) ==
+		cfg.get_configvalue_as_bool("show-read-articles"));
+	REQUIRE(snapshot->get_bool(ConfigKey::SSL_VERIFYPEER) ==
+		cfg.get_configvalue_as_bool("ssl-verifypeer"));
+}
+
+TEST_CASE("snapshot() reflects changes, but older snapshots don't",
+	"[ConfigContainer]")
+{
+	ConfigContainer cfg;
+	const auto before = cfg.snapshot();
+
+	SECTION("set_configvalue()") {
+		cfg.set_configvalue("max-items", "42");
+		REQUIRE(cfg.snapshot()->get_int(ConfigKey::MAX_ITEMS) == 42);
+		REQUIRE(before->get_int(ConfigKey::MAX_ITEMS) == 0);
+	}
+
+	SECTION("toggle()") {
+		cfg.toggle("show-read-feeds");
+		REQUIRE_FALSE(
+			cfg.snapshot()->get_bool(ConfigKey::SHOW_READ_FEEDS));
+		REQUIRE(before->get_bool(ConfigKey::SHOW_READ_FEEDS));
+	}
+
+	SECTION("handle_action()") {
+		cfg.handle_action("ignore-mode", {"display"});
+		REQUIRE(cfg.snapshot()->get(ConfigKey::IGNORE_MODE) ==
+			"display");
+		REQUIRE(before->get(ConfigKey::IGNORE_MODE) == "download");
+
+		cfg.reset_to_default("ignore-mode");
+		REQUIRE(cfg.snapshot()->get(ConfigKey::IGNORE_MODE) ==
+			"download");
+	}
+}
+
+TEST_CASE("snapshot() resolves tilde in paths", "[ConfigContainer]")
+{
+	ConfigContainer cfg;
+
+	cfg.set_configvalue("cookie-cache", "~/cookies.txt");
+	REQUIRE(cfg.snapshot()->get(ConfigKey::COOKIE_CACHE) ==
+		cfg.get_configvalue("cookie-cache"));
+	REQUIRE(cfg.snapshot()->get(ConfigKey::COOKIE_CACHE)[0] != '~');
+}
+
 TEST_CASE("toggle() does nothing if setting is non-boolean",
 	"[ConfigContainer]")
 {
@@ -428,6 +485,18 @@ TEST_CASE(
 		REQUIRE(sort_strategy.sm == FeedSortMethod::LAST_UPDATED);
 		REQUIRE(sort_strategy.sd == SortDirection::ASC);
 	}
+
+	SECTION("reloadtime") {
+		cfg.set_configvalue("feed-sort-order", "reloadtime");
+		sort_strategy = cfg.get_feed_sort_strategy();
+		REQUIRE(sort_strategy.sm == FeedSortMethod::RELOAD_TIME);
+		REQUIRE(sort_strategy.sd == SortDirection::DESC);
+
+		cfg.set_configvalue("feed-sort-order", "reloadtime-asc");
+		sort_strategy = cfg.get_feed_sort_strategy();
+		REQUIRE(sort_strategy.sm == FeedSortMethod::RELOAD_TIME);
+		REQUIRE(sort_strategy.sd == SortDirection::ASC);
+	}
 }
 
 TEST_CASE(
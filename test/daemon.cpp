@@ -0,0 +1,234 @@
+#include "daemon.h"
+
+#include <cstring>
+#include <future>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+#include "3rd-party/catch.hpp"
+#include "3rd-party/json.hpp"
+#include "cache.h"
+#include "configcontainer.h"
+#include "configpaths.h"
+#include "controller.h"
+#include "feedcontainer.h"
+#include "reloader.h"
+#include "rssfeed.h"
+#include "rssitem.h"
+#include "test-helpers.h"
+#include "view.h"
+
+using namespace newsboat;
+
+namespace {
+
+int listen_on(const std::string& path)
+{
+	struct sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+	const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	REQUIRE(fd != -1);
+	REQUIRE(::bind(fd, reinterpret_cast<struct sockaddr*>(&addr),
+			sizeof(addr)) == 0);
+	REQUIRE(::listen(fd, 1) == 0);
+	return fd;
+}
+
+/// A Controller with two feeds, which can't be downloaded, and a Daemon
+/// serving it
+class DaemonFixture {
+public:
+	DaemonFixture()
+		: ctrl(paths)
+		, view(&ctrl)
+		, rsscache(":memory:", &cfg)
+		, reloader(&ctrl, &rsscache, &cfg)
+		, daemon(&ctrl, &reloader, &cfg, socket_file.get_path())
+	{
+		ctrl.set_view(&view);
+
+		first = make_feed("gopher://example.com/first.xml", 2, 1);
+		second = make_feed("gopher://example.com/second.xml", 1, 1);
+		ctrl.get_feedcontainer()->set_feeds({first, second});
+		ctrl.get_feedcontainer()->reset_feeds_status();
+	}
+
+	std::shared_ptr<RssFeed> make_feed(const std::string& url,
+		unsigned int unread,
+		unsigned int read)
+	{
+		auto feed = std::make_shared<RssFeed>(&rsscache);
+		feed->set_rssurl(url);
+		for (unsigned int i = 0; i < unread + read; ++i) {
+			auto item = std::make_shared<RssItem>(&rsscache);
+			item->set_guid(url + "#" + std::to_string(i));
+			item->set_unread_nowrite(i < unread);
+			feed->add_item(item);
+		}
+		return feed;
+	}
+
+	ConfigPaths paths;
+	Controller ctrl;
+	newsboat::View view;
+	ConfigContainer cfg;
+	Cache rsscache;
+	Reloader reloader;
+	TestHelpers::TempFile socket_file;
+	Daemon daemon;
+
+	std::shared_ptr<RssFeed> first;
+	std::shared_ptr<RssFeed> second;
+};
+
+} // namespace
+
+TEST_CASE("execute() answers unknown commands with an error", "[Daemon]")
+{
+	DaemonFixture f;
+
+	REQUIRE(f.daemon.execute("frobnicate") ==
+		"ERR unknown command: frobnicate");
+	REQUIRE(f.daemon.execute("  frobnicate   now ") ==
+		"ERR unknown command: frobnicate");
+}
+
+TEST_CASE("execute() reports the number of unread articles and the stats",
+	"[Daemon]")
+{
+	DaemonFixture f;
+
+	REQUIRE(f.daemon.execute("print-unread") == "OK 3 unread articles");
+
+	const std::string reply = f.daemon.execute("stats");
+	REQUIRE(reply.substr(0, 3) == "OK ");
+	const auto stats = nlohmann::json::parse(reply.substr(3));
+	REQUIRE(stats["gauges"]["feeds"] == 2);
+	REQUIRE(stats["gauges"]["feeds.unread"] == 2);
+	REQUIRE(stats["gauges"]["articles"] == 5);
+	REQUIRE(stats["gauges"]["articles.unread"] == 3);
+	REQUIRE(stats["gauges"]["daemon.reloading"] == 0);
+}
+
+TEST_CASE("execute() refuses to mark an unknown feed read", "[Daemon]")
+{
+	DaemonFixture f;
+
+	REQUIRE(f.daemon.execute("mark-read https://example.com/unknown.xml") ==
+		"ERR no such feed: https://example.com/unknown.xml");
+	REQUIRE(f.daemon.execute("print-unread") == "OK 3 unread articles");
+}
+
+TEST_CASE("execute() reloads the feed with the given URL", "[Daemon]")
+{
+	DaemonFixture f;
+
+	SECTION("Only that feed is reloaded") {
+		REQUIRE(f.daemon.execute("reload gopher://example.com/second.xml") ==
+			"OK");
+		REQUIRE(f.first->get_status() == "_");
+		// Its URL isn't supported, so the reload fails
+		REQUIRE(f.second->get_status() == "x");
+	}
+
+	SECTION("The feed is found after the feeds were sorted") {
+		f.ctrl.get_feedcontainer()->set_feeds({f.second, f.first});
+
+		REQUIRE(f.daemon.execute("reload gopher://example.com/second.xml") ==
+			"OK");
+		REQUIRE(f.first->get_status() == "_");
+		REQUIRE(f.second->get_status() == "x");
+	}
+
+	SECTION("Unknown feeds are an error") {
+		REQUIRE(f.daemon.execute("reload gopher://example.com/unknown.xml")
+			.substr(0, 4) == "ERR ");
+		REQUIRE(f.first->get_status() == "_");
+		REQUIRE(f.second->get_status() == "_");
+	}
+
+	SECTION("Nothing is reloaded while another reload is running") {
+		// The lock has to be held by some other thread
+		std::promise<bool> locked;
+		std::promise<void> done;
+		std::thread other_reload([&]() {
+			locked.set_value(f.reloader.trylock_reload_mutex());
+			done.get_future().wait();
+			f.reloader.unlock_reload_mutex();
+		});
+		REQUIRE(locked.get_future().get());
+
+		const auto reply_one = f.daemon.execute(
+				"reload gopher://example.com/second.xml");
+		const auto reply_all = f.daemon.execute("reload");
+		done.set_value();
+		other_reload.join();
+
+		REQUIRE(reply_one.substr(0, 4) == "ERR ");
+		REQUIRE(reply_all.substr(0, 4) == "ERR ");
+		REQUIRE(f.second->get_status() == "_");
+	}
+
+	// The reload lock is released in every case
+	REQUIRE(f.reloader.trylock_reload_mutex());
+	f.reloader.unlock_reload_mutex();
+}
+
+TEST_CASE("send_commands() returns false if no daemon is listening",
+	"[Daemon]")
+{
+	TestHelpers::TempFile socket_file;
+
+	std::vector<std::string> replies;
+	REQUIRE_FALSE(Daemon::send_commands(
+			socket_file.get_path(), {"reload"}, replies));
+	REQUIRE(replies.empty());
+}
+
+TEST_CASE("send_commands() sends commands one per line and collects a reply "
+	"for each of them",
+	"[Daemon]")
+{
+	TestHelpers::TempFile socket_file;
+	const int listen_fd = listen_on(socket_file.get_path());
+
+	std::vector<std::string> received;
+	std::thread server([&]() {
+		const int fd = ::accept(listen_fd, nullptr, nullptr);
+		std::string buffer;
+		char chunk[64];
+		ssize_t n;
+		while ((n = ::recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+			buffer.append(chunk, n);
+			size_t newline;
+			while ((newline = buffer.find('\n')) != std::string::npos) {
+				const auto command = buffer.substr(0, newline);
+				buffer.erase(0, newline + 1);
+				received.push_back(command);
+				const std::string reply = command == "stats"
+					? "OK feeds=1\n"
+					: "ERR unknown command: " + command + "\n";
+				::send(fd, reply.data(), reply.length(), 0);
+			}
+		}
+		::close(fd);
+	});
+
+	std::vector<std::string> replies;
+	const bool connected = Daemon::send_commands(
+			socket_file.get_path(), {"stats", "frobnicate"}, replies);
+	server.join();
+	::close(listen_fd);
+
+	REQUIRE(connected);
+	REQUIRE(received == std::vector<std::string>({"stats", "frobnicate"}));
+	REQUIRE(replies == std::vector<std::string>({
+		"OK feeds=1",
+		"ERR unknown command: frobnicate"
+	}));
+}
@@ -0,0 +1,410 @@
+#include "downloadengine.h"
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <netinet/in.h>
+#include <queue>
+#include <sstream>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "3rd-party/catch.hpp"
+#include "test-helpers.h"
+
+using namespace podboat;
+
+namespace {
+
+int listen_on_loopback(uint16_t& port)
+{
+	struct sockaddr_in addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	REQUIRE(fd != -1);
+	REQUIRE(::bind(fd, reinterpret_cast<struct sockaddr*>(&addr),
+			sizeof(addr)) == 0);
+	REQUIRE(::listen(fd, 1) == 0);
+
+	socklen_t length = sizeof(addr);
+	REQUIRE(::getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr),
+			&length) == 0);
+	port = ntohs(addr.sin_port);
+	return fd;
+}
+
+/// Answers each connection to \a listen_fd with whatever \a respond returns
+/// for its request, until the socket is shut down. Returns the requests.
+std::vector<std::string> serve(int listen_fd,
+	const std::function<std::string(const std::string&)>& respond)
+{
+	std::vector<std::string> requests;
+	int fd;
+	while ((fd = ::accept(listen_fd, nullptr, nullptr)) != -1) {
+		std::string request;
+		char chunk[1024];
+		ssize_t n;
+		while (request.find("\r\n\r\n") == std::string::npos
+			&& (n = ::recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+			request.append(chunk, n);
+		}
+		requests.push_back(request);
+
+		const std::string response = respond(request);
+		size_t sent = 0;
+		while (sent < response.size()) {
+			n = ::send(fd, response.data() + sent, response.size() - sent,
+					MSG_NOSIGNAL);
+			if (n <= 0) {
+				break;
+			}
+			sent += n;
+		}
+		::close(fd);
+	}
+	return requests;
+}
+
+bool accepts_gzip(const std::string& request)
+{
+	std::string lowercase = request;
+	for (auto& c : lowercase) {
+		c = std::tolower(static_cast<unsigned char>(c));
+	}
+	const auto header = lowercase.find("\r\naccept-encoding:");
+	if (header == std::string::npos) {
+		return false;
+	}
+	const auto end = lowercase.find("\r\n", header + 2);
+	return lowercase.substr(header, end - header).find("gzip") !=
+		std::string::npos;
+}
+
+std::string http_response(const std::string& body,
+	const std::string& extra_headers)
+{
+	return "HTTP/1.1 200 OK\r\n"
+		"Content-Type: audio/mpeg\r\n"
+		"Content-Length: " + std::to_string(body.size()) + "\r\n"
+		+ extra_headers
+		+ "Connection: close\r\n"
+		"\r\n"
+		+ body;
+}
+
+DlStatus wait_until_done(const Download& dl)
+{
+	for (int i = 0; i < 1000; ++i) {
+		const DlStatus status = dl.status();
+		if (status != DlStatus::QUEUED && status != DlStatus::DOWNLOADING) {
+			return status;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return dl.status();
+}
+
+std::string read_file(const std::string& path)
+{
+	std::ifstream f(path, std::ifstream::binary);
+	std::ostringstream contents;
+	contents << f.rdbuf();
+	return contents.str();
+}
+
+/// Downloads an enclosure from a local server that answers with \a respond.
+/// Puts the requests it got into \a requests, and the file into \a contents.
+DlStatus download_from(
+	const std::function<std::string(const std::string&)>& respond,
+	unsigned int max_segments,
+	std::vector<std::string>& requests,
+	std::string& contents)
+{
+	TestHelpers::TempDir tmp;
+	uint16_t port = 0;
+	const int listen_fd = listen_on_loopback(port);
+
+	newsboat::ConfigContainer cfg;
+	Download dl([]() {});
+	dl.set_url("http://127.0.0.1:" + std::to_string(port) + "/episode.mp3");
+	dl.set_filename(tmp.get_path() + "episode.mp3");
+
+	std::thread server([&]() {
+		requests = serve(listen_fd, respond);
+	});
+	DlStatus status;
+	{
+		DownloadEngine engine(&cfg);
+		engine.set_max_segments(max_segments);
+		engine.enqueue(&dl);
+		status = wait_until_done(dl);
+	}
+	::shutdown(listen_fd, SHUT_RDWR);
+	server.join();
+	::close(listen_fd);
+
+	contents = read_file(dl.filename());
+	return status;
+}
+
+} // namespace
+
+TEST_CASE("Pending downloads are started by priority, then in the order "
+	"they were enqueued",
+	"[DownloadEngine]")
+{
+	using Pending = DownloadEngine::Pending;
+	using Priority = DownloadEngine::Priority;
+
+	std::priority_queue<Pending, std::vector<Pending>,
+		DownloadEngine::PendingOrder> pending;
+	pending.push({nullptr, Priority::NORMAL, 1});
+	pending.push({nullptr, Priority::NORMAL, 2});
+	pending.push({nullptr, Priority::HIGH, 3});
+	pending.push({nullptr, Priority::NORMAL, 4});
+	pending.push({nullptr, Priority::HIGH, 5});
+
+	std::vector<uint64_t> order;
+	while (!pending.empty()) {
+		order.push_back(pending.top().sequence);
+		pending.pop();
+	}
+	REQUIRE(order == std::vector<uint64_t>({3, 5, 1, 2, 4}));
+}
+
+TEST_CASE("refill_budget() adds the limit's worth of bytes for the elapsed "
+	"time, up to a second's worth",
+	"[DownloadEngine]")
+{
+	SECTION("Without a limit, there's no budget to keep track of") {
+		REQUIRE(DownloadEngine::refill_budget(0, 0, 1.0) == 0);
+		REQUIRE(DownloadEngine::refill_budget(-5000, 0, 0.5) == 0);
+	}
+
+	SECTION("The budget grows with the elapsed time") {
+		REQUIRE(DownloadEngine::refill_budget(0, 1000, 0.5) == 500);
+		REQUIRE(DownloadEngine::refill_budget(200, 1000, 0.3) == 500);
+		REQUIRE(DownloadEngine::refill_budget(500, 1000, 0.0) == 500);
+	}
+
+	SECTION("An idle period doesn't allow a burst above the limit") {
+		REQUIRE(DownloadEngine::refill_budget(0, 1000, 10.0) == 1000);
+		REQUIRE(DownloadEngine::refill_budget(900, 1000, 0.5) == 1000);
+	}
+
+	SECTION("Bytes received beyond the budget are paid back first") {
+		REQUIRE(DownloadEngine::refill_budget(-3000, 1000, 1.0) == -2000);
+		REQUIRE(DownloadEngine::refill_budget(-300, 1000, 0.5) == 200);
+	}
+}
+
+TEST_CASE("split_segments() splits large files into back-to-back segments",
+	"[DownloadEngine]")
+{
+	const uint64_t MiB = 1024 * 1024;
+
+	SECTION("Files that are too small get a single segment") {
+		for (const uint64_t size : {
+				uint64_t(0), uint64_t(1), 4 * MiB - 1, 7 * MiB
+			}) {
+			const auto segments = DownloadEngine::split_segments(size, 4);
+			REQUIRE(segments.size() == 1);
+			REQUIRE(segments[0].start == 0);
+			REQUIRE(segments[0].end == size);
+			REQUIRE(segments[0].done == 0);
+		}
+	}
+
+	SECTION("A single segment is used if splitting is turned off") {
+		REQUIRE(DownloadEngine::split_segments(1000 * MiB, 1).size() == 1);
+		REQUIRE(DownloadEngine::split_segments(1000 * MiB, 0).size() == 1);
+	}
+
+	SECTION("Each segment gets at least a few megabytes") {
+		REQUIRE(DownloadEngine::split_segments(12 * MiB, 8).size() == 3);
+		REQUIRE(DownloadEngine::split_segments(100 * MiB, 8).size() == 8);
+	}
+
+	SECTION("Segments cover the file and start at aligned offsets") {
+		const uint64_t size = 100 * MiB + 12345;
+		const auto segments = DownloadEngine::split_segments(size, 3);
+		REQUIRE(segments.size() == 3);
+
+		REQUIRE(segments[0].start == 0);
+		for (size_t i = 0; i < segments.size(); ++i) {
+			INFO("segment " << i);
+			REQUIRE(segments[i].start % (256 * 1024) == 0);
+			REQUIRE(segments[i].end > segments[i].start);
+			REQUIRE(segments[i].done == 0);
+			if (i > 0) {
+				REQUIRE(segments[i].start == segments[i - 1].end);
+			}
+		}
+		REQUIRE(segments.back().end == size);
+	}
+}
+
+TEST_CASE("Segments survive a round-trip through the state file",
+	"[DownloadEngine]")
+{
+	const std::vector<DownloadEngine::Segment> segments = {
+		{0, 1000, 1000},
+		{1000, 5000, 123},
+		{5000, 5001, 0},
+	};
+
+	std::stringstream state;
+	DownloadEngine::write_state(state, segments);
+
+	std::vector<DownloadEngine::Segment> loaded;
+	REQUIRE(DownloadEngine::read_state(state, loaded));
+	REQUIRE(loaded.size() == segments.size());
+	for (size_t i = 0; i < segments.size(); ++i) {
+		INFO("segment " << i);
+		REQUIRE(loaded[i].start == segments[i].start);
+		REQUIRE(loaded[i].end == segments[i].end);
+		REQUIRE(loaded[i].done == segments[i].done);
+	}
+}
+
+TEST_CASE("read_state() rejects corrupt and truncated state files",
+	"[DownloadEngine]")
+{
+	const std::string complete = "2\n0 1000 10\n1000 2000 20\n";
+
+	std::vector<DownloadEngine::Segment> segments;
+	const auto read = [&segments](const std::string& content) {
+		std::istringstream in(content);
+		return DownloadEngine::read_state(in, segments);
+	};
+
+	REQUIRE(read(complete));
+
+	SECTION("Empty file") {
+		REQUIRE_FALSE(read(""));
+		REQUIRE_FALSE(read("0\n"));
+	}
+
+	SECTION("Truncated at any point") {
+		for (size_t length = 0; length < complete.size() - 1; ++length) {
+			INFO("length " << length);
+			REQUIRE_FALSE(read(complete.substr(0, length)));
+		}
+	}
+
+	SECTION("Garbage") {
+		REQUIRE_FALSE(read("garbage"));
+		REQUIRE_FALSE(read("2\n0 1000 10\n1000 two 20\n"));
+		REQUIRE_FALSE(read(complete + "3000 4000 0\n"));
+	}
+
+	SECTION("Segments with a gap or an overlap") {
+		REQUIRE_FALSE(read("2\n0 1000 10\n1500 2000 20\n"));
+		REQUIRE_FALSE(read("2\n0 1000 10\n900 2000 20\n"));
+	}
+
+	SECTION("First segment doesn't start at 0") {
+		REQUIRE_FALSE(read("1\n10 1000 10\n"));
+	}
+
+	SECTION("Empty segment") {
+		REQUIRE_FALSE(read("1\n0 0 0\n"));
+	}
+
+	SECTION("More bytes done than the segment has") {
+		REQUIRE_FALSE(read("1\n0 1000 1001\n"));
+	}
+}
+
+TEST_CASE("Enclosures are saved byte for byte, even if the server compressed "
+	"them",
+	"[DownloadEngine]")
+{
+	const std::string plain(20000, 'x');
+	// `plain`, gzipped; its Content-Length is much shorter than the text
+	const std::string gzipped(
+		"\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\xed\xc1\x31\x01"
+		"\x00\x00\x00\xc2\xa0\xda\x8b\x6f\x0d\x0f\xa0\x00\x00\x00"
+		"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+		"\x00\x00\x00\x78\x30\x03\x47\x65\x41\x20\x4e\x00\x00",
+		54);
+	const std::string gzip_response =
+		http_response(gzipped, "Content-Encoding: gzip\r\n");
+
+	std::function<std::string(const std::string&)> respond;
+	std::string expected;
+	SECTION("Servers that compress when asked aren't asked to") {
+		expected = plain;
+		respond = [&](const std::string& request) {
+			return accepts_gzip(request)
+				? gzip_response
+				: http_response(plain, "");
+		};
+	}
+	SECTION("Compression that wasn't asked for is kept") {
+		expected = gzipped;
+		respond = [&](const std::string&) {
+			return gzip_response;
+		};
+	}
+
+	std::vector<std::string> requests;
+	std::string contents;
+	REQUIRE(download_from(respond, 1, requests, contents) == DlStatus::READY);
+	REQUIRE(contents == expected);
+}
+
+TEST_CASE("Downloads are only split if they aren't sent encoded",
+	"[DownloadEngine]")
+{
+	std::string body(16 * 1024 * 1024, '\0');
+	for (size_t i = 0; i < body.size(); ++i) {
+		body[i] = static_cast<char>(i * 7 % 251);
+	}
+
+	std::string encoding;
+	const auto respond = [&](const std::string& request) {
+		const std::string headers = "Accept-Ranges: bytes\r\n" + encoding;
+		const std::string range = "\r\nRange: bytes=";
+		const auto found = request.find(range);
+		if (found == std::string::npos) {
+			return http_response(body, headers);
+		}
+
+		char* end = nullptr;
+		const uint64_t first = std::strtoull(
+				request.c_str() + found + range.size(), &end, 10);
+		const uint64_t last = std::strtoull(end + 1, nullptr, 10);
+		std::string response = http_response(
+				body.substr(first, last - first + 1),
+				headers + "Content-Range: bytes " + std::to_string(first)
+				+ "-" + std::to_string(last) + "/"
+				+ std::to_string(body.size()) + "\r\n");
+		response.replace(0, response.find("\r\n"), "HTTP/1.1 206 Partial Content");
+		return response;
+	};
+
+	std::vector<std::string> requests;
+	std::string contents;
+
+	SECTION("Plain ones are") {
+		REQUIRE(download_from(respond, 4, requests, contents) ==
+			DlStatus::READY);
+		REQUIRE(requests.size() == 4);
+		REQUIRE(contents == body);
+	}
+
+	SECTION("Encoded ones are fetched in one piece") {
+		encoding = "Content-Encoding: gzip\r\n";
+		REQUIRE(download_from(respond, 4, requests, contents) ==
+			DlStatus::READY);
+		REQUIRE(requests.size() == 1);
+		REQUIRE(contents == body);
+	}
+}
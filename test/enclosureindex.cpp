@@ -0,0 +1,105 @@
+#include "enclosureindex.h"
+
+#include <fstream>
+#include <unistd.h>
+
+#include "3rd-party/catch.hpp"
+#include "test-helpers.h"
+
+using namespace podboat;
+
+namespace {
+
+void write_file(const std::string& path, const std::string& content)
+{
+	std::ofstream f(path, std::ofstream::binary);
+	f << content;
+}
+
+} // namespace
+
+TEST_CASE("canonical_url() ignores differences that don't change the file",
+	"[EnclosureIndex]")
+{
+	const std::string expected = "example.com/ep/1.mp3";
+
+	REQUIRE(EnclosureIndex::canonical_url("https://example.com/ep/1.mp3") ==
+		expected);
+	REQUIRE(EnclosureIndex::canonical_url("http://EXAMPLE.com/ep/1.mp3") ==
+		expected);
+	REQUIRE(EnclosureIndex::canonical_url("http://example.com:80/ep/1.mp3") ==
+		expected);
+	REQUIRE(EnclosureIndex::canonical_url(
+			"https://example.com:443/ep/1.mp3#t=10") == expected);
+	REQUIRE(EnclosureIndex::canonical_url(
+			"https://example.com/ep/1.mp3?utm_source=feed&utm_medium=rss") ==
+		expected);
+
+	SECTION("but keeps other query parameters and the path's case") {
+		REQUIRE(EnclosureIndex::canonical_url(
+				"https://example.com/get?id=1&utm_source=x") ==
+			"example.com/get?id=1");
+		REQUIRE(EnclosureIndex::canonical_url("https://example.com/Ep/1.mp3")
+			!= expected);
+	}
+
+	SECTION("an empty path is the same as /") {
+		REQUIRE(EnclosureIndex::canonical_url("https://example.com") ==
+			"example.com/");
+		REQUIRE(EnclosureIndex::canonical_url("https://example.com?a=b") ==
+			"example.com/?a=b");
+	}
+}
+
+TEST_CASE("EnclosureIndex finds files by URL, ETag and content, "
+	"and remembers them across loads",
+	"[EnclosureIndex]")
+{
+	TestHelpers::TempDir dir;
+	const std::string index_file = dir.get_path() + "enclosures";
+	const std::string episode = dir.get_path() + "episode.mp3";
+	const std::string copy = dir.get_path() + "copy.mp3";
+	write_file(episode, "episode content");
+	write_file(copy, "episode content");
+
+	{
+		EnclosureIndex index(index_file);
+		index.load();
+		REQUIRE(index.find_by_url("https://example.com/1.mp3") == "");
+
+		index.add({"https://track.example.org/r/example.com/1.mp3",
+				"https://example.com/1.mp3"},
+			episode,
+			15,
+			"abc123");
+
+		REQUIRE(index.find_by_url("http://example.com/1.mp3") == episode);
+		REQUIRE(index.find_by_url(
+				"https://track.example.org/r/example.com/1.mp3") == episode);
+		REQUIRE(index.find_by_etag("https://example.com/2.mp3", "abc123", 15)
+			== episode);
+		REQUIRE(index.find_by_etag("https://example.com/2.mp3", "abc123", 16)
+			== "");
+		REQUIRE(index.find_by_etag("https://example.com/2.mp3", "", 15) == "");
+		// Other servers can use the same ETag for unrelated files
+		REQUIRE(index.find_by_etag("https://example.net/2.mp3", "abc123", 15)
+			== "");
+		REQUIRE(index.find_by_content(copy) == episode);
+		REQUIRE(index.find_by_content(episode) == "");
+	}
+
+	EnclosureIndex index(index_file);
+	index.load();
+	REQUIRE(index.find_by_url("https://example.com/1.mp3") == episode);
+
+	SECTION("entries whose file changed or disappeared are ignored") {
+		write_file(episode, "different length");
+		REQUIRE(index.find_by_url("https://example.com/1.mp3") == "");
+
+		::unlink(episode.c_str());
+		index.load();
+		REQUIRE(index.find_by_url("https://example.com/1.mp3") == "");
+		REQUIRE(index.find_by_etag("https://example.com/1.mp3", "abc123", 15)
+			== "");
+	}
+}
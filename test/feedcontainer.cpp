@@ -411,6 +411,44 @@ TEST_CASE("Correctly sorts feeds", "[FeedContainer]")
 	}
 }
 
+TEST_CASE("sort_feeds() can sort by the duration of the last reload",
+	"[FeedContainer]")
+{
+	FeedContainer feedcontainer;
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const auto feeds = get_five_empty_feeds(&rsscache);
+	feedcontainer.set_feeds(feeds);
+
+	feeds[0]->set_last_reload_duration(300);
+	feeds[1]->set_last_reload_duration(0);
+	feeds[2]->set_last_reload_duration(5000000);
+	feeds[3]->set_last_reload_duration(42);
+	feeds[4]->set_last_reload_duration(1000);
+
+	SECTION("by reloadtime asc") {
+		cfg.set_configvalue("feed-sort-order", "reloadtime-asc");
+		feedcontainer.sort_feeds(cfg.get_feed_sort_strategy());
+		const auto sorted_feeds = feedcontainer.get_all_feeds();
+		REQUIRE(sorted_feeds[0] == feeds[2]);
+		REQUIRE(sorted_feeds[1] == feeds[4]);
+		REQUIRE(sorted_feeds[2] == feeds[0]);
+		REQUIRE(sorted_feeds[3] == feeds[3]);
+		REQUIRE(sorted_feeds[4] == feeds[1]);
+	}
+
+	SECTION("by reloadtime desc") {
+		cfg.set_configvalue("feed-sort-order", "reloadtime-desc");
+		feedcontainer.sort_feeds(cfg.get_feed_sort_strategy());
+		const auto sorted_feeds = feedcontainer.get_all_feeds();
+		REQUIRE(sorted_feeds[0] == feeds[1]);
+		REQUIRE(sorted_feeds[1] == feeds[3]);
+		REQUIRE(sorted_feeds[2] == feeds[0]);
+		REQUIRE(sorted_feeds[3] == feeds[4]);
+		REQUIRE(sorted_feeds[4] == feeds[2]);
+	}
+}
+
 TEST_CASE("Sorting by firsttag-asc puts empty tags on top", "[FeedContainer]")
 {
 	FeedContainer feedcontainer;
@@ -1,5 +1,7 @@
 #include "fmtstrformatter.h"
 
+#include <vector>
+
 #include "3rd-party/catch.hpp"
 
 using namespace newsboat;
@@ -325,3 +327,46 @@ TEST_CASE("Question mark is treated literally outside of conditionals",
 
 	REQUIRE(fmt.do_format("%x? %y") == "What's the ultimate answer? 42");
 }
+
+TEST_CASE("do_format() with CompiledFormat gives the same results as with "
+	"a format string",
+	"[FmtStrFormatter]")
+{
+	FmtStrFormatter fmt;
+	fmt.register_fmt('a', "AAA");
+	fmt.register_fmt('b', "буква");
+	fmt.register_fmt('m', "");
+
+	const std::vector<std::string> formats = {
+		"",
+		"%%",
+		"<%a> <%5b> | %-5a%%",
+		"%a%> %b",
+		"%?a?%a&no?",
+		"%?m?%m&%-8b?|",
+	};
+	for (const auto& format : formats) {
+		const CompiledFormat compiled(format);
+		REQUIRE(compiled.format() == format);
+		for (const unsigned int width : {0, 3, 20}) {
+			REQUIRE(fmt.do_format(compiled, width) ==
+				fmt.do_format(format, width));
+		}
+	}
+}
+
+TEST_CASE("CompiledFormat can be reused with different values",
+	"[FmtStrFormatter]")
+{
+	const CompiledFormat compiled("%t (%a)");
+
+	FmtStrFormatter first;
+	first.register_fmt('t', "How I Spent My Summer");
+	first.register_fmt('a', "John Doe");
+	REQUIRE(first.do_format(compiled) == "How I Spent My Summer (John Doe)");
+
+	FmtStrFormatter second;
+	second.register_fmt('t', "This Week in Rust");
+	second.register_fmt('a', "Rust Project");
+	REQUIRE(second.do_format(compiled) == "This Week in Rust (Rust Project)");
+}
@@ -0,0 +1,48 @@
+#include "internedstring.h"
+
+#include "3rd-party/catch.hpp"
+
+using namespace newsboat;
+
+TEST_CASE("InternedString holds the value it was constructed with",
+	"[InternedString]")
+{
+	const InternedString empty;
+	REQUIRE(empty.empty());
+	REQUIRE(empty.str() == "");
+
+	const InternedString from_empty("");
+	REQUIRE(from_empty.empty());
+
+	const InternedString url("https://example.com/feed.xml");
+	REQUIRE_FALSE(url.empty());
+	REQUIRE(url.str() == "https://example.com/feed.xml");
+}
+
+TEST_CASE("InternedStrings with the same value share storage",
+	"[InternedString]")
+{
+	const std::string value = "https://example.com/shared.xml";
+	const InternedString a(value);
+	const InternedString b(value);
+	const InternedString c("https://example.com/other.xml");
+
+	REQUIRE(&a.str() == &b.str());
+	REQUIRE(&a.str() != &c.str());
+	REQUIRE(c.str() == "https://example.com/other.xml");
+}
+
+TEST_CASE("InternedString pool forgets values that aren't used anymore",
+	"[InternedString]")
+{
+	const InternedString kept("https://example.com/kept.xml");
+
+	for (unsigned int i = 0; i < 10000; ++i) {
+		InternedString temporary("https://example.com/" + std::to_string(i));
+	}
+
+	REQUIRE(InternedString::pool_size() < 5000);
+	REQUIRE(kept.str() == "https://example.com/kept.xml");
+	REQUIRE(&InternedString("https://example.com/kept.xml").str()
+		== &kept.str());
+}
@@ -0,0 +1,138 @@
+#include "itemprerenderer.h"
+
+#include <chrono>
+#include <thread>
+
+#include "3rd-party/catch.hpp"
+
+#include "cache.h"
+#include "configcontainer.h"
+#include "itemrenderer.h"
+#include "rssfeed.h"
+
+using namespace newsboat;
+
+namespace {
+
+std::shared_ptr<RssItem> make_item(Cache* c,
+	const std::string& guid,
+	const std::string& description)
+{
+	auto item = std::make_shared<RssItem>(c);
+	item->set_guid(guid);
+	item->set_title("Title of " + guid);
+	item->set_description(description);
+	return item;
+}
+
+bool take_with_timeout(ItemPrerenderer& prerenderer,
+	const std::shared_ptr<RssItem>& item,
+	unsigned int text_width,
+	unsigned int window_width,
+	PrerenderedItem& result)
+{
+	// take() only waits for the item that is being rendered right now, so
+	// we have to poll until the worker gets to our item.
+	for (int i = 0; i < 500; ++i) {
+		if (prerenderer.take(item, text_width, window_width, result)) {
+			return true;
+		}
+		prerenderer.schedule({item}, text_width, window_width, nullptr,
+			"article");
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return false;
+}
+
+} // namespace
+
+TEST_CASE("ItemPrerenderer produces the same output as "
+	"item_renderer::to_stfl_list()",
+	"[ItemPrerenderer]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	ItemPrerenderer prerenderer(cfg);
+
+	auto item = make_item(&rsscache, "first",
+			"<p>Hello, <a href='https://example.com/'>world</a>!</p>");
+
+	prerenderer.schedule({item}, 40, 50, nullptr, "article");
+
+	PrerenderedItem result;
+	REQUIRE(take_with_timeout(prerenderer, item, 40, 50, result));
+
+	std::vector<LinkPair> links;
+	const auto expected = item_renderer::to_stfl_list(
+			cfg, item, 40, 50, nullptr, "article", links);
+
+	REQUIRE(result.text == expected.first);
+	REQUIRE(result.num_lines == expected.second);
+	REQUIRE(result.links == links);
+
+	SECTION("Result can only be taken once") {
+		REQUIRE_FALSE(prerenderer.take(item, 40, 50, result));
+	}
+}
+
+TEST_CASE("ItemPrerenderer::take() rejects outdated results",
+	"[ItemPrerenderer]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	ItemPrerenderer prerenderer(cfg);
+
+	auto item = make_item(&rsscache, "guid", "<p>Old content</p>");
+	prerenderer.schedule({item}, 40, 50, nullptr, "article");
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	PrerenderedItem result;
+
+	SECTION("Widths changed") {
+		REQUIRE_FALSE(prerenderer.take(item, 60, 70, result));
+	}
+
+	SECTION("Item changed after it was scheduled") {
+		item->set_description("<p>New content</p>");
+		REQUIRE_FALSE(prerenderer.take(item, 40, 50, result));
+	}
+
+	SECTION("Results are dropped by clear()") {
+		prerenderer.clear();
+		REQUIRE_FALSE(prerenderer.take(item, 40, 50, result));
+	}
+}
+
+TEST_CASE("ItemPrerenderer renders the feed title from when the item was "
+	"scheduled",
+	"[ItemPrerenderer]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	ItemPrerenderer prerenderer(cfg);
+
+	auto feed = std::make_shared<RssFeed>(&rsscache);
+	feed->set_title("Feed title");
+	auto item = make_item(&rsscache, "guid", "<p>Content</p>");
+	item->set_feedptr(feed);
+
+	prerenderer.schedule({item}, 40, 50, nullptr, "article");
+
+	SECTION("The result matches rendering the item directly") {
+		PrerenderedItem result;
+		REQUIRE(take_with_timeout(prerenderer, item, 40, 50, result));
+
+		std::vector<LinkPair> links;
+		const auto expected = item_renderer::to_stfl_list(
+				cfg, item, 40, 50, nullptr, "article", links);
+		REQUIRE(result.text == expected.first);
+	}
+
+	SECTION("A result with an outdated title is rejected") {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		feed->set_title("Renamed feed");
+
+		PrerenderedItem result;
+		REQUIRE_FALSE(prerenderer.take(item, 40, 50, result));
+	}
+}
@@ -546,3 +546,39 @@ TEST_CASE("item_renderer::get_feedtitle() returns item's feed URL "
 	const auto result = item_renderer::get_feedtitle(item);
 	REQUIRE(result == feedurl);
 }
+
+TEST_CASE("item_renderer::to_plain_text_batch() renders every item like "
+	"to_plain_text() and reports them in order",
+	"[item_renderer]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	std::vector<std::shared_ptr<RssItem>> items;
+	std::vector<std::shared_ptr<RssFeed>> feeds;
+	for (int i = 0; i < 20; ++i) {
+		std::shared_ptr<RssItem> item;
+		std::shared_ptr<RssFeed> feed;
+		std::tie(item, feed) = create_test_item(&rsscache);
+		item->set_title(ITEM_TITLE + " #" + std::to_string(i));
+		item->set_description("<p>Article number " + std::to_string(i) +
+			"</p>");
+		items.push_back(item);
+		feeds.push_back(feed);
+	}
+
+	std::vector<size_t> indices;
+	std::vector<std::string> texts;
+	item_renderer::to_plain_text_batch(cfg, items,
+	[&](size_t idx, const std::string& text, bool rendered) {
+		REQUIRE(rendered);
+		indices.push_back(idx);
+		texts.push_back(text);
+	});
+
+	REQUIRE(indices.size() == items.size());
+	for (size_t i = 0; i < items.size(); ++i) {
+		REQUIRE(indices[i] == i);
+		REQUIRE(texts[i] == item_renderer::to_plain_text(cfg, items[i]));
+	}
+}
@@ -0,0 +1,109 @@
+#include "jsonlistparser.h"
+
+#include <vector>
+
+#include "3rd-party/catch.hpp"
+
+using namespace newsboat;
+using json = nlohmann::json;
+
+TEST_CASE("JsonListParser hands out the list's elements one by one",
+	"[JsonListParser]")
+{
+	std::vector<json> items;
+	JsonListParser parser("content", [&](const json& item) {
+		items.push_back(item);
+	});
+
+	const std::string text = R"({
+		"seq": 0,
+		"status": 0,
+		"content": [
+			{"id": 1, "title": "First", "labels": [[1, "a"], [2, "b"]]},
+			{"id": 2, "title": null, "attachments": []},
+			42,
+			"text",
+			[1, 2.5, true]
+		],
+		"extra": {"content": [7, 8]}
+	})";
+
+	json rest;
+	REQUIRE(parser.parse(text, rest));
+
+	REQUIRE(items.size() == 5);
+	REQUIRE(items[0] == json::parse(
+			R"({"id": 1, "title": "First", "labels": [[1, "a"], [2, "b"]]})"));
+	REQUIRE(items[1] == json::parse(
+			R"({"id": 2, "title": null, "attachments": []})"));
+	REQUIRE(items[2] == 42);
+	REQUIRE(items[3] == "text");
+	REQUIRE(items[4] == json::parse("[1, 2.5, true]"));
+
+	SECTION("and keeps the rest of the reply") {
+		REQUIRE(rest == json::parse(
+				R"({"seq": 0, "status": 0, "content": [],
+				"extra": {"content": [7, 8]}})"));
+	}
+}
+
+TEST_CASE("JsonListParser keeps replies without the list as they are",
+	"[JsonListParser]")
+{
+	unsigned int items = 0;
+	JsonListParser parser("content", [&](const json&) {
+		items++;
+	});
+
+	json rest;
+
+	SECTION("Error message instead of a list") {
+		const std::string text =
+			R"({"status": 1, "content": {"error": "NOT_LOGGED_IN"}})";
+		REQUIRE(parser.parse(text, rest));
+		REQUIRE(rest == json::parse(text));
+	}
+
+	SECTION("Top-level array") {
+		REQUIRE(parser.parse("[1, 2, 3]", rest));
+		REQUIRE(rest == json::parse("[1, 2, 3]"));
+	}
+
+	SECTION("Scalar") {
+		REQUIRE(parser.parse("\"content\"", rest));
+		REQUIRE(rest == "content");
+	}
+
+	REQUIRE(items == 0);
+}
+
+TEST_CASE("JsonListParser returns false for invalid JSON", "[JsonListParser]")
+{
+	std::vector<int> ids;
+	JsonListParser parser("stories", [&](const json& item) {
+		ids.push_back(item["id"]);
+	});
+
+	json rest;
+	REQUIRE_FALSE(parser.parse(R"({"stories": [{"id": 1}, {"id": 2}, {"id")",
+			rest));
+	REQUIRE(ids == std::vector<int>({1, 2}));
+
+	REQUIRE_FALSE(parser.parse("", rest));
+}
+
+TEST_CASE("JsonListParser passes on exceptions thrown by the handler",
+	"[JsonListParser]")
+{
+	JsonListParser parser("items", [](const json& item) {
+		const std::string title = item.at("title");
+		(void)title;
+	});
+
+	json rest;
+	REQUIRE(parser.parse(R"({"items": [{"title": "fine"}]})", rest));
+	REQUIRE_THROWS_AS(parser.parse(R"({"items": [{"title": 1}]})", rest),
+		json::type_error);
+	REQUIRE_THROWS_AS(parser.parse(R"({"items": [{}]})", rest),
+		json::out_of_range);
+}
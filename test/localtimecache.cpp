@@ -0,0 +1,45 @@
+#include "localtimecache.h"
+
+#include "3rd-party/catch.hpp"
+
+#include "test-helpers.h"
+#include "utils.h"
+
+using namespace newsboat;
+
+TEST_CASE("LocalTimeCache::format() returns the same string as "
+	"utils::mt_strf_localtime()",
+	"[LocalTimeCache]")
+{
+	TestHelpers::EnvVar tzEnv("TZ");
+	tzEnv.set("UTC");
+
+	LocalTimeCache cache;
+
+	// Sun Sep 30 19:34:25 UTC 2018
+	const time_t t = 1538336065;
+
+	REQUIRE(cache.format("%F %T", t) == "2018-09-30 19:34:25");
+	REQUIRE(cache.format("%F %T", t) == utils::mt_strf_localtime("%F %T", t));
+	REQUIRE(cache.format("%F %T", t + 60) == "2018-09-30 19:35:25");
+
+	SECTION("Changing the format drops old results") {
+		REQUIRE(cache.format("%d %b", t) == "30 Sep");
+		REQUIRE(cache.format("%F %T", t) == "2018-09-30 19:34:25");
+	}
+}
+
+TEST_CASE("LocalTimeCache keeps working after it fills up",
+	"[LocalTimeCache]")
+{
+	TestHelpers::EnvVar tzEnv("TZ");
+	tzEnv.set("UTC");
+
+	LocalTimeCache cache(2);
+
+	const time_t day = 24 * 60 * 60;
+	for (time_t t = 0; t < 5 * day; t += day) {
+		REQUIRE(cache.format("%F", t) == utils::mt_strf_localtime("%F", t));
+	}
+	REQUIRE(cache.format("%F", 0) == "1970-01-01");
+}
@@ -0,0 +1,125 @@
+#include "logqueue.h"
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "3rd-party/catch.hpp"
+
+using namespace newsboat;
+
+TEST_CASE("LogQueue rounds its capacity up to a power of two", "[LogQueue]")
+{
+	REQUIRE(LogQueue(0).capacity() == 2);
+	REQUIRE(LogQueue(1).capacity() == 2);
+	REQUIRE(LogQueue(8).capacity() == 8);
+	REQUIRE(LogQueue(100).capacity() == 128);
+}
+
+TEST_CASE("The smallest LogQueue doesn't overwrite messages that weren't "
+	"popped yet",
+	"[LogQueue]")
+{
+	LogQueue queue(1);
+	Level level;
+	std::string message;
+
+	REQUIRE(queue.push(Level::DEBUG, "first"));
+	REQUIRE(queue.push(Level::ERROR, "second"));
+	REQUIRE_FALSE(queue.push(Level::INFO, "third"));
+	REQUIRE(queue.take_dropped() == 1);
+
+	REQUIRE(queue.pop(level, message));
+	REQUIRE(message == "first");
+	REQUIRE(queue.pop(level, message));
+	REQUIRE(message == "second");
+	REQUIRE_FALSE(queue.pop(level, message));
+}
+
+TEST_CASE("LogQueue::pop() returns messages in the order they were pushed",
+	"[LogQueue]")
+{
+	LogQueue queue(4);
+	Level level;
+	std::string message;
+
+	REQUIRE_FALSE(queue.pop(level, message));
+
+	REQUIRE(queue.push(Level::DEBUG, "first"));
+	REQUIRE(queue.push(Level::ERROR, "second"));
+	REQUIRE(queue.pushed() == 2);
+
+	REQUIRE(queue.pop(level, message));
+	REQUIRE(level == Level::DEBUG);
+	REQUIRE(message == "first");
+
+	REQUIRE(queue.pop(level, message));
+	REQUIRE(level == Level::ERROR);
+	REQUIRE(message == "second");
+
+	REQUIRE_FALSE(queue.pop(level, message));
+}
+
+TEST_CASE("LogQueue::push() drops messages when the queue is full",
+	"[LogQueue]")
+{
+	LogQueue queue(2);
+	Level level;
+	std::string message;
+
+	REQUIRE(queue.push(Level::INFO, "1"));
+	REQUIRE(queue.push(Level::INFO, "2"));
+	REQUIRE_FALSE(queue.push(Level::INFO, "3"));
+	REQUIRE_FALSE(queue.push(Level::INFO, "4"));
+	REQUIRE(queue.take_dropped() == 2);
+	REQUIRE(queue.take_dropped() == 0);
+
+	SECTION("slots can be reused once they're popped") {
+		REQUIRE(queue.pop(level, message));
+		REQUIRE(message == "1");
+		REQUIRE(queue.push(Level::INFO, "5"));
+
+		REQUIRE(queue.pop(level, message));
+		REQUIRE(message == "2");
+		REQUIRE(queue.pop(level, message));
+		REQUIRE(message == "5");
+		REQUIRE_FALSE(queue.pop(level, message));
+	}
+}
+
+TEST_CASE("LogQueue doesn't lose or duplicate messages pushed from many "
+	"threads", "[LogQueue]")
+{
+	const unsigned int threads = 4;
+	const unsigned int per_thread = 10000;
+	LogQueue queue(64);
+
+	std::vector<std::thread> producers;
+	for (unsigned int t = 0; t < threads; ++t) {
+		producers.emplace_back([&queue, t]() {
+			for (unsigned int i = 0; i < per_thread; ++i) {
+				const auto message =
+					std::to_string(t) + ":" + std::to_string(i);
+				while (!queue.push(Level::DEBUG, message)) {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	std::set<std::string> received;
+	Level level;
+	std::string message;
+	while (received.size() < threads * per_thread) {
+		if (queue.pop(level, message)) {
+			REQUIRE(received.insert(message).second);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+
+	for (auto& producer : producers) {
+		producer.join();
+	}
+	REQUIRE_FALSE(queue.pop(level, message));
+}
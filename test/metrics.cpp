@@ -0,0 +1,113 @@
+#include "metrics.h"
+
+#include "3rd-party/catch.hpp"
+
+using namespace newsboat;
+
+TEST_CASE("Counter::increment() adds to the value", "[Metrics]")
+{
+	Counter counter;
+	REQUIRE(counter.get() == 0);
+
+	counter.increment();
+	counter.increment(41);
+	REQUIRE(counter.get() == 42);
+
+	counter.reset();
+	REQUIRE(counter.get() == 0);
+}
+
+TEST_CASE("Histogram keeps count, total and maximum", "[Metrics]")
+{
+	Histogram histogram;
+	REQUIRE(histogram.count() == 0);
+	REQUIRE(histogram.percentile(50) == 0);
+
+	histogram.record(10);
+	histogram.record(1000);
+	histogram.record(30);
+
+	REQUIRE(histogram.count() == 3);
+	REQUIRE(histogram.total() == 1040);
+	REQUIRE(histogram.max() == 1000);
+
+	histogram.reset();
+	REQUIRE(histogram.count() == 0);
+	REQUIRE(histogram.total() == 0);
+	REQUIRE(histogram.max() == 0);
+}
+
+TEST_CASE("Histogram::percentile() returns an upper bound within a factor "
+	"of two",
+	"[Metrics]")
+{
+	Histogram histogram;
+	for (int i = 0; i < 90; ++i) {
+		histogram.record(100);
+	}
+	for (int i = 0; i < 10; ++i) {
+		histogram.record(5000);
+	}
+
+	const auto p50 = histogram.percentile(50);
+	REQUIRE(p50 >= 100);
+	REQUIRE(p50 < 200);
+
+	const auto p90 = histogram.percentile(90);
+	REQUIRE(p90 >= 100);
+	REQUIRE(p90 < 200);
+
+	// Never larger than the largest sample
+	REQUIRE(histogram.percentile(99) == 5000);
+	REQUIRE(histogram.percentile(100) == 5000);
+}
+
+TEST_CASE("MetricsRegistry returns the same metric for the same name",
+	"[Metrics]")
+{
+	MetricsRegistry registry;
+
+	REQUIRE(&registry.counter("a") == &registry.counter("a"));
+	REQUIRE(&registry.counter("a") != &registry.counter("b"));
+	REQUIRE(&registry.histogram("a") == &registry.histogram("a"));
+	REQUIRE(&registry.gauge("a") == &registry.gauge("a"));
+}
+
+TEST_CASE("MetricsRegistry::to_json() lists all metrics", "[Metrics]")
+{
+	MetricsRegistry registry;
+
+	SECTION("Empty registry") {
+		REQUIRE(registry.to_json() ==
+			R"({"counters":{},"gauges":{},"histograms":{}})");
+	}
+
+	SECTION("Registry with some metrics") {
+		registry.counter("fetch.bytes").increment(512);
+		registry.counter("reload.errors");
+		registry.gauge("feeds").set(3);
+		registry.histogram("parse").record(3);
+
+		REQUIRE(registry.to_json() ==
+			R"({"counters":{"fetch.bytes":512,"reload.errors":0},)"
+			R"("gauges":{"feeds":3},)"
+			R"("histograms":{"parse":{"count":1,"total_us":3,)"
+			R"("max_us":3,"p50_us":3,"p90_us":3,"p99_us":3}}})");
+	}
+
+	SECTION("reset() zeroes the values, but keeps the names") {
+		registry.counter("fetch.bytes").increment(512);
+		registry.reset();
+		REQUIRE(registry.to_json() ==
+			R"({"counters":{"fetch.bytes":0},"gauges":{},"histograms":{}})");
+	}
+}
+
+TEST_CASE("ScopeTimer records its lifetime into a histogram", "[Metrics]")
+{
+	Histogram histogram;
+	{
+		ScopeTimer timer(histogram);
+	}
+	REQUIRE(histogram.count() == 1);
+}
@@ -79,3 +79,34 @@ TEST_CASE("reload removes downloads iff they are marked as finished or deleted",
 		}
 	}
 }
+
+TEST_CASE("reload loads each URL from the queue file only once",
+	"[QueueLoader]")
+{
+	auto empty_callback = []() {};
+	newsboat::ConfigContainer cfg;
+	TestHelpers::TempFile queueFile;
+
+	{
+		std::ofstream f(queueFile.get_path());
+		f << "https://example.com/1.mp3 \"/tmp/1.mp3\"\n";
+		f << "https://example.com/2.mp3 \"/tmp/2.mp3\"\n";
+		f << "https://example.com/1.mp3 \"/tmp/1-again.mp3\"\n";
+		f << "https://example.com/3.mp3 \"/tmp/3.mp3\"\n";
+	}
+
+	QueueLoader queue_loader(queueFile.get_path(), cfg, empty_callback);
+
+	std::vector<Download> downloads;
+	downloads.emplace_back(empty_callback);
+	downloads.back().set_url("https://example.com/3.mp3");
+	downloads.back().set_status(DlStatus::QUEUED);
+
+	queue_loader.reload(downloads);
+
+	REQUIRE(downloads.size() == 3);
+	REQUIRE(downloads[0].url() == "https://example.com/3.mp3");
+	REQUIRE(downloads[1].url() == "https://example.com/1.mp3");
+	REQUIRE(downloads[1].filename() == "/tmp/1.mp3");
+	REQUIRE(downloads[2].url() == "https://example.com/2.mp3");
+}
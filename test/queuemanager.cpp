@@ -0,0 +1,142 @@
+#include "queuemanager.h"
+
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "3rd-party/catch.hpp"
+#include "cache.h"
+#include "configcontainer.h"
+#include "configpaths.h"
+#include "rssfeed.h"
+#include "rssitem.h"
+#include "test-helpers.h"
+#include "utils.h"
+
+using namespace newsboat;
+
+namespace {
+
+std::vector<std::string> read_lines(const std::string& path)
+{
+	std::vector<std::string> lines;
+	std::ifstream f(path);
+	std::string line;
+	while (std::getline(f, line)) {
+		lines.push_back(line);
+	}
+	return lines;
+}
+
+bool starts_with(const std::string& str, const std::string& prefix)
+{
+	return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::shared_ptr<RssItem> make_item(Cache* c, const std::string& url)
+{
+	auto item = std::make_shared<RssItem>(c);
+	item->set_guid(url);
+	item->set_title("Episode");
+	item->set_enclosure_url(url);
+	return item;
+}
+
+/// Points ConfigPaths at a temporary home directory
+class QueueFixture {
+public:
+	QueueFixture()
+		: home("HOME")
+		, xdg_config("XDG_CONFIG_HOME")
+		, xdg_data("XDG_DATA_HOME")
+	{
+		REQUIRE(0 == utils::mkdir_parents(tmp.get_path() + ".newsboat",
+				0700));
+		home.set(tmp.get_path());
+		xdg_config.unset();
+		xdg_data.unset();
+	}
+
+	TestHelpers::TempDir tmp;
+	TestHelpers::EnvVar home;
+	TestHelpers::EnvVar xdg_config;
+	TestHelpers::EnvVar xdg_data;
+};
+
+const std::string URL_A = "https://example.com/a.mp3";
+const std::string URL_B = "https://example.com/b.mp3";
+const std::string URL_C = "https://example.com/c.mp3";
+
+} // namespace
+
+TEST_CASE("QueueManager::enqueue_url() adds each URL to the queue file once",
+	"[QueueManager]")
+{
+	QueueFixture fixture;
+	ConfigPaths paths;
+	REQUIRE(paths.initialized());
+	ConfigContainer cfg;
+	cfg.set_configvalue("download-path", fixture.tmp.get_path());
+	Cache rsscache(":memory:", &cfg);
+	auto feed = std::make_shared<RssFeed>(&rsscache);
+
+	QueueManager queue_manager(&cfg, &paths);
+	queue_manager.enqueue_url(make_item(&rsscache, URL_A), feed);
+	queue_manager.enqueue_url(make_item(&rsscache, URL_B), feed);
+	queue_manager.enqueue_url(make_item(&rsscache, URL_A), feed);
+
+	const auto lines = read_lines(paths.queue_file());
+	REQUIRE(lines.size() == 2);
+	REQUIRE(starts_with(lines[0], URL_A + " "));
+	REQUIRE(starts_with(lines[1], URL_B + " "));
+
+	SECTION("URLs already in the file are known to a new QueueManager") {
+		QueueManager another(&cfg, &paths);
+		another.enqueue_url(make_item(&rsscache, URL_B), feed);
+		REQUIRE(read_lines(paths.queue_file()).size() == 2);
+	}
+}
+
+TEST_CASE("QueueManager notices when someone else changes the queue file",
+	"[QueueManager]")
+{
+	QueueFixture fixture;
+	ConfigPaths paths;
+	REQUIRE(paths.initialized());
+	ConfigContainer cfg;
+	cfg.set_configvalue("download-path", fixture.tmp.get_path());
+	Cache rsscache(":memory:", &cfg);
+	auto feed = std::make_shared<RssFeed>(&rsscache);
+
+	QueueManager queue_manager(&cfg, &paths);
+	queue_manager.enqueue_url(make_item(&rsscache, URL_A), feed);
+	const auto lines = read_lines(paths.queue_file());
+	REQUIRE(lines.size() == 1);
+
+	SECTION("Rewritten right away, with the same size") {
+		// Like podboat removing the download and another one being
+		// queued, all within the same second
+		const std::string replaced =
+			URL_C + lines[0].substr(URL_A.size());
+		std::ofstream(paths.queue_file(), std::ofstream::trunc)
+				<< replaced << "\n";
+
+		queue_manager.enqueue_url(make_item(&rsscache, URL_A), feed);
+
+		const auto new_lines = read_lines(paths.queue_file());
+		REQUIRE(new_lines.size() == 2);
+		REQUIRE(new_lines[0] == replaced);
+		REQUIRE(starts_with(new_lines[1], URL_A + " "));
+	}
+
+	SECTION("Removed") {
+		REQUIRE(::unlink(paths.queue_file().c_str()) == 0);
+
+		queue_manager.enqueue_url(make_item(&rsscache, URL_A), feed);
+
+		const auto new_lines = read_lines(paths.queue_file());
+		REQUIRE(new_lines.size() == 1);
+		REQUIRE(starts_with(new_lines[0], URL_A + " "));
+	}
+}
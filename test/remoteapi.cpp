@@ -24,6 +24,8 @@ public:
 	{
 		return get_credentials(scope, name).pass;
 	}
+	using RemoteApi::greader_delta_url;
+	using RemoteApi::parse_greader_item_refs;
 	bool authenticate()
 	{
 		throw 0;
@@ -118,3 +120,75 @@ TEST_CASE("eval_password() returns the first line of command's output",
 	// following test will wait for user input and block tests
 	// REQUIRE(RemoteApi->eval_password("read password") == "");
 }
+
+TEST_CASE("greader_delta_url() asks for articles newer than given time",
+	"[RemoteApi]")
+{
+	const std::string feedurl =
+		"https://www.inoreader.com/reader/atom/"
+		"feed%2Fhttp%3A%2F%2Fexample.com%2Ffeed?n=20";
+
+	REQUIRE(test_api::greader_delta_url(feedurl, 1581847200, "") ==
+		feedurl + "&ot=1581847200");
+	REQUIRE(test_api::greader_delta_url(feedurl, 1581847200, "Ab+3/De=") ==
+		feedurl + "&ot=1581847200&c=Ab%2B3%2FDe%3D");
+	REQUIRE(test_api::greader_delta_url(
+			"https://theoldreader.com/reader/atom/feed/1", 5, "") ==
+		"https://theoldreader.com/reader/atom/feed/1?ot=5");
+}
+
+TEST_CASE("parse_greader_item_refs() returns Atom IDs of the articles",
+	"[RemoteApi]")
+{
+	std::unordered_set<std::string> guids;
+
+	SECTION("decimal IDs are turned into 16 hexadecimal digits") {
+		REQUIRE(test_api::parse_greader_item_refs(
+				R"({"items":[],"itemRefs":[)"
+				R"({"id":"21945486699","directStreamIds":[]},)"
+				R"({"id":"1"}]})",
+				guids));
+		REQUIRE(guids.size() == 2);
+		REQUIRE(guids.count(
+				"tag:google.com,2005:reader/item/000000051c0d8d6b") == 1);
+		REQUIRE(guids.count(
+				"tag:google.com,2005:reader/item/0000000000000001") == 1);
+	}
+
+	SECTION("hexadecimal IDs are only prefixed") {
+		REQUIRE(test_api::parse_greader_item_refs(
+				R"({"itemRefs":[{"id":"5469e4df091452f4b5000ded"}]})",
+				guids));
+		REQUIRE(guids.size() == 1);
+		REQUIRE(guids.count("tag:google.com,2005:reader/item/"
+				"5469e4df091452f4b5000ded") == 1);
+	}
+
+	SECTION("an empty stream is an empty list") {
+		REQUIRE(test_api::parse_greader_item_refs(
+				R"({"itemRefs":[]})", guids));
+		REQUIRE(guids.empty());
+	}
+
+	SECTION("an empty stream without itemRefs is an empty list") {
+		REQUIRE(test_api::parse_greader_item_refs(
+				R"({"items":[]})", guids));
+		REQUIRE(guids.empty());
+	}
+
+	SECTION("an error message isn't an empty list") {
+		REQUIRE_FALSE(test_api::parse_greader_item_refs(
+				R"({"error":"Stream not found"})", guids));
+		REQUIRE_FALSE(test_api::parse_greader_item_refs(
+				R"({"errors":["Authorization required"]})", guids));
+		REQUIRE_FALSE(test_api::parse_greader_item_refs("{}", guids));
+		REQUIRE_FALSE(test_api::parse_greader_item_refs("[]", guids));
+	}
+
+	SECTION("invalid replies are rejected") {
+		REQUIRE_FALSE(test_api::parse_greader_item_refs("Error=Unauthorized",
+				guids));
+		REQUIRE_FALSE(test_api::parse_greader_item_refs(
+				R"({"itemRefs":"none"})", guids));
+	}
+}
@@ -0,0 +1,371 @@
+#include "remotesyncqueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#include "3rd-party/catch.hpp"
+#include "cache.h"
+#include "configcontainer.h"
+#include "remoteapi.h"
+#include "rssfeed.h"
+#include "rssitem.h"
+#include "test-helpers.h"
+
+using namespace newsboat;
+
+namespace {
+
+class RecordingApi : public RemoteApi {
+public:
+	explicit RecordingApi(ConfigContainer* cfg)
+		: RemoteApi(cfg)
+		, offline(false)
+	{
+	}
+
+	bool authenticate() override
+	{
+		return true;
+	}
+	std::vector<TaggedFeedUrl> get_subscribed_urls() override
+	{
+		return {};
+	}
+	void add_custom_headers(curl_slist**) override {}
+
+	bool mark_all_read(const std::string& feedurl) override
+	{
+		return record("all " + feedurl, {feedurl});
+	}
+	bool mark_all_read_until(const std::string& feedurl,
+		const std::string& newest,
+		int64_t marked_at) override
+	{
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			marked_at_values.push_back(marked_at);
+		}
+		if (newest.empty()) {
+			return mark_all_read(feedurl);
+		}
+		return record("all " + feedurl + " up to " + newest, {feedurl});
+	}
+	std::string get_newest_article(
+		const std::vector<std::string>& guids) override
+	{
+		std::string newest;
+		for (const auto& guid : guids) {
+			newest = std::max(newest, guid);
+		}
+		return newest;
+	}
+	bool mark_article_read(const std::string& guid, bool read) override
+	{
+		return record((read ? "read " : "unread ") + guid, {guid});
+	}
+	bool mark_articles_read(const std::vector<std::string>& guids,
+		bool read) override
+	{
+		std::string call = read ? "read" : "unread";
+		for (const auto& guid : guids) {
+			call += " " + guid;
+		}
+		return record(call, guids);
+	}
+	bool update_article_flags(const std::string& oldflags,
+		const std::string& newflags,
+		const std::string& guid) override
+	{
+		return record("flags " + guid + " " + oldflags + "->" + newflags,
+		{guid});
+	}
+
+	std::vector<std::string> get_calls()
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		return calls;
+	}
+
+	std::vector<int64_t> get_marked_at_values()
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		return marked_at_values;
+	}
+
+	/// Requests fail as if the server couldn't be reached
+	bool offline;
+	/// Requests involving these articles or feeds are refused
+	std::set<std::string> rejected;
+
+private:
+	bool record(const std::string& call,
+		const std::vector<std::string>& targets)
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		calls.push_back(call);
+		if (offline) {
+			set_request_error(RequestError::CONNECTION);
+			return false;
+		}
+		for (const auto& target : targets) {
+			if (rejected.count(target) != 0) {
+				set_request_error(RequestError::REJECTED);
+				return false;
+			}
+		}
+		set_request_error(RequestError::NONE);
+		return true;
+	}
+
+	std::mutex mtx;
+	std::vector<std::string> calls;
+	std::vector<int64_t> marked_at_values;
+};
+
+int64_t now_usec()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void add_items(Cache& cache,
+	const std::string& feedurl,
+	const std::vector<std::string>& guids)
+{
+	auto feed = std::make_shared<RssFeed>(&cache);
+	feed->set_rssurl(feedurl);
+	for (const auto& guid : guids) {
+		auto item = std::make_shared<RssItem>(&cache);
+		item->set_guid(guid);
+		item->set_feedurl(feedurl);
+		feed->add_item(item);
+	}
+	cache.externalize_rssfeed(feed, false);
+}
+
+} // namespace
+
+TEST_CASE("RemoteSyncQueue coalesces changes and sends them in batches",
+	"[RemoteSyncQueue]")
+{
+	ConfigContainer cfg;
+	Cache cache(":memory:", &cfg);
+	RecordingApi api(&cfg);
+	RemoteSyncQueue queue(&cache, &api);
+
+	queue.mark_article_read("a", true);
+	queue.mark_article_read("b", true);
+	queue.mark_article_read("c", true);
+	queue.mark_article_read("b", false);
+	queue.update_article_flags("", "s", "a");
+	queue.update_article_flags("s", "sp", "a");
+	queue.update_article_flags("", "s", "c");
+	queue.update_article_flags("s", "", "c");
+	queue.mark_all_read("feed1");
+	queue.mark_all_read("feed1");
+	queue.mark_article_read("a", false);
+	queue.mark_all_read("feed2");
+
+	REQUIRE(queue.flush());
+
+	const std::vector<std::string> expected = {
+		"read a c",
+		"unread b",
+		"flags a ->sp",
+		"all feed1",
+		"unread a",
+		"all feed2",
+	};
+	REQUIRE(api.get_calls() == expected);
+	REQUIRE(cache.get_remote_changes(100).empty());
+}
+
+TEST_CASE("RemoteSyncQueue keeps changes that couldn't be sent",
+	"[RemoteSyncQueue]")
+{
+	TestHelpers::TempFile dbfile;
+	ConfigContainer cfg;
+	RecordingApi api(&cfg);
+
+	{
+		Cache cache(dbfile.get_path(), &cfg);
+		RemoteSyncQueue queue(&cache, &api);
+		api.offline = true;
+		queue.mark_article_read("a", true);
+		queue.mark_all_read("feed");
+
+		REQUIRE_FALSE(queue.flush());
+		REQUIRE(api.get_calls().size() == 1);
+
+		const auto changes = cache.get_remote_changes(100);
+		REQUIRE(changes.size() == 2);
+		REQUIRE(changes[0].action == RemoteChange::Action::MARK_READ);
+		REQUIRE(changes[0].target == "a");
+	}
+
+	SECTION("and sends them after a restart") {
+		api.offline = false;
+		Cache cache(dbfile.get_path(), &cfg);
+		RemoteSyncQueue queue(&cache, &api);
+		REQUIRE(queue.flush());
+
+		const std::vector<std::string> expected = {
+			"read a",
+			"read a",
+			"all feed",
+		};
+		REQUIRE(api.get_calls() == expected);
+	}
+}
+
+TEST_CASE("RemoteSyncQueue doesn't count attempts while the server can't "
+	"be reached", "[RemoteSyncQueue]")
+{
+	ConfigContainer cfg;
+	Cache cache(":memory:", &cfg);
+	RecordingApi api(&cfg);
+	RemoteSyncQueue queue(&cache, &api);
+
+	api.offline = true;
+	queue.mark_article_read("a", true);
+	queue.mark_article_read("b", true);
+	queue.update_article_flags("", "s", "a");
+
+	for (int i = 0; i < 20; i++) {
+		REQUIRE_FALSE(queue.flush());
+	}
+
+	const auto changes = cache.get_remote_changes(100);
+	REQUIRE(changes.size() == 3);
+	for (const auto& change : changes) {
+		REQUIRE(change.attempts == 0);
+	}
+}
+
+TEST_CASE("RemoteSyncQueue sends the articles of a refused batch one by one",
+	"[RemoteSyncQueue]")
+{
+	ConfigContainer cfg;
+	Cache cache(":memory:", &cfg);
+	RecordingApi api(&cfg);
+	RemoteSyncQueue queue(&cache, &api);
+
+	api.rejected = {"b"};
+	queue.mark_article_read("a", true);
+	queue.mark_article_read("b", true);
+	queue.mark_article_read("c", true);
+	queue.update_article_flags("", "s", "c");
+
+	REQUIRE_FALSE(queue.flush());
+
+	const std::vector<std::string> expected = {
+		"read a b c",
+		"read a",
+		"read b",
+		"read c",
+		"flags c ->s",
+	};
+	REQUIRE(api.get_calls() == expected);
+
+	const auto changes = cache.get_remote_changes(100);
+	REQUIRE(changes.size() == 1);
+	REQUIRE(changes[0].target == "b");
+	REQUIRE(changes[0].attempts == 1);
+}
+
+TEST_CASE("RemoteSyncQueue tells the user about changes it gives up on",
+	"[RemoteSyncQueue]")
+{
+	ConfigContainer cfg;
+	Cache cache(":memory:", &cfg);
+	RecordingApi api(&cfg);
+	std::vector<std::string> messages;
+	RemoteSyncQueue queue(&cache, &api, [&](const std::string& message) {
+		messages.push_back(message);
+	});
+
+	api.rejected = {"feed"};
+	queue.mark_all_read("feed");
+	queue.mark_article_read("a", true);
+
+	for (int i = 0; i < 9; i++) {
+		REQUIRE_FALSE(queue.flush());
+	}
+	REQUIRE(messages.empty());
+	REQUIRE(cache.get_remote_changes(100).size() == 2);
+
+	REQUIRE_FALSE(queue.flush());
+	REQUIRE(messages.size() == 1);
+	REQUIRE(messages[0].find("feed") != std::string::npos);
+
+	REQUIRE(queue.flush());
+	const auto calls = api.get_calls();
+	REQUIRE(calls.back() == "read a");
+}
+
+TEST_CASE("RemoteSyncQueue tells the API which articles the user saw when "
+	"marking a feed read", "[RemoteSyncQueue]")
+{
+	ConfigContainer cfg;
+	Cache cache(":memory:", &cfg);
+	RecordingApi api(&cfg);
+	RemoteSyncQueue queue(&cache, &api);
+
+	add_items(cache, "feed", {"a", "b"});
+	const int64_t before = now_usec();
+	queue.mark_all_read("feed");
+	const int64_t after = now_usec();
+
+	SECTION("articles that arrive later don't count") {
+		add_items(cache, "feed", {"c"});
+		REQUIRE(queue.flush());
+
+		const std::vector<std::string> expected = {"all feed up to b"};
+		REQUIRE(api.get_calls() == expected);
+		const auto marked_at = api.get_marked_at_values();
+		REQUIRE(marked_at.size() == 1);
+		REQUIRE(marked_at[0] >= before);
+		REQUIRE(marked_at[0] <= after);
+	}
+
+	SECTION("the last of consecutive changes is sent") {
+		add_items(cache, "feed", {"c"});
+		queue.mark_all_read("feed");
+		REQUIRE(queue.flush());
+
+		const std::vector<std::string> expected = {"all feed up to c"};
+		REQUIRE(api.get_calls() == expected);
+		const auto marked_at = api.get_marked_at_values();
+		REQUIRE(marked_at.size() == 1);
+		REQUIRE(marked_at[0] >= after);
+	}
+}
+
+TEST_CASE("Cache drops remote changes that failed too many times",
+	"[Cache]")
+{
+	ConfigContainer cfg;
+	Cache cache(":memory:", &cfg);
+
+	RemoteChange change;
+	change.target = "a";
+	cache.queue_remote_change(change);
+	change.target = "b";
+	cache.queue_remote_change(change);
+
+	auto changes = cache.get_remote_changes(100);
+	REQUIRE(changes.size() == 2);
+	const std::vector<int64_t> first = {changes[0].id};
+
+	REQUIRE(cache.fail_remote_changes(first, 2) == 0);
+	REQUIRE(cache.fail_remote_changes(first, 2) == 1);
+	changes = cache.get_remote_changes(100);
+	REQUIRE(changes.size() == 1);
+	REQUIRE(changes[0].target == "b");
+
+	cache.remove_remote_changes({changes[0].id});
+	REQUIRE(cache.get_remote_changes(100).empty());
+}
@@ -393,3 +393,40 @@ TEST_CASE(
 	f.set_rssurl("query:Title:unread = \"yes\" and age between 0:7");
 	REQUIRE(f.is_query_feed());
 }
+
+TEST_CASE("RssFeed::get_item_by_guid() finds items that are in the feed",
+	"[rss]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	RssFeed f(&rsscache);
+
+	auto make_item = [&](const std::string& guid, const std::string& title) {
+		const auto item = std::make_shared<RssItem>(&rsscache);
+		item->set_guid(guid);
+		item->set_title(title);
+		return item;
+	};
+
+	f.add_item(make_item("first", "First"));
+	f.add_item(make_item("second", "Second"));
+	REQUIRE(f.get_item_by_guid("first")->title() == "First");
+	REQUIRE(f.get_item_by_guid("second")->title() == "Second");
+
+	SECTION("later items replace earlier ones with the same GUID") {
+		f.add_item(make_item("first", "Newer first"));
+		REQUIRE(f.get_item_by_guid("first")->title() == "Newer first");
+
+		// Dropping the earlier item doesn't break the lookup
+		f.erase_item(f.items().begin());
+		f.add_item(make_item("first", "Newest first"));
+		REQUIRE(f.get_item_by_guid("first")->title() == "Newest first");
+		REQUIRE(f.get_item_by_guid("second")->title() == "Second");
+	}
+
+	SECTION("erased items can't be found anymore") {
+		f.erase_item(f.items().begin());
+		REQUIRE(f.get_item_by_guid("first")->guid().empty());
+		REQUIRE(f.get_item_by_guid("second")->title() == "Second");
+	}
+}
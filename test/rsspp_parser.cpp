@@ -214,3 +214,40 @@ TEST_CASE("Extracts data from Atom 1.0", "[rsspp::Parser]")
 	REQUIRE(f.items[2].base ==
 		"http://example.com/content/atom_testing.html");
 }
+
+TEST_CASE("Extracts continuation token from Google Reader-style streams",
+	"[rsspp::Parser]")
+{
+	rsspp::Parser p;
+	rsspp::Feed f;
+
+	REQUIRE_NOTHROW(f = p.parse_file("data/greader-stream.xml"));
+
+	REQUIRE(f.rss_version == rsspp::Feed::ATOM_1_0);
+	REQUIRE(f.continuation == "Ab3De7gH");
+	REQUIRE(f.items.size() == 2u);
+	REQUIRE(f.items[0].guid ==
+		"tag:google.com,2005:reader/item/000000051c0d8d6b");
+	REQUIRE(f.items[0].labels.size() == 2u);
+	REQUIRE(f.items[0].labels[1] == "read");
+
+	SECTION("and leaves it empty for other feeds") {
+		REQUIRE_NOTHROW(f = p.parse_file("data/atom10_1.xml"));
+		REQUIRE(f.continuation.empty());
+	}
+}
+
+TEST_CASE("Parser can be used for several documents in a row",
+	"[rsspp::Parser]")
+{
+	rsspp::Parser p;
+	rsspp::Feed f;
+
+	REQUIRE_NOTHROW(f = p.parse_file("data/rss20_1.xml"));
+	REQUIRE(f.rss_version == rsspp::Feed::RSS_2_0);
+
+	REQUIRE_NOTHROW(f = p.parse_file("data/atom10_1.xml"));
+	REQUIRE(f.rss_version == rsspp::Feed::ATOM_1_0);
+	REQUIRE(f.title == "test atom");
+	REQUIRE(f.items.size() == 3u);
+}
@@ -2,6 +2,8 @@
 
 #include "3rd-party/catch.hpp"
 
+#include "utils.h"
+
 using namespace newsboat;
 
 TEST_CASE("lines marked as `wrappable` are wrapped to fit width",
@@ -247,3 +249,43 @@ TEST_CASE(
 		REQUIRE(result.second == expected_count);
 	}
 }
+
+TEST_CASE("stfl_text_width() agrees with utils::strwidth_stfl()",
+	"[TextFormatter]")
+{
+	const std::vector<std::string> inputs = {
+		"",
+		"ASCII only",
+		"tab\tand control\x01 characters",
+		"<b>bold</> and <>escaped",
+		"dangling <",
+		"<<<>>>",
+		"つれづれなるままに",
+		"mixed: naïve 日本語 <u>text</>",
+	};
+
+	for (const auto& input : inputs) {
+		INFO("input: " << input);
+		REQUIRE(stfl_text_width(input) == utils::strwidth_stfl(input));
+	}
+}
+
+TEST_CASE("wrap_line() doesn't count STFL tags towards line width",
+	"[TextFormatter]")
+{
+	const std::vector<std::string> expected = {
+		"<0>lorem</> ipsum ",
+		"<>dolor",
+	};
+	REQUIRE(wrap_line("<0>lorem</> ipsum <>dolor", 12) == expected);
+}
+
+TEST_CASE("wrap_line() splits long words without breaking STFL tags",
+	"[TextFormatter]")
+{
+	const std::vector<std::string> expected = {
+		"ab<0>cd",
+		"ef</>gh",
+	};
+	REQUIRE(wrap_line("ab<0>cdef</>gh", 4) == expected);
+}
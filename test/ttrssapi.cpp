@@ -0,0 +1,279 @@
+#include "ttrssapi.h"
+
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "3rd-party/catch.hpp"
+#include "3rd-party/json.hpp"
+#include "cache.h"
+#include "configcontainer.h"
+#include "rss/feed.h"
+#include "rssfeed.h"
+#include "rssparser.h"
+
+using namespace newsboat;
+
+using json = nlohmann::json;
+
+namespace {
+
+/// Answers getHeadlines from a list of articles instead of a server
+class FakeTtRssApi : public TtRssApi {
+public:
+	explicit FakeTtRssApi(ConfigContainer* cfg)
+		: TtRssApi(cfg)
+	{
+	}
+
+	void add_article(int64_t id, const std::string& feed_id, bool unread)
+	{
+		json article;
+		article["id"] = id;
+		article["feed_id"] = feed_id;
+		article["title"] = "Article " + std::to_string(id);
+		article["link"] = "https://example.com/" + std::to_string(id);
+		article["author"] = "";
+		article["content"] = nullptr;
+		article["attachments"] = nullptr;
+		article["unread"] = unread;
+		article["updated"] = 1600000000 + id;
+		articles.push_back(article);
+	}
+
+	std::vector<std::map<std::string, std::string>> requests;
+
+protected:
+	std::string send_op(const std::string& op,
+		const std::map<std::string, std::string>& args,
+		CURL*) override
+	{
+		requests.push_back(args);
+		requests.back()["op"] = op;
+
+		json reply;
+		reply["seq"] = 0;
+		if (op != "getHeadlines") {
+			reply["status"] = 1;
+			reply["content"]["error"] = "UNKNOWN_METHOD";
+			return reply.dump();
+		}
+
+		const auto arg = [&args](const std::string& name,
+		const std::string& default_value) {
+			const auto it = args.find(name);
+			return it == args.end() ? default_value : it->second;
+		};
+		const int64_t since = std::stoll(arg("since_id", "0"));
+		const std::string feed_id = arg("feed_id", "");
+		const bool unread_only = (arg("view_mode", "") == "unread");
+		const bool show_content = (arg("show_content", "0") == "1");
+		const size_t skip = std::stoul(arg("skip", "0"));
+		const size_t limit = std::stoul(arg("limit", "200"));
+
+		reply["status"] = 0;
+		reply["content"] = json::array();
+		size_t matched = 0;
+		for (const auto& article : articles) {
+			if (article["id"].get<int64_t>() <= since
+				|| (feed_id != "-4" && article["feed_id"] != feed_id)
+				|| (unread_only && !article["unread"].get<bool>())) {
+				continue;
+			}
+			matched++;
+			if (matched <= skip) {
+				continue;
+			}
+			if (reply["content"].size() >= limit) {
+				break;
+			}
+			json headline = article;
+			if (show_content) {
+				headline["content"] = "<p>Content</p>";
+			}
+			reply["content"].push_back(headline);
+		}
+		return reply.dump();
+	}
+
+private:
+	std::vector<json> articles;
+};
+
+std::vector<std::string> guids_of(const rsspp::Feed& feed)
+{
+	std::vector<std::string> guids;
+	for (const auto& item : feed.items) {
+		guids.push_back(item.guid);
+	}
+	return guids;
+}
+
+} // namespace
+
+TEST_CASE("prefetch_feeds serves feeds that are synced up to where it started",
+	"[TtRssApi]")
+{
+	ConfigContainer cfg;
+	FakeTtRssApi api(&cfg);
+	api.add_article(1, "1", false);
+	api.add_article(2, "2", true);
+	api.add_article(3, "1", true);
+	api.add_article(4, "1", true);
+	api.add_article(5, "3", false);
+
+	rsspp::Feed feed;
+	REQUIRE_FALSE(api.get_prefetched_feed("1", 3, feed));
+
+	REQUIRE(api.prefetch_feeds(3));
+
+	SECTION("feeds with new articles get them") {
+		REQUIRE(api.get_prefetched_feed("1", 3, feed));
+		REQUIRE(guids_of(feed) == std::vector<std::string>({"4"}));
+		REQUIRE(feed.items[0].content_encoded == "<p>Content</p>");
+		REQUIRE(feed.sync_position == 5);
+	}
+
+	SECTION("feeds without new articles get none") {
+		REQUIRE(api.get_prefetched_feed("2", 4, feed));
+		REQUIRE(feed.items.empty());
+		REQUIRE(feed.sync_position == 5);
+	}
+
+	SECTION("feeds that are further behind aren't served") {
+		REQUIRE_FALSE(api.get_prefetched_feed("2", 2, feed));
+		REQUIRE_FALSE(api.get_prefetched_feed("2", 0, feed));
+	}
+
+	SECTION("nothing is served once the prefetch is discarded") {
+		api.discard_prefetched_feeds();
+		REQUIRE_FALSE(api.get_prefetched_feed("1", 3, feed));
+	}
+}
+
+TEST_CASE("prefetch_feeds gets all unread articles", "[TtRssApi]")
+{
+	ConfigContainer cfg;
+	FakeTtRssApi api(&cfg);
+	api.add_article(1, "1", true);
+	api.add_article(2, "1", false);
+	api.add_article(3, "2", true);
+	api.add_article(4, "1", true);
+
+	std::unordered_set<std::string> guids;
+	REQUIRE_FALSE(api.get_unread_guids("https://example.com/feed#1", 100,
+			guids));
+
+	REQUIRE(api.prefetch_feeds(3));
+
+	REQUIRE(api.get_unread_guids("https://example.com/feed#1", 100, guids));
+	REQUIRE(guids == std::unordered_set<std::string>({"1", "4"}));
+
+	guids.clear();
+	REQUIRE(api.get_unread_guids("https://example.com/feed#2", 100, guids));
+	REQUIRE(guids == std::unordered_set<std::string>({"3"}));
+
+	guids.clear();
+	REQUIRE(api.get_unread_guids("https://example.com/feed#1", 1, guids));
+	REQUIRE(guids.size() == 1);
+}
+
+TEST_CASE("fetch_feed brings feeds that were behind up to the prefetch",
+	"[TtRssApi]")
+{
+	ConfigContainer cfg;
+	FakeTtRssApi api(&cfg);
+	api.add_article(1, "1", true);
+	api.add_article(2, "2", true);
+	api.add_article(3, "2", true);
+	api.add_article(4, "1", true);
+	api.add_article(5, "1", true);
+
+	SECTION("without a prefetch, the feed's own newest article is used") {
+		const rsspp::Feed feed = api.fetch_feed("2", nullptr);
+		REQUIRE(guids_of(feed) == std::vector<std::string>({"3", "2"}));
+		REQUIRE(feed.sync_position == 3);
+	}
+
+	SECTION("with a prefetch, the feed catches up with it") {
+		REQUIRE(api.prefetch_feeds(4));
+
+		rsspp::Feed feed;
+		REQUIRE_FALSE(api.get_prefetched_feed("2", 3, feed));
+
+		feed = api.fetch_feed("2", nullptr);
+		REQUIRE(guids_of(feed) == std::vector<std::string>({"3", "2"}));
+		REQUIRE(feed.sync_position == 5);
+
+		// Which lets the next prefetch serve it
+		REQUIRE(api.get_prefetched_feed("2", feed.sync_position, feed));
+	}
+}
+
+TEST_CASE("prefetch_feeds doesn't download anything if there are too many "
+	"new articles",
+	"[TtRssApi]")
+{
+	ConfigContainer cfg;
+	FakeTtRssApi api(&cfg);
+	for (int64_t id = 1; id <= 5001; id++) {
+		api.add_article(id, std::to_string(id % 7), true);
+	}
+
+	REQUIRE_FALSE(api.prefetch_feeds(0));
+
+	// A single headline without content was asked for
+	REQUIRE(api.requests.size() == 1);
+	REQUIRE(api.requests[0]["op"] == "getHeadlines");
+	REQUIRE(api.requests[0]["limit"] == "1");
+	REQUIRE(api.requests[0]["show_content"] == "0");
+
+	rsspp::Feed feed;
+	REQUIRE_FALSE(api.get_prefetched_feed("1", 0, feed));
+
+	SECTION("a later start makes it fit") {
+		api.requests.clear();
+		REQUIRE(api.prefetch_feeds(2));
+		REQUIRE(api.get_prefetched_feed("1", 2, feed));
+		REQUIRE(feed.items.size() == 714);
+	}
+}
+
+TEST_CASE("The sync position is only saved along with the articles",
+	"[TtRssApi]")
+{
+	ConfigContainer cfg;
+	cfg.set_configvalue("urls-source", "ttrss");
+	Cache rsscache(":memory:", &cfg);
+	FakeTtRssApi api(&cfg);
+	api.add_article(1, "2", true);
+	api.add_article(2, "2", true);
+	const std::string feedurl = "https://example.com/feed#2";
+
+	SECTION("for feeds that are fetched one by one") {
+		RssParser parser(feedurl, &rsscache, &cfg, nullptr, &api);
+		auto feed = parser.parse();
+		REQUIRE(feed != nullptr);
+		REQUIRE(rsscache.fetch_sync_watermark(feedurl) == 0);
+
+		rsscache.externalize_rssfeed(feed, false);
+		REQUIRE(rsscache.fetch_sync_watermark(feedurl) == 2);
+	}
+
+	SECTION("for prefetched feeds") {
+		RssParser first(feedurl, &rsscache, &cfg, nullptr, &api);
+		rsscache.externalize_rssfeed(first.parse(), false);
+
+		api.add_article(3, "2", true);
+		REQUIRE(api.prefetch_feeds(2));
+		RssParser parser(feedurl, &rsscache, &cfg, nullptr, &api);
+		auto feed = parser.parse();
+		REQUIRE(feed != nullptr);
+		REQUIRE(feed->total_item_count() == 1);
+		REQUIRE(rsscache.fetch_sync_watermark(feedurl) == 2);
+
+		rsscache.externalize_rssfeed(feed, false);
+		REQUIRE(rsscache.fetch_sync_watermark(feedurl) == 3);
+	}
+}
@@ -710,6 +710,15 @@ TEST_CASE("trim()", "[utils]")
 	str = "     \n";
 	utils::trim(str);
 	REQUIRE(str == "");
+
+	str = "inner  whitespace\tis kept";
+	utils::trim(str);
+	REQUIRE(str == "inner  whitespace\tis kept");
+
+	// U+00A0 NO-BREAK SPACE and U+3000 IDEOGRAPHIC SPACE
+	str = "\u00A0non-ASCII whitespace\u3000";
+	utils::trim(str);
+	REQUIRE(str == "non-ASCII whitespace");
 }
 
 TEST_CASE("trim_end()", "[utils]")